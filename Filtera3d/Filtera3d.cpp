@@ -15,6 +15,10 @@
 #include "Array.h"
 #include "Vec.h"
 #include "MathOp.h"
+#include "BoundedQueue.h"       // for -pipeline
+
+#include <thread>               // for -pipeline
+
 using namespace hh;
 
 namespace {
@@ -46,6 +50,7 @@ bool info = false;
 bool box = false;
 bool boxframe = false;
 bool nooutput = false;
+bool pipeline = false;
 int every = 0;
 int first = 0;
 int split = 0;
@@ -104,6 +109,21 @@ struct S_outlier {
     Array<Point> pa;
 } g_outlier;
 
+// With -pipeline, one thread parses the input and another formats the output, while the main thread processes
+//  the elements; the threads exchange batches of A3dElem through bounded queues.
+struct S_pipeline {
+    static constexpr int k_batch_size = 256;
+    static constexpr int k_queue_capacity = 8; // batches
+    using Queue = BoundedQueue<Array<A3dElem>>;
+    // The input queue is shared with the reader thread, which is abandoned if processing stops early.
+    std::shared_ptr<Queue> input{std::make_shared<Queue>(k_queue_capacity)};
+    Queue output{k_queue_capacity};
+    Array<A3dElem> output_batch;
+    std::thread reader;
+    std::thread writer;
+    bool reader_detached {false};
+} g_pipeline;
+
 HH_STATNP(Slnvert);             // polyline # of vertices
 HH_STATNP(Sledgel);             // polyline edge length
 HH_STATNP(Slclosed);            // polyline closed
@@ -237,18 +257,33 @@ void compute_stats(const A3dElem& el) {
     }
 }
 
+void flush_output_batch() {
+    Array<A3dElem> batch; swap(batch, g_pipeline.output_batch);
+    if (batch.num()) assertx(g_pipeline.output.push(std::move(batch)));
+}
+
+// write element, either directly or through the output thread
+void write_element(const A3dElem& el) {
+    if (!g_pipeline.writer.joinable()) { oa3d.write(el); return; }
+    g_pipeline.output_batch.push(el);
+    // Commands such as endframe are forwarded promptly so that a downstream viewer can display them.
+    if (g_pipeline.output_batch.num()>=S_pipeline::k_batch_size || A3dElem::command_type(el.type()))
+        flush_output_batch();
+}
+
 // output element
 void output_element(const A3dElem& el) {
-    if (!nooutput) oa3d.write(el);
+    if (!nooutput) write_element(el);
 }
 
 // split element and output statistics
 void pass3(const A3dElem& el) {
     static int nelem = 0;
     if (split && nelem++>=split) {
-        oa3d.write_end_frame(el.binary());
+        write_element(A3dElem(A3dElem::EType::endframe, el.binary()));
         delay_frame();
-        oa3d.write_end_object(el.binary(), 1.f, 0.f);
+        A3dElem el_endobject(A3dElem::EType::endobject, el.binary()); el_endobject.f() = V(1.f, 0.f, 0.f);
+        write_element(el_endobject);
         if (speedup) fsplit *= speedup;
         split = int(fsplit+.01f);
         nelem = 1;
@@ -676,11 +711,56 @@ void compute_outlier() {
     }
 }
 
+void process_pipelined(RSA3dStream& ia3d) {
+    std::shared_ptr<S_pipeline::Queue> input = g_pipeline.input;
+    g_pipeline.reader = std::thread([&ia3d, input] {
+        for (bool done = false; !done; ) {
+            Array<A3dElem> batch(S_pipeline::k_batch_size);
+            for_int(i, batch.num()) {
+                ia3d.read(batch[i]);
+                if (batch[i].type()==A3dElem::EType::endfile) { batch.resize(i+1); done = true; break; }
+                // Forward commands (e.g. end-of-frame) immediately so that interactive streams are not delayed.
+                if (A3dElem::command_type(batch[i].type())) { batch.resize(i+1); break; }
+            }
+            if (!input->push(std::move(batch))) break; // the consumer stopped early
+        }
+        input->close();
+    });
+    g_pipeline.writer = std::thread([] {
+        for (Array<A3dElem> batch; g_pipeline.output.pop(batch); ) {
+            for (const A3dElem& el : batch) oa3d.write(el);
+        }
+    });
+    bool done = false, stopped_early = false;
+    for (Array<A3dElem> batch; !done && g_pipeline.input->pop(batch); ) {
+        for (A3dElem& el : batch) {
+            if (loop(el)) { done = true; stopped_early = el.type()!=A3dElem::EType::endfile; break; }
+        }
+    }
+    g_pipeline.input->close();
+    if (stopped_early) {
+        // Like the serial path, stop without reading the rest of the input; the reader may be blocked waiting for
+        //  more elements (possibly from an unending stream), so it is abandoned rather than joined.
+        g_pipeline.reader.detach();
+        g_pipeline.reader_detached = true;
+    } else {
+        g_pipeline.reader.join();
+    }
+    // The remaining processing is serial, and its diagnostics must not interleave with the output thread.
+    flush_output_batch();
+    g_pipeline.output.close();
+    g_pipeline.writer.join();
+}
+
 void process(RSA3dStream& ia3d) {
-    A3dElem el;
-    for (;;) {
-        ia3d.read(el);
-        if (loop(el)) break;
+    if (pipeline) {
+        process_pipelined(ia3d);
+    } else {
+        A3dElem el;
+        for (;;) {
+            ia3d.read(el);
+            if (loop(el)) break;
+        }
     }
     if (outliern) compute_outlier();
     if (joinlines) join_lines();
@@ -777,6 +857,7 @@ int main(int argc, const char** argv) {
     ARGSF(box,                  ": show bounding box");
     ARGSF(boxframe,             ": output frame that will box data");
     ARGSF(nooutput,             ": turn off a3d output");
+    ARGSF(pipeline,             ": parse, process, and output in concurrent threads");
     ARGSC("",                   ":**");
     ARGSP(split,                "i : output frame every ith element");
     ARGSP(speedup,              "factor : increase 'split' every frame");
@@ -816,6 +897,7 @@ int main(int argc, const char** argv) {
     }
     if (stat) info = 1;
     if (stat || box || boxframe) nooutput = true;
+    if (pipeline && (frdelay || eldelay)) { Warning("-pipeline is ignored with -frdelay or -eldelay"); pipeline = false; }
     bbox.clear();
     g_inter.bb.clear();
     fsplit = float(split);
@@ -824,5 +906,6 @@ int main(int argc, const char** argv) {
     if (tobinary) my_setenv("A3D_BINARY", "1");
     process(ia3d);
     hh_clean_up();
+    if (g_pipeline.reader_detached) exit(0); // skip destroying ia3d, which the abandoned reader may still access
     return 0;
 }
@@ -20,11 +20,16 @@
 #include "MathOp.h"             // smooth_step(), floor(Vec<>)
 #include "RangeOp.h"
 #include "Multigrid.h"
-#include "MatrixOp.h"           // euclidean_distance_map()
-#include "GridOp.h"
+#include "MatrixOp.h"           // transform()
+#include "GridOp.h"             // euclidean_distance_transform()
 #include "Color_ramp.h"         // k_color_ramp
 #include "Encoding.h"
 #include "GridPixelOp.h"        // scale_Matrix_Pixel()
+#include "ImageRows.h"          // RImageRows, WImageRows
+#include "BoundedQueue.h"
+#include <thread>               // for -stream, -batch
+#include <atomic>               // for -batch
+#include <exception>            // std::exception_ptr, for -stream
 using namespace hh;
 
 namespace {
@@ -48,6 +53,7 @@ bool toggle_order = false;
 bool g_not = false;
 bool fixedbnd = false;
 float wconformal = 0.f;
+int blurboxes = 0;
 float gscale = 1.f;
 int g_niter = 1;
 bool use_lab = true;
@@ -396,45 +402,61 @@ void do_vboundaryrule(Args& args) {
     g_filterbs[0].set_bndrule(bndrule);
 }
 
-void do_cropsides(Args& args) {
-    int vl = parse_size(args.get_string(), image.xsize(), false);
-    int vr = parse_size(args.get_string(), image.xsize(), false);
-    int vt = parse_size(args.get_string(), image.ysize(), false);
-    int vb = parse_size(args.get_string(), image.ysize(), false);
-    Grid<2,Pixel>& grid = image;
-    grid = crop(grid, V(vt, vl), V(vb, vr), g_bndrules, &gcolor);
+// Parse the arguments of the crop operation op applied to an image with dimensions dims;
+//  ret: the amounts (dL, dU) to crop on the lower and upper sides, or false if op is not such an operation.
+bool parse_crop(const string& op, Args& args, const Vec2<int>& dims, Vec2<int>& dL, Vec2<int>& dU) {
+    dL = dU = twice(0);
+    if (op=="-cropsides") {
+        int vl = parse_size(args.get_string(), dims[1], false);
+        int vr = parse_size(args.get_string(), dims[1], false);
+        int vt = parse_size(args.get_string(), dims[0], false);
+        int vb = parse_size(args.get_string(), dims[0], false);
+        dL = V(vt, vl); dU = V(vb, vr);
+    } else if (op=="-cropl") {
+        dL[1] = parse_size(args.get_string(), dims[1], false);
+    } else if (op=="-cropr") {
+        dU[1] = parse_size(args.get_string(), dims[1], false);
+    } else if (op=="-cropt") {
+        dL[0] = parse_size(args.get_string(), dims[0], false);
+    } else if (op=="-cropb") {
+        dU[0] = parse_size(args.get_string(), dims[0], false);
+    } else if (op=="-cropall") {
+        string s = args.get_string();
+        dL = dU = V(parse_size(s, dims[0], false), parse_size(s, dims[1], false));
+    } else if (op=="-cropcoord") {
+        int x0 = parse_size(args.get_string(), dims[1], true);
+        int y0 = parse_size(args.get_string(), dims[0], true);
+        int x1 = parse_size(args.get_string(), dims[1], true);
+        int y1 = parse_size(args.get_string(), dims[0], true);
+        dL = V(y0, x0); dU = dims-V(y1, x1);
+    } else if (op=="-croptodims") {
+        int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
+        auto ndims = V(ny, nx);
+        dL = (dims-ndims)/2;
+        dU = dims-ndims-dL;
+    } else {
+        return false;
+    }
+    return true;
 }
 
-void do_cropl(Args& args) {
-    int v = parse_size(args.get_string(), image.xsize(), false);
+void apply_crop(const string& op, Args& args) {
+    Vec2<int> dL, dU; assertx(parse_crop(op, args, image.dims(), dL, dU));
     Grid<2,Pixel>& grid = image;
-    grid = crop(grid, V(0, v), V(0, 0), g_bndrules, &gcolor);
+    grid = crop(grid, dL, dU, g_bndrules, &gcolor);
 }
 
-void do_cropr(Args& args) {
-    int v = parse_size(args.get_string(), image.xsize(), false);
-    Grid<2,Pixel>& grid = image;
-    grid = crop(grid, V(0, 0), V(0, v), g_bndrules, &gcolor);
-}
+void do_cropsides(Args& args) { apply_crop("-cropsides", args); }
 
-void do_cropt(Args& args) {
-    int v = parse_size(args.get_string(), image.ysize(), false);
-    Grid<2,Pixel>& grid = image;
-    grid = crop(grid, V(v, 0), V(0, 0), g_bndrules, &gcolor);
-}
+void do_cropl(Args& args) { apply_crop("-cropl", args); }
 
-void do_cropb(Args& args) {
-    int v = parse_size(args.get_string(), image.ysize(), false);
-    Grid<2,Pixel>& grid = image;
-    grid = crop(grid, V(0, 0), V(v, 0), g_bndrules, &gcolor);
-}
+void do_cropr(Args& args) { apply_crop("-cropr", args); }
 
-void do_cropall(Args& args) {
-    string s = args.get_string();
-    Vec2<int> sides = V(parse_size(s, image.ysize(), false), parse_size(s, image.xsize(), false));
-    Grid<2,Pixel>& grid = image;
-    grid = crop(grid, sides, sides, g_bndrules, &gcolor);
-}
+void do_cropt(Args& args) { apply_crop("-cropt", args); }
+
+void do_cropb(Args& args) { apply_crop("-cropb", args); }
+
+void do_cropall(Args& args) { apply_crop("-cropall", args); }
 
 void do_cropsquare(Args& args) {
     int x = parse_size(args.get_string(), image.xsize(), true);
@@ -455,24 +477,9 @@ void do_croprectangle(Args& args) {
     grid = crop(grid, p0, image.dims()-p0-s, g_bndrules, &gcolor);
 }
 
-void do_cropcoord(Args& args) {
-    int x0 = parse_size(args.get_string(), image.xsize(), true);
-    int y0 = parse_size(args.get_string(), image.ysize(), true);
-    int x1 = parse_size(args.get_string(), image.xsize(), true);
-    int y1 = parse_size(args.get_string(), image.ysize(), true);
-    const Vec2<int> p0(y0, x0), p1(y1, x1);
-    Grid<2,Pixel>& grid = image;
-    grid = crop(grid, p0, image.dims()-p1, g_bndrules, &gcolor);
-}
+void do_cropcoord(Args& args) { apply_crop("-cropcoord", args); }
 
-void do_croptodims(Args& args) {
-    int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
-    auto ndims = V(ny, nx);
-    auto yx0 = (image.dims()-ndims)/2;
-    auto yx1 = image.dims()-ndims-yx0;
-    Grid<2,Pixel>& grid = image;
-    grid = crop(grid, yx0, yx1, g_bndrules, &gcolor);
-}
+void do_croptodims(Args& args) { apply_crop("-croptodims", args); }
 
 void do_cropmatte() {
     const int nz = image.zsize();
@@ -539,44 +546,48 @@ void do_vfilter(Args& args) {
     g_filterbs[0].set_filter(filter);
 }
 
-void do_scaleunif(Args& args) {
-    HH_TIMER(_scale);
-    float s = args.get_float();
-    image.scale(twice(s), g_filterbs, &gcolor);
+// Parse the arguments of the scale operation op applied to an image with dimensions dims;
+//  ret: the scaling factors, or zero if op is not such an operation.
+Vec2<float> parse_scale(const string& op, Args& args, const Vec2<int>& dims) {
+    if (op=="-scaleunif") {
+        float s = args.get_float();
+        return twice(s);
+    } else if (op=="-scalenonunif") {
+        float sx = args.get_float(), sy = args.get_float();
+        return V(sy, sx);
+    } else if (op=="-scaletox") {
+        int nx = parse_size(args.get_string(), dims[1], false); assertx(nx>0);
+        return twice(float(nx)/assertx(dims[1]));
+    } else if (op=="-scaletoy") {
+        int ny = parse_size(args.get_string(), dims[0], false); assertx(ny>0);
+        return twice(float(ny)/assertx(dims[0]));
+    } else if (op=="-scaletodims") {
+        int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
+        return convert<float>(V(ny, nx))/convert<float>(dims);
+    } else if (op=="-scaleinside") {
+        int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
+        return twice(min(convert<float>(V(ny, nx))/convert<float>(dims)));
+    } else {
+        return twice(0.f);
+    }
 }
 
-void do_scalenonunif(Args& args) {
+void apply_scale(const string& op, Args& args) {
     HH_TIMER(_scale);
-    float sx = args.get_float(), sy = args.get_float();
-    image.scale(V(sy, sx), g_filterbs, &gcolor);
+    image.scale(parse_scale(op, args, image.dims()), g_filterbs, &gcolor);
 }
 
-void do_scaletox(Args& args) {
-    HH_TIMER(_scale);
-    int nx = parse_size(args.get_string(), image.xsize(), false); assertx(nx>0);
-    float s = float(nx)/assertx(image.xsize());
-    image.scale(twice(s), g_filterbs, &gcolor);
-}
+void do_scaleunif(Args& args) { apply_scale("-scaleunif", args); }
 
-void do_scaletoy(Args& args) {
-    HH_TIMER(_scale);
-    int ny = parse_size(args.get_string(), image.ysize(), false); assertx(ny>0);
-    float s = float(ny)/assertx(image.ysize());
-    image.scale(twice(s), g_filterbs, &gcolor);
-}
+void do_scalenonunif(Args& args) { apply_scale("-scalenonunif", args); }
 
-void do_scaletodims(Args& args) {
-    HH_TIMER(_scale);
-    int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
-    auto syx = convert<float>(V(ny, nx))/convert<float>(image.dims());
-    image.scale(syx, g_filterbs, &gcolor);
-}
+void do_scaletox(Args& args) { apply_scale("-scaletox", args); }
 
-void do_scaleinside(Args& args) {
-    HH_TIMER(_scale);
-    int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
-    image.scale(twice(min(convert<float>(V(ny, nx))/convert<float>(image.dims()))), g_filterbs, &gcolor);
-}
+void do_scaletoy(Args& args) { apply_scale("-scaletoy", args); }
+
+void do_scaletodims(Args& args) { apply_scale("-scaletodims", args); }
+
+void do_scaleinside(Args& args) { apply_scale("-scaleinside", args); }
 
 void do_scalehalf2n1() {
     HH_TIMER(_scale);
@@ -788,6 +799,16 @@ void do_noisegaussian(Args& args) {
     }
 }
 
+// Normalized 1D Gaussian kernel with standard deviation sdv_pixels, truncated at 2.5 standard deviations.
+Array<float> blur_kernel(float sdv_pixels) {
+    const float nsvd = 2.5f;
+    const int r = int(nsvd*sdv_pixels+.5f);    // window radius
+    Array<float> ar_gauss(2*r+1);              // cached Gaussian weights
+    for_int(i, 2*r+1) { ar_gauss[i] = gaussian(float(i)-r, sdv_pixels); }
+    ar_gauss /= float(sum(ar_gauss));
+    return ar_gauss;
+}
+
 void do_blur(Args& args) {
     // e.g.: Filterimage ~/data/image/lake.png -blur 1 | imgv
     // Filterimage ~/data/image/rampart1.jpg -info -blur 1 -info | imgv
@@ -798,10 +819,8 @@ void do_blur(Args& args) {
     //  new  (_blur:                   0.50  x7.2      0.54)
     HH_TIMER(_blur);
     const float sdv_pixels = args.get_float(); // 1sdv in pixels
-    const float nsvd = 2.5f;
-    const int r = int(nsvd*sdv_pixels+.5f);    // window radius
-    Array<float> ar_gauss(2*r+1);              // cached Gaussian weights
-    for_int(i, 2*r+1) { ar_gauss[i] = gaussian(float(i)-r, sdv_pixels); }
+    Array<float> ar_gauss = blur_kernel(sdv_pixels);
+    const int r = (ar_gauss.num()-1)/2;        // window radius
     // SHOW(ar_gauss);
     if (0) {
         {                    // normalize the 1D weights such that 2D tensor sums to 1 over discrete 2D window
@@ -820,9 +839,13 @@ void do_blur(Args& args) {
             image[yx] = vec.pixel();
         }, 1000);
     } else {
-        ar_gauss /= float(sum(ar_gauss));
         // SHOW(ar_gauss); SHOW(sum(ar_gauss));
-        for_int(d, 2) image = convolve_d(image, d, ar_gauss, Bndrule::reflected);
+        if (blurboxes) {
+            // Filterimage ~/data/image/rampart1.jpg -info -blurboxes 3 -blur 16 -info | imgv
+            for_int(d, 2) image = box_blur_d(image, d, sdv_pixels, Bndrule::reflected, nullptr, blurboxes);
+        } else {
+            for_int(d, 2) image = convolve_d(image, d, ar_gauss, Bndrule::reflected);
+        }
     }
 }
 
@@ -962,6 +985,84 @@ void do_invideo(Args& args) {
     nooutput = true;
 }
 
+int batch_threads = 0;          // number of threads decoding (and encoding) images in -batch; 0 means the number of cores
+
+// Apply the remaining operations to each image in listfile, which contains pairs "infile outfile".
+// The operations are applied to one image at a time (each operation being itself parallel), while worker threads
+//  decode the next images and encode the previous results.  The number of images in flight is bounded, and their
+//  buffers are recycled, so memory use is independent of the number of files.
+void do_batch(Args& args) {
+    // e.g.: ls *.jpg | awk '{print $1, "thumbs/" $1}' >list; Filterimage -batch list -scaleifgtmax 256 -to jpg
+    HH_TIMER(_batch);
+    string listfile = args.get_filename();
+    struct Job { string ifilename, ofilename; };
+    Array<Job> jobs; {
+        RFile fi(listfile);
+        for (Job job; fi() >> job.ifilename >> job.ofilename; ) jobs.push(job);
+    }
+    struct BatchImage { int index; unique_ptr<Image> pimage; string error; bool write; };
+    const int nthreads = batch_threads ? batch_threads : get_max_threads();
+    const int max_in_flight = 2*nthreads+1;
+    BoundedQueue<unique_ptr<Image>> queue_free(max_in_flight); // recycled image buffers
+    for_int(i, max_in_flight) { assertx(queue_free.push(make_unique<Image>())); }
+    BoundedQueue<BatchImage> queue_decoded(max_in_flight), queue_processed(max_in_flight);
+    std::atomic<int> next_job{0}, num_readers{nthreads};
+    auto func_reader = [&] {
+        for (unique_ptr<Image> pimage; queue_free.pop(pimage); ) {
+            const int i = next_job++;
+            if (i>=jobs.num()) { queue_free.close(); break; } // release the other readers
+            BatchImage bimage{i, std::move(pimage), "", false};
+            try {
+                bimage.pimage->set_silent_io_progress(true); // (the flag is exchanged by swap())
+                bimage.pimage->read_file(jobs[i].ifilename);
+            } catch (const std::runtime_error& ex) {
+                bimage.error = ex.what();
+            }
+            if (!queue_decoded.push(std::move(bimage))) break;
+        }
+        if (--num_readers==0) queue_decoded.close();
+    };
+    std::atomic<int> num_errors{0};
+    auto func_writer = [&] {
+        for (BatchImage bimage; queue_processed.pop(bimage); ) {
+            if (bimage.write) {
+                try {
+                    bimage.pimage->set_silent_io_progress(true);
+                    bimage.pimage->write_file(jobs[bimage.index].ofilename);
+                } catch (const std::runtime_error& ex) {
+                    showf("batch: error writing image '%s': %s\n", jobs[bimage.index].ofilename.c_str(), ex.what());
+                    num_errors++;
+                }
+            }
+            queue_free.push(std::move(bimage.pimage)); // (fails harmlessly once all images are read)
+        }
+    };
+    Array<std::thread> threads;
+    for_int(i, nthreads) { threads.push(std::thread(func_reader)); threads.push(std::thread(func_writer)); }
+    ConsoleProgress cprogress("Batch");
+    int count = 0;
+    for (BatchImage bimage; queue_decoded.pop(bimage); ) {
+        cprogress.update(float(count++)/jobs.num());
+        if (bimage.error!="") {
+            showf("batch: error reading image '%s': %s\n", jobs[bimage.index].ifilename.c_str(), bimage.error.c_str());
+            num_errors++;
+        } else {
+            swap(image, *bimage.pimage);
+            nooutput = false;
+            ParseArgs parseargs{Array<string>{""}}; parseargs.copy_parse(*g_parseargs);
+            parseargs.parse();
+            swap(image, *bimage.pimage);
+            bimage.write = !nooutput;
+        }
+        assertx(queue_processed.push(std::move(bimage)));
+    }
+    queue_processed.close();
+    for (std::thread& thread : threads) thread.join();
+    if (num_errors) showf("batch: %d of %d images failed\n", int(num_errors), jobs.num());
+    while (args.num()) args.get_string(); // discard already parsed arguments
+    nooutput = true;
+}
+
 void do_gridcrop(Args& args) {
     // Filterimage ~/data/image/lake.png -as_cropsides -1 -1 -1 -1 -gridcrop 3 3 20 20 | imgv
     int nx = args.get_int(), ny = args.get_int(); assertx(nx>=2 && ny>=2);
@@ -1028,14 +1129,18 @@ void do_replace(Args& args) {
     showf("Replaced %d pixels\n", count);
 }
 
-void do_gamma(Args& args) {
-    float gamma = args.get_float();
+void apply_gamma(MatrixView<Pixel> im, int nz, float gamma) {
     Vec<uchar,256> transf; for_int(i, 256) { transf[i] = uchar(clamp(pow(i/255.f, gamma), 0.f, 1.f)*255.f+.5f); }
-    parallel_for_coords(image.dims(), [&](const Vec2<int>& yx) {
-        for_int(z, image.zsize()) { image[yx][z] = transf[image[yx][z]]; }
+    parallel_for_coords(im.dims(), [&](const Vec2<int>& yx) {
+        for_int(z, nz) { im[yx][z] = transf[im[yx][z]]; }
     }, 10);
 }
 
+void do_gamma(Args& args) {
+    float gamma = args.get_float();
+    apply_gamma(image, image.zsize(), gamma);
+}
+
 void do_tobw() {
     image.to_bw();
 }
@@ -1317,16 +1422,16 @@ void do_voronoidilate() {
     // Using Vec2<float>:  win: 0.74  gcc: 0.23
     // Using Vec2<int>  :  win: 0.27  gcc: 0.19
     HH_TIMER(_voronoi);
-    if (image.suffix()=="jpg") assertnever("euclidean_distance_map not useful on jpg image");
-    Matrix<Vec2<int>> mvec(image.dims(), image.dims());
+    if (image.suffix()=="jpg") assertnever("euclidean_distance_transform not useful on jpg image");
+    Matrix<bool> mfeature(image.dims());
     int num_undef = 0;
     for (const auto& yx : range(image.dims())) {
         bool is_undef = rgb_equal(image[yx], gcolor)^g_not;
-        if (!is_undef) mvec[yx] = V(0, 0);
+        mfeature[yx] = !is_undef;
         num_undef += is_undef;
     }
     showf("voronoidilate: filling in %d undefined pixels\n", num_undef);
-    euclidean_distance_map(mvec);
+    const Grid<2,Vec2<int>> mvec = euclidean_distance_transform<2>(mfeature);
     // Fill in unfilled pixels
     for (const auto& yx : range(image.dims())) {
         if (mag2(mvec[yx])==0) continue;
@@ -1337,13 +1442,12 @@ void do_voronoidilate() {
 }
 
 void do_featureoffsets() {
-    if (image.suffix()=="jpg") assertnever("euclidean_distance_map not useful on jpg image");
-    Matrix<Vec2<int>> mvec(image.dims(), image.dims()); // (mvec is initialized with large values image.dims())
-    for (const auto& yx : range(image.dims())) {
-        bool is_undef = rgb_equal(image[yx], gcolor)^g_not;
-        if (!is_undef) mvec[yx] = V(0, 0);
-    }
-    euclidean_distance_map(mvec);
+    if (image.suffix()=="jpg") assertnever("euclidean_distance_transform not useful on jpg image");
+    Matrix<bool> mfeature(image.dims());
+    parallel_for_coords(image.dims(), [&](const Vec2<int>& yx) {
+        mfeature[yx] = !(rgb_equal(image[yx], gcolor)^g_not);
+    }, 4);
+    const Grid<2,Vec2<int>> mvec = euclidean_distance_transform<2>(mfeature);
     for (const auto& yx : range(image.dims())) {
         assertx(mvec[yx][0]<image.ysize()); // no more large (undefined) values
         HH_SSTAT(Svoronoidist, mag(mvec[yx]));
@@ -1452,15 +1556,19 @@ void do_cycle(Args& args) {
     }
 }
 
-void do_transf(Args& args) {
-    Frame frame = FrameIO::parse_frame(args.get_string());
-    parallel_for_coords(image.dims(), [&](const Vec2<int>& yx) {
-        Point p(0.f, 0.f, 0.f); for_int(z, image.zsize()) { p[z] = image[yx][z]/255.f; }
+void apply_transf(MatrixView<Pixel> im, int nz, const Frame& frame) {
+    parallel_for_coords(im.dims(), [&](const Vec2<int>& yx) {
+        Point p(0.f, 0.f, 0.f); for_int(z, nz) { p[z] = im[yx][z]/255.f; }
         p *= frame;
-        for_int(z, image.zsize()) { image[yx][z] = uchar(clamp(p[z], 0.f, 1.f)*255.f+.5f); }
+        for_int(z, nz) { im[yx][z] = uchar(clamp(p[z], 0.f, 1.f)*255.f+.5f); }
     }, 30);
 }
 
+void do_transf(Args& args) {
+    Frame frame = FrameIO::parse_frame(args.get_string());
+    apply_transf(image, image.zsize(), frame);
+}
+
 void do_composite(Args& args) {
     string opname = args.get_string();
     float weight = args.get_float();
@@ -2375,12 +2483,12 @@ void do_procedure(Args& args) {
                 // # Sp0tcost:           (79313  )          0:255         av=8.1941299      sd=35.532955
             }
         }
-        Matrix<Vec2<int>> mvec(image.dims()); { // compute vectors to closest pixel in the mask
-            const auto undefined_dist = mvec.dims();
+        Grid<2,Vec2<int>> mvec; {  // compute vectors to closest pixel in the mask
+            Matrix<bool> mfeature(image.dims());
             parallel_for_coords(image.dims(), [&](const Vec2<int>& yx) {
-                mvec[yx] = image[yx][0]>=cost_threshold ? V(0, 0) : undefined_dist;
-            }, 8);
-            euclidean_distance_map(mvec);
+                mfeature[yx] = image[yx][0]>=cost_threshold;
+            }, 4);
+            mvec = euclidean_distance_transform<2>(mfeature);
         }
         {                       // dilate the mask by a radius that is the square-root of radius2_threshold
             Image image_dilated(image.dims());
@@ -2699,6 +2807,400 @@ void do_compare(Args& args) {
 }
 
 
+// *** stream
+
+// Out-of-core processing of images that are too large to fit in memory, e.g.:
+//  Filterimage -stream huge.png huge.small.png -gamma 1.2 -blur 2 -filter keys -scaleu .25 -cropall 10
+// The operations form a pipeline of stages, each producing its output rows in order from the rows of the stage
+//  before it, so that only a bounded window of rows is held in memory.  Reading (with prefetching) and writing
+//  (with write-behind) run in their own threads, and each strip of rows is processed in parallel.
+
+int stream_rows = 64;           // number of output rows in each strip
+
+// A stage of the streaming pipeline; get_rows() is called on successive strips of rows, from top to bottom.
+class StreamStage : noncopyable {
+ public:
+    virtual ~StreamStage()                      { }
+    const Vec2<int>& dims() const               { return _dims; }
+    int zsize() const                           { return _zsize; }
+    virtual void get_rows(MatrixView<Pixel> rows) = 0; // next rows.ysize() rows
+ protected:
+    Vec2<int> _dims;
+    int _zsize;
+};
+
+// Sliding window over the rows of a stream, for stages whose output rows depend on a neighborhood of input rows.
+template<typename T> class StreamWindow : noncopyable {
+ public:
+    using Fetch = std::function<void(MatrixView<T>)>; // get the next rows of the stream
+    explicit StreamWindow(const Vec2<int>& dims, Fetch fetch) : _dims(dims), _fetch(std::move(fetch)) { }
+    const Vec2<int>& dims() const               { return _dims; }
+    // Get the rows [ya, yb) of the stream; ya must be nondecreasing over successive calls.
+    CMatrixView<T> get(int ya, int yb) {
+        assertx(ya>=_y0 && ya<yb && yb<=_dims[0]);
+        int ndrop = std::min(ya-_y0, _n);
+        for_int(i, _n-ndrop) { _buf[i].assign(_buf[i+ndrop]); }
+        _y0 += ndrop; _n -= ndrop;
+        while (_y0<ya) {        // skip rows that are never needed
+            Matrix<T> skip(V(std::min(ya-_y0, stream_rows), _dims[1]));
+            _fetch(skip);
+            _y0 += skip.ysize();
+        }
+        if (yb-_y0>_buf.ysize()) {
+            Matrix<T> nbuf(V(yb-_y0, _dims[1]));
+            if (_n) nbuf.slice(0, _n).assign(_buf.slice(0, _n));
+            _buf = std::move(nbuf);
+        }
+        if (_y0+_n<yb) {
+            _fetch(_buf.slice(_n, yb-_y0));
+            _n = yb-_y0;
+        }
+        return _buf.slice(0, yb-_y0);
+    }
+ private:
+    Vec2<int> _dims;
+    Fetch _fetch;
+    Matrix<T> _buf;             // rows [_y0, _y0+_n) of the stream are in _buf[0.._n-1]
+    int _y0 {0};
+    int _n {0};
+};
+
+// Range [ymin, ymax] of the actual rows of a stream with ny rows referenced by its virtual rows [ya, yb);
+//  ret: false if there are none (bndrule==Bndrule::border).
+bool referenced_rows(int ny, int ya, int yb, Bndrule bndrule, int& ymin, int& ymax) {
+    if (bndrule==Bndrule::periodic && (ya<0 || yb>ny)) assertnever("-stream does not support periodic rows");
+    ymin = ny; ymax = -1;
+    for_intL(y, ya, yb) {
+        int yy = y; if (map_boundaryrule_1D(yy, ny, bndrule)) { ymin = min(ymin, yy); ymax = max(ymax, yy); }
+    }
+    return ymax>=0;
+}
+
+// Copy the virtual rows [ya, yb) of the stream in window, mapped onto its actual rows using bndrule.
+template<typename T> Matrix<T> gather_rows(StreamWindow<T>& window, int ya, int yb, Bndrule bndrule,
+                                           const T& bordervalue) {
+    const int ny = window.dims()[0];
+    Matrix<T> mat(V(yb-ya, window.dims()[1]));
+    int ymin, ymax;
+    CMatrixView<T> rows(nullptr, V(0, 0)); if (referenced_rows(ny, ya, yb, bndrule, ymin, ymax)) rows.reinit(window.get(ymin, ymax+1));
+    for_intL(y, ya, yb) {
+        int yy = y;
+        if (map_boundaryrule_1D(yy, ny, bndrule)) mat[y-ya].assign(rows[yy-ymin]); else fill(mat[y-ya], bordervalue);
+    }
+    return mat;
+}
+
+// Read the rows of an image file, prefetching strips of rows in a separate thread.
+class SourceStage : public StreamStage {
+ public:
+    explicit SourceStage(const string& filename) : _rimage(filename) {
+        _dims = _rimage.dims(); _zsize = _rimage.zsize();
+        _thread = std::thread([this] { read_strips(); });
+    }
+    ~SourceStage()                              { _queue.close(); _thread.join(); }
+    const string& suffix() const                { return _rimage.suffix(); }
+    void get_rows(MatrixView<Pixel> rows) override {
+        for (int y = 0; y<rows.ysize(); ) {
+            if (_strip_row==_strip.ysize()) {
+                if (!_queue.pop(_strip)) {
+                    if (_exception) std::rethrow_exception(_exception);
+                    assertnever("");
+                }
+                _strip_row = 0;
+            }
+            int n = std::min(rows.ysize()-y, _strip.ysize()-_strip_row);
+            rows.slice(y, y+n).assign(_strip.slice(_strip_row, _strip_row+n));
+            y += n; _strip_row += n;
+        }
+    }
+ private:
+    RImageRows _rimage;
+    BoundedQueue<Matrix<Pixel>> _queue {2};
+    std::exception_ptr _exception; // set by _thread (e.g. on a corrupt file) before closing _queue
+    std::thread _thread;
+    Matrix<Pixel> _strip;       // current strip received from _thread
+    int _strip_row {0};         // next row of _strip to return
+    void read_strips() {
+        try {
+            while (_rimage.cur_row()<_dims[0]) {
+                Matrix<Pixel> strip(V(std::min(stream_rows, _dims[0]-_rimage.cur_row()), _dims[1]));
+                _rimage.read_rows(strip);
+                if (!_queue.push(std::move(strip))) break;
+            }
+        }
+        catch (...) {
+            _exception = std::current_exception();
+        }
+        _queue.close();
+    }
+};
+
+// Apply a function independently to each row.
+class PixelStage : public StreamStage {
+ public:
+    using Func = std::function<void(MatrixView<Pixel>)>;
+    explicit PixelStage(StreamStage& up, int zsize, Func func) : _up(up), _func(std::move(func)) {
+        _dims = _up.dims(); _zsize = zsize;
+    }
+    void get_rows(MatrixView<Pixel> rows) override { _up.get_rows(rows); _func(rows); }
+ private:
+    StreamStage& _up;
+    Func _func;
+};
+
+// Crop (but not extend) the image.
+class CropStage : public StreamStage {
+ public:
+    explicit CropStage(StreamStage& up, const Vec2<int>& dL, const Vec2<int>& dU) : _up(up), _dL(dL) {
+        if (min(dL)<0 || min(dU)<0) assertnever("-stream does not support negative crops");
+        _dims = _up.dims()-dL-dU; _zsize = _up.zsize();
+        assertx(min(_dims)>0);
+    }
+    void get_rows(MatrixView<Pixel> rows) override {
+        for (int nskip = _dL[0]; nskip>0; ) { // skip the top rows on the first call
+            Matrix<Pixel> skip(V(std::min(nskip, stream_rows), _up.dims()[1]));
+            _up.get_rows(skip);
+            nskip -= skip.ysize(); _dL[0] -= skip.ysize();
+        }
+        Matrix<Pixel> urows(V(rows.ysize(), _up.dims()[1]));
+        _up.get_rows(urows);
+        for_int(y, rows.ysize()) { rows[y].assign(urows[y].segment(_dL[1], _dims[1])); }
+    }
+ private:
+    StreamStage& _up;
+    Vec2<int> _dL;
+};
+
+// Gaussian blur, identical to do_blur().
+class BlurStage : public StreamStage {
+ public:
+    explicit BlurStage(StreamStage& up, float sdv_pixels)
+        : _sdv(sdv_pixels), _nboxes(blurboxes), _kernel(blur_kernel(sdv_pixels)),
+          _window(up.dims(), [&up](MatrixView<Pixel> rows) { up.get_rows(rows); }) {
+        _dims = up.dims(); _zsize = up.zsize();
+        if (_nboxes) {
+            _r = 0; for (int r : gaussian_box_radii(_sdv, _nboxes)) _r += r;
+        } else {
+            _r = (_kernel.num()-1)/2;
+        }
+    }
+    void get_rows(MatrixView<Pixel> rows) override {
+        const int r = _r, n = rows.ysize();
+        // Vertical blur on the rows extended by radius r; then horizontal blur within each row.
+        // The box filters sum integers exactly, so the result does not depend on the extent of the strip.
+        auto blur = [&](CMatrixView<Pixel> mat, int d) -> Matrix<Pixel> {
+            if (_nboxes) return box_blur_d<2>(mat, d, _sdv, Bndrule::reflected, nullptr, _nboxes);
+            return convolve_d<2>(mat, d, _kernel, k_reflected);
+        };
+        Matrix<Pixel> mat;
+        if (_y-r>=0 && _y+n+r<=_dims[0]) {
+            mat = blur(_window.get(_y-r, _y+n+r), 0);
+        } else {                // rows near the top or bottom boundary
+            mat = blur(gather_rows(_window, _y-r, _y+n+r, k_reflected, Pixel{}), 0);
+        }
+        rows.assign(blur(mat.slice(r, r+n), 1));
+        _y += n;
+    }
+ private:
+    float _sdv;
+    int _nboxes;                // value of -blurboxes when the stage was created (0=exact Gaussian)
+    Array<float> _kernel;
+    int _r;                     // vertical radius of the blur
+    StreamWindow<Pixel> _window;
+    int _y {0};                 // next output row
+};
+
+// Rescale the image, like Image::scale() except for rounding and for a truncation of the inverse convolution
+//  (for filters like spline and omoms) to a neighborhood of k_halo rows in the vertical direction.
+class ScaleStage : public StreamStage {
+ public:
+    explicit ScaleStage(StreamStage& up, const Vec2<float>& syx)
+        : _filterbs(g_filterbs), _cdims(up.dims()), _ndims(convert<int>(convert<float>(_cdims)*syx+.5f)),
+          // Order the two dimensions as in details::scale_i(), including its tie rule (equal adjusted scale
+          //  factors process the vertical dimension first), so that the output matches Image::scale().
+          _hfirst((syx[1]<1.f ? syx[1]/2.f : syx[1]>1.f ? syx[1]*2.f : syx[1])<syx[0]),
+          _window(V(_cdims[0], _hfirst ? _ndims[1] : _cdims[1]),
+                  [this, &up](MatrixView<Vector4> rows) { fetch(up, rows); }) {
+        for_int(d, 2) {
+            const Filter& filter = _filterbs[d].filter();
+            if (filter.is_preprocess() || filter.name()=="justspline")
+                assertnever("-stream does not support filter " + filter.name());
+        }
+        if (!product(_ndims)) assertnever("-stream does not support scaling to zero image");
+        _dims = _ndims; _zsize = up.zsize();
+        convert(CGrid1View(gcolor), Grid1View(_vborder));
+        const FilterBnd& filterb = _filterbs[0];
+        _videntity = _ndims[0]==_cdims[0] && filterb.filter().is_interpolating();
+        _vinvconv = !_videntity && filterb.filter().has_inv_convolution();
+        if (_vinvconv && filterb.bndrule()==Bndrule::periodic) assertnever("-stream does not support periodic rows");
+        filterb.setup_kernel_weights(_cdims[0], _ndims[0], false, _pixelindex0, _weights);
+    }
+    void get_rows(MatrixView<Pixel> rows) override {
+        const FilterBnd& filterb = _filterbs[0];
+        const int cy = _cdims[0], ny = _ndims[0], n = rows.ysize(), nk = _weights.xsize();
+        const bool magnify = ny>=cy;
+        Matrix<Vector4> mat;
+        if (_videntity) {
+            mat = _window.get(_y, _y+n);
+        } else {
+            // Output rows [oa, ob), extended for the inverse convolution after minification.
+            const bool post_invconv = _vinvconv && !magnify, pre_invconv = _vinvconv && magnify;
+            const int oa = post_invconv ? max(_y-k_halo, 0) : _y;
+            const int ob = post_invconv ? min(_y+n+k_halo, ny) : _y+n;
+            // Input rows [ya, yb), extended for the inverse convolution before magnification.
+            int ya, yb; CMatrixView<Vector4> vin(nullptr, V(0, 0)); Matrix<Vector4> matin;
+            if (referenced_rows(cy, _pixelindex0[oa], _pixelindex0[ob-1]+nk, filterb.bndrule(), ya, yb)) {
+                yb += 1;
+                if (pre_invconv) { ya = max(ya-k_halo, 0); yb = min(yb+k_halo, cy); }
+                vin.reinit(_window.get(ya, yb));
+                if (pre_invconv) {
+                    matin = vin;
+                    details::inverse_convolution_d(matin, filterb, 0);
+                    vin.reinit(matin);
+                }
+            }
+            mat.init(V(ob-oa, _window.dims()[1]));
+            parallel_for_each(range(ob-oa), [&](const int i) {
+                const int y = oa+i;
+                Vector4* __restrict ao = mat[i].data();
+                const int nx = mat.xsize();
+                for_int(x, nx) { ao[x] = Vector4(0.f); }
+                for_int(k, nk) {
+                    int yy = _pixelindex0[y]+k; const float w = _weights[y][k];
+                    if (map_boundaryrule_1D(yy, cy, filterb.bndrule())) {
+                        const Vector4* __restrict ai = vin[yy-ya].data();
+                        for_int(x, nx) { ao[x] += w*ai[x]; }
+                    } else {
+                        const Vector4 v = w*_vborder;
+                        for_int(x, nx) { ao[x] += v; }
+                    }
+                }
+            }, _weights.xsize()*mat.xsize()*4);
+            if (post_invconv) {
+                details::inverse_convolution_d(mat, filterb, 0);
+                Matrix<Vector4> nmat(mat.slice(_y-oa, _y-oa+n)); mat = std::move(nmat);
+            }
+        }
+        if (!_hfirst) mat = details::scale_d(mat, 1, _ndims[1], _filterbs[1], &_vborder, false, std::move(mat));
+        convert(mat, rows);
+        _y += n;
+    }
+ private:
+    static constexpr int k_halo = 32; // rows of support for the truncated vertical inverse convolution
+    Vec2<FilterBnd> _filterbs;        // (later operations may modify g_filterbs)
+    Vec2<int> _cdims;                 // dimensions of input image
+    Vec2<int> _ndims;
+    bool _hfirst;                     // scale horizontally before scaling vertically
+    StreamWindow<Vector4> _window;    // input rows, already scaled horizontally if _hfirst
+    Vector4 _vborder;
+    bool _videntity;
+    bool _vinvconv;
+    Array<int> _pixelindex0;
+    Matrix<float> _weights;
+    int _y {0};                       // next output row
+    void fetch(StreamStage& up, MatrixView<Vector4> rows) {
+        Matrix<Pixel> urows(V(rows.ysize(), _cdims[1])); up.get_rows(urows);
+        Matrix<Vector4> mat(urows.dims()); convert(urows, mat);
+        if (_hfirst) mat = details::scale_d(mat, 1, _ndims[1], _filterbs[1], &_vborder, false, std::move(mat));
+        rows.assign(mat);
+    }
+};
+
+// Read a list of operations and apply them to the rows of an image file, writing the result to another file.
+void do_stream(Args& args) {
+    HH_TIMER(_stream);
+    string ifilename = args.get_filename(), ofilename = args.get_filename();
+    Array<unique_ptr<StreamStage>> stages;
+    stages.push(make_unique<SourceStage>(ifilename));
+    string suffix = image.suffix()!="" ? image.suffix() : static_cast<SourceStage&>(*stages[0]).suffix();
+    while (args.num()) {
+        string op = g_parseargs->option_name(args.get_string()); // e.g. "-scaleu" becomes "-scaleunif"
+        StreamStage& up = *stages.last();
+        const int nz = up.zsize();
+        Vec2<int> dL, dU; Vec2<float> syx;
+        if (op=="-filter") {
+            do_filter(args);
+        } else if (op=="-hfilter") {
+            do_hfilter(args);
+        } else if (op=="-vfilter") {
+            do_vfilter(args);
+        } else if (op=="-boundaryrule") {
+            do_boundaryrule(args);
+        } else if (op=="-hboundaryrule") {
+            do_hboundaryrule(args);
+        } else if (op=="-vboundaryrule") {
+            do_vboundaryrule(args);
+        } else if (op=="-color") {
+            do_color(args);
+        } else if (op=="-to") {
+            do_to(args); suffix = image.suffix();
+        } else if (op=="-gamma") {
+            float gamma = args.get_float();
+            stages.push(make_unique<PixelStage>(up, nz, [nz, gamma](MatrixView<Pixel> rows) {
+                apply_gamma(rows, nz, gamma);
+            }));
+        } else if (op=="-transf") {
+            Frame frame = FrameIO::parse_frame(args.get_string());
+            stages.push(make_unique<PixelStage>(up, nz, [nz, frame](MatrixView<Pixel> rows) {
+                apply_transf(rows, nz, frame);
+            }));
+        } else if (op=="-tobw") {
+            stages.push(make_unique<PixelStage>(up, 1, [nz](MatrixView<Pixel> rows) {
+                Image im(rows.dims()); im.set_zsize(nz); im.assign(rows);
+                im.to_bw();
+                rows.assign(im);
+            }));
+        } else if (op=="-blurboxes") {
+            blurboxes = args.get_int();
+        } else if (op=="-blur") {
+            stages.push(make_unique<BlurStage>(up, args.get_float()));
+        } else if (parse_crop(op, args, up.dims(), dL, dU)) {
+            stages.push(make_unique<CropStage>(up, dL, dU));
+        } else if (!is_zero(syx = parse_scale(op, args, up.dims()))) {
+            stages.push(make_unique<ScaleStage>(up, syx));
+        } else {
+            assertnever("Operation '" + op + "' is not supported within -stream");
+        }
+    }
+    const StreamStage& last = *stages.last();
+    const Vec2<int> dims = last.dims();
+    {
+        WImageRows wimage(ofilename, dims, last.zsize(), suffix);
+        BoundedQueue<Matrix<Pixel>> queue(2);
+        std::exception_ptr writer_exception; // set by writer before closing queue
+        std::thread writer([&] {
+            try {
+                for (Matrix<Pixel> strip; queue.pop(strip); ) wimage.write_rows(strip);
+            }
+            catch (...) {
+                writer_exception = std::current_exception();
+            }
+            queue.close();
+        });
+        std::exception_ptr exception; // the writer thread must be joined before propagating any exception
+        try {
+            ConsoleProgress cprogress("Stream");
+            for (int y = 0; y<dims[0]; y += stream_rows) {
+                cprogress.update(float(y)/dims[0]);
+                Matrix<Pixel> strip(V(min(stream_rows, dims[0]-y), dims[1]));
+                stages.last()->get_rows(strip);
+                if (!queue.push(std::move(strip))) break; // the writer failed
+            }
+        }
+        catch (...) {
+            exception = std::current_exception();
+        }
+        queue.close();
+        writer.join();
+        if (writer_exception) std::rethrow_exception(writer_exception);
+        if (exception) std::rethrow_exception(exception);
+        wimage.finish();
+    }
+    while (stages.num()) stages.pop(); // destroy the stages in reverse order
+    nooutput = true;
+}
+
+
 // *** Pyramid  (see also Pyramid.cpp)
 
 // Color-space conversion of a single pixel (each channel in range [0.f, 255.f]).
@@ -3133,6 +3635,10 @@ int main(int argc, const char** argv) {
     ARGSD(assemble,             "nx ny images_lr_tb_order : concatenate grid of images");
     ARGSD(fromtxt,              "nx ny nch file.txt : read values in range [0., 1.]");
     ARGSD(invideo,              "videofile : process each video frame, writing to a new video");
+    ARGSD(stream,               "infile outfile ops : process a large image in strips of rows (some ops only)");
+    ARGSP(stream_rows,          "n : number of rows in each strip for -stream");
+    ARGSD(batch,                "listfile ops : apply ops to each 'infile outfile' pair, several images concurrently");
+    ARGSP(batch_threads,        "n : number of decoding/encoding threads for -batch (0=number of cores)");
     ARGSC("",                   ":");
     ARGSD(to,                   "suffix : set output format (jpg, png, bmp, ppm, rgb, tif, wmp)");
     ARGSD(outfile,              "filename : output an intermediate image");
@@ -3208,6 +3714,7 @@ int main(int argc, const char** argv) {
     ARGSD(permutecolors,        ": randomize the unique colors");
     ARGSD(randomizeRGB,         ": randomize the unique colors, across channels too");
     ARGSD(noisegaussian,        "sd : introduce white Gaussian noise (in range 0..255)");
+    ARGSP(blurboxes,            "n : for -blur, approximate the Gaussian using n box filters (e.g. 3; 0=exact)");
     ARGSD(blur,                 "r : apply Gaussian blurring with 1sdv = r pixels (e.g. 1.)");
     ARGSC("",                   ":");
     ARGSD(composite,            "op_name float back_image : blend");
@@ -3254,7 +3761,8 @@ int main(int argc, const char** argv) {
     ARGSD(tofmp,                "f.fmp : output (X, Y, Z) binary floating-point");
     string arg0 = args.num() ? args.peek_string() : "";
     if (!ParseArgs::special_arg(arg0) && arg0!="-nostdin" && arg0!="-create" && !begins_with(arg0, "-as") &&
-        arg0!="-fromtxt" && arg0!="-invideo") {
+        arg0!="-fromtxt" && arg0!="-invideo" && arg0!="-stream" && arg0!="-stream_rows" && arg0!="-batch" &&
+        arg0!="-batch_threads") {
         string filename = "-"; if (args.num() && (arg0=="-" || arg0[0]!='-')) filename = args.get_filename();
         image.read_file(filename);
     }
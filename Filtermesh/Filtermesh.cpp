@@ -3374,11 +3374,11 @@ void do_signeddistcontour(Args& args) {
         return signed_distance(p, f);
     };
     GMesh nmesh; {
-        Contour3DMesh<decltype(func_mesh_signed_distance)> contour(grid, &nmesh, func_mesh_signed_distance);
+        // func_mesh_signed_distance() only reads mesh and psp, so it is safe to evaluate concurrently.
+        Contour3DMeshParallel<decltype(func_mesh_signed_distance)> contour(grid, &nmesh, func_mesh_signed_distance);
         contour.set_ostream(&std::cout);
-        for (Vertex v : mesh.vertices()) {
-            contour.march_from(mesh.point(v));
-        }
+        Array<Vec3<float>> startps; for (Vertex v : mesh.vertices()) { startps.push(mesh.point(v)); }
+        contour.march_from(startps);
     }
     mesh.copy(nmesh);
 }
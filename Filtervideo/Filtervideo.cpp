@@ -21,6 +21,7 @@
 #include "MatrixOp.h"           // euclidean_distance_map()
 #include "ArrayOp.h"            // median()
 #include "GridPixelOp.h"        // spatially_scale_Grid3_Pixel()
+#include "GridOp.h"             // box_blur_d()
 using namespace hh;
 
 namespace {
@@ -38,6 +39,8 @@ int tradius = 0;                // was 4
 bool nooutput = false;
 int trunc_begin = 0;            // skip the first trunc_begin frames
 int trunc_frames = INT_MAX;      // read at most trunc_frames frames
+bool nostream = false;          // disable streaming of frame-local operations
+int blurboxes = 3;              // number of box filters approximating the Gaussian in -blur
 
 // ********
 
@@ -75,32 +78,35 @@ int parse_size(string s, int size, bool measure_neg_from_end) {
     return i;
 }
 
-int parse_nframes(string s, bool measure_neg_from_end) {
+int parse_nframes(string s, bool measure_neg_from_end, int nframes, double framerate) {
     assertx(s!="");
     bool is_neg = remove_at_beginning(s, "-"); assertx(s[0]!='-');
     int i;
     if (remove_at_end(s, "sec") || remove_at_end(s, "s")) {
         float v = Args::parse_float(s);
-        assertx(video.attrib().framerate);
-        i = int(v*video.attrib().framerate+.5);
+        assertx(framerate);
+        i = int(v*framerate+.5);
     } else if (remove_at_end(s, "%")) {
         float v = Args::parse_float(s);
-        i = int(v*.01f*video.nframes()+.5f);
+        i = int(v*.01f*nframes+.5f);
     } else {
         i = Args::parse_int(s);
     }
     assertx(i>=0);
     if (is_neg) {
-        if (measure_neg_from_end) i = assertx(video.nframes())-i;
+        if (measure_neg_from_end) i = assertx(nframes)-i;
         else i = -i;
     }
     return i;
 }
 
-void read_video(const string& filename, bool use_nv12) {
+int parse_nframes(const string& s, bool measure_neg_from_end) {
+    return parse_nframes(s, measure_neg_from_end, video.nframes(), video.attrib().framerate);
+}
+
+void read_video(RVideo& rvideo, bool use_nv12) {
     // Similar code in: Video::read_file(), VideoNv12::read_file(), and FilterVideo.cpp::read_video().
     HH_TIMER(_read_video);
-    RVideo rvideo(filename, use_nv12);
     showf("Reading video %s\n", Video::diagnostic_string(rvideo.dims(), rvideo.attrib()).c_str());
     const int nfexpect = rvideo.nframes()-trunc_begin;
     const int nf_read_expect = max(min(nfexpect, trunc_frames), 0);
@@ -141,6 +147,11 @@ void read_video(const string& filename, bool use_nv12) {
     else video.special_reduce_dim0(nftruncread);
 }
 
+void read_video(const string& filename, bool use_nv12) {
+    RVideo rvideo(filename, use_nv12);
+    read_video(rvideo, use_nv12);
+}
+
 // ***
 
 void do_nostdin(Args& args) {
@@ -167,6 +178,11 @@ void do_readnv12(Args& args) {
     read_video(filename, true);
 }
 
+void do_nostream(Args& args) {
+    dummy_use(args);
+    assertnever("should have been caught in main()");
+}
+
 void do_trunc_begin(Args& args) {
     dummy_use(args);
     assertnever("should have been caught in main()");
@@ -624,6 +640,21 @@ void do_phaseoffset(Args& args) {
     video = std::move(nvideo);
 }
 
+// Linear blend of two frames, giving weight alpha to frame1.
+void blend_frames(CMatrixView<Pixel> frame0, CMatrixView<Pixel> frame1, float alpha, MatrixView<Pixel> nframe) {
+    assertx(same_size(frame0, frame1) && same_size(frame0, nframe));
+    for_int(y, frame0.ysize()) for_int(x, frame0.xsize()) {
+        for_int(z, nz) {
+            nframe(y, x)[z] = uchar((1.f-alpha)*frame0(y, x)[z]+
+                                    (    alpha)*frame1(y, x)[z]+.5f);
+        }
+        nframe(y, x)[3] = 255;
+    }
+}
+
+// Weight given to the end frame at index i of the 2*radius crossfaded frames.
+float crossfade_alpha(int i, int radius) { return 1.f-.5f*(i+.5f)/radius; }
+
 void do_tcrossfade(Args& args) {
     HH_TIMER(_tcrossfade);
     int fbeg = parse_nframes(args.get_string(), true);
@@ -636,24 +667,11 @@ void do_tcrossfade(Args& args) {
         int fb = fbeg-tradius+i;
         int fe = fend-tradius+i;
         int fdst = fb>=fbeg ? fb : fe;
-        float alpha = 1.f-.5f*(i+.5f)/tradius; // weight given to end frame fe
+        float alpha = crossfade_alpha(i, tradius); // weight given to end frame fe
         if (0) showf("alpha=%.4f fb=%-3d fe=%-3d fdst=%-3d\n", alpha, fb, fe, fdst);
         int fbc = clamp(fb, 0, nframes-1);
         int fec = clamp(fe, 0, nframes-1);
-        if (1) {                // good code always
-            for_int(y, video.ysize()) for_int(x, video.xsize()) for_int(z, nz) {
-                tvideo(i, y, x)[z] = uchar((1.f-alpha)*video(fbc, y, x)[z]+
-                                           (    alpha)*video(fec, y, x)[z]+.5f);
-            }
-        } else {                // good code with gcc
-            auto videofbc = video[fbc], videofec = video[fbc];
-            for (const auto& yx : range(video.spatial_dims())) {
-                for_int(z, nz) {
-                    tvideo[i][yx][z] = uchar((1.f-alpha)*videofbc[yx][z]+
-                                             (    alpha)*videofec[yx][z]+.5f);
-                }
-            }
-        }
+        blend_frames(video[fbc], video[fec], alpha, tvideo[i]);
     });
     parallel_for_each(range(tradius), [&](const int i) { video[fbeg+i].assign(tvideo[tradius+i]); });
     parallel_for_each(range(tradius), [&](const int i) { video[fend-tradius+i].assign(tvideo[i]); });
@@ -780,92 +798,90 @@ void do_boundaryrule(Args& args) {
     filterb.set_bndrule(bndrule);
 }
 
-void do_cropsides(Args& args) {
-    int vl = parse_size(args.get_string(), video.xsize(), false);
-    int vr = parse_size(args.get_string(), video.xsize(), false);
-    int vt = parse_size(args.get_string(), video.ysize(), false);
-    int vb = parse_size(args.get_string(), video.ysize(), false);
-    Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, V(0, vt, vl), V(0, vb, vr), thrice(bndrule), &gcolor);
+// Parse the arguments of crop operation op on frames of dimensions sdims; ret: false if op is not a crop.
+bool parse_crop(const string& op, Args& args, const Vec2<int>& sdims, Vec2<int>& dL, Vec2<int>& dU) {
+    const int ny = sdims[0], nx = sdims[1];
+    dL = dU = twice(0);
+    if (op=="-cropsides") {
+        int vl = parse_size(args.get_string(), nx, false);
+        int vr = parse_size(args.get_string(), nx, false);
+        int vt = parse_size(args.get_string(), ny, false);
+        int vb = parse_size(args.get_string(), ny, false);
+        dL = V(vt, vl); dU = V(vb, vr);
+    } else if (op=="-cropl") {
+        dL[1] = parse_size(args.get_string(), nx, false);
+    } else if (op=="-cropr") {
+        dU[1] = parse_size(args.get_string(), nx, false);
+    } else if (op=="-cropt") {
+        dL[0] = parse_size(args.get_string(), ny, false);
+    } else if (op=="-cropb") {
+        dU[0] = parse_size(args.get_string(), ny, false);
+    } else if (op=="-cropall") {
+        int v = ny==nx ? parse_size(args.get_string(), ny, false) : args.get_int();
+        dL = dU = twice(v);
+    } else if (op=="-cropsquare") {
+        int x = parse_size(args.get_string(), nx, true);
+        int y = parse_size(args.get_string(), ny, true);
+        int s = ny==nx ? parse_size(args.get_string(), ny, false) : args.get_int();
+        const int y0 = y-s/2, x0 = x-s/2;
+        dL = V(y0, x0); dU = V(ny-y0-s, nx-x0-s);
+    } else if (op=="-croprectangle") {
+        int x = parse_size(args.get_string(), nx, true);
+        int y = parse_size(args.get_string(), ny, true);
+        int sx = parse_size(args.get_string(), nx, false);
+        int sy = parse_size(args.get_string(), ny, false);
+        int y0 = y-sy/2, x0 = x-sx/2;
+        dL = V(y0, x0); dU = V(ny-y0-sy, nx-x0-sx);
+    } else if (op=="-cropcoord") {
+        int x0 = parse_size(args.get_string(), nx, true);
+        int y0 = parse_size(args.get_string(), ny, true);
+        int x1 = parse_size(args.get_string(), nx, true);
+        int y1 = parse_size(args.get_string(), ny, true);
+        dL = V(y0, x0); dU = V(ny-y1, nx-x1);
+    } else if (op=="-croptodims") {
+        int x = args.get_int(), y = args.get_int(); assertx(x>0 && y>0);
+        auto ndims = V(y, x);
+        dL = (sdims-ndims)/2;
+        dU = sdims-ndims-dL;
+    } else if (op=="-cropmult") {
+        int fac = args.get_int();
+        assertx(fac>=1);
+        auto ndims = (sdims+(fac-1))/fac*fac;
+        dL = (sdims-ndims)/2;
+        dU = sdims-ndims-dL;
+    } else {
+        return false;
+    }
+    return true;
 }
 
-void do_cropl(Args& args) {
-    int v = parse_size(args.get_string(), video.xsize(), false);
+void apply_crop(const string& op, Args& args) {
+    Vec2<int> dL, dU; assertx(parse_crop(op, args, video.spatial_dims(), dL, dU));
     Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, V(0, 0, v), V(0, 0, 0), thrice(bndrule), &gcolor);
+    grid = hh::crop(grid, concat(V(0), dL), concat(V(0), dU), thrice(bndrule), &gcolor);
 }
 
-void do_cropr(Args& args) {
-    int v = parse_size(args.get_string(), video.xsize(), false);
-    Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, V(0, 0, 0), V(0, 0, v), thrice(bndrule), &gcolor);
-}
+void do_cropsides(Args& args) { apply_crop("-cropsides", args); }
 
-void do_cropt(Args& args) {
-    int v = parse_size(args.get_string(), video.ysize(), false);
-    Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, V(0, v, 0), V(0, 0, 0), thrice(bndrule), &gcolor);
-}
+void do_cropl(Args& args) { apply_crop("-cropl", args); }
 
-void do_cropb(Args& args) {
-    int v = parse_size(args.get_string(), video.ysize(), false);
-    Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, V(0, 0, 0), V(0, v, 0), thrice(bndrule), &gcolor);
-}
+void do_cropr(Args& args) { apply_crop("-cropr", args); }
 
-void do_cropall(Args& args) {
-    int v = video.ysize()==video.xsize() ? parse_size(args.get_string(), video.ysize(), false) : args.get_int();
-    Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, V(0, v, v), V(0, v, v), thrice(bndrule), &gcolor);
-}
+void do_cropt(Args& args) { apply_crop("-cropt", args); }
 
-void do_cropsquare(Args& args) {
-    int x = parse_size(args.get_string(), video.xsize(), true);
-    int y = parse_size(args.get_string(), video.ysize(), true);
-    int s = video.ysize()==video.xsize() ? parse_size(args.get_string(), video.ysize(), false) : args.get_int();
-    const int y0 = y-s/2, x0 = x-s/2;
-    Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, V(0, y0, x0), V(0, video.ysize()-y0-s, video.xsize()-x0-s), thrice(bndrule), &gcolor);
-}
+void do_cropb(Args& args) { apply_crop("-cropb", args); }
 
-void do_croprectangle(Args& args) {
-    int x = parse_size(args.get_string(), video.xsize(), true);
-    int y = parse_size(args.get_string(), video.ysize(), true);
-    int sx = parse_size(args.get_string(), video.xsize(), false);
-    int sy = parse_size(args.get_string(), video.ysize(), false);
-    int y0 = y-sy/2, x0 = x-sx/2;
-    Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, V(0, y0, x0), V(0, video.ysize()-y0-sy, video.xsize()-x0-sx), thrice(bndrule), &gcolor);
-}
+void do_cropall(Args& args) { apply_crop("-cropall", args); }
 
-void do_cropcoord(Args& args) {
-    int x0 = parse_size(args.get_string(), video.xsize(), true);
-    int y0 = parse_size(args.get_string(), video.ysize(), true);
-    int x1 = parse_size(args.get_string(), video.xsize(), true);
-    int y1 = parse_size(args.get_string(), video.ysize(), true);
-    Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, V(0, y0, x0), V(0, video.ysize()-y1, video.xsize()-x1), thrice(bndrule), &gcolor);
-}
+void do_cropsquare(Args& args) { apply_crop("-cropsquare", args); }
 
-void do_croptodims(Args& args) {
-    int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
-    auto ndims = V(ny, nx);
-    auto yx0 = (video.spatial_dims()-ndims)/2;
-    auto yx1 = video.spatial_dims()-ndims-yx0;
-    Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, concat(V(0), yx0), concat(V(0), yx1), thrice(bndrule), &gcolor);
-}
+void do_croprectangle(Args& args) { apply_crop("-croprectangle", args); }
 
-void do_cropmult(Args& args) {
-    int fac = args.get_int();
-    assertx(fac>=1);
-    auto ndims = (video.spatial_dims()+(fac-1))/fac*fac;
-    auto yx0 = (video.spatial_dims()-ndims)/2;
-    auto yx1 = video.spatial_dims()-ndims-yx0;
-    Grid<3,Pixel>& grid = video;
-    grid = hh::crop(grid, concat(V(0), yx0), concat(V(0), yx1), thrice(bndrule), &gcolor);
-}
+void do_cropcoord(Args& args) { apply_crop("-cropcoord", args); }
+
+void do_croptodims(Args& args) { apply_crop("-croptodims", args); }
 
+void do_cropmult(Args& args) { apply_crop("-cropmult", args); }
 
 // *** scale
 
@@ -873,75 +889,84 @@ void do_filter(Args& args) {
     filterb.set_filter(Filter::get(args.get_string()));
 }
 
-static void apply_scale(const Vec2<float>& v) {
-    video.scale(v, twice(filterb), &gcolor);
-    if (max(v)<1.f) {
-        video.attrib().bitrate = int(video.attrib().bitrate*pow(float(product(v)), .8f)+.5f);
-        showf("Reducing bitrate after scaling: %s\n", Video::diagnostic_string(video.dims(), video.attrib()).c_str());
+// Parse the arguments of scale operation op on frames of dimensions sdims; ret: false if op is not a scale.
+// Sets no_effect if the operation leaves the frames unchanged (-scaleifgtmax on small enough frames).
+bool parse_scale(const string& op, Args& args, const Vec2<int>& sdims, Vec2<float>& syx, bool& no_effect) {
+    no_effect = false;
+    if (op=="-scaleunif") {
+        float s = args.get_float();
+        syx = twice(s);
+    } else if (op=="-scalenonunif") {
+        float sx = args.get_float(), sy = args.get_float();
+        syx = V(sy, sx);
+    } else if (op=="-scaletox") {
+        int nx = parse_size(args.get_string(), sdims[1], false); assertx(nx>0);
+        syx = twice(float(nx)/assertx(sdims[1]));
+    } else if (op=="-scaletoy") {
+        int ny = parse_size(args.get_string(), sdims[0], false); assertx(ny>0);
+        syx = twice(float(ny)/assertx(sdims[0]));
+    } else if (op=="-scaleifgtmax") {
+        int n = args.get_int(); assertx(n>0);
+        int cn = max(sdims);
+        no_effect = cn<=n;
+        syx = no_effect ? twice(1.f) : twice(float(n)/assertx(cn));
+    } else if (op=="-scaletodims") {
+        int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
+        syx = convert<float>(V(ny, nx))/convert<float>(sdims);
+    } else if (op=="-scaleinside") {
+        int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
+        syx = twice(min(convert<float>(V(ny, nx))/convert<float>(sdims)));
+    } else {
+        return false;
     }
+    return true;
 }
 
-void do_scaleunif(Args& args) {
-    HH_TIMER(_scale);
-    float s = args.get_float();
-    apply_scale(twice(s));
+void reduce_bitrate_after_scale(Video::Attrib& attrib, const Vec2<float>& syx) {
+    if (max(syx)<1.f) attrib.bitrate = int(attrib.bitrate*pow(float(product(syx)), .8f)+.5f);
 }
 
-void do_scalenonunif(Args& args) {
+void apply_scale(const string& op, Args& args) {
     HH_TIMER(_scale);
-    float sx = args.get_float(), sy = args.get_float();
-    apply_scale(V(sy, sx));
+    Vec2<float> syx; bool no_effect; assertx(parse_scale(op, args, video.spatial_dims(), syx, no_effect));
+    if (no_effect) return;
+    video.scale(syx, twice(filterb), &gcolor);
+    if (max(syx)<1.f) {
+        reduce_bitrate_after_scale(video.attrib(), syx);
+        showf("Reducing bitrate after scaling: %s\n", Video::diagnostic_string(video.dims(), video.attrib()).c_str());
+    }
 }
 
-void do_scaletox(Args& args) {
-    HH_TIMER(_scale);
-    int nx = parse_size(args.get_string(), video.xsize(), false); assertx(nx>0);
-    float s = float(nx)/assertx(video.xsize());
-    apply_scale(twice(s));
-}
+void do_scaleunif(Args& args) { apply_scale("-scaleunif", args); }
 
-void do_scaletoy(Args& args) {
-    HH_TIMER(_scale);
-    int ny = parse_size(args.get_string(), video.ysize(), false); assertx(ny>0);
-    float s = float(ny)/assertx(video.ysize());
-    apply_scale(twice(s));
-}
+void do_scalenonunif(Args& args) { apply_scale("-scalenonunif", args); }
 
-void do_scaleifgtmax(Args& args) {
-    HH_TIMER(_scale);
-    int n = args.get_int(); assertx(n>0);
-    int cn = max(video.spatial_dims());
-    if (cn<=n) return;
-    apply_scale(twice(float(n)/assertx(cn)));
-}
+void do_scaletox(Args& args) { apply_scale("-scaletox", args); }
 
-void do_scaletodims(Args& args) {
-    HH_TIMER(_scale);
-    int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
-    auto syx = convert<float>(V(ny, nx))/convert<float>(video.spatial_dims());
-    apply_scale(syx);
-}
+void do_scaletoy(Args& args) { apply_scale("-scaletoy", args); }
 
-void do_scaleinside(Args& args) {
-    HH_TIMER(_scale);
-    int nx = args.get_int(), ny = args.get_int(); assertx(nx>0 && ny>0);
-    apply_scale(twice(min(convert<float>(V(ny, nx))/convert<float>(video.spatial_dims()))));
-}
+void do_scaleifgtmax(Args& args) { apply_scale("-scaleifgtmax", args); }
+
+void do_scaletodims(Args& args) { apply_scale("-scaletodims", args); }
+
+void do_scaleinside(Args& args) { apply_scale("-scaleinside", args); }
 
 // *** misc
 
+void flip_vertical(MatrixView<Pixel> frame) {
+    for_int(y, frame.ysize()/2) { swap_ranges(frame[y], frame[frame.ysize()-1-y]); }
+}
+
+void flip_horizontal(MatrixView<Pixel> frame) {
+    for_int(y, frame.ysize()) { reverse(frame[y]); }
+}
+
 void do_flipvertical() {
-    parallel_for_each(range(video.nframes()), [&](const int f) {
-        for_int(y, video.ysize()/2) {
-            swap_ranges(video[f][y], video[f][video.ysize()-1-y]);
-        }
-    });
+    parallel_for_each(range(video.nframes()), [&](const int f) { flip_vertical(video[f]); });
 }
 
 void do_fliphorizontal() {
-    parallel_for_each(range(video.nframes()), [&](const int f) {
-        for_int(y, video.ysize()) { reverse(video[f][y]); }
-    });
+    parallel_for_each(range(video.nframes()), [&](const int f) { flip_horizontal(video[f]); });
 }
 
 void do_disassemble(Args& args) {
@@ -1003,9 +1028,21 @@ void do_replace(Args& args) {
     showf("Replaced %d pixels\n", count);
 }
 
+// Spatially blur each frame, approximating a Gaussian with 1sdv = sdv_pixels using successive box filters.
+void do_blur(Args& args) {
+    const float sdv_pixels = args.get_float();
+    HH_TIMER(_blur);
+    for_intL(d, 1, 3) { video = box_blur_d(video, d, sdv_pixels, Bndrule::reflected, nullptr, blurboxes); }
+}
+
+Vec<uchar,256> gamma_table(float gamma) {
+    Vec<uchar,256> transf; for_int(i, 256) { transf[i] = static_cast<uchar>(255.f*pow(i/255.f, gamma)+0.5f); }
+    return transf;
+}
+
 void do_gamma(Args& args) {
     float gamma = args.get_float();
-    Vec<uchar,256> transf; for_int(i, 256) { transf[i] = static_cast<uchar>(255.f*pow(i/255.f, gamma)+0.5f); }
+    const Vec<uchar,256> transf = gamma_table(gamma);
     if (1) {
         parallel_for_each(range(video.size()), [&](const size_t i) {
             for_int(z, nz) { video.raster(i)[z] = transf[video.raster(i)[z]]; } // fastest
@@ -1988,24 +2025,31 @@ void do_diff(Args& args) {
     }, 20);
 }
 
+void apply_transf(ArrayView<Pixel> pixels, const Frame& frame) {
+    for (Pixel& pix : pixels) {
+        Point p(0.f, 0.f, 0.f); for_int(z, nz) { p[z] = pix[z]/255.f; }
+        p *= frame;
+        for_int(z, nz) { pix[z] = uchar(clamp(p[z], 0.f, 1.f)*255.f+.5f); }
+    }
+}
+
 void do_transf(Args& args) {
     Frame frame = FrameIO::parse_frame(args.get_string());
-    parallel_for_each(range(video.nframes()), [&](const int f) {
-        for (Pixel& pix : video[f]) {
-            Point p(0.f, 0.f, 0.f); for_int(z, nz) { p[z] = pix[z]/255.f; }
-            p *= frame;
-            for_int(z, nz) { pix[z] = uchar(clamp(p[z], 0.f, 1.f)*255.f+.5f); }
-        }
-    });
+    parallel_for_each(range(video.nframes()), [&](const int f) { apply_transf(video[f].array_view(), frame); });
 }
 
-void do_noisegaussian(Args& args) {
-    float sd = args.get_float();
-    for (Pixel& pix : video) {
+// Uses the global random sequence in raster order, so the result is the same whether frames are streamed or not.
+void add_gaussian_noise(ArrayView<Pixel> pixels, float sd) {
+    for (Pixel& pix : pixels) {
         for_int(z, nz) { pix[z] = clamp_to_uchar(int(to_float(pix[z])+Random::G.gauss()*sd+.5f)); }
     }
 }
 
+void do_noisegaussian(Args& args) {
+    float sd = args.get_float();
+    add_gaussian_noise(video.array_view(), sd);
+}
+
 Vector frame_median(CMatrixView<Pixel> frame) {
     Vector vmedian;
     Array<float> ar_tmp; ar_tmp.reserve(assert_narrow_cast<int>(product(frame.dims())));
@@ -2053,6 +2097,258 @@ void do_frameinfo() {
     }
 }
 
+// *** stream
+
+// When every operation is frame-local (or needs only a bounded window of frames, like -tcrossfade), the input video
+//  is streamed from RVideo through a chain of stages to WVideo, so memory use does not grow with the video length.
+
+// A stage of the stream receives frames in order and passes its resulting frames to the next stage.
+class StreamStage {
+ public:
+    virtual ~StreamStage()                      { }
+    void set_next(StreamStage* next)            { _next = next; }
+    virtual void put(Matrix<Pixel>&& frame)     { _next->put(std::move(frame)); }
+    virtual void finish()                       { _next->finish(); } // called after the last frame
+    virtual bool done() const                   { return _next->done(); } // true if further frames are unused
+ protected:
+    StreamStage* _next {nullptr};
+};
+
+// Apply an operation to each frame independently; the operation may change the frame dimensions.
+class FrameStage : public StreamStage {
+ public:
+    using Func = std::function<void(Matrix<Pixel>&)>;
+    explicit FrameStage(Func func)              : _func(std::move(func)) { }
+    void put(Matrix<Pixel>&& frame) override    { _func(frame); _next->put(std::move(frame)); }
+ private:
+    Func _func;
+};
+
+// Keep only the frames in the interval [f0, f1).
+class SelectStage : public StreamStage {
+ public:
+    SelectStage(int f0, int f1)                 : _f0(f0), _f1(f1) { }
+    void put(Matrix<Pixel>&& frame) override {
+        if (_f>=_f0 && _f<_f1) _next->put(std::move(frame));
+        _f++;
+    }
+    bool done() const override                 { return _f>=_f1 || _next->done(); }
+ private:
+    int _f0, _f1;
+    int _f {0};
+};
+
+// Same result as do_tcrossfade().  The frames [fbeg, fend+radius) are held until the last frame they blend with has
+//  arrived, so memory is proportional to the crossfade interval rather than to the video length.
+class CrossfadeStage : public StreamStage {
+ public:
+    CrossfadeStage(int fbeg, int fend, int radius) : _fbeg(fbeg), _fend(fend), _radius(radius), _pre(radius) { }
+    void put(Matrix<Pixel>&& frame) override {
+        const int f = _f++;
+        if (_released || f<_fbeg) {
+            if (!_released && f>=_fbeg-_radius) _pre[f-(_fbeg-_radius)] = frame;
+            _next->put(std::move(frame));
+            return;
+        }
+        _held.push(std::move(frame));
+        if (f==_fend+_radius-1) release();
+    }
+    void finish() override {
+        if (!_released) release();
+        _next->finish();
+    }
+ private:
+    int _fbeg, _fend, _radius;
+    Array<Matrix<Pixel>> _pre;  // copies of the frames [fbeg-radius, fbeg), which were already passed on
+    Array<Matrix<Pixel>> _held; // frames [fbeg, fend+radius)
+    int _f {0};                 // number of frames received
+    bool _released {false};
+    CMatrixView<Pixel> frame_at(int f) const {
+        f = clamp(f, 0, _f-1);
+        return f<_fbeg ? _pre[f-(_fbeg-_radius)] : _held[f-_fbeg];
+    }
+    void release() {
+        _released = true;
+        if (!_held.num()) return;
+        Array<Matrix<Pixel>> tframes(2*_radius);
+        parallel_for_each(range(2*_radius), [&](const int i) {
+            tframes[i].init(_held[0].dims());
+            blend_frames(frame_at(_fbeg-_radius+i), frame_at(_fend-_radius+i), crossfade_alpha(i, _radius), tframes[i]);
+        });
+        for_int(i, _radius) {
+            if (i<_held.num()) _held[i] = std::move(tframes[_radius+i]);
+            const int j = _fend-_radius+i-_fbeg;
+            if (j<_held.num()) _held[j] = std::move(tframes[i]);
+        }
+        for (Matrix<Pixel>& frame : _held) { _next->put(std::move(frame)); }
+        _held.clear(); _pre.clear();
+    }
+};
+
+// Write the frames to the output video on stdout; it is created with the dimensions of the first frame.
+class SinkStage : public StreamStage {
+ public:
+    explicit SinkStage(const Video::Attrib& attrib) : _attrib(attrib) { }
+    void put(Matrix<Pixel>&& frame) override {
+        if (!_pwvideo) _pwvideo = make_unique<WVideo>("-", frame.dims(), _attrib);
+        _pwvideo->write(frame);
+    }
+    void finish() override                      { _pwvideo = nullptr; }
+    bool done() const override                  { return false; }
+ private:
+    Video::Attrib _attrib;
+    unique_ptr<WVideo> _pwvideo;
+};
+
+// Try to process the video from rvideo with the operations in pargs in a streaming fashion.
+// ret: false if some operation is not frame-local, in which case nothing is read and the global state is unchanged.
+bool stream_video(RVideo& rvideo, ParseArgs& pargs) {
+    HH_TIMER(_stream);
+    ParseArgs args{Array<string>{""}}; args.copy_parse(pargs); // pargs is left intact for the in-memory fallback
+    const FilterBnd saved_filterb = filterb; const Bndrule saved_bndrule = bndrule;
+    const Pixel saved_gcolor = gcolor; const int saved_tradius = tradius; const int saved_blurboxes = blurboxes;
+    auto restore = [&] {
+        filterb = saved_filterb; bndrule = saved_bndrule; gcolor = saved_gcolor; tradius = saved_tradius;
+        blurboxes = saved_blurboxes;
+    };
+    // The global video holds no frames in this mode; its attributes are those of the stream (and are anyway reset
+    //  by read_video() in the fallback).
+    Video::Attrib& attrib = video.attrib();
+    attrib = rvideo.attrib();
+    Vec2<int> sdims = rvideo.spatial_dims();
+    int nframes = rvideo.nframes(); // estimated from the video duration
+    Array<unique_ptr<StreamStage>> stages;
+    bool clear_audio = false;
+    Array<string> messages;     // shown only if the video is streamed
+    auto add_frame_op = [&](FrameStage::Func func) { stages.push(make_unique<FrameStage>(std::move(func))); };
+    auto select = [&](int f0, int f1) {
+        stages.push(make_unique<SelectStage>(f0, f1));
+        if (f0>0 || f1<nframes) clear_audio = true;
+        nframes = max(min(f1, nframes)-f0, 0);
+    };
+    if (trunc_begin || trunc_frames!=INT_MAX) {
+        select(trunc_begin, trunc_frames==INT_MAX ? INT_MAX : trunc_begin+trunc_frames);
+    }
+    while (args.num()) {
+        string op = args.option_name(args.get_string()); // e.g. "-scaleu" becomes "-scaleunif"
+        Vec2<int> dL, dU; Vec2<float> syx; bool no_effect;
+        if (op=="-filter") {
+            do_filter(args);
+        } else if (op=="-boundaryrule") {
+            do_boundaryrule(args);
+        } else if (op=="-color") {
+            do_color(args);
+        } else if (op=="-tradius") {
+            tradius = args.get_int();
+        } else if (op=="-blurboxes") {
+            blurboxes = args.get_int();
+        } else if (op=="-framerate") {
+            do_framerate(args);
+        } else if (op=="-bitrate") {
+            do_bitrate(args);
+        } else if (op=="-bpp") {
+            float bpp = args.get_float(); assertx(bpp>0.f);
+            attrib.bitrate = int(bpp*product(sdims)+.5f);
+        } else if (op=="-to") {
+            do_to(args);
+        } else if (op=="-noaudio") {
+            do_noaudio();
+        } else if (op=="-gamma") {
+            const Vec<uchar,256> transf = gamma_table(args.get_float());
+            add_frame_op([transf](Matrix<Pixel>& frame) {
+                parallel_for_each(range(frame.size()), [&](const size_t i) {
+                    for_int(z, nz) { frame.raster(i)[z] = transf[frame.raster(i)[z]]; }
+                }, 10);
+            });
+        } else if (op=="-blur") {
+            const float sdv_pixels = args.get_float();
+            const int nboxes = blurboxes;
+            add_frame_op([sdv_pixels, nboxes](Matrix<Pixel>& frame) {
+                for_int(d, 2) { frame = box_blur_d(frame, d, sdv_pixels, Bndrule::reflected, nullptr, nboxes); }
+            });
+        } else if (op=="-transf") {
+            Frame tframe = FrameIO::parse_frame(args.get_string());
+            add_frame_op([tframe](Matrix<Pixel>& frame) {
+                parallel_for_each(range(frame.ysize()), [&](const int y) { apply_transf(frame[y], tframe); });
+            });
+        } else if (op=="-noisegaussian") {
+            float sd = args.get_float();
+            add_frame_op([sd](Matrix<Pixel>& frame) { add_gaussian_noise(frame.array_view(), sd); });
+        } else if (op=="-flipvertical") {
+            add_frame_op([](Matrix<Pixel>& frame) { flip_vertical(frame); });
+        } else if (op=="-fliphorizontal") {
+            add_frame_op([](Matrix<Pixel>& frame) { flip_horizontal(frame); });
+        } else if (parse_crop(op, args, sdims, dL, dU)) {
+            const Vec2<Bndrule> bndrules = twice(bndrule); const Pixel color = gcolor;
+            add_frame_op([dL, dU, bndrules, color](Matrix<Pixel>& frame) {
+                Grid<2,Pixel>& grid = frame;
+                grid = hh::crop(grid, dL, dU, bndrules, &color);
+            });
+            sdims = sdims-dL-dU;
+        } else if (parse_scale(op, args, sdims, syx, no_effect)) {
+            if (no_effect) continue;
+            Vec2<int> newdims = convert<int>(convert<float>(sdims)*syx+.5f); // as in hh::scale(const Video&, ...)
+            if (attrib.suffix!="avi") newdims = (newdims+1)/2*2; // make sizes be even integers
+            // Degenerate scales (e.g. "-scaleunif 0") are left to the in-memory path, which reports them.
+            if (!(min(syx)>0.f) || !product(newdims)) { restore(); return false; }
+            const Vec2<FilterBnd> filterbs = twice(filterb); const Pixel color = gcolor;
+            add_frame_op([newdims, filterbs, color](Matrix<Pixel>& frame) {
+                Matrix<Pixel> nframe(newdims);
+                scale_Matrix_Pixel(frame, filterbs, &color, nframe);
+                frame = std::move(nframe);
+            });
+            sdims = newdims;
+            if (max(syx)<1.f) {
+                reduce_bitrate_after_scale(attrib, syx);
+                messages.push("Reducing bitrate after scaling: " +
+                              Video::diagnostic_string(concat(V(nframes), sdims), attrib));
+            }
+        } else if (op=="-start" || op=="-end" || op=="-interval" || op=="-tcrossfade") {
+            // Positions relative to the video length ("-n" from the end, or "n%") would have to be resolved against
+            //  the estimated nframes rather than the frames actually decoded, so they are left to the in-memory path.
+            Array<string> positions; for_int(i, op=="-start" || op=="-end" ? 1 : 2) positions.push(args.get_string());
+            for (const string& s : positions) {
+                if (begins_with(s, "-") || ends_with(s, "%")) { restore(); return false; }
+            }
+            Array<int> fs; for (const string& s : positions) fs.push(parse_nframes(s, true, nframes, attrib.framerate));
+            if (op=="-start") {
+                if (fs[0]>0) select(fs[0], INT_MAX);
+            } else if (op=="-end") {
+                select(0, fs[0]); // no effect if the video has at most fs[0] frames
+            } else if (op=="-interval") {
+                select(fs[0], max(fs[1], fs[0]));
+            } else {
+                const int fbeg = fs[0], fend = fs[1];
+                assertx(tradius>0);
+                assertw(fbeg-tradius>=0 && fend+tradius<nframes); assertx(fbeg+tradius-1<fend-tradius);
+                stages.push(make_unique<CrossfadeStage>(fbeg, fend, tradius));
+            }
+        } else {
+            restore();
+            return false;
+        }
+    }
+    restore();
+    if (!product(sdims) || !nframes) return false;
+    showf("Streaming video %s\n", Video::diagnostic_string(rvideo.dims(), rvideo.attrib()).c_str());
+    for (const string& s : messages) showf("%s\n", s.c_str());
+    if (clear_audio && attrib.audio.size()) { Warning("Clearing audio"); attrib.audio.clear(); } // TODO
+    if (!attrib.framerate) { Warning("Video write: setting framerate to 30fps"); attrib.framerate = 30.; }
+    stages.push(make_unique<SinkStage>(attrib));
+    for_int(i, stages.num()-1) { stages[i]->set_next(stages[i+1].get()); }
+    {
+        ConsoleProgress cprogress("Vstream");
+        for (int f = 0; !stages[0]->done(); f++) {
+            if (rvideo.nframes()) cprogress.update(float(f)/rvideo.nframes());
+            Matrix<Pixel> frame(rvideo.spatial_dims());
+            if (!rvideo.read(frame)) break;
+            stages[0]->put(std::move(frame));
+        }
+    }
+    stages[0]->finish();
+    return true;
+}
+
 } // namespace
 
 int main(int argc, const char** argv) {
@@ -2062,6 +2358,7 @@ int main(int argc, const char** argv) {
     ARGSC("",                   ": (Video coordinates: (x=0, y=0) at left, top)");
     ARGSC("",                   ":A video is automatically read from stdin except with the following arguments:");
     ARGSD(nostdin,              ": do not attempt to read input video from stdin");
+    ARGSD(nostream,             ": read the whole video into memory even if all operations are frame-local");
     ARGSD(create,               "nframes width height : create video (default white)");
     ARGSD(readnv12,             "filename : read video into NV12 grids rather than RGB grid");
     ARGSD(trunc_begin,          "nframes : skip the first nframes frames");
@@ -2134,6 +2431,8 @@ int main(int argc, const char** argv) {
     ARGSC("",                   ":");
     ARGSD(replace,              "r g b : replace all pixels matching specified color with this color");
     ARGSD(gamma,                "v : gammawarp video");
+    ARGSP(blurboxes,            "n : number of box filters used by -blur (e.g. 3)");
+    ARGSD(blur,                 "r : spatially blur each frame, approximating a Gaussian with 1sdv = r pixels");
     ARGSC("",                   ":");
     ARGSD(loadpj,               "file.pj{o,r} : read progressive video project file");
     ARGSD(loadvlp,              "file.vlp : read progressive video project file");
@@ -2159,7 +2458,10 @@ int main(int argc, const char** argv) {
     ARGSD(equalizemedians,      ": shift image values at each frame to make frame medians identical");
     ARGSD(equalizemeans,        ": shift image values at each frame to make frame means identical");
     for (;; ) {
-        if (args.num()>=2 && args.peek_string()=="-trunc_begin") {
+        if (args.num()>=1 && args.peek_string()=="-nostream") {
+            args.get_string();
+            nostream = true;
+        } else if (args.num()>=2 && args.peek_string()=="-trunc_begin") {
             args.get_string();
             trunc_begin = args.get_int();
         } else if (args.num()>=2 && args.peek_string()=="-trunc_frames") {
@@ -2171,7 +2473,9 @@ int main(int argc, const char** argv) {
     if (!ParseArgs::special_arg(arg0) && arg0!="-nostdin" && arg0!="-create" && !begins_with(arg0, "-as") &&
         arg0!="-fromimages" && arg0!="-readnv12") {
         string filename = "-"; if (args.num() && (arg0=="-" || arg0[0]!='-')) filename = args.get_filename();
-        read_video(filename, false);
+        RVideo rvideo(filename);
+        if (!nostream && stream_video(rvideo, args)) return 0;
+        read_video(rvideo, false);
     }
     args.parse();
     if (!nooutput) {
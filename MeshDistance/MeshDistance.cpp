@@ -13,6 +13,9 @@
 #include "Timer.h"
 #include "MathOp.h"
 #include "RangeOp.h"
+#include "Map.h"
+#include "Parallel.h"
+#include "AtomicOperate.h"
 using namespace hh;
 
 namespace {
@@ -29,6 +32,7 @@ bool vertexpts = false;
 bool unitcube0 = false;
 bool unitdiag0 = true;
 bool maxerror = false;
+bool hausdorff = false;
 
 Array<GMesh> meshes;            // meshes to compare
 Frame xform;                    // space -> "small" unit cube around all meshes
@@ -72,55 +76,112 @@ struct PStats {
     }
 };
 
-void project_point(GMesh& meshs, const Point& ps, const A3dColor& pscol, const Vector& psnor,
-                   const GMesh& meshd, const PolygonFaceSpatial& psp, Vertex vv, PStats& pstats) {
-    SpatialSearch<PolygonFace*> ss(&psp, ps*xform);
-    PolygonFace* polyface = ss.next();
-    Face fd = polyface->face;
-    Array<Corner> cad = meshd.get_corners(fd);
-    Bary baryd;
-    {
-        Point clp;
-        float d2 = project_point_triangle2(ps,
-                                           meshd.point(meshd.corner_vertex(cad[0])),
-                                           meshd.point(meshd.corner_vertex(cad[1])),
-                                           meshd.point(meshd.corner_vertex(cad[2])),
-                                           baryd, clp);
-        pstats.Sgd2.enter(d2);
-        if (errmesh && vv) {
-            float g_K = 1000000.f*(1.0f/bbdiag);
-            float g_MK = 0.f;
-            if (0) g_MK = 75.f*(1.0f/bbdiag);
-            d2 = abs(d2);
-            float val = g_K*log(d2+1.f);
-            HH_SSTAT(Serrval, val);
-            // showdf("val %f first cut %f d2 %f\n", val, bbdiag/100, d2*100);
-            // if (val < 1.f)
-            if (val < bbdiag/100) {
-                meshs.update_string(vv, "rgb", sform("(%g %g %g)", 1.f, max(0.f, 1.f-val), max(0.f, 1.f-val)).c_str());
-            } else if (val < bbdiag/50) { // else if (val < 2.f)
-                meshs.update_string(vv, "rgb", sform("(%g %g %g)", 1.f, min(val-1.f, 1.f), 0.f).c_str());
-            } else {
-                // val = val - 2;
-                if (0) val /= g_MK;
-                meshs.update_string(vv, "rgb", sform("(%g %g %g)", max(0.f, 1.f-val), 0.f, 0.f).c_str());
-            }
+// Point sampled on a source mesh, to be projected onto a destination mesh.
+struct Sample {
+    Face f;                     // random point within face f, or
+    Bary bary;
+    Vertex v;                   // vertex (if v!=nullptr)
+};
+
+// Squared errors of a projected sample.
+struct SampleError {
+    float gd2;                  // geometric error
+    float cd2;                  // color error
+    float nd2;                  // normal error
+};
+
+// Faces of a destination mesh in a spatial structure (in the space of xform).
+struct MeshSpatial {
+    explicit MeshSpatial(const GMesh& mesh) : psp(psp_size(mesh)) {
+        HH_TIMER(_create_spatial);
+        ar_polyface.reserve(mesh.num_faces());
+        for (Face f : mesh.faces()) {
+            Polygon poly(3); mesh.polygon(f, poly); assertx(poly.num()==3);
+            for_int(i, poly.num()) { poly[i] *= xform; }
+            ar_polyface.push(PolygonFace(std::move(poly), f));
         }
+        for (PolygonFace& polyface : ar_polyface) { psp.enter(&polyface); }
     }
-    pstats.Scd2.enter(dist2(pscol, interp(c_color(cad[0]), c_color(cad[1]), c_color(cad[2]), baryd[0], baryd[1])));
-    pstats.Snd2.enter(dist2(psnor, interp(c_normal(cad[0]), c_normal(cad[1]), c_normal(cad[2]), baryd[0], baryd[1])));
+    static int psp_size(const GMesh& mesh) {
+        // return max(10, int(sqrt(float(mesh.num_vertices()))/5.f+.5f));
+        int size = (mesh.num_vertices()<20000 ? 25 :
+                    mesh.num_vertices()<30000 ? 32 :
+                    mesh.num_vertices()<100000 ? 40 :
+                    mesh.num_vertices()<300000 ? 70 :
+                    100);
+        return getenv_int("PSP_SIZE", size, true);
+    }
+    Array<PolygonFace> ar_polyface;
+    PolygonFaceSpatial psp;
+};
+
+Vec3<Corner> triangle_corners(const GMesh& mesh, Face f) {
+    Vec3<Corner> ca; int i = 0;
+    for (Corner c : mesh.corners(f)) { ca[i++] = c; }
+    assertx(i==3);
+    return ca;
 }
 
-void project_point(GMesh& meshs, Face fs, CArrayView<Corner> cas, const Bary& barys, const GMesh& meshd,
-                   const PolygonFaceSpatial& psp, Vertex vv, PStats& pstats) {
-    dummy_use(fs);
-    Point ps = interp(meshs.point(meshs.corner_vertex(cas[0])),
-                      meshs.point(meshs.corner_vertex(cas[1])),
-                      meshs.point(meshs.corner_vertex(cas[2])),
-                      barys[0], barys[1]);
-    A3dColor pscol = interp(c_color(cas[0]), c_color(cas[1]), c_color(cas[2]), barys[0], barys[1]);
-    Vector psnor = interp(c_normal(cas[0]), c_normal(cas[1]), c_normal(cas[2]), barys[0], barys[1]);
-    project_point(meshs, ps, pscol, psnor, meshd, psp, vv, pstats);
+Point sample_point(const GMesh& meshs, const Sample& sample) {
+    if (sample.v) return meshs.point(sample.v);
+    Vec3<Corner> cas = triangle_corners(meshs, sample.f);
+    return interp(meshs.point(meshs.corner_vertex(cas[0])),
+                  meshs.point(meshs.corner_vertex(cas[1])),
+                  meshs.point(meshs.corner_vertex(cas[2])),
+                  sample.bary[0], sample.bary[1]);
+}
+
+// Find the face of meshd closest to point ps, and its squared distance.
+Face closest_face(const Point& ps, const GMesh& meshd, const MeshSpatial& mspatial, Bary& baryd, float& d2) {
+    SpatialSearch<PolygonFace*> ss(&mspatial.psp, ps*xform);
+    Face fd = ss.next()->face;
+    Vec3<Corner> cad = triangle_corners(meshd, fd);
+    Vec3<Point> pts; for_int(i, 3) { pts[i] = meshd.point(meshd.corner_vertex(cad[i])); }
+    Point clp; d2 = project_point_triangle2(ps, pts[0], pts[1], pts[2], baryd, clp);
+    return fd;
+}
+
+// Project a sample of meshs onto meshd; thread-safe.
+SampleError project_sample(const GMesh& meshs, const Sample& sample, const GMesh& meshd,
+                           const MeshSpatial& mspatial) {
+    Point ps = sample_point(meshs, sample);
+    A3dColor pscol; Vector psnor;
+    if (sample.v) {             // works on mesh containing just isolated vertices
+        pscol = A3dColor(0.f, 0.f, 0.f);
+        psnor = v_normal(sample.v);
+    } else {
+        Vec3<Corner> cas = triangle_corners(meshs, sample.f);
+        const Bary& barys = sample.bary;
+        pscol = interp(c_color(cas[0]), c_color(cas[1]), c_color(cas[2]), barys[0], barys[1]);
+        psnor = interp(c_normal(cas[0]), c_normal(cas[1]), c_normal(cas[2]), barys[0], barys[1]);
+    }
+    SampleError error;
+    Bary baryd; Face fd = closest_face(ps, meshd, mspatial, baryd, error.gd2);
+    Vec3<Corner> cad = triangle_corners(meshd, fd);
+    error.cd2 = dist2(pscol, interp(c_color(cad[0]), c_color(cad[1]), c_color(cad[2]), baryd[0], baryd[1]));
+    error.nd2 = dist2(psnor, interp(c_normal(cad[0]), c_normal(cad[1]), c_normal(cad[2]), baryd[0], baryd[1]));
+    return error;
+}
+
+// Color vertex vv of meshs according to its squared distance d2 to the other mesh.
+void color_vertex_error(GMesh& meshs, Vertex vv, float d2) {
+    float g_K = 1000000.f*(1.0f/bbdiag);
+    float g_MK = 0.f;
+    if (0) g_MK = 75.f*(1.0f/bbdiag);
+    d2 = abs(d2);
+    float val = g_K*log(d2+1.f);
+    HH_SSTAT(Serrval, val);
+    // showdf("val %f first cut %f d2 %f\n", val, bbdiag/100, d2*100);
+    // if (val < 1.f)
+    if (val < bbdiag/100) {
+        meshs.update_string(vv, "rgb", sform("(%g %g %g)", 1.f, max(0.f, 1.f-val), max(0.f, 1.f-val)).c_str());
+    } else if (val < bbdiag/50) { // else if (val < 2.f)
+        meshs.update_string(vv, "rgb", sform("(%g %g %g)", 1.f, min(val-1.f, 1.f), 0.f).c_str());
+    } else {
+        // val = val - 2;
+        if (0) val /= g_MK;
+        meshs.update_string(vv, "rgb", sform("(%g %g %g)", max(0.f, 1.f-val), 0.f, 0.f).c_str());
+    }
 }
 
 void print_it(const string& s, const PStats& pstats) {
@@ -153,39 +214,11 @@ void print_it(const string& s, const PStats& pstats) {
     }
 }
 
-void compute_mesh_distance(GMesh& meshs, const GMesh& meshd, PStats& pastats) {
-
-    Bbox bb; bb.clear();
-    // compute the meshes bounding box
-    for (Face f : meshd.faces()) {
-        for (Vertex v : meshd.vertices(f)) {
-            bb.union_with(meshd.point(v));
-        }
-    }
-    bbdiag = mag(bb[0]-bb[1]);
-    // showdf("size of the diag %f\n", bbdiag);
-    // PolygonFaceSpatial psp(max(10, int(sqrt(float(meshd.num_vertices()))/5.f+.5f)));
-    int psp_size = (meshd.num_vertices()<20000 ? 25 :
-                    meshd.num_vertices()<30000 ? 32 :
-                    meshd.num_vertices()<100000 ? 40 :
-                    meshd.num_vertices()<300000 ? 70 :
-                    100);
-    psp_size = getenv_int("PSP_SIZE", psp_size, true);
-    Array<PolygonFace> ar_polyface; ar_polyface.reserve(meshd.num_faces());
-    PolygonFaceSpatial psp(psp_size);
-    {
-        HH_TIMER(_create_spatial);
-        for (Face fd : meshd.faces()) {
-            Polygon poly(3); meshd.polygon(fd, poly); assertx(poly.num()==3);
-            for_int(i, poly.num()) { poly[i] *= xform; }
-            ar_polyface.push(PolygonFace(std::move(poly), fd));
-        }
-        for (PolygonFace& polyface : ar_polyface) { psp.enter(&polyface); }
-    }
-    HH_TIMER(_sample_distances);
+// Sample points on meshs: numpts random points (drawn from Random::G), then its vertices if vertexpts (or if
+//  errmesh, to color the vertices of meshs).
+Array<Sample> sample_mesh(const GMesh& meshs, bool color_vertices, int& nrandom) {
+    Array<Sample> samples;
     if (numpts) {
-        PStats pstats;
-        // showdf("- random sampling of %d points\n", numpts);
         Array<Face> fface;      // Face of this index (nf)
         Array<float> fcarea;    // cumulative area (nf+1)
         {
@@ -197,42 +230,106 @@ void compute_mesh_distance(GMesh& meshs, const GMesh& meshd, PStats& pastats) {
             for_int(i, fface.num()) { fcarea[i] /= float(sum_area); }
             fcarea.push(1.00001f);
         }
-        Array<Corner> cas;
+        samples.reserve(numpts);
         for_int(i, numpts) {
             int fi = discrete_binary_search(fcarea, 0, fface.num(), Random::G.unif());
-            Face f = fface[fi];
-            cas = meshs.get_corners(f, std::move(cas));
             float a = Random::G.unif(), b = Random::G.unif();
             if (a+b>1.f) { a = 1.f-a; b = 1.f-b; }
-            Bary bary(a, b, 1.f-a-b);
-            project_point(meshs, f, cas, bary, meshd, psp, nullptr, pstats);
+            samples.push(Sample{fface[fi], Bary(a, b, 1.f-a-b), nullptr});
+        }
+    }
+    nrandom = samples.num();
+    if (vertexpts || color_vertices) {
+        for (Vertex v : meshs.vertices()) { samples.push(Sample{nullptr, Bary(0.f, 0.f, 0.f), v}); }
+    }
+    return samples;
+}
+
+float mesh_bbox_diag(const GMesh& mesh) {
+    Bbox bb; bb.clear();
+    for (Face f : mesh.faces()) {
+        for (Vertex v : mesh.vertices(f)) {
+            bb.union_with(mesh.point(v));
+        }
+    }
+    return mag(bb[0]-bb[1]);
+}
+
+// Accumulate the errors of the samples of meshs, in their original order.
+void accumulate_errors(GMesh& meshs, const GMesh& meshd, CArrayView<Sample> samples, int nrandom,
+                       CArrayView<SampleError> errors, PStats& pastats) {
+    bbdiag = mesh_bbox_diag(meshd);
+    // showdf("size of the diag %f\n", bbdiag);
+    auto accumulate = [&](int ib, int ie, PStats& pstats) {
+        for_intL(i, ib, ie) {
+            const SampleError& error = errors[i];
+            pstats.Sgd2.enter(error.gd2);
+            pstats.Scd2.enter(error.cd2);
+            pstats.Snd2.enter(error.nd2);
+            if (errmesh && samples[i].v) color_vertex_error(meshs, samples[i].v, error.gd2);
         }
+    };
+    if (numpts) {
+        PStats pstats;
+        accumulate(0, nrandom, pstats);
         if (verb>=2) print_it(" r", pstats);
         pastats.add(pstats);
     }
-    if (vertexpts) {
+    if (nrandom<samples.num()) {
         PStats pstats;
-        // showdf("- vertex sampling\n");
-        Array<Corner> cas;
-        for (Vertex v : meshs.vertices()) {
-            if (1) {            // works on mesh containing just isolated vertices
-                const Vector& psnor = v_normal(v);
-                const A3dColor pscol(0.f, 0.f, 0.f);
-                project_point(meshs, meshs.point(v), pscol, psnor, meshd, psp, v, pstats);
-            } else {
-                Face f = assertx(meshs.most_clw_face(v));
-                cas = meshs.get_corners(f, std::move(cas));
-                Bary bary(0.f, 0.f, 0.f);
-                int cai = cas.index(meshs.corner(v, f)); assertx(cai>=0);
-                bary[cai] = 1.f;
-                project_point(meshs, f, cas, bary, meshd, psp, v, pstats);
-            }
+        accumulate(nrandom, samples.num(), pstats);
+        if (vertexpts) {
+            if (verb>=2) print_it(" v", pstats);
+            pastats.add(pstats);
         }
-        if (verb>=2) print_it(" v", pstats);
-        pastats.add(pstats);
     }
 }
 
+// Maximum distance from the samples of meshs to meshd (one-sided Hausdorff distance).
+// Samples are traversed in chunks of nearby samples (ordered by face); a sample whose distance to the face of
+//  meshd closest to the previous sample is already below the current maximum cannot increase the maximum, so its
+//  search is skipped (early out).  The result is exact and independent of the order of evaluation.
+float hausdorff_distance(const GMesh& meshs, CArrayView<Sample> samples, const GMesh& meshd,
+                         const MeshSpatial& mspatial, int& nsearched) {
+    Array<int> order(samples.num()); for_int(i, order.num()) { order[i] = i; }
+    Map<Face,int> mfindex; for (Face f : meshs.faces()) { mfindex.enter(f, mfindex.num()); }
+    auto key = [&](int i) { return samples[i].v ? -1 : mfindex.get(samples[i].f); };
+    sort(order, [&](int i1, int i2) { int k1 = key(i1), k2 = key(i2); return k1<k2 || (k1==k2 && i1<i2); });
+    const int chunk_size = 1024;
+    const int nchunks = (samples.num()+chunk_size-1)/chunk_size;
+    volatile float max_d2 = 0.f;
+    Array<int> ar_nsearched(nchunks, 0);
+    parallel_for_each(range(nchunks), [&](const int ichunk) {
+        Face hintf = nullptr;
+        for_intL(j, ichunk*chunk_size, min((ichunk+1)*chunk_size, samples.num())) {
+            Point ps = sample_point(meshs, samples[order[j]]);
+            if (hintf) {
+                Vec3<Corner> cad = triangle_corners(meshd, hintf);
+                Bary bary; Point clp;
+                float d2 = project_point_triangle2(ps, meshd.point(meshd.corner_vertex(cad[0])),
+                                                   meshd.point(meshd.corner_vertex(cad[1])),
+                                                   meshd.point(meshd.corner_vertex(cad[2])), bary, clp);
+                if (d2<=max_d2) continue; // upper bound on distance cannot increase the maximum
+            }
+            Bary baryd; float d2;
+            hintf = closest_face(ps, meshd, mspatial, baryd, d2);
+            ar_nsearched[ichunk]++;
+            if (d2>max_d2) atomic_operate(&max_d2, [d2](float v) { return max(v, d2); });
+        }
+    }, chunk_size*2000);
+    nsearched = 0; for (int n : ar_nsearched) { nsearched += n; }
+    return max_d2;
+}
+
+void print_hausdorff(const string& s, int nsamples, float d2, int nsearched) {
+    float vg = my_sqrt(d2);
+    string sg = (unitcube0 ? sform("uLi=%%%#-10.4f", vg/g_side0*100.f) :
+                 unitdiag0 ? sform("dLi=%%%#-10.4f", vg/g_diag0*100.f) :
+                 sform(" Li=%#-10.5f", vg));
+    string ssearched = nsearched>=0 ? sform("  (searched %d samples)", nsearched) : "";
+    showdf("%s(%7d)  %s%s\n", s.c_str(), nsamples, sg.c_str(), ssearched.c_str());
+}
+
 void do_distance() {
     HH_TIMER(_distance);
     assertx(meshes.num()==2);
@@ -251,13 +348,41 @@ void do_distance() {
     g_side0 = bbox0.max_side();
     g_diag0 = dist(bbox0[0], bbox0[1]);
     numpts = int(maxnfaces*nptfac+.5f);
+    // Direction idir measures the distance from meshes[idir] to meshes[1-idir].
+    const int ndir = bothdir ? 2 : 1;
+    Array<unique_ptr<MeshSpatial>> mspatials(ndir);
+    for_int(idir, ndir) { mspatials[idir] = make_unique<MeshSpatial>(meshes[1-idir]); }
+    Vec2<Array<Sample>> samples;
+    Vec2<int> nrandom(0, 0);
+    for_int(idir, ndir) { samples[idir] = sample_mesh(meshes[idir], errmesh && !hausdorff && idir==0, nrandom[idir]); }
+    HH_TIMER(_sample_distances);
+    if (hausdorff) {
+        // The two directions are evaluated one after the other, each in parallel over chunks of samples.
+        float max_d2 = 0.f;
+        for_int(idir, ndir) {
+            int nsearched;
+            float d2 = hausdorff_distance(meshes[idir], samples[idir], meshes[1-idir], *mspatials[idir], nsearched);
+            if (!bothdir || verb>=2) print_hausdorff(sform(" %c", '0'+idir), samples[idir].num(), d2,
+                                                     verb>=2 ? nsearched : -1);
+            max_d2 = max(max_d2, d2);
+        }
+        if (bothdir) print_hausdorff(" B", samples[0].num()+samples[1].num(), max_d2, -1);
+        return;
+    }
+    // The samples of both directions are projected concurrently.
+    Vec2<Array<SampleError>> errors;
+    for_int(idir, ndir) { errors[idir].init(samples[idir].num()); }
+    const int n0 = samples[0].num();
+    parallel_for_each(range(n0+samples[1].num()), [&](const int i) {
+        const int idir = i<n0 ? 0 : 1, j = i<n0 ? i : i-n0;
+        errors[idir][j] = project_sample(meshes[idir], samples[idir][j], meshes[1-idir], *mspatials[idir]);
+    }, 5000);
     PStats pbstats;
-    for_int(idir, 2) {
+    for_int(idir, ndir) {
         PStats pastats;
-        if (!bothdir && idir==1) continue;
         if (bothdir && verb>=2)
             showdf("Distance mesh%d -> mesh%d\n", idir, 1-idir);
-        compute_mesh_distance(meshes[idir], meshes[1-idir], pastats);
+        accumulate_errors(meshes[idir], meshes[1-idir], samples[idir], nrandom[idir], errors[idir], pastats);
         pbstats.add(pastats);
         if (!bothdir || verb>=2) print_it(sform(" %c", '0'+idir), pastats);
     }
@@ -277,6 +402,7 @@ int main(int argc, const char** argv) {
     ARGSP(unitcube0,            "bool : normalize distance by mesh0 bbox side");
     ARGSP(unitdiag0,            "bool : normalize distance by mesh0 bbox diag");
     ARGSP(maxerror,             "bool : include Linf norm");
+    ARGSP(hausdorff,            "bool : only compute the Linf norm (Hausdorff distance), with early out");
     ARGSD(distance,             ": compute inter-mesh distances");
     HH_TIMER(MeshDistance);
     args.parse();
@@ -2,6 +2,7 @@
 #include "Args.h"
 #include "GMesh.h"
 #include "MeshOp.h"             // Vnors
+#include "MeshAttrib.h"
 #include "FileIO.h"
 #include "GeomOp.h"             // dihedral_angle_cos()
 #include "Bbox.h"
@@ -74,12 +75,12 @@ namespace {
 //
 //  Array<WedgeInfo> : 8*4     *1w/v == 32 bytes/vertex
 //
-//  pqecost: 5*4              *3e/v == 60 bytes/vertex
+//  pqecost: (2+1)*4          *3e/v == 36 bytes/vertex  (heap node + e_pqslot)
 //
 //  fptinfo: (13)*4          *3.0p/v == 156 bytes/vertex
 //  eptinfo: (5)*4           *1.5p/v == 30 bytes/vertex
 //
-//  Total so far: 826 bytes/vertex
+//  Total so far: 802 bytes/vertex
 //
 //  ?qem: (10)*4               *1q/v ==   40 bytes/vertex
 //
@@ -291,7 +292,9 @@ struct P2WedgeInfo {
 HH_SAC_ALLOCATE_FUNC(Mesh::MVertex, int, v_desn); // number of descendants
 HH_SAC_ALLOCATE_FUNC(Mesh::MVertex, int, v_desh); // height of descendant tree
 
-HH_SAC_ALLOCATE_FUNC(Mesh::MVertex, BoundingSphere, v_bsphere);
+// Bounding sphere of each vertex (only if bspherefac), kept in a side table rather than in every vertex.
+unique_ptr<VertexAttrib<BoundingSphere>> g_vbsphere;
+inline BoundingSphere& v_bsphere(Vertex v)      { return (*g_vbsphere)[v]; }
 
 HH_SAC_ALLOCATE_FUNC(Mesh::MVertex, bool, v_global); // vertex is feature
 
@@ -329,8 +332,15 @@ struct Param {
 
 constexpr float k_bad_dih = 1e20f;
 
-class LHPqueue : public HPqueue<Edge> {
-    using base = HPqueue<Edge>;
+HH_SACABLE(IPqueueSlot);
+HH_SAC_ALLOCATE_CD_FUNC(Mesh::MEdge, IPqueueSlot, e_pqslot); // index of edge in pqecost heap
+
+struct edge_pqslot {
+    int& operator()(Edge e) const               { return e_pqslot(e).index; }
+};
+
+class LHPqueue : public IPqueue<Edge, edge_pqslot> {
+    using base = IPqueue<Edge, edge_pqslot>;
  public:
     void clear()                                { _tot = 0.; _ntot = 0; base::clear(); }
     void enter(Edge e, float pri) {
@@ -358,6 +368,14 @@ class LHPqueue : public HPqueue<Edge> {
         if (pri<k_bad_dih) { _tot += pri; _ntot++; }
         return base::update(e, pri);
     }
+    void update_batch(CArrayView<std::pair<Edge, float>> updates) {
+        for (const auto& pair : updates) {
+            float opri = base::retrieve(pair.first); assertx(opri>=0.f);
+            if (opri<k_bad_dih) { _tot -= opri; --_ntot; }
+            if (pair.second<k_bad_dih) { _tot += pair.second; _ntot++; }
+        }
+        base::update_batch(updates);
+    }
     double total_priority() const               { return _tot; }
     int total_num() const                       { return _ntot; }
  private:
@@ -1203,6 +1221,7 @@ void parse_mesh() {
     }
     // Construct bounding spheres
     if (bspherefac) {
+        g_vbsphere = make_unique<VertexAttrib<BoundingSphere>>(mesh);
         Bbox bbox;
         for (Vertex v : mesh.vertices()) {
             bbox[0] = bbox[1] = mesh.point(v);
@@ -4497,12 +4516,14 @@ void optimize() {
             }
         }
         SSTATV2(Serecompute, seterecompute.num());
+        Array<std::pair<Edge, float>> ar_updates; ar_updates.reserve(seterecompute.num());
         for (Edge ee : seterecompute) {
             float cost1; int dummy_min_ii; Vertex dummy_vs;
             try_ecol(ee, false, cost1, dummy_min_ii, dummy_vs);
-            pqecost.update(ee, cost1);
+            ar_updates.push(std::make_pair(ee, cost1));
             neval++;
         }
+        pqecost.update_batch(ar_updates);
     }
     cprogress.clear();
     if (verb>=2)
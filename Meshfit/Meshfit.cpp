@@ -19,6 +19,7 @@
 #include "Polygon.h"
 #include "Stat.h"
 #include "MeshSearch.h"
+#include "Parallel.h"
 #include "LLS.h"
 #include "BinarySearch.h"
 #include "RangeOp.h"
@@ -117,6 +118,7 @@ float fliter = 1.f;
 float crep = 1e-5f;
 float crbf = 3.f;
 bool boundaryfixed = false;
+bool concurrentstoc = false;    // in stoc, evaluate candidate operations on disjoint neighborhoods concurrently
 bool nooutput = false;
 int verb = 1;
 float feswaasym = .01f;
@@ -382,38 +384,14 @@ float project_point_neighb(const Point& p, Face& cf, Bary& ret_bary, Point& ret_
 }
 
 void global_project_aux() {
+    // The points are projected concurrently; each search has its own state.
+    Array<Face> ar_face(pt.co.num());
     if (!have_quads) {
         MeshSearch msearch(&mesh, false);
-        if (1) {
-            Face hintf = nullptr;
-            for_int(i, pt.co.num()) {
-                Bary bary; Point clp; float d2;
-                Face f = msearch.search(pt.co[i], hintf, bary, clp, d2);
-                hintf = f;
-                point_change_face(i, f);
-                pt.clp[i] = clp;
-            }
-        } else {                // TODO: parallel; it crashes?
-            // c:\hh\src\libhh\hh.cpp(143): hh::`anonymous namespace'::show_call_stack
-            // c:\hh\src\libhh\hh.cpp(236): hh::`anonymous namespace'::my_top_level_exception_filter
-            // c:\hh\src\libhh\spatial.h(190): hh::ObjectSpatial<hh::details::polygonface_approx_distance2,hh::details::polygonface_distance2>::add_cell
-            // c:\hh\src\libhh\spatial.cpp(105): hh::BSpatialSearch::BSpatialSearch
-            // c:\hh\src\libhh\meshsearch.cpp(126): hh::MeshSearch::search
-            // c:\hh\src\meshfit\meshfit.cpp(365): `anonymous namespace'::global_project_aux$omp$1
-            //  why does gfit not change geometry significantly?
-            //  is it possible to remove FORCE_GLOBAL_PROJECT ?
-            //  try fgfit?
-            Array<Face> ar_face(pt.co.num()); Array<Point> ar_clp(pt.co.num());
-            parallel_for_each(range(pt.co.num()), [&](const int i) {
-                Bary bary; float d2;
-                Face hintf = pt.cmf[i]; // different semantics now
-                ar_face[i] = msearch.search(pt.co[i], hintf, bary, ar_clp[i], d2);
-            });
-            for_int(i, pt.co.num()) {
-                point_change_face(i, ar_face[i]);
-                pt.clp[i] = ar_clp[i];
-            }
-        }
+        parallel_for_each(range(pt.co.num()), [&](const int i) {
+            Bary bary; float d2;
+            ar_face[i] = msearch.search(pt.co[i], nullptr, bary, pt.clp[i], d2);
+        }, 5000);
     } else {
         const int nv = mesh.num_vertices();
         Array<PolygonFace> ar_polyface;
@@ -433,26 +411,33 @@ void global_project_aux() {
         }
         PolygonFaceSpatial psp(nv<10000 ? 15 : nv<30000 ? 25 : 35);
         for (PolygonFace& polyface : ar_polyface) { psp.enter(&polyface); }
-        for_int(i, pt.co.num()) {
+        parallel_for_each(range(pt.co.num()), [&](const int i) {
             SpatialSearch<PolygonFace*> ss(&psp, pt.co[i]);
             PolygonFace* polyface = ss.next();
-            Face f = polyface->face;
-            point_change_face(i, f);
-            project_point(pt.co[i], f, dummy_bary, pt.clp[i]);
-        }
+            ar_face[i] = polyface->face;
+            Bary bary; project_point(pt.co[i], ar_face[i], bary, pt.clp[i]);
+        }, 5000);
     }
+    for_int(i, pt.co.num()) { point_change_face(i, ar_face[i]); }
 }
 
 void local_project_aux() {
-    for_int(i, pt.co.num()) {
-        Face cf = pt.cmf[i];
+    // Traverse the points grouped by their current face, so that each thread projects points onto nearby faces.
+    Array<int> ar_pts; ar_pts.reserve(pt.co.num());
+    for (Face f : mesh.faces()) { push_face_points(f, ar_pts); }
+    assertx(ar_pts.num()==pt.co.num());
+    Array<Face> ar_face(pt.co.num());
+    parallel_for_each(range(ar_pts.num()), [&](const int i) {
+        const int pi = ar_pts[i];
+        Face cf = pt.cmf[pi]; Bary bary;
         if (restrictfproject) {
-            project_point(pt.co[i], cf, dummy_bary, pt.clp[i]);
+            project_point(pt.co[pi], cf, bary, pt.clp[pi]);
         } else {
-            project_point_neighb(pt.co[i], cf, dummy_bary, pt.clp[i]);
+            project_point_neighb(pt.co[pi], cf, bary, pt.clp[pi]);
         }
-        point_change_face(i, cf);
-    }
+        ar_face[pi] = cf;
+    }, 2000);
+    for_int(i, pt.co.num()) { point_change_face(i, ar_face[i]); }
 }
 
 void global_project() {
@@ -789,30 +774,36 @@ void reproject_locally(CArrayView<int> ar_pts, CArrayView<Face> ar_faces) {
         Bbox& bb = ar_bb[i]; bb.clear();
         for (Vertex v : mesh.vertices(f)) { bb.union_with(mesh.point(v)); }
     }
-    Polygon poly;
-    for (int pi : ar_pts) {
-        const Point& p = pt.co[pi];
-        static Array<float> ar_d2; ar_d2.init(nf);
-        for_int(i, nf) {
-            ar_d2[i] = square(lb_dist_point_bbox(p, ar_bb[i]));
-        }
-        float mind2 = BIGFLOAT; Face minf = nullptr;
-        for (;;) {
-            int tmini; float tmind2 = min_index(ar_d2, &tmini);
-            if (tmind2==BIGFLOAT) break; // ok, no more triangles to consider
-            if (tmind2>=mind2) break;
-            ar_d2[tmini] = BIGFLOAT;
-            Face f = ar_faces[tmini];
-            mesh.polygon(f, poly); assertx(poly.num()==3);
-            Point clp;
-            float d2 = project_point_triangle2(p, poly[0], poly[1], poly[2], dummy_bary, clp);
-            if (d2<mind2) {
-                mind2 = d2; minf = f; pt.clp[pi] = clp;
+    // The points are projected concurrently in chunks; the faces are reassigned afterwards in order.
+    Array<Face> ar_minf(ar_pts.num());
+    const int chunk = 64;
+    parallel_for_each(range((ar_pts.num()+chunk-1)/chunk), [&](const int ichunk) {
+        Polygon poly;
+        Array<float> ar_d2(nf);
+        for_intL(i, ichunk*chunk, min((ichunk+1)*chunk, ar_pts.num())) {
+            const int pi = ar_pts[i];
+            const Point& p = pt.co[pi];
+            for_int(j, nf) {
+                ar_d2[j] = square(lb_dist_point_bbox(p, ar_bb[j]));
             }
+            float mind2 = BIGFLOAT; Face minf = nullptr;
+            for (;;) {
+                int tmini; float tmind2 = min_index(ar_d2, &tmini);
+                if (tmind2==BIGFLOAT) break; // ok, no more triangles to consider
+                if (tmind2>=mind2) break;
+                ar_d2[tmini] = BIGFLOAT;
+                Face f = ar_faces[tmini];
+                mesh.polygon(f, poly); assertx(poly.num()==3);
+                Bary bary; Point clp;
+                float d2 = project_point_triangle2(p, poly[0], poly[1], poly[2], bary, clp);
+                if (d2<mind2) {
+                    mind2 = d2; minf = f; pt.clp[pi] = clp;
+                }
+            }
+            ar_minf[i] = assertx(minf);
         }
-        assertx(minf);
-        point_change_face(pi, minf);
-    }
+    }, chunk*nf*200);
+    for_int(i, ar_pts.num()) { point_change_face(ar_pts[i], ar_minf[i]); }
 }
 
 // Fit a set of points to a ring of vertices while optimizing the center
@@ -835,8 +826,9 @@ void local_fit(CArrayView<int> ar_pts, CArrayView<const Point*> wa,
     bool closed = wa[0]==wa[nw-1];
     float sqrtit = sqrt(spring), sqrtbt = sqrt(spring*spbf);
     double rss1; dummy_init(rss1);
+    Array<Bbox> ar_bb(nw-1);
+    Array<float> ar_d2(nw-1);
     for_int(ni, niter) {
-        static Array<Bbox> ar_bb; ar_bb.init(nw-1);
         for_int(i, nw-1) {
             Bbox& bb = ar_bb[i]; bb.clear();
             bb.union_with(newp); bb.union_with(*wa[i]); bb.union_with(*wa[i+1]);
@@ -845,7 +837,6 @@ void local_fit(CArrayView<int> ar_pts, CArrayView<const Point*> wa,
         for (int pi : ar_pts) {
             // HH_SSTAT(SLFconsid, nw-1);
             const Point& p = pt.co[pi];
-            static Array<float> ar_d2; ar_d2.init(nw-1);
             for_int(i, nw-1) {
                 // ar_d2[i] = square(lb_dist_point_triangle(p, newp, *wa[i], *wa[i+1]));
                 ar_d2[i] = square(lb_dist_point_bbox(p, ar_bb[i]));
@@ -1021,8 +1012,22 @@ int vertex_num_sharp_edges(Vertex v) {
     return nsharpe;
 }
 
-EResult try_ecol(Edge e, int ni, int nri, float& edrss) {
-    HH_STIMER(__try_ecol);
+// A candidate operation on an edge.  It is first evaluated without modifying the mesh, so that operations whose
+//  neighborhoods are disjoint (see claim_neighborhood()) can be evaluated concurrently, and then applied if successful.
+struct EdgeOp {
+    Edge e;
+    EResult result;
+    float edrss;
+    Point newp;                 // position of the kept (ecol), new (espl), or moved (eswa) vertex
+    float w1;                   // ecol: interpolation weight of vertex1(e) attributes
+    Vertex vo1, v1, vo2, v2;    // eswa: vo1 is moved; (vo1, v1, vo2, v2) are ccw about the edge
+    Face f1, f2;                // eswa: f1 is adjacent to v1 and f2 to v2
+    Array<int> ar_pts;          // points projecting onto the affected faces
+    Array<Face> ar_faces;       // ecol, eswa: remaining affected faces
+};
+
+EResult eval_ecol(EdgeOp& eop, int ni) {
+    Edge e = eop.e;
     if (!mesh.nice_edge_collapse(e)) return R_illegal; // not a legal move
     Vertex v1 = mesh.vertex1(e), v2 = mesh.vertex2(e);
     Face f1 = mesh.face1(e), f2 = mesh.face2(e);
@@ -1051,7 +1056,7 @@ EResult try_ecol(Edge e, int ni, int nri, float& edrss) {
     int nbvb = mesh.is_boundary(v1)+mesh.is_boundary(v2);
     float minb = min(min_dihedral_about_vertex(mesh, v1), min_dihedral_about_vertex(mesh, v2));
     double rssf = 0.;
-    Array<int> ar_pts; Array<Face> ar_faces;
+    Array<int>& ar_pts = eop.ar_pts; Array<Face>& ar_faces = eop.ar_faces;
     for (Face f : mesh.faces(v1)) {
         push_face_points(f, ar_pts);
         if (f==f1 || f==f2) continue;
@@ -1094,7 +1099,7 @@ EResult try_ecol(Edge e, int ni, int nri, float& edrss) {
     }
     if (minii<0) return R_dih; // no dihedrally admissible configuration
     // Then, explore ni iterations from that chosen starting point
-    float w1 = minii*.5f;
+    eop.w1 = minii*.5f;
     if (ni) {
         double rss0;
         local_fit(ar_pts, wa, ni, minp, rss0, minrss1);
@@ -1102,13 +1107,23 @@ EResult try_ecol(Edge e, int ni, int nri, float& edrss) {
         if (mina<k_mincos && mina<minb) return R_dih; // change disallowed
     }
     double drss = minrss1-rssf-(nbvb==2 ? crbf : 1)*double(crep);
-    edrss = float(drss);
+    eop.edrss = float(drss);
     if (verb>=4) SHOW("ecol:", rssf, minrss1, drss);
     if (drss>=0) return R_energy; // energy function does not decrease
+    eop.newp = minp;
+    return R_success;
+}
+
+void apply_ecol(EdgeOp& eop, int nri) {
     // ALL SYSTEMS GO
-    HH_SSTAT(Sminii, minii==1);
+    HH_SSTAT(Sminii, eop.w1==.5f);
     HH_STIMER(__doecol);
+    Edge e = eop.e;
+    Vertex v1 = mesh.vertex1(e);
+    Face f1 = mesh.face1(e), f2 = mesh.face2(e);
     if (k_simp96) {
+        Vertex v2 = mesh.vertex2(e);
+        float w1 = eop.w1;
         Vector nor1, nor2, nnor; UV uv1, uv2, uvn;
         string str;
         if (get_vertex_normal(v1, nor1) && get_vertex_normal(v2, nor2)) {
@@ -1131,22 +1146,30 @@ EResult try_ecol(Edge e, int ni, int nri, float& edrss) {
     for (Edge ee : mesh.edges(v1)) { ecand.add(ee); }
     for (Face f : mesh.faces(v1)) { ecand.add(mesh.opp_edge(v1, f)); }
     if (sdebug>=2) assertx(mesh.is_nice());
-    mesh.set_point(v1, minp);
-    reproject_locally(ar_pts, ar_faces);
+    mesh.set_point(v1, eop.newp);
+    reproject_locally(eop.ar_pts, eop.ar_faces);
     cleanup_neighborhood(v1, nri);
-    return R_success;
 }
 
-EResult try_espl(Edge e, int ni, int nri, float& edrss) {
-    HH_STIMER(__try_espl);
+EResult try_ecol(Edge e, int ni, int nri, float& edrss) {
+    HH_STIMER(__try_ecol);
+    EdgeOp eop; eop.e = e; eop.edrss = edrss;
+    EResult result = eval_ecol(eop, ni);
+    edrss = eop.edrss;
+    if (result==R_success) apply_ecol(eop, nri);
+    return result;
+}
+
+EResult eval_espl(EdgeOp& eop, int ni) {
     // always legal
+    Edge e = eop.e;
     Vertex v1 = mesh.vertex1(e), v2 = mesh.vertex2(e);
     Vertex vo1 = mesh.side_vertex1(e), vo2 = mesh.side_vertex2(e);
     Array<const Point*> wa { &mesh.point(v2), &mesh.point(vo1), &mesh.point(v1) };
     if (vo2) wa.push_array(V(&mesh.point(vo2), &mesh.point(v2)));
     float minb = vo2 ? edge_dihedral_angle_cos(mesh, e) : 2;
     double rssf = spring_energy(e);
-    Array<int> ar_pts;
+    Array<int>& ar_pts = eop.ar_pts;
     for (Face f : mesh.faces(e)) {
         push_face_points(f, ar_pts);
     }
@@ -1159,18 +1182,24 @@ EResult try_espl(Edge e, int ni, int nri, float& edrss) {
     float mina = min_local_dihedral(wa, newp);
     if (mina<k_mincos && mina<minb) return R_dih; // change disallowed
     double drss = rss1-rssf+(vo2 ? 1.f : crbf)*double(crep);
-    edrss = float(drss);
+    eop.edrss = float(drss);
     if (verb>=4) SHOW("espl:", rssf, rss1, drss);
     if (drss>=0) return R_energy; // energy function does not decrease
+    eop.newp = newp;
+    return R_success;
+}
+
+void apply_espl(EdgeOp& eop, int nri) {
     // ALL SYSTEMS GO
     HH_STIMER(__doespl);
+    Edge e = eop.e;
     for (Face f : mesh.faces(e)) {
         for (Edge ee : mesh.edges(f)) { // one duplication
             ecand.remove(ee);
         }
     }
     Vertex v = mesh.split_edge(e);
-    mesh.set_point(v, newp);
+    mesh.set_point(v, eop.newp);
     // add 8 edges (5 if boundary)
     for (Face f : mesh.faces(v)) {
         for (Edge ee : mesh.edges(f)) { // four duplications
@@ -1180,14 +1209,24 @@ EResult try_espl(Edge e, int ni, int nri, float& edrss) {
     // Since ar_pts project onto f1+f2 (which are still there), it is easy to update the projections:
     fit_ring(v, 2);
     cleanup_neighborhood(v, nri);
-    return R_success;
+}
+
+EResult try_espl(Edge e, int ni, int nri, float& edrss) {
+    HH_STIMER(__try_espl);
+    EdgeOp eop; eop.e = e; eop.edrss = edrss;
+    EResult result = eval_espl(eop, ni);
+    edrss = eop.edrss;
+    if (result==R_success) apply_espl(eop, nri);
+    return result;
 }
 
 // Note: correspondences on Edge e such as vertex1(e)==v1 may fail here!
 // Try swapping edge (v1, v2) into edge (vo1, vo2), allowing vertex vo1 to move.
 // To do this, gather points in current ring of vo1 plus points on f2.
-EResult check_half_eswa(Edge e, Vertex vo1, Vertex v1, Vertex vo2, Vertex v2, Face f2, Face f1,
-                        int ni, int nri, float& edrss) {
+EResult eval_half_eswa(EdgeOp& eop, int ni) {
+    Edge e = eop.e;
+    Vertex vo1 = eop.vo1, v1 = eop.v1, vo2 = eop.vo2, v2 = eop.v2;
+    Face f1 = eop.f1, f2 = eop.f2;
     Array<const Point*> wa; {
         assertx(mesh.ccw_vertex(vo1, v1)==v2);
         Vertex w = mesh.most_clw_vertex(vo1), wf = w;
@@ -1199,7 +1238,8 @@ EResult check_half_eswa(Edge e, Vertex vo1, Vertex v1, Vertex vo2, Vertex v2, Fa
         }
         if (w) wa.push(&mesh.point(w));
     }
-    Array<int> ar_pts; Array<Face> ar_faces;
+    Array<int>& ar_pts = eop.ar_pts; Array<Face>& ar_faces = eop.ar_faces;
+    ar_pts.init(0); ar_faces.init(0);
     for (Face f : mesh.faces(vo1)) {
         if (f==f1) continue;
         assertx(f!=f2);
@@ -1223,7 +1263,7 @@ EResult check_half_eswa(Edge e, Vertex vo1, Vertex v1, Vertex vo2, Vertex v2, Fa
     float mina = min_local_dihedral(wa, newp);
     if (mina<k_mincos && mina<minb) return R_dih; // change disallowed
     double drss = rss1-rssf+crep*feswaasym;
-    edrss = float(drss);
+    eop.edrss = float(drss);
     if (verb>=4) SHOW("eswa:", rssf, rss1, drss);
     if (drss>0) return R_energy;
     const char* finfo1 = mesh.get_string(f1);
@@ -1238,19 +1278,26 @@ EResult check_half_eswa(Edge e, Vertex vo1, Vertex v1, Vertex vo2, Vertex v2, Fa
         Warning("Edge swap would lose face info");
         return R_illegal;
     }
+    eop.newp = newp;
+    return R_success;
+}
+
+void apply_half_eswa(EdgeOp& eop, int nri) {
     // ALL SYSTEMS GO
     HH_STIMER(__doeswa);
+    Edge e = eop.e;
+    Vertex vo1 = eop.vo1, v1 = eop.v1, vo2 = eop.vo2, v2 = eop.v2;
     ecand.remove(e);
-    remove_face(f1);
-    remove_face(f2);
+    remove_face(eop.f1);
+    remove_face(eop.f2);
     Edge enew = assertx(mesh.swap_edge(e));
-    mesh.set_point(vo1, newp);
+    mesh.set_point(vo1, eop.newp);
     // add about 9 edges
     ecand.add(mesh.edge(vo2, v1));
     ecand.add(mesh.edge(vo2, v2));
     for (Edge ee : mesh.edges(vo1)) { ecand.add(ee); }
-    for (Face f : mesh.faces(enew)) { ar_faces.push(f); }
-    reproject_locally(ar_pts, ar_faces);
+    for (Face f : mesh.faces(enew)) { eop.ar_faces.push(f); }
+    reproject_locally(eop.ar_pts, eop.ar_faces);
     if (nri) {
         fit_ring(vo2, nri);
         fit_ring(v1, nri);
@@ -1262,50 +1309,178 @@ EResult check_half_eswa(Edge e, Vertex vo1, Vertex v1, Vertex vo2, Vertex v2, Fa
         fit_ring(v2, nri);
         fit_ring(vo1, nri);
     }
-    return R_success;
 }
 
-EResult try_eswa(Edge e, int ni, int nri, float& edrss) {
-    HH_STIMER(__try_eswa);
+// Check whether the swap of edge e is allowed at all.
+EResult check_eswa(Edge e) {
     if (!mesh.legal_edge_swap(e)) return R_illegal; // not legal move
     if (k_simp96 && edge_sharp(e)) {
         Warning("Not swapping sharp edges");
         return R_illegal;
     }
     Vertex v1 = mesh.vertex1(e), v2 = mesh.vertex2(e);
-    Face f1 = mesh.face1(e), f2 = mesh.face2(e);
     Vertex vo1 = mesh.side_vertex1(e), vo2 = mesh.side_vertex2(e);
     // Compare angles immediately before and after swap
     float minb = edge_dihedral_angle_cos(mesh, e);
     float mina = dihedral_angle_cos(mesh.point(vo1), mesh.point(vo2), mesh.point(v1), mesh.point(v2));
     if (mina<k_mincos && mina<minb) return R_dih;
-    // Will try both cases, but randomly select which one to try first
-    EResult result;
-    if (Random::G.get_unsigned(2)) {
-        result = check_half_eswa(e, vo1, v1, vo2, v2, f2, f1, ni, nri, edrss);
-        if (result==R_success) return result;
-        result = check_half_eswa(e, vo2, v2, vo1, v1, f1, f2, ni, nri, edrss);
-    } else {
-        result = check_half_eswa(e, vo2, v2, vo1, v1, f1, f2, ni, nri, edrss);
-        if (result==R_success) return result;
-        result = check_half_eswa(e, vo1, v1, vo2, v2, f2, f1, ni, nri, edrss);
+    return R_success;
+}
+
+// Evaluate both halves of the swap of edge e, starting with the one that moves side_vertex1(e) if vo1_first.
+EResult eval_eswa(EdgeOp& eop, int ni, bool vo1_first) {
+    Edge e = eop.e;
+    Vertex v1 = mesh.vertex1(e), v2 = mesh.vertex2(e);
+    Face f1 = mesh.face1(e), f2 = mesh.face2(e);
+    Vertex vo1 = mesh.side_vertex1(e), vo2 = mesh.side_vertex2(e);
+    EResult result = R_illegal;
+    for (bool moves_vo1 : {vo1_first, !vo1_first}) {
+        if (moves_vo1) {
+            eop.vo1 = vo1; eop.v1 = v1; eop.vo2 = vo2; eop.v2 = v2; eop.f1 = f1; eop.f2 = f2;
+        } else {
+            eop.vo1 = vo2; eop.v1 = v2; eop.vo2 = vo1; eop.v2 = v1; eop.f1 = f2; eop.f2 = f1;
+        }
+        result = eval_half_eswa(eop, ni);
+        if (result==R_success) break;
     }
     return result;
 }
 
+EResult try_eswa(Edge e, int ni, int nri, float& edrss) {
+    HH_STIMER(__try_eswa);
+    EResult result = check_eswa(e);
+    if (result!=R_success) return result;
+    // Will try both cases, but randomly select which one to try first
+    EdgeOp eop; eop.e = e; eop.edrss = edrss;
+    result = eval_eswa(eop, ni, Random::G.get_unsigned(2)!=0);
+    edrss = eop.edrss;
+    if (result==R_success) apply_half_eswa(eop, nri);
+    return result;
+}
+
+const Vec<float,OP_NUM> k_op_ni = {4.f, 3.f, 3.f};  // number of local fit iterations in evaluating each operation
+const Vec<float,OP_NUM> k_op_nri = {2.f, 4.f, 2.f}; // number of local fit iterations after applying each operation
+
 EResult try_op(Edge e, EOperation op, float& edrss) {
     HH_STIMER(__try_op);
     EResult result;
-    result = (op==OP_ecol ? try_ecol(e, int(4.f*fliter+.5f), int(2.f*fliter+.5f), edrss) :
-               op==OP_espl ? try_espl(e, int(3.f*fliter+.5f), int(4.f*fliter+.5f), edrss) :
-               op==OP_eswa ? try_eswa(e, int(3.f*fliter+.5f), int(2.f*fliter+.5f), edrss) :
-               (assertnever(""), R_success));
+    const int ni = int(k_op_ni[op]*fliter+.5f), nri = int(k_op_nri[op]*fliter+.5f);
+    result = (op==OP_ecol ? try_ecol(e, ni, nri, edrss) :
+              op==OP_espl ? try_espl(e, ni, nri, edrss) :
+              op==OP_eswa ? try_eswa(e, ni, nri, edrss) :
+              (assertnever(""), R_success));
     opstat.na[op]++;
     if (result==R_success) opstat.ns[op]++;
     opstat.nor[result]++;
     return result;
 }
 
+// Mark the vertices within 3 edges of the endpoints of e, unless any is already marked.
+// Evaluating an operation on e reads only the mesh and the point projections within this neighborhood, and applying
+//  it modifies only those, so operations whose neighborhoods are disjoint can be evaluated concurrently.
+bool claim_neighborhood(Edge e, Set<Vertex>& claimed) {
+    Set<Vertex> setv;
+    Array<Vertex> ar_v;
+    for (Vertex v : mesh.vertices(e)) {
+        if (claimed.contains(v)) return false;
+        setv.enter(v); ar_v.push(v);
+    }
+    int ib = 0;
+    for_int(i, 3) {
+        int ie = ar_v.num();
+        for_intL(j, ib, ie) {
+            for (Vertex w : mesh.vertices(ar_v[j])) {
+                if (!setv.add(w)) continue;
+                if (claimed.contains(w)) return false;
+                ar_v.push(w);
+            }
+        }
+        ib = ie;
+    }
+    for (Vertex v : ar_v) { claimed.enter(v); }
+    return true;
+}
+
+// Concurrent variant of the loop in do_stoc().  Each round draws a batch of random candidate edges and keeps those
+//  whose neighborhoods are disjoint (the others are returned to ecand); these are evaluated concurrently, trying
+//  ecol, espl, and eswa as in do_stoc(), and the successful operations are applied serially in the order drawn.
+// The result is deterministic, but differs from that of do_stoc() since the edges are examined in a different order.
+// Experimental: on the tested meshes it is slower than do_stoc(); its speedup on many cores has not been measured.
+void stoc_concurrent(int& ni, int& nbad) {
+    const int batch_size = 256;
+    struct Candidate {
+        EdgeOp eop;
+        EOperation op;
+        bool vo1_first;
+        Vec<int,OP_NUM> results;    // EResult of each operation attempted, else -1
+    };
+    int lecol = 0, lespl = 0, leswa = 0;
+    while (!ecand.empty()) {
+        Array<Candidate> cands; Array<Edge> deferred;
+        {
+            Set<Vertex> claimed;
+            // (Stop early once most candidates conflict, as on a small mesh.)
+            while (cands.num()<batch_size && deferred.num()<batch_size/8 && !ecand.empty()) {
+                Edge e = ecand.remove_random(Random::G);
+                ASSERTX(mesh.valid(e));
+                if (!claim_neighborhood(e, claimed)) { deferred.push(e); continue; }
+                cands.push(Candidate());
+                Candidate& cand = cands.last();
+                cand.eop.e = e;
+                cand.vo1_first = Random::G.get_unsigned(2)!=0;
+            }
+        }
+        for (Edge e : deferred) { ecand.enter(e); }
+        {
+            HH_STIMER(__stoc_eval);
+            parallel_for_each(range(cands.num()), [&](const int i) {
+                Candidate& cand = cands[i];
+                fill(cand.results, -1);
+                for_int(iop, OP_NUM) {
+                    EOperation op = EOperation(iop);
+                    if (op==OP_espl && !fliter) continue; // do not try edge_splits under zippysimplify
+                    EdgeOp& eop = cand.eop;
+                    eop.ar_pts.init(0); eop.ar_faces.init(0);
+                    const int opni = int(k_op_ni[op]*fliter+.5f);
+                    EResult result;
+                    if (op==OP_ecol) result = eval_ecol(eop, opni);
+                    else if (op==OP_espl) result = eval_espl(eop, opni);
+                    else if ((result = check_eswa(eop.e))==R_success) result = eval_eswa(eop, opni, cand.vo1_first);
+                    cand.results[op] = result;
+                    cand.op = op;
+                    if (result==R_success) break;
+                }
+            }, 200000);
+        }
+        for (Candidate& cand : cands) {
+            ni++;
+            for_int(op, OP_NUM) {
+                if (cand.results[op]<0) continue;
+                opstat.na[op]++;
+                opstat.nor[cand.results[op]]++;
+            }
+            if (verb>=2 && ni%100==0) {
+                showdf("it %5d, ecol=%2d  espl=%2d  eswa=%2d   [%5d/%-5d]\n",
+                       ni, opstat.ns[OP_ecol]-lecol, opstat.ns[OP_espl]-lespl,
+                       opstat.ns[OP_eswa]-leswa, ecand.num(), mesh.num_edges());
+                lecol = opstat.ns[OP_ecol]; lespl = opstat.ns[OP_espl];
+                leswa = opstat.ns[OP_eswa];
+            }
+            if (cand.results[cand.op]!=R_success) { nbad++; continue; }
+            opstat.ns[cand.op]++;
+            const int nri = int(k_op_nri[cand.op]*fliter+.5f);
+            if (cand.op==OP_ecol) apply_ecol(cand.eop, nri);
+            else if (cand.op==OP_espl) apply_espl(cand.eop, nri);
+            else apply_half_eswa(cand.eop, nri);
+            if (verb>=3)
+                showf("it %5d, %s (after %3d) [%5d/%-5d] edrss=%e\n",
+                      ni, opname[cand.op].c_str(), nbad, ecand.num(), mesh.num_edges(), cand.eop.edrss);
+            if (file_spawn) (*file_spawn)().flush();
+            nbad = 0;
+        }
+    }
+}
+
 void do_stoc() {
     perhaps_initialize();
     HH_STIMER(_stoc);
@@ -1317,6 +1492,7 @@ void do_stoc() {
     opstat.notswaps = 0;
     int ni = 0, nbad = 0, lecol = 0, lespl = 0, leswa = 0;
     for (Edge e : mesh.edges()) { ecand.enter(e); }
+    if (concurrentstoc) stoc_concurrent(ni, nbad);
     while (!ecand.empty()) {
         ni++;
         Edge e = ecand.remove_random(Random::G);
@@ -1462,6 +1638,7 @@ int main(int argc, const char** argv) {
     ARGSP(spbf,                 "ratio : set spring constant boundary factor");
     ARGSP(fliter,               "factor : modify # local iters done in stoc");
     ARGSP(feswaasym,            "f : set drss threshold (fraction of crep)");
+    ARGSF(concurrentstoc,       ": in stoc, evaluate independent edge operations concurrently (experimental)");
     HH_TIMER(Meshfit);
     showdf("%s", args.header().c_str());
     args.parse();
@@ -9,7 +9,7 @@
 #include "MeshOp.h"             // gather_boundary(), edge_signed_dihedral_angle(), etc.
 #include "Set.h"
 #include "RangeOp.h"            // reverse()
-#include <atomic>
+#include "Parallel.h"           // parallel_for_each()
 
 namespace hh {
 
@@ -60,34 +60,49 @@ constexpr bool k_touch_approx = true;
 
 const Point k_boundary_point_far_away = thrice(1e10f); // to topologically fill mesh boundaries
 
-// Remember to initialize these sacs, including in cycle closing operations.
-HH_SAC_ALLOCATE_FUNC(Mesh::MVertex, float, v_dist); // distance from seed vertex during BFS, or BIGFLOAT if not reached
-HH_SAC_ALLOCATE_FUNC(Mesh::MVertex, Vertex, v_vprev); // previous vertex during BFS
-// HH_SAC_ALLOCATE_FUNC(Mesh::MVertex, Vertex, v_vtouch); // previous jump-across vertex during BFS;
-//  implementation as map_vtouch is equally efficient because it is accessed infrequently.
-
-HH_SAC_ALLOCATE_FUNC(Mesh::MEdge, int, e_bfsnum); // for secondary BFS search
-// HH_SAC_ALLOCATE_FUNC(Mesh::MEdge, bool, e_joined); // records whether Vertex-Voronoi-regions are joined;
-//  implementation as flags(e).flag(eflag_joined) is equally efficient.
-
-const FlagMask eflag_joined = Mesh::allocate_Edge_flag(); // records whether Vertex-Voronoi-regions are joined
+// Remember to initialize this sac, including in cycle closing operations.
+HH_SAC_ALLOCATE_FUNC(Mesh::MEdge, int, e_index); // dense index into SearchState edge arrays
 
 bool difference_is_within_relative_eps(float a, float b, float eps) { return abs(a-b)/(max(a, b)+1e-10f) < eps; }
 
 } // namespace
 
-inline Flag CloseMinCycles::e_joined(Edge e) { return _mesh.flags(e).flag(eflag_joined); }
+// The state of one search, kept in dense arrays (indexed by vertex_id() and e_index()) rather than in mesh
+//  attributes, so that searches from several seed vertices can traverse the unmodified mesh concurrently.
+// Edge indices are never reused, so a stale entry for an edge destroyed by close_cycle() is harmless.
+struct CloseMinCycles::SearchState {
+    explicit SearchState(const GMesh& mesh)     : _mesh(mesh) { }
+    float& v_dist(Vertex v)                     { return _vdist[_mesh.vertex_id(v)]; }
+    Vertex& v_vprev(Vertex v)                   { return _vprev[_mesh.vertex_id(v)]; }
+    bool& e_joined(Edge e)                      { return _ejoined[e_index(e)]; }
+    int& e_bfsnum(Edge e)                       { return _ebfsnum[e_index(e)]; }
+    int next_bfsnum()                           { return (++_bfsnum)*2; }
+    void extend(int num_eindex) {               // cover the vertices and edges created since the last call
+        for (int i = _vdist.num(); i<_mesh.vertex_id_bound(); i++) { _vdist.push(BIGFLOAT); _vprev.push(nullptr); }
+        for (int i = _ejoined.num(); i<num_eindex; i++) { _ejoined.push(false); _ebfsnum.push(0); }
+    }
+ private:
+    const GMesh& _mesh;
+    Array<float> _vdist;        // distance from seed vertex during BFS, or BIGFLOAT if not reached
+    Array<Vertex> _vprev;       // previous vertex during BFS
+    // v_vtouch (previous jump-across vertex during BFS) is a local map_vtouch because it is accessed infrequently.
+    Array<bool> _ejoined;       // records whether Vertex-Voronoi-regions are joined
+    Array<int> _ebfsnum;        // for secondary BFS search
+    int _bfsnum {0};
+};
+
+inline void CloseMinCycles::assign_index(Edge e) { e_index(e) = _num_eindex++; }
 
 // Re-initialize v_dist() and e_joined() on the region that was just searched.
-void CloseMinCycles::flood_reinitialize(Vertex vseed) {
-    v_dist(vseed) = BIGFLOAT;
+void CloseMinCycles::flood_reinitialize(SearchState& st, Vertex vseed) {
+    st.v_dist(vseed) = BIGFLOAT;
     Queue<Vertex> queue; queue.enqueue(vseed);
     while (!queue.empty()) {
-        Vertex vc = queue.dequeue(); ASSERTX(v_dist(vc)==BIGFLOAT);
+        Vertex vc = queue.dequeue(); ASSERTX(st.v_dist(vc)==BIGFLOAT);
         for (Edge e : _mesh.edges(vc)) {
-            e_joined(e) = false;
+            st.e_joined(e) = false;
             Vertex vn = _mesh.opp_vertex(vc, e);
-            if (v_dist(vn)!=BIGFLOAT) { v_dist(vn) = BIGFLOAT; queue.enqueue(vn); }
+            if (st.v_dist(vn)!=BIGFLOAT) { st.v_dist(vn) = BIGFLOAT; queue.enqueue(vn); }
         }
     }
 }
@@ -96,7 +111,7 @@ void CloseMinCycles::flood_reinitialize(Vertex vseed) {
 //   (1) duplicating each vertex along the cycle, and
 //   (2) closing each of the resulting two boundaries with a fan of triangle faces.
 // Return the cycle of new corresponding vertices (which is in reverse order from vao).
-Array<Vertex> CloseMinCycles::close_cycle(const CArrayView<Vertex> vao) {
+Array<Vertex> CloseMinCycles::close_cycle(SearchState& st, const CArrayView<Vertex> vao) {
     assertx(vao.num()>=3);
     // First, create the new vertices by splitting the old ones, creating two mesh boundaries.
     Array<Vertex> van;          // new vertices
@@ -116,9 +131,10 @@ Array<Vertex> CloseMinCycles::close_cycle(const CArrayView<Vertex> vao) {
         }
         _mesh.set_point(vn, p);
         _mesh.set_string(vn, _mesh.get_string(vo));
-        v_dist(vn) = 0.f;       // any value !=BIGFLOAT
         // Note: Vertex vn is not entered into pqvlbsr, because its corresponding old vertex is already there.
-        for (Edge e : _mesh.edges(vn)) { e_bfsnum(e) = 0; } // e_joined(e) will be initialized shortly
+        for (Edge e : _mesh.edges(vn)) { assign_index(e); } // e_joined(e) will be initialized shortly
+        st.extend(_num_eindex);
+        st.v_dist(vn) = 0.f;    // any value !=BIGFLOAT
         // On corners and faces, all sacs, strings, and flags are preserved.
     }
     // Next, fill the two boundaries with center_split().
@@ -127,7 +143,6 @@ Array<Vertex> CloseMinCycles::close_cycle(const CArrayView<Vertex> vao) {
     for_int(fi, 2) {
         Face fn = _mesh.create_face(fi==0 ? vao : van);
         Vertex vn = _mesh.center_split_face(fn);
-        v_dist(vn) = 0.f;       // any value !=BIGFLOAT
         if (1) {
             // For all edges in the two cycles after the closure, label them with the "sharp" attribute.
             for (Face f : _mesh.faces(vn)) { Edge e = _mesh.opp_edge(vn, f); _mesh.update_string(e, "sharp", ""); }
@@ -136,11 +151,12 @@ Array<Vertex> CloseMinCycles::close_cycle(const CArrayView<Vertex> vao) {
             // Label the two vertices at the centers of the face fans.
             _mesh.update_string(vn, "filledcenter", "");
         }
-        // Clean-up / initialize the edge data.
-        for (Face f : _mesh.faces(vn)) {
-            for (Edge e : _mesh.edges(f)) { e_bfsnum(e) = 0; } // e_joined(e) will be initialized shortly
-        }
-        for (Vertex v : _mesh.vertices(vn)) { v_dist(v) = 0.f; } // any value !=BIGFLOAT
+        // Initialize the edge data, on the spoke and ring edges of the fan.
+        for (Face f : _mesh.faces(vn)) { assign_index(_mesh.opp_edge(vn, f)); }
+        for (Edge e : _mesh.edges(vn)) { assign_index(e); } // e_joined(e) will be initialized shortly
+        st.extend(_num_eindex);
+        st.v_dist(vn) = 0.f;    // any value !=BIGFLOAT
+        for (Vertex v : _mesh.vertices(vn)) { st.v_dist(v) = 0.f; } // any value !=BIGFLOAT
         if (1) {                // heuristically characterize as handle/tunnel based on geometric embedding
             for (Face f : _mesh.faces(vn)) {
                 Edge e = _mesh.opp_edge(vn, f);                   // Face f2 = _mesh.opp_face(f, e);
@@ -160,8 +176,11 @@ Array<Vertex> CloseMinCycles::close_cycle(const CArrayView<Vertex> vao) {
 }
 
 // Given Edge e adjacent to two already BFS-visited vertices, determine if connecting them would form a nonseparating cycle.
-bool CloseMinCycles::would_be_nonseparating_cycle(Edge e12, bool exact) {
-    HH_STIMER(__would_be_nonseparating_cycle);
+// Only state st is modified, so searches with distinct states may call this concurrently.
+bool CloseMinCycles::would_be_nonseparating_cycle(SearchState& st, Edge e12, bool exact) const {
+    auto v_dist = [&](Vertex v) -> float& { return st.v_dist(v); };
+    auto e_joined = [&](Edge e) -> bool& { return st.e_joined(e); };
+    auto e_bfsnum = [&](Edge e) -> int& { return st.e_bfsnum(e); };
     assertx(v_dist(_mesh.vertex1(e12))!=BIGFLOAT && v_dist(_mesh.vertex2(e12))!=BIGFLOAT);
     assertx(!e_joined(e12));
     e_joined(e12) = true;       // must be undone before function return if the cycle is non-separating
@@ -173,8 +192,7 @@ bool CloseMinCycles::would_be_nonseparating_cycle(Edge e12, bool exact) {
         Vec2<Queue<Corner>> queues; // initialized with two opposing half-edges
         queues[0].enqueue(_mesh.corner(_mesh.vertex2(e12), _mesh.face1(e12)));
         queues[1].enqueue(_mesh.corner(_mesh.vertex1(e12), _mesh.face2(e12)));
-        static std::atomic<int> g_bfsnum{0}; // thread-safe
-        int bfsnum = (++g_bfsnum)*2;
+        int bfsnum = st.next_bfsnum();
         Vec2<Set<Edge>> sets;   // for slower algorithm
         int count = 0;
         connected = [&]{
@@ -204,7 +222,7 @@ bool CloseMinCycles::would_be_nonseparating_cycle(Edge e12, bool exact) {
                 }
             }
         }();
-        HH_SSTAT(Scount, count);
+        HH_SSTAT_CONCURRENT(Scount, count);
         if (0) {
             Vertex v1 = _mesh.vertex1(e12), v2 = _mesh.vertex2(e12);
             showdf("would_be_nonseparating_cycle v_dist(%d)=%g v_dist(%d)=%g e12=%g exact=%d connected=%d count=%d\n",
@@ -246,7 +264,7 @@ bool CloseMinCycles::would_be_nonseparating_cycle(Edge e12, bool exact) {
                     }
                 }
             }
-            HH_SSTAT(Szipper, count);
+            HH_SSTAT_CONCURRENT(Szipper, count);
             if (0) showdf("joined %d additional edges\n", count);
         }
     }
@@ -257,12 +275,13 @@ bool CloseMinCycles::would_be_nonseparating_cycle(Edge e12, bool exact) {
 // Determine if the associated cycle is non-separating (i.e. spans a topological handle).
 // If it is, optionally process the cycle.
 // Return: was_a_nonseparating_cycle.
-bool CloseMinCycles::look_for_cycle(Vertex v1, Vertex v2, bool process, float verify_dist, int& num_edges) {
-    HH_STIMER(__look_for_cycle);
+// If process is false, only state st is modified, so searches with distinct states may call this concurrently.
+bool CloseMinCycles::look_for_cycle(SearchState& st, Vertex v1, Vertex v2, bool process, float verify_dist,
+                                    int& num_edges) {
     if (verb) Warning("Looking for cycle");
     Edge e12 = _mesh.edge(v1, v2);
-    assertx(!e_joined(e12));
-    if (!would_be_nonseparating_cycle(e12, true)) {
+    assertx(!st.e_joined(e12));
+    if (!would_be_nonseparating_cycle(st, e12, true)) {
         if (verb) Warning("not a cycle");
         return false;
     }
@@ -271,7 +290,7 @@ bool CloseMinCycles::look_for_cycle(Vertex v1, Vertex v2, bool process, float ve
         epath[0].push(e12);
         for_int(i, 2) {
             for (Vertex v = _mesh.vertex(e12, i); ; ) {
-                Vertex vn = v_vprev(v); if (!vn) break;
+                Vertex vn = st.v_vprev(v); if (!vn) break;
                 Edge e = _mesh.edge(v, vn); epath[i].push(e);
                 v = vn;
             }
@@ -289,7 +308,7 @@ bool CloseMinCycles::look_for_cycle(Vertex v1, Vertex v2, bool process, float ve
         float len = 0.f;
         for (Edge e : ecycle) { len += _mesh.length(e); }
         if (0) showdf("Cycle edges=%d length=%g v1d=%g v2d=%g e12=%g\n",
-                      ecycle.num(), len, v_dist(v1), v_dist(v2), _mesh.length(e12));
+                      ecycle.num(), len, st.v_dist(v1), st.v_dist(v2), _mesh.length(e12));
         HH_SSTAT(Scyclene, ecycle.num());
         HH_SSTAT(Scyclelen, len);
         assertw(difference_is_within_relative_eps(len, verify_dist*2.f, 1e-6f));
@@ -301,9 +320,9 @@ bool CloseMinCycles::look_for_cycle(Vertex v1, Vertex v2, bool process, float ve
             ASSERTX(_mesh.opp_vertex(vao.last(), ecycle[0])==vao[0]); // ecycle is truly a cycle.
         }
         if (0) { SHOWL; for (Vertex v : vao) { SHOW(_mesh.vertex_id(v)); } }
-        Array<Vertex> van = close_cycle(vao);
+        Array<Vertex> van = close_cycle(st, vao);
         // Re-initialize v_dist() and e_joined() for that portion of the mesh disconnected from vseed.
-        flood_reinitialize(van[0]); // pick any new vertex
+        flood_reinitialize(st, van[0]); // pick any new vertex
     }
     return true;
 }
@@ -311,9 +330,13 @@ bool CloseMinCycles::look_for_cycle(Vertex v1, Vertex v2, bool process, float ve
 // Find the smallest size cycle containing vertex vseed -- report search radius (BIGFLOAT if no cycle found)
 //   and farthest vertex in cycle from vseed.
 // If parameter "process" is true, modify the mesh to close the cycle.
-// The caller must clean up e_joined() and v_dist() after this function completes.
-void CloseMinCycles::min_cycle_from_vertex(Vertex vseed, bool process, float& search_radius,
+// The caller must clean up e_joined() and v_dist() in st after this function completes.
+// If process is false, the mesh is not modified, so searches with distinct states may proceed concurrently.
+void CloseMinCycles::min_cycle_from_vertex(SearchState& st, Vertex vseed, bool process, float& search_radius,
                                            Vertex& farthest_vertex, int& num_edges) {
+    auto v_dist = [&](Vertex v) -> float& { return st.v_dist(v); };
+    auto v_vprev = [&](Vertex v) -> Vertex& { return st.v_vprev(v); };
+    auto e_joined = [&](Edge e) -> bool& { return st.e_joined(e); };
     if (sdebug) {               // verify that previous search has cleanly reinitialized all fields.
         Warning("sdebug");
         for (Edge e : _mesh.edges()) { assertx(!e_joined(e)); }
@@ -351,7 +374,7 @@ void CloseMinCycles::min_cycle_from_vertex(Vertex vseed, bool process, float& se
                 if (verb) Warning("joined in the meantime");
                 continue;
             }
-            if (look_for_cycle(vnew, v_vtouch(vnew), process, vdist, num_edges)) {
+            if (look_for_cycle(st, vnew, v_vtouch(vnew), process, vdist, num_edges)) {
                 // we have found a cycle; exit from function
                 search_radius = vdist; farthest_vertex = v_vtouch(vnew);
                 break;
@@ -399,7 +422,7 @@ void CloseMinCycles::min_cycle_from_vertex(Vertex vseed, bool process, float& se
                     Edge e = _mesh.edge(vnew, v);
                     if (e_joined(e)) continue; // may have been joined in the meantime during this loop
                     if (verb) Warning("Front is about to touch itself");
-                    if (!would_be_nonseparating_cycle(e, false)) {
+                    if (!would_be_nonseparating_cycle(st, e, false)) {
                         if (verb) Warning("Not would_be_nonseparating_cycle");
                         continue;
                     }
@@ -427,19 +450,29 @@ void CloseMinCycles::min_cycle_from_vertex(Vertex vseed, bool process, float& se
 //   minimal cycle passing through any vertex traversed during the BFS search.
 //  Intuitively, if the BFS covers a large mesh region before finding a cycle, then most of the vertices
 //   in the search region cannot contain small cycles.
+// Each round searches concurrently from the num_searches vertices with the smallest lower bounds, each search with
+//  its own SearchState.  The results are committed serially in seed order, so the outcome depends on num_searches
+//  but not on the number of threads.  At most one cycle (the smallest one found) is closed per round; closing it
+//  invalidates the cycles found by the other searches of the round, but not the lower bounds they established.
+// The default num_searches==1 is the original sequential search.  Setting _num_searches to 0 uses get_max_threads()
+//  searches, so that the result then varies with the machine.
 void CloseMinCycles::find_cycles() {
     HH_TIMER(_find_cycles);
+    const int num_searches = _num_searches ? _num_searches : get_max_threads();
+    assertx(num_searches>=1);
+    Array<unique_ptr<SearchState>> states;
+    for_int(i, num_searches) { states.push(make_unique<SearchState>(_mesh)); states[i]->extend(_num_eindex); }
     if (0) {                    // debug
         // results in 2 separate components, so not a topological handle
-        close_cycle(V(_mesh.id_vertex(50), _mesh.id_vertex(53), _mesh.id_vertex(59), _mesh.id_vertex(49)));
+        close_cycle(*states[0], V(_mesh.id_vertex(50), _mesh.id_vertex(53), _mesh.id_vertex(59), _mesh.id_vertex(49)));
         return;
     }
     if (0) {                    // debug
         float sr; Vertex vfarthest; int num_edges;
-        min_cycle_from_vertex(_mesh.id_vertex(49), true, sr, vfarthest, num_edges); SHOW(sr);
+        min_cycle_from_vertex(*states[0], _mesh.id_vertex(49), true, sr, vfarthest, num_edges); SHOW(sr);
         for (Vertex v : _mesh.vertices()) {
-            if (v_dist(v)!=BIGFLOAT)
-                showf("vdist(%d)=%g\n", _mesh.vertex_id(v), v_dist(v));
+            if (states[0]->v_dist(v)!=BIGFLOAT)
+                showf("vdist(%d)=%g\n", _mesh.vertex_id(v), states[0]->v_dist(v));
         }
         return;
     }
@@ -452,68 +485,96 @@ void CloseMinCycles::find_cycles() {
     int nprocessed = 0;
     float ubsr = BIGFLOAT;             // upper-bound on search radius for minimal cycle
     int iter = 0;
+    struct Search {
+        Vertex vseed;
+        float lbsr;             // lower-bound on search radius about vseed when it was selected
+        float sr;
+        Vertex vfarthest;
+        int num_edges;
+    };
+    Array<Search> searches;
     for (;;) {
-        Vertex vseed = pqvlbsr.min();
-        float lbsr = pqvlbsr.min_priority();
+        searches.init(0);
         if (vrand) {            // override choice of initial vertex
-            vseed = vrand;
-            lbsr = pqvlbsr.retrieve(vseed); assertx(lbsr==0.f);
+            searches.push(Search{vrand, pqvlbsr.retrieve(vrand), BIGFLOAT, nullptr, INT_MAX});
+            assertx(searches[0].lbsr==0.f);
             vrand = nullptr;
+        } else if (num_searches==1) {
+            searches.push(Search{pqvlbsr.min(), pqvlbsr.min_priority(), BIGFLOAT, nullptr, INT_MAX});
+        } else {
+            // Enumerate the seeds with smallest lower bounds by temporarily removing them from pqvlbsr.
+            while (searches.num()<num_searches && !pqvlbsr.empty()) {
+                float lbsr = pqvlbsr.min_priority();
+                if (searches.num() && (lbsr==BIGFLOAT || lbsr>_max_cycle_length/2.f)) break;
+                searches.push(Search{pqvlbsr.remove_min(), lbsr, BIGFLOAT, nullptr, INT_MAX});
+            }
+            for (const Search& search : searches) { pqvlbsr.enter(search.vseed, search.lbsr); }
         }
+        float lbsr = searches[0].lbsr;
         if (lbsr==BIGFLOAT) { showdf("No more cycles at all\n"); break; }
         if (lbsr>_max_cycle_length/2.f) { showdf("No more cycles of size <=%g\n", _max_cycle_length); break; }
-        ++iter;
-        float sr; Vertex vfarthest; int num_edges; min_cycle_from_vertex(vseed, false, sr, vfarthest, num_edges);
-        ubsr = min(ubsr, sr); // if find a cycle, possibly reduce the upper-bound on the minimal search radius
-        if (verb) showf("it=%-4d v=%-7d sr=%-12g nedges=%-4d lb=%-12g ub=%-12g\n",
-                        iter, _mesh.vertex_id(vseed), sr, (num_edges==INT_MAX ? -1 : num_edges), lbsr, ubsr);
-        if (!(sr*(1.f+2e-7f)>=lbsr)) { SHOW((lbsr-sr)/sr-1.f); assertx(sr>=lbsr); }
-        if (!(ubsr*(1.f+2e-7f)>=lbsr)) { SHOW((lbsr-ubsr)/ubsr-1.f); assertx(ubsr>=lbsr); }
-        if (0 && sr==BIGFLOAT) { // this test is invalid if the mesh has multiple connected components
-            showdf("No more cycles at all\n");
-            break;              // efficiency shortcut: no need to clean up v_dist() and e_joined().
-        }
-        // Update pqvlbsr and re-initialize v_dist() and e_joined().
-        {
+        parallel_for_each(range(searches.num()), [&](const int i) {
+            Search& search = searches[i];
+            min_cycle_from_vertex(*states[i], search.vseed, false, search.sr, search.vfarthest, search.num_edges);
+        });
+        for_int(i, searches.num()) {
+            SearchState& st = *states[i];
+            Vertex vseed = searches[i].vseed;
+            float sr = searches[i].sr;
+            lbsr = searches[i].lbsr;
+            ++iter;
+            ubsr = min(ubsr, sr); // if find a cycle, possibly reduce the upper-bound on the minimal search radius
+            if (verb) showf("it=%-4d v=%-7d sr=%-12g nedges=%-4d lb=%-12g ub=%-12g\n", iter, _mesh.vertex_id(vseed),
+                            sr, (searches[i].num_edges==INT_MAX ? -1 : searches[i].num_edges), lbsr, ubsr);
+            if (!(sr*(1.f+2e-7f)>=lbsr)) { SHOW((lbsr-sr)/sr-1.f); assertx(sr>=lbsr); }
+            if (!(ubsr*(1.f+2e-7f)>=lbsr)) { SHOW((lbsr-ubsr)/ubsr-1.f); assertx(ubsr>=lbsr); }
+            // Update pqvlbsr and re-initialize v_dist() and e_joined().
             pqvlbsr.update(vseed, sr); // should never change again because it is the exact distance
-            // The following is like flood_reinitialize(vseed) but it also updates pqvlbsr.
-            v_dist(vseed) = BIGFLOAT;
+            // The following is like flood_reinitialize(st, vseed) but it also updates pqvlbsr.
+            st.v_dist(vseed) = BIGFLOAT;
             Queue<Vertex> queue; queue.enqueue(vseed);
             while (!queue.empty()) {
-                Vertex vc = queue.dequeue(); ASSERTX(v_dist(vc)==BIGFLOAT);
+                Vertex vc = queue.dequeue(); ASSERTX(st.v_dist(vc)==BIGFLOAT);
                 for (Edge e : _mesh.edges(vc)) {
-                    e_joined(e) = false;
+                    st.e_joined(e) = false;
                     Vertex vn = _mesh.opp_vertex(vc, e);
-                    if (v_dist(vn)!=BIGFLOAT) {
+                    if (st.v_dist(vn)!=BIGFLOAT) {
                         // Vertex vn was found to have distance v_dist(vn) from vseed.
                         // Since the minimal cycle about vseed has length sr*2, we can infer that the minimal cycle
                         //  about vn cannot be smaller than (sr-v_dist(vn))*2.
-                        float nlb = sr-v_dist(vn); // new lower-bound radius
+                        float nlb = sr-st.v_dist(vn); // new lower-bound radius
                         if (nlb<0.f) { if (0) SHOW(nlb); assertx(nlb>-sr*1e-6f); nlb = 0.f; }
                         pqvlbsr.enter_update_if_greater(vn, nlb);
-                        v_dist(vn) = BIGFLOAT; queue.enqueue(vn);
+                        st.v_dist(vn) = BIGFLOAT; queue.enqueue(vn);
                     }
                 }
             }
             lbsr = pqvlbsr.min_priority();
             if (!(ubsr>=lbsr)) { SHOW(_mesh.vertex_id(pqvlbsr.min()), lbsr); assertnever(""); }
         }
-        if (sr==BIGFLOAT) continue; // no more cycles in this connected component of the mesh
+        const Search* psearch = nullptr; // smallest cycle found in this round
+        for (const Search& search : searches) {
+            if (search.sr!=BIGFLOAT && (!psearch || search.sr<psearch->sr)) psearch = &search;
+        }
+        if (!psearch) continue; // no more cycles in these connected components of the mesh
+        float sr = psearch->sr;
         // Process the cycle if its radius is within some fraction of the lower-bound minimal cycle radius lbsr.
         if (sr<=_frac_cycle_length*lbsr) { // was: "if (sr==lbsr)"
             if (verb) showdf("After %d iter, processing cycle of length %g\n", iter+1, sr*2.f);
-            assertx(num_edges<INT_MAX);
+            int num_edges = psearch->num_edges; assertx(num_edges<INT_MAX);
             if (num_edges>_max_cycle_nedges) { showdf("Stopping because next cycle has %d>%d edges\n",
                                                       num_edges, _max_cycle_nedges); break; }
             bool restart_at_farthest = true; // may improve loop if _frac_cycle_length>1.f (e.g. holes3.m)
             if (!assertw(_frac_cycle_length>(1.f+1e-6f))) restart_at_farthest = false; // fix 20140911
-            if (restart_at_farthest) vseed = vfarthest;
-            float old_sr = sr;
-            min_cycle_from_vertex(vseed, true, sr, vfarthest, num_edges);
+            Vertex vseed = restart_at_farthest ? psearch->vfarthest : psearch->vseed;
+            SearchState& st = *states[0];
+            float old_sr = sr; Vertex vfarthest;
+            min_cycle_from_vertex(st, vseed, true, sr, vfarthest, num_edges);
             assertx(sr<=old_sr*(1.f+1e-6f)); if (!restart_at_farthest) assertx(sr==old_sr);
             assertw(num_edges<=_max_cycle_nedges);
-            flood_reinitialize(vseed); // again re-initialize v_dist() and e_joined()
-            if (sdebug) { Warning("slow"); for (Edge e : _mesh.edges()) { assertx(!e_joined(e)); } }
+            flood_reinitialize(st, vseed); // again re-initialize v_dist() and e_joined()
+            if (sdebug) { Warning("slow"); for (Edge e : _mesh.edges()) { assertx(!st.e_joined(e)); } }
+            for (auto& pst : states) { pst->extend(_num_eindex); } // cover the vertices and edges just created
             ++nprocessed;
             --_cgenus;
             ubsr = BIGFLOAT;
@@ -550,16 +611,8 @@ void CloseMinCycles::compute() {
         SHOW(mesh_genus_string(_mesh));
         assertx(_mesh.is_nice());
     }
-    for (Vertex v : _mesh.vertices()) {
-        assertx(_mesh.degree(v)>0); // no isolated vertices
-        v_dist(v) = BIGFLOAT;
-        // v_vtouch(v) is undefined
-        // v_vprev(v) is undefined
-    }
-    for (Edge e : _mesh.edges()) {
-        e_joined(e) = false;
-        e_bfsnum(e) = 0;
-    }
+    for (Vertex v : _mesh.vertices()) { assertx(_mesh.degree(v)>0); } // no isolated vertices
+    for (Edge e : _mesh.edges()) { assign_index(e); }
     {
         HH_TIMER(__genus);
         float fgenus = mesh_genus(_mesh); // somewhat slow implementation
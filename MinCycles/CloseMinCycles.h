@@ -18,18 +18,22 @@ class CloseMinCycles {
     int _ncycles {INT_MAX};              // by default, perform as many cycle closures as possible
     int _desired_genus {0};             // by default, simplify mesh topology to genus zero
     float _frac_cycle_length {1.f};     // by default, find exact minimal cycles (>1.f means approximate)
+    int _num_searches {1};              // seeds searched concurrently per round; 0 means get_max_threads() (the
+                                        //  result then depends on the machine)
     void compute();
  private:
+    struct SearchState;
     GMesh& _mesh;
     int _cgenus {INT_MAX};       // current mesh genus
     int _tot_handles {0};
     int _tot_tunnels {0};
-    Flag e_joined(Edge e);
-    void flood_reinitialize(Vertex vseed);
-    Array<Vertex> close_cycle(const CArrayView<Vertex> vao);
-    bool would_be_nonseparating_cycle(Edge e12, bool exact);
-    bool look_for_cycle(Vertex v1, Vertex v2, bool process, float verify_dist, int& num_edges);
-    void min_cycle_from_vertex(Vertex vseed, bool process, float& search_radius,
+    int _num_eindex {0};         // number of edge indices assigned so far
+    void assign_index(Edge e);
+    void flood_reinitialize(SearchState& st, Vertex vseed);
+    Array<Vertex> close_cycle(SearchState& st, const CArrayView<Vertex> vao);
+    bool would_be_nonseparating_cycle(SearchState& st, Edge e12, bool exact) const;
+    bool look_for_cycle(SearchState& st, Vertex v1, Vertex v2, bool process, float verify_dist, int& num_edges);
+    void min_cycle_from_vertex(SearchState& st, Vertex vseed, bool process, float& search_radius,
                                Vertex& farthest_vertex, int& num_edges);
     void find_cycles();
 };
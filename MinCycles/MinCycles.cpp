@@ -12,6 +12,7 @@ int maxcyclenedges = INT_MAX;
 int ncycles = INT_MAX;
 int genus = 0;
 float fraccyclelength = 1.f;
+int nsearches = 1;
 bool nooutput = false;
 
 GMesh mesh;
@@ -23,6 +24,7 @@ void do_closecycles() {
     cmc._ncycles = ncycles;
     cmc._desired_genus = genus;
     cmc._frac_cycle_length = fraccyclelength;
+    cmc._num_searches = nsearches;
     cmc.compute();
 }
 
@@ -37,6 +39,7 @@ int main(int argc, const char** argv) {
     ARGSP(genus,                "g : when mesh genus <=g");
     ARGSC("",                   ":*");
     ARGSP(fraccyclelength,      "frac>=1 : allow finding cycles with length fractionally greater than minimal");
+    ARGSP(nsearches,            "n : number of concurrent seed searches (1=sequential, 0=#threads)");
     ARGSC("",                   ":*");
     ARGSD(closecycles,          ": perform topological simplification");
     ARGSF(nooutput,             ": do not print mesh at program end");
@@ -12,6 +12,7 @@
 #include "Map.h"
 #include "Random.h"
 #include "Facedistance.h"
+#include "Parallel.h"
 #include "Timer.h"
 using namespace hh;
 
@@ -19,30 +20,28 @@ namespace {
 
 struct mvertex; using vertex = mvertex*;
 struct mvertex {
+    int id;                     // unique within the curve; hashing on it makes set traversals deterministic
     Point p;                    // position of vertex
     Vec2<vertex> v;             // { previous_vertex, next_vertex }; either may be nullptr
     Set<int> pts;               // points projecting onto associated edge (defined if v[1]!=nullptr)
 };
-Set<vertex> verts;
+struct hash_vertex { size_t operator()(vertex v) const { return v->id; } };
+using SetVertex = Set<vertex, hash_vertex>;
 
 struct S_pt {
     int n;
     Array<Point> co;            // position of point
     Array<vertex> cle;          // closest edge
     Array<float> dis2;          // distance squared to closest edge
-} pt;
-
-Set<vertex> ecand;              // set of candidate edges in stoc
+};
 
-float spring = 0.f;
 float fliter = 1;
 float crep = 1e-5f;
 bool nooutput = false;
 int verb = 1;
+bool batched = false;           // curves were fitted with -batch
 
 WSA3dStream g_oa3d{std::cout};
-Frame xform;                    // original verts+pts -> verts+pts in unit cube
-Frame xformi;                   // inverse
 enum EOperation { OP_ecol, OP_espl, OP_NUM };
 const Vec<string,OP_NUM> opname = {"ecol", "espl"};
 enum EResult { R_success, R_energy, R_illegal, R_NUM };
@@ -50,19 +49,79 @@ const Vec<string,R_NUM> orname = {"success", "positive_energy", "illegal"};
 struct S_opstat {
     Vec<int,OP_NUM> na, ns;
     Vec<int,R_NUM> nor;
-} opstat;
+};
 
 const Array<float> spring_sched = {1e-2f, 1e-3f, 1e-4f, 1e-8f};
 constexpr int k_max_gfit_iter = 30;
 unique_ptr<WFile> file_spawn;
 unique_ptr<WSA3dStream> a3d_spawn;
 
-float get_edis() {
+// A polyline fitted to a set of points.
+// In batch mode, many curves are fitted concurrently; each such curve has its own random number generator (so that
+//  its result does not depend on the other curves) and does not print diagnostics, record timers, or spawn output.
+struct Curve : noncopyable {
+    explicit Curve(bool pbatch = false, uint32_t seed = 0) : batch(pbatch), batch_random(seed) { }
+    ~Curve() { for (vertex v : verts) { delete v; } }
+    bool batch;
+    Random batch_random;
+    SetVertex verts;
+    S_pt pt {};
+    SetVertex ecand;            // set of candidate edges in stoc
+    float spring {0.f};
+    bool initialized {false};
+    Frame xform;                // original verts+pts -> verts+pts in unit cube
+    Frame xformi;               // inverse
+    S_opstat opstat;
+    int vertexnum {0};          // id to assign to next new vertex
+    //
+    Random& random()                            { return batch ? batch_random : Random::G; }
+    int verbosity() const                       { return batch ? 0 : verb; }
+    // Timers are not thread-safe, so the curves of a batch are not timed.
+    unique_ptr<Timer> timer(const string& name, Timer::EMode mode = Timer::EMode::normal) const {
+        return batch ? nullptr : make_unique<Timer>(name, mode);
+    }
+    vertex new_vertex() { vertex v = new mvertex; v->id = vertexnum++; verts.enter(v); return v; }
+    float get_edis() const;
+    float get_espr() const;
+    float get_erep() const;
+    void analyze_poly(int indent, const string& s) const;
+    void poly_transform(const Frame& f);
+    void compute_xform();
+    void initial_projection();
+    void perhaps_initialize();
+    void output_poly(WSA3dStream& oa3d, bool clearobject = false);
+    void enter_point(const Point& p, vertex v);
+    void initialize_poly(const Polygon& poly);
+    vertex locally_closest_edge(int pi, float& d2) const;
+    void change_edge(int pi, vertex v);
+    void reproject_locally(int pi);
+    void global_project();
+    void global_fit();
+    void local_fit(CArrayView<int> arpts, Vec2<vertex>& v, int niter, Point& newp,
+                   double& prss0, double& prss1) const;
+    void fit_ring(vertex v, int niter);
+    void cleanup_neighborhood(vertex v, int nri);
+    EResult try_ecol(vertex v, int ni, int nri, float& edrss);
+    EResult try_espl(vertex v, int ni, int nri, float& edrss);
+    EResult try_op(vertex v, EOperation op, float& edrss);
+    void create_poly(bool pclosed, int n);
+    void gfit(int niter);
+    void stoc();
+    void lfit(int ni, int nli);
+    void apply_schedule();
+    void reconstruct();
+    void simplify();
+    void spawn_output()                         { if (a3d_spawn && !batch) output_poly(*a3d_spawn, true); }
+};
+
+Curve g_curve;                  // the curve fitted by the command-line operations
+
+float Curve::get_edis() const {
     float edis = 0.f; for_int(i, pt.n) { edis += pt.dis2[i]; }
     return edis;
 }
 
-float get_espr() {
+float Curve::get_espr() const {
     double espr = 0.;
     for (vertex v : verts) {
         if (v->v[1]) espr += spring*dist2(v->p, v->v[1]->p);
@@ -70,11 +129,11 @@ float get_espr() {
     return float(espr);
 }
 
-float get_erep() {
+float Curve::get_erep() const {
     return crep*verts.num();
 }
 
-void analyze_poly(int indent, const string& s) {
+void Curve::analyze_poly(int indent, const string& s) const {
     string str; for_int(i, indent) str += " ";
     int nv = verts.num();
     float edis = get_edis(), espr = get_espr(), erep = get_erep();
@@ -85,31 +144,32 @@ void analyze_poly(int indent, const string& s) {
     showdf("%s  energies: edis=%g espr=%g erep=%g etot=%g\n", str.c_str(), edis, espr, erep, etot);
 }
 
-void poly_transform(const Frame& f) {
+void Curve::poly_transform(const Frame& f) {
     for (vertex v : verts) { v->p *= f; }
 }
 
-void compute_xform() {
+void Curve::compute_xform() {
     Bbox bb;
     bb.clear();
     for_int(i, pt.n) { bb.union_with(pt.co[i]); }
     for (vertex v : verts) { bb.union_with(v->p); }
     xform = bb.get_frame_to_small_cube();
-    if (verb>=1) showdf("Applying xform: %s", FrameIO::create_string(xform, 1, 0.f).c_str());
+    if (verbosity()>=1) showdf("Applying xform: %s", FrameIO::create_string(xform, 1, 0.f).c_str());
     xformi = ~xform;
     for_int(i, pt.n) { pt.co[i] *= xform; }
     poly_transform(xform);
 }
 
-void initial_projection() {
-    HH_TIMER(_initialproj);
+void Curve::initial_projection() {
+    auto up_timer = timer("_initialproj");
     // do it inefficiently for now ?
-    for_int(i, pt.n) {
+    // The points are projected concurrently, then entered into the edges in order.
+    Array<vertex> edges; for (vertex v : verts) { if (v->v[1]) edges.push(v); }
+    parallel_for_each(range(pt.n), [&](const int i) {
         if (!pt.cle[i]) {
             float mind2 = BIGFLOAT;
             vertex mine = nullptr;
-            for (vertex v : verts) {
-                if (!v->v[1]) continue;
+            for (vertex v : edges) {
                 float d2 = project_point_seg2(pt.co[i], v->p, v->v[1]->p);
                 if (d2<mind2) { mind2 = d2; mine = v; }
             }
@@ -117,25 +177,26 @@ void initial_projection() {
         }
         vertex v = pt.cle[i];
         pt.dis2[i] = project_point_seg2(pt.co[i], v->p, v->v[1]->p);
-        v->pts.enter(i);
-    }
-    analyze_poly(0, "INITIAL");
+    }, uint64_t(edges.num())*10);
+    for_int(i, pt.n) { pt.cle[i]->pts.enter(i); }
+    if (verbosity()>=1) analyze_poly(0, "INITIAL");
 }
 
-void perhaps_initialize() {
-    if (xform[0][0]) return;    // already initialized
+void Curve::perhaps_initialize() {
+    if (initialized) return;
+    initialized = true;
     assertx(pt.n && verts.num());
     assertw(spring>0);          // just warn user
     compute_xform();
     initial_projection();
 }
 
-void output_poly(WSA3dStream& oa3d, bool clearobject = false) {
+void Curve::output_poly(WSA3dStream& oa3d, bool clearobject) {
     perhaps_initialize();
     poly_transform(xformi);
     if (clearobject) oa3d.write_clear_object();
     A3dElem el;
-    Set<vertex> setv;
+    SetVertex setv;
     for (vertex v : verts) { setv.enter(v); }
     while (!setv.empty()) {
         vertex vf = setv.get_one(), vf0 = vf;
@@ -156,22 +217,21 @@ void output_poly(WSA3dStream& oa3d, bool clearobject = false) {
     poly_transform(xform);
 }
 
-void enter_point(const Point& p, vertex v) {
+void Curve::enter_point(const Point& p, vertex v) {
     pt.co.push(p);
     pt.cle.push(v);
     pt.dis2.push(0.f);
     pt.n++;
 }
 
-void initialize_poly(const Polygon& poly) {
+void Curve::initialize_poly(const Polygon& poly) {
     int num = poly.num();
     bool closed = !compare(poly[0], poly[num-1], 1e-6f);
     if (closed) --num;
     assertx(num>=(closed ? 3 : 2));
     vertex vf = nullptr, vl = nullptr;
     for_int(i, num) {
-        vertex v = new mvertex;
-        verts.enter(v);
+        vertex v = new_vertex();
         v->p = poly[i];
         v->v[0] = vl;
         if (vl) vl->v[1] = v;
@@ -181,10 +241,11 @@ void initialize_poly(const Polygon& poly) {
     assertx(vf); assertx(vl);   // HH_ASSUME(vf); HH_ASSUME(vl);
     vf->v[0] = closed ? vl : nullptr;
     vl->v[1] = closed ? vf : nullptr;
-    showdf("created %s poly structure with %d vertices\n", (closed ? "closed" : "open"), num);
+    if (verbosity()>=1) showdf("created %s poly structure with %d vertices\n", (closed ? "closed" : "open"), num);
 }
 
-void reproject_locally(int pi) {
+// Return the edge closest to point pi among its current edge and the two adjacent edges, without modifying the curve.
+vertex Curve::locally_closest_edge(int pi, float& d2) const {
     vertex v = assertx(pt.cle[pi]);
     assertx(v->pts.contains(pi)); // optional
     assertx(v->v[1]);             // optional
@@ -194,19 +255,30 @@ void reproject_locally(int pi) {
         (a = project_point_seg2(pt.co[pi], v->v[0]->p, v->p))<mind2) { mind2 = a; mine = v->v[0]; }
     if (v->v[1]->v[1] &&
         (a = project_point_seg2(pt.co[pi], v->v[1]->p, v->v[1]->v[1]->p))<mind2) { mind2 = a; mine = v->v[1]; }
-    pt.dis2[pi] = mind2;
-    if (mine==v) return;
-    assertx(v->pts.remove(pi));
-    mine->pts.enter(pi);
-    pt.cle[pi] = mine;
+    d2 = mind2;
+    return mine;
 }
 
-void global_project() {
-    // local projection
-    for_int(i, pt.n) { reproject_locally(i); }
+void Curve::change_edge(int pi, vertex v) {
+    if (v==pt.cle[pi]) return;
+    assertx(pt.cle[pi]->pts.remove(pi));
+    v->pts.enter(pi);
+    pt.cle[pi] = v;
 }
 
-void global_fit() {
+void Curve::reproject_locally(int pi) {
+    vertex v = locally_closest_edge(pi, pt.dis2[pi]);
+    change_edge(pi, v);
+}
+
+void Curve::global_project() {
+    // local projection; the points are projected concurrently, then moved to their new edges in order.
+    Array<vertex> ar_cle(pt.n);
+    parallel_for_each(range(pt.n), [&](const int i) { ar_cle[i] = locally_closest_edge(i, pt.dis2[i]); }, 100);
+    for_int(i, pt.n) { change_edge(i, ar_cle[i]); }
+}
+
+void Curve::global_fit() {
     Map<vertex,int> mvi;
     Array<vertex> va;
     for (vertex v : verts) {
@@ -217,7 +289,7 @@ void global_fit() {
     if (spring) {
         for (vertex v : verts) { if (v->v[1]) m++; }
     }
-    if (verb>=2) showf("GlobalFit: about to solve a %dx%d LLS system\n", m, n);
+    if (verbosity()>=2) showf("GlobalFit: about to solve a %dx%d LLS system\n", m, n);
     SparseLLS lls(m, n, 3);
     // Add point constraints
     for_int(i, pt.n) {
@@ -256,7 +328,8 @@ void global_fit() {
 }
 
 // v[0] or v[1] may be nullptr
-void local_fit(CArrayView<int> arpts, Vec2<vertex>& v, int niter, Point& newp, double& prss0, double& prss1) {
+void Curve::local_fit(CArrayView<int> arpts, Vec2<vertex>& v, int niter, Point& newp,
+                      double& prss0, double& prss1) const {
     assertx(v[0] || v[1]);
     float sqrtit = sqrt(spring);
     for_int(ni, niter) {
@@ -300,7 +373,7 @@ void local_fit(CArrayView<int> arpts, Vec2<vertex>& v, int niter, Point& newp, d
     }
 }
 
-void fit_ring(vertex v, int niter) {
+void Curve::fit_ring(vertex v, int niter) {
     assertx(v);
     Vec2<vertex> va { v->v[0], v->v[1] };
     Array<int> arpts;
@@ -310,7 +383,7 @@ void fit_ring(vertex v, int niter) {
     for (int pi : arpts) { reproject_locally(pi); }
 }
 
-void cleanup_neighborhood(vertex v, int nri) {
+void Curve::cleanup_neighborhood(vertex v, int nri) {
     assertx(v);
     if (!nri) return;
     vertex v0 = v->v[0], v00 = v0 && v0->v[0] ? v0->v[0] : nullptr;
@@ -331,7 +404,7 @@ void cleanup_neighborhood(vertex v, int nri) {
 //    v0      v      v1
 //    va[0]                 va[1]
 //    ev[0]   ev[1]  ev[2]
-EResult try_ecol(vertex v, int ni, int nri, float& edrss) {
+EResult Curve::try_ecol(vertex v, int ni, int nri, float& edrss) {
     vertex v0 = v->v[0], v1 = assertx(v->v[1]), ov = v0 ? v0 : v1;
     Vec2<vertex> va { v0, v1->v[1] };
     Vec3<vertex> ev { v0, v, v1 };
@@ -358,7 +431,7 @@ EResult try_ecol(vertex v, int ni, int nri, float& edrss) {
     double rss0, rss1; local_fit(arpts, va, ni, newp, rss0, rss1);
     double drss = rss1-rssf-double(crep);
     edrss = float(drss);
-    if (verb>=4) SHOW("ecol:", rssf, rss1, drss);
+    if (verbosity()>=4) SHOW("ecol:", rssf, rss1, drss);
     if (drss>=0) return R_energy; // energy function does not decrease
     // ALL SYSTEMS GO
     // move points off to other segment and reproject later
@@ -378,7 +451,7 @@ EResult try_ecol(vertex v, int ni, int nri, float& edrss) {
     return R_success;
 }
 
-EResult try_espl(vertex v, int ni, int nri, float& edrss) {
+EResult Curve::try_espl(vertex v, int ni, int nri, float& edrss) {
     // always legal
     Vec2<vertex> va { v, assertx(v->v[1]) };
     double rssf = spring*dist2(va[0]->p, va[1]->p);
@@ -389,11 +462,10 @@ EResult try_espl(vertex v, int ni, int nri, float& edrss) {
     double rss0, rss1; local_fit(arpts, va, ni, newp, rss0, rss1);
     double drss = rss1-rssf+double(crep);
     edrss = float(drss);
-    if (verb>=4) SHOW("espl:", rssf, rss1, drss);
+    if (verbosity()>=4) SHOW("espl:", rssf, rss1, drss);
     if (drss>=0) return R_energy; // energy function does not decrease
     // ALL SYSTEMS GO
-    vertex vn = new mvertex;
-    verts.enter(vn);
+    vertex vn = new_vertex();
     vn->p = newp;
     vn->v[0] = va[0];
     vn->v[1] = va[1];
@@ -408,8 +480,8 @@ EResult try_espl(vertex v, int ni, int nri, float& edrss) {
     return R_success;
 }
 
-EResult try_op(vertex v, EOperation op, float& edrss) {
-    HH_ATIMER(__try_op);
+EResult Curve::try_op(vertex v, EOperation op, float& edrss) {
+    auto up_timer = timer("__try_op", Timer::EMode::abbrev);
     EResult result;
     result = (op==OP_ecol ? try_ecol(v, int(4.f*fliter+.5f), int(2.f*fliter+.5f), edrss) :
                op==OP_espl ? try_espl(v, int(3.f*fliter+.5f), int(4.f*fliter+.5f), edrss) :
@@ -420,7 +492,7 @@ EResult try_op(vertex v, EOperation op, float& edrss) {
     return result;
 }
 
-void create_poly(bool pclosed, int n) {
+void Curve::create_poly(bool pclosed, int n) {
     // initialize the manifold using principal components of data
     assertx(pt.n);
     Frame frame; Vec3<float> eimag; principal_components(pt.co, frame, eimag);
@@ -444,99 +516,40 @@ void create_poly(bool pclosed, int n) {
     initialize_poly(poly);
 }
 
-void do_pfilename(Args& args) {
-    HH_TIMER(_pfilename);
-    RFile is(args.get_filename());
-    RSA3dStream ia3d(is());
-    A3dElem el;
-    Polygon poly;
-    for (;;) {
-        ia3d.read(el);
-        if (el.type()==A3dElem::EType::endfile) break;
-        if (el.type()==A3dElem::EType::comment) continue;
-        if (el.type()!=A3dElem::EType::polyline) { Warning("Non-polyline input ignored"); continue; }
-        el.update(A3dElem::EType::polygon);
-        el.get_polygon(poly);
-        initialize_poly(poly);
-    }
-    assertx(verts.num());
-}
-
-void do_sample(Args& args) {
-    assertx(!pt.n && verts.num());
-    int n = args.get_int();
-    // Note: could add sample points from the polygon based on edge length.
-    Array<vertex> arv; for (vertex v : verts) { if (v->v[1]) arv.push(v); }
-    for_int(i, n) {
-        vertex v = arv[Random::G.get_unsigned(arv.num())];
-        enter_point(interp(v->p, v->v[1]->p, Random::G.unif()), v);
-    }
-    // Enter vertices as points
-    for (vertex v : verts) {
-        enter_point(v->p, v->v[1] ? v : v->v[0]);
-    }
-    showdf("%d points read\n", pt.n);
-}
-
-void do_filename(Args& args) {
-    HH_TIMER(_filename);
-    assertx(!pt.n);
-    RFile is(args.get_filename());
-    RSA3dStream ia3d(is());
-    A3dElem el;
-    for (;;) {
-        ia3d.read(el);
-        if (el.type()==A3dElem::EType::endfile) break;
-        if (el.type()==A3dElem::EType::comment) continue;
-        if (el.type()!=A3dElem::EType::point) { Warning("Non-point input ignored"); continue; }
-        enter_point(el[0].p, nullptr);
-    }
-    showdf("%d points read\n", pt.n);
-}
-
-void do_opencurve(Args& args) {
-    create_poly(false, args.get_int());
-}
-
-void do_closedcurve(Args& args) {
-    create_poly(true, args.get_int());
-}
-
-void do_gfit(Args& args) {
+void Curve::gfit(int niter) {
     perhaps_initialize();
-    HH_TIMER(_gfit);
-    int niter = args.get_int();
-    if (verb>=2) showdf("\n");
-    if (verb>=1) showdf("Beginning gfit, %d iterations, spr=%g\n", niter, spring);
+    auto up_timer = timer("_gfit");
+    if (verbosity()>=2) showdf("\n");
+    if (verbosity()>=1) showdf("Beginning gfit, %d iterations, spr=%g\n", niter, spring);
     float ecsc = get_edis()+get_espr(); // energy constant simplicial complex
     int i;
     for (i = 0; !niter || i<niter; ) {
         if (!niter && i>=k_max_gfit_iter) break;
         i++;
-        if (verb>=3) showdf("iter %d/%d\n", i, niter);
-        std::cout.flush();
-        { HH_ATIMER(__lls); global_fit(); }
-        { HH_ATIMER(__project); global_project(); }
+        if (verbosity()>=3) showdf("iter %d/%d\n", i, niter);
+        if (!batch) std::cout.flush();
+        { auto up_timer2 = timer("__lls", Timer::EMode::abbrev); global_fit(); }
+        { auto up_timer2 = timer("__project", Timer::EMode::abbrev); global_project(); }
         float necsc = get_edis()+get_espr();
         float echange = necsc-ecsc;
         assertw(echange<0);
-        if (verb>=4) {
+        if (verbosity()>=4) {
             analyze_poly(2, "gfit_iter");
             showdf(" change in energy=%g\n", echange);
         }
-        if (a3d_spawn) output_poly(*a3d_spawn, true);
+        spawn_output();
         if (!niter && echange>-1e-4f) break;
         ecsc = necsc;
     }
-    if (verb>=2) showdf("Finished gfit, did %d iterations\n", i);
-    if (verb>=2) analyze_poly(0, "after_gfit");
+    if (verbosity()>=2) showdf("Finished gfit, did %d iterations\n", i);
+    if (verbosity()>=2) analyze_poly(0, "after_gfit");
 }
 
-void do_stoc() {
+void Curve::stoc() {
     perhaps_initialize();
-    HH_STIMER(_stoc);
-    if (verb>=2) showdf("\n");
-    if (verb>=1) showdf("Beginning stoc, spring=%g, fliter=%g\n", spring, fliter);
+    auto up_timer = timer("_stoc", Timer::EMode::summary);
+    if (verbosity()>=2) showdf("\n");
+    if (verbosity()>=1) showdf("Beginning stoc, spring=%g, fliter=%g\n", spring, fliter);
     fill(opstat.na, 0); fill(opstat.ns, 0);
     fill(opstat.nor, 0);
     {
@@ -544,7 +557,7 @@ void do_stoc() {
         for (vertex v : verts) { if (v->v[1]) ecand.enter(v); }
         while (!ecand.empty()) {
             i++;
-            vertex v = ecand.remove_random(Random::G);
+            vertex v = ecand.remove_random(random());
             assertx(v->v[1]);
             EOperation op; op = OP_ecol; // dummy_init(op);
             EResult result = R_illegal;
@@ -552,85 +565,214 @@ void do_stoc() {
             if (result!=R_success) { op = OP_ecol; result = try_op(v, op, edrss); }
             if (result!=R_success) { op = OP_espl; result = try_op(v, op, edrss); }
             if (result!=R_success) { nbad++; continue; }
-            if (verb>=3 || (verb>=2 && i>=lasti+100)) {
+            if (verbosity()>=3 || (verbosity()>=2 && i>=lasti+100)) {
                 showdf("it %5d, %s (after %3d) [%5d/%-5d] edrss=%e\n",
                        i, opname[op].c_str(), nbad, ecand.num(), verts.num(), edrss);
                 lasti = i;
             }
-            if (a3d_spawn) output_poly(*a3d_spawn, true);
+            spawn_output();
             nbad = 0;
         }
-        if (verb>=2) showdf("it %d, last search: %d wasted attempts\n", i, nbad);
+        if (verbosity()>=2) showdf("it %d, last search: %d wasted attempts\n", i, nbad);
     }
     const int nat = narrow_cast<int>(sum(opstat.na));
     const int nst = narrow_cast<int>(sum(opstat.ns));
-    if (verb>=2) {
+    if (verbosity()>=2) {
         showdf("Endstoc:  (col=%d/%d, espl=%d/%d tot=%d/%d)\n",
                opstat.ns[OP_ecol], opstat.na[OP_ecol], opstat.ns[OP_espl], opstat.na[OP_espl], nst, nat);
         showdf("Result of %d attempted operations:\n", nat);
         for_int(i, R_NUM) { showdf("  %5d %s\n", opstat.nor[i], orname[i].c_str()); }
     }
-    if (verb>=2) analyze_poly(0, "after_stoc");
+    if (verbosity()>=2) analyze_poly(0, "after_stoc");
 }
 
-void do_lfit(Args& args) {
+void Curve::lfit(int ni, int nli) {
     perhaps_initialize();
-    HH_STIMER(_lfit);
-    int ni = args.get_int();
-    int nli = args.get_int();
-    if (verb>=2) showdf("\n");
-    if (verb>=1) showdf("Beginning lfit, %d iters (nli=%d), spr=%g\n", ni, nli, spring);
+    auto up_timer = timer("_lfit", Timer::EMode::summary);
+    if (verbosity()>=2) showdf("\n");
+    if (verbosity()>=1) showdf("Beginning lfit, %d iters (nli=%d), spr=%g\n", ni, nli, spring);
     for_int(i, ni) {
         for (vertex v : verts) {
             fit_ring(v, nli);
         }
-        if (a3d_spawn) output_poly(*a3d_spawn, true);
+        spawn_output();
     }
-    if (verb>=2) showdf("Finished lfit\n");
-    if (verb>=2) analyze_poly(0, "after_lfit");
+    if (verbosity()>=2) showdf("Finished lfit\n");
+    if (verbosity()>=2) analyze_poly(0, "after_lfit");
 }
 
-void apply_schedule() {
+void Curve::apply_schedule() {
     while (spring>spring_sched[0]) {
-        { Args args { "2", "3" }; do_lfit(args); } // -lfit 2 3
-        do_stoc();                                 // -stoc
-        { Args args { "2", "3" }; do_lfit(args); } // -lfit 2 3
+        lfit(2, 3);             // -lfit 2 3
+        stoc();                 // -stoc
+        lfit(2, 3);             // -lfit 2 3
         spring *= .1f;
     }
     for (float spr : spring_sched) {
-        spring = spr;                              // -spring f
-        { Args args { "2", "3" }; do_lfit(args); } // -lfit 2 3
-        do_stoc();                                 // -stoc
-        { Args args { "2", "3" }; do_lfit(args); } // -lfit 2 3
+        spring = spr;           // -spring f
+        lfit(2, 3);             // -lfit 2 3
+        stoc();                 // -stoc
+        lfit(2, 3);             // -lfit 2 3
     }
 }
 
-void do_reconstruct() {
-    HH_TIMER(_reconstruct);
+void Curve::reconstruct() {
+    auto up_timer = timer("_reconstruct");
     if (!spring) spring = spring_sched[0];
     perhaps_initialize();
-    { Args args { "0" }; do_gfit(args); }
+    gfit(0);
     apply_schedule();
 }
 
-void do_simplify() {
-    HH_TIMER(_simplify);
+void Curve::simplify() {
+    auto up_timer = timer("_simplify");
     if (!spring) spring = spring_sched[0];
     perhaps_initialize();
     apply_schedule();
 }
 
+void do_pfilename(Args& args) {
+    HH_TIMER(_pfilename);
+    RFile is(args.get_filename());
+    RSA3dStream ia3d(is());
+    A3dElem el;
+    Polygon poly;
+    for (;;) {
+        ia3d.read(el);
+        if (el.type()==A3dElem::EType::endfile) break;
+        if (el.type()==A3dElem::EType::comment) continue;
+        if (el.type()!=A3dElem::EType::polyline) { Warning("Non-polyline input ignored"); continue; }
+        el.update(A3dElem::EType::polygon);
+        el.get_polygon(poly);
+        g_curve.initialize_poly(poly);
+    }
+    assertx(g_curve.verts.num());
+}
+
+void do_sample(Args& args) {
+    Curve& curve = g_curve;
+    assertx(!curve.pt.n && curve.verts.num());
+    int n = args.get_int();
+    // Note: could add sample points from the polygon based on edge length.
+    Array<vertex> arv; for (vertex v : curve.verts) { if (v->v[1]) arv.push(v); }
+    for_int(i, n) {
+        vertex v = arv[Random::G.get_unsigned(arv.num())];
+        curve.enter_point(interp(v->p, v->v[1]->p, Random::G.unif()), v);
+    }
+    // Enter vertices as points
+    for (vertex v : curve.verts) {
+        curve.enter_point(v->p, v->v[1] ? v : v->v[0]);
+    }
+    showdf("%d points read\n", curve.pt.n);
+}
+
+void do_filename(Args& args) {
+    HH_TIMER(_filename);
+    assertx(!g_curve.pt.n);
+    RFile is(args.get_filename());
+    RSA3dStream ia3d(is());
+    A3dElem el;
+    for (;;) {
+        ia3d.read(el);
+        if (el.type()==A3dElem::EType::endfile) break;
+        if (el.type()==A3dElem::EType::comment) continue;
+        if (el.type()!=A3dElem::EType::point) { Warning("Non-point input ignored"); continue; }
+        g_curve.enter_point(el[0].p, nullptr);
+    }
+    showdf("%d points read\n", g_curve.pt.n);
+}
+
+void do_opencurve(Args& args) {
+    g_curve.create_poly(false, args.get_int());
+}
+
+void do_closedcurve(Args& args) {
+    g_curve.create_poly(true, args.get_int());
+}
+
+void do_spring(Args& args) {
+    g_curve.spring = args.get_float();
+}
+
+void do_reconstruct() {
+    g_curve.reconstruct();
+}
+
+void do_simplify() {
+    g_curve.simplify();
+}
+
+void do_gfit(Args& args) {
+    g_curve.gfit(args.get_int());
+}
+
+void do_stoc() {
+    g_curve.stoc();
+}
+
+void do_lfit(Args& args) {
+    int ni = args.get_int();
+    int nli = args.get_int();
+    g_curve.lfit(ni, nli);
+}
+
+// Reconstruct a curve for each point set in a stream, where the point sets are separated by end-of-frame elements.
+// The curves are fitted concurrently and written in input order, each followed by an end-of-frame element.
+void do_batch(Args& args) {
+    HH_TIMER(_batch);
+    string filename = args.get_filename();
+    int n = args.get_int();     // >0: closed curves with n vertices; <0: open curves with -n vertices
+    assertx(abs(n)>=2);
+    Array<Array<Point>> point_sets(1);
+    {
+        RFile is(filename);
+        RSA3dStream ia3d(is());
+        A3dElem el;
+        for (;;) {
+            ia3d.read(el);
+            if (el.type()==A3dElem::EType::endfile) break;
+            if (el.type()==A3dElem::EType::comment) continue;
+            if (el.type()==A3dElem::EType::endframe) {
+                if (point_sets.last().num()) point_sets.push(Array<Point>());
+                continue;
+            }
+            if (el.type()!=A3dElem::EType::point) { Warning("Non-point input ignored"); continue; }
+            point_sets.last().push(el[0].p);
+        }
+        if (!point_sets.last().num()) point_sets.sub(1);
+    }
+    showdf("%d point sets read\n", point_sets.num());
+    Array<unique_ptr<Curve>> curves;
+    for_int(i, point_sets.num()) { curves.push(make_unique<Curve>(true, i)); }
+    parallel_for_each(range(curves.num()), [&](const int i) {
+        Curve& curve = *curves[i];
+        curve.spring = g_curve.spring;
+        for (const Point& p : point_sets[i]) { curve.enter_point(p, nullptr); }
+        curve.create_poly(n>0, abs(n));
+        curve.reconstruct();
+    });
+    int nv = 0; float etot = 0.f;
+    for (auto& curve : curves) {
+        nv += curve->verts.num();
+        etot += curve->get_edis()+curve->get_espr()+curve->get_erep();
+        if (verb>=2) showdf(" curve: points=%d v=%d\n", curve->pt.n, curve->verts.num());
+        if (!nooutput) { curve->output_poly(g_oa3d); g_oa3d.write_end_frame(); }
+    }
+    showdf("Fitted %d curves: total v=%d etot=%g\n", curves.num(), nv, etot);
+    batched = true;
+}
+
 void do_outpoly(Args& args) {
     HH_TIMER(_outpoly);
     WFile os(args.get_filename());
     WSA3dStream oa3d(os());
-    output_poly(oa3d);
+    g_curve.output_poly(oa3d);
 }
 
 void do_spawn(Args& args) {
     file_spawn = make_unique<WFile>(args.get_filename());
     a3d_spawn = make_unique<WSA3dStream>((*file_spawn)());
-    output_poly(*a3d_spawn);
+    g_curve.output_poly(*a3d_spawn);
 }
 
 } // namespace
@@ -645,8 +787,9 @@ int main(int argc, const char** argv) {
     ARGSP(crep,                 "v : set constant for representation energy");
     ARGSD(reconstruct,          ": apply reconstruction schedule");
     ARGSD(simplify,             ": apply simplification schedule");
+    ARGSD(batch,                "file.pts n : reconstruct curve per point set ('f'-separated) from n-gon (n<0: open)");
     ARGSC("",                   ":");
-    ARGSP(spring,               "tension : set sprint constant");
+    ARGSD(spring,               "tension : set sprint constant");
     ARGSC("",                   ":");
     ARGSD(gfit,                 "niter : do global fit (0=until convergence)");
     ARGSD(stoc,                 ": do stochastic operations");
@@ -659,15 +802,16 @@ int main(int argc, const char** argv) {
     HH_TIMER(Polyfit);
     showdf("%s", args.header().c_str());
     args.parse();
-    perhaps_initialize();
-    analyze_poly(0, "FINAL");
+    if (!batched) {
+        g_curve.perhaps_initialize();
+        g_curve.analyze_poly(0, "FINAL");
+    }
     HH_TIMER_END(Polyfit);
     if (file_spawn) {
         a3d_spawn = nullptr;
         file_spawn = nullptr;
     }
     hh_clean_up();
-    if (!nooutput) output_poly(g_oa3d);
-    for (vertex v : verts) { delete v; }
+    if (!nooutput && !batched) g_curve.output_poly(g_oa3d);
     return 0;
 }
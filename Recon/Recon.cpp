@@ -32,7 +32,7 @@
 #include "Spatial.h"
 #include "Principal.h"
 #include "Graph.h"
-#include "GraphOp.h"            // graph_edge_stats(), graph_num_components(), graph_mst()
+#include "GraphOp.h"            // graph_edge_stats(), graph_num_components(), graph_mst_parallel()
 #include "Contour.h"
 #include "GMesh.h"
 #include "MeshOp.h"
@@ -58,6 +58,8 @@ int prop = 2;
 int usenormals = 0;             // 1=use them in optimization, 2=skip opt+use to orient, 3=use_exactly
 int maxkintp = 20;
 int minkintp = 4;
+bool octree = false;            // contour an adaptive octree instead of the uniform grid
+float octree_tol = .05f;        // octree flatness tolerance, as a fraction of samplingd
 
 int num;                        // # data points
 bool is_3D;                     // is it a 3D problem (vs. 2D)
@@ -180,21 +182,6 @@ void init_output() {
     iom = process_arg('m');
 }
 
-void compute_tp(int i, int& n, Frame& f) {
-    PArray<Point,40> pa;
-    SpatialSearch<int> ss(SPp.get(), co[i]);
-    for (;;) {
-        assertx(!ss.done());
-        float dis2; int pi = ss.next(&dis2);
-        if ((pa.num()>=minkintp && dis2>square(samplingd)) || pa.num()>=maxkintp) break;
-        pa.push(co[pi]);
-        if (pi!=i && !gpcpseudo->contains(i, pi)) gpcpseudo->enter_undirected(i, pi);
-    }
-    Vec3<float> eimag;
-    principal_components(pa, f, eimag);
-    n = pa.num();
-}
-
 void draw_pc_extent(Mk3d& mk) {
     mk_save; mk.scale(2);
     Mklib mklib(mk);
@@ -247,10 +234,16 @@ void process_principal() {
     HH_STAT(Sr21); HH_STAT(Sr20); HH_STAT(Sr10);
     HH_STAT(Slen2); HH_STAT(Slen1); HH_STAT(Slen0);
     HH_STAT(Snei);
+    Array<Frame> frames(num);
+    Array<Array<int>> neighbors;
+    local_principal_components(co, *SPp, minkintp, maxkintp, samplingd, frames, &neighbors);
     for_int(i, num) {
-        int n; Frame f; compute_tp(i, n, f);
+        const Frame& f = frames[i];
+        for (int pi : neighbors[i]) {
+            if (pi!=i && !gpcpseudo->contains(i, pi)) gpcpseudo->enter_undirected(i, pi);
+        }
         if (ioo) pctrans[i] = f;
-        Snei.enter(n);
+        Snei.enter(neighbors[i].num());
         float len0 = mag(f.v(0)), len1 = mag(f.v(1)), len2 = mag(f.v(2));
         assertx(len2>0);        // principal_components() should do this
         Slen0.enter(len0); Slen1.enter(len1); Slen2.enter(len2);
@@ -355,19 +348,17 @@ void show_propagation(int i, int j, float dotp) {
     iop->end_polyline();
 }
 
-// Propagate orientation along tree gpcpath from vertex i (orig. num) using recursive DFS.
-void propagate_along_path(int i) {
-    assertx(i>=0 && i<=num);
-    if (i<num) assertx(pciso[i]);
-    for (int j : gpcpath->edges(i)) {
-        assertx(j>=0 && j<=num);
-        if (j==num || pciso[j]) continue; // immediate caller
-        float corr = pc_dot(i, j);
-        pScorr->enter(abs(corr));
-        if (corr<0) pcnor[j] = -pcnor[j];
+// Propagate orientation along tree gpcpath from its root num, in breadth-first order.
+void propagate_along_path() {
+    Array<int> parent; Array<float> dots; Array<bool> flip;
+    Array<int> order = graph_propagate_orientation(*gpcpath, num, pc_dot, parent, dots, flip);
+    for_intL(k, 1, order.num()) {
+        int i = order[parent[k]], j = order[k];
+        assertx(j>=0 && j<num && !pciso[j]);
+        pScorr->enter(abs(dots[k]));
+        if (flip[k]) pcnor[j] = -pcnor[j];
         pciso[j] = true;
-        show_propagation(i, j, abs(corr));
-        propagate_along_path(j);
+        show_propagation(i, j, abs(dots[k]));
     }
 }
 
@@ -380,11 +371,11 @@ void orient_set(const Set<int>& nodes) {
     {
         HH_TIMER(__graphmst);
         // must be connected here!
-        assertx(graph_mst<int>(*gpcpseudo, pc_corr, *gpcpath));
+        assertx(graph_mst_parallel<int>(*gpcpseudo, pc_corr, *gpcpath));
     }
     int nextlink = gpcpath->out_degree(num);
     if (nextlink>1) showdf(" num_exteriorlinks_used=%d\n", nextlink);
-    propagate_along_path(num);
+    propagate_along_path();
     gpcpath = nullptr;
     remove_exterior_orientation();
 }
@@ -513,7 +504,7 @@ float compute_signed(const Point& p, Point& proj) {
         float dis2; ss.next(&dis2);
         if (dis2>square(samplingd)) return k_Contour_undefined;
     }
-    if (prop) {
+    if (prop && !octree) {
         // check that grid point is close to a data point
         SpatialSearch<int> ss(SPp.get(), p);
         float dis2; ss.next(&dis2);
@@ -524,6 +515,98 @@ float compute_signed(const Point& p, Point& proj) {
     return dis;
 }
 
+// For each point, find the nearest element of the spatial partition sp, whose element positions are elems.
+// A single search about the centroid of the (nearby) points continues until no unvisited element can be nearer
+//  to any of the points, so the result agrees with separate searches (except for ties).
+void nearest_elements(const PointSpatial<int>& sp, CArrayView<Point> elems, CArrayView<Point> points,
+                      ArrayView<int> nearest, ArrayView<float> dis2s) {
+    const int n = points.num();
+    if (!n) return;
+    Homogeneous h; for (const Point& p : points) { h += p; }
+    Point pcenter = to_Point(h/float(n));
+    Array<float> radii(n); for_int(i, n) { radii[i] = dist(points[i], pcenter); }
+    fill(dis2s, BIGFLOAT);
+    SpatialSearch<int> ss(&sp, pcenter);
+    while (!ss.done()) {
+        float dis2; int ei = ss.next(&dis2);
+        // All unvisited elements are at least dis from pcenter.
+        float dis = sqrt(dis2);
+        bool all_found = true;
+        for_int(i, n) {
+            float d2 = dist2(points[i], elems[ei]);
+            if (d2<dis2s[i]) { dis2s[i] = d2; nearest[i] = ei; }
+            if (!(dis2s[i]<=square(max(dis-radii[i], 0.f)))) all_found = false;
+        }
+        if (all_found) break;
+    }
+    for_int(i, n) { assertx(dis2s[i]<BIGFLOAT); }
+}
+
+// For each point, determine if some element of sp (whose element positions are elems) lies within distance dmax,
+//  using a single search about the centroid of the (nearby) points.
+void near_elements(const PointSpatial<int>& sp, CArrayView<Point> elems, CArrayView<Point> points, float dmax,
+                   ArrayView<bool> are_near) {
+    const int n = points.num();
+    if (!n) return;
+    Homogeneous h; for (const Point& p : points) { h += p; }
+    Point pcenter = to_Point(h/float(n));
+    Array<float> radii(n); for_int(i, n) { radii[i] = dist(points[i], pcenter); }
+    fill(are_near, false);
+    SpatialSearch<int> ss(&sp, pcenter);
+    while (!ss.done()) {
+        float dis2; int ei = ss.next(&dis2);
+        // All unvisited elements are at least dis from pcenter.
+        float dis = sqrt(dis2);
+        bool all_found = true;
+        for_int(i, n) {
+            if (are_near[i]) continue;
+            if (dist2(points[i], elems[ei])<=square(dmax)) { are_near[i] = true; continue; }
+            if (dis-radii[i]<=dmax) all_found = false;
+        }
+        if (all_found) break;
+    }
+}
+
+// Same as compute_unsigned() on each of the nearby points.
+void compute_unsigned_batch(CArrayView<Point> points, ArrayView<float> dis) {
+    const int n = points.num();
+    Array<int> nearest(n); Array<float> dis2s(n);
+    nearest_elements(*SPp, co, points, nearest, dis2s);
+    for_int(i, n) { dis[i] = sqrt(dis2s[i])-unsigneddis; }
+}
+
+// Same as compute_signed() on each of the nearby points.
+void compute_signed_batch(CArrayView<Point> points, ArrayView<float> dis) {
+    assertx(is_3D);
+    const int n = points.num();
+    Array<int> nearest(n); Array<float> dis2s(n);
+    nearest_elements(*SPpc, pcorg, points, nearest, dis2s);
+    Array<int> ind; Array<Point> projs;
+    for_int(i, n) {
+        int tpi = nearest[i];
+        dis[i] = dot(points[i]-pcorg[tpi], pcnor[tpi]);
+        Point proj = points[i]-dis[i]*pcnor[tpi];
+        if (proj[0]<=0 || proj[0]>=1 || proj[1]<=0 || proj[1]>=1 || proj[2]<=0 || proj[2]>=1) {
+            dis[i] = k_Contour_undefined;
+        } else {
+            ind.push(i); projs.push(proj);
+        }
+    }
+    Array<bool> are_near(n);
+    // check that projected points are close to data points
+    near_elements(*SPp, co, projs, samplingd, are_near.head(projs.num()));
+    for_int(j, projs.num()) { if (!are_near[j]) dis[ind[j]] = k_Contour_undefined; }
+    if (prop && !octree) {         // (for the octree, the band about the data points plays this role)
+        // check that grid points are close to data points
+        Array<Point> pts; ind.init(0);
+        for_int(i, n) { if (dis[i]!=k_Contour_undefined) { ind.push(i); pts.push(points[i]); } }
+        float grid_diagonal = sqrt(3.f)/gridsize;
+        const float fudge = 1.2f;
+        near_elements(*SPp, co, pts, grid_diagonal*fudge, are_near.head(pts.num()));
+        for_int(j, pts.num()) { if (!are_near[j]) dis[ind[j]] = k_Contour_undefined; }
+    }
+}
+
 void print_directed_seg(Mk3d& mk, const Point& p1, const Point& p2, const A3dColor& col) {
     Vector v = p2-p1;
     assertx(v.normalize());
@@ -555,6 +638,35 @@ template<int D> struct eval_point {
     }
 };
 
+// Thread-safe evaluation (no iol output) for Contour3DMeshParallel, which evaluates the cube vertices of each
+//  marching front together.  These are grouped into clusters of nearby points that share a single spatial search.
+struct eval_batch3D {
+    float operator()(const Vec3<float>& p) const {
+        Point proj;
+        return unsigneddis ? compute_unsigned(p, proj) : compute_signed(p, proj);
+    }
+    void operator()(CArrayView<Vec3<float>> points, ArrayView<float> values) const {
+        const int n = points.num();
+        const float fcluster = 1.f/samplingd; // clusters have side length samplingd
+        auto cluster_key = [&](int i) {
+            Vec3<int> ci = convert<int>(points[i]*fcluster);
+            return (uint64_t(ci[0])<<42) | (uint64_t(ci[1])<<21) | uint64_t(ci[2]);
+        };
+        Array<int> order(n); for_int(i, n) { order[i] = i; }
+        Array<uint64_t> keys(n); for_int(i, n) { keys[i] = cluster_key(i); }
+        sort(order, [&](int i1, int i2) { return keys[i1]<keys[i2] || (keys[i1]==keys[i2] && i1<i2); });
+        Array<Point> pts; Array<float> dis;
+        for (int i0 = 0; i0<n; ) {
+            int i1 = i0+1; while (i1<n && keys[order[i1]]==keys[order[i0]]) i1++;
+            pts.init(0); for_intL(j, i0, i1) { pts.push(points[order[j]]); }
+            dis.init(pts.num());
+            if (unsigneddis) compute_unsigned_batch(pts, dis); else compute_signed_batch(pts, dis);
+            for_intL(j, i0, i1) { values[order[j]] = dis[j-i0]; }
+            i0 = i1;
+        }
+    }
+};
+
 struct output_border3D {
     void operator()(const Array<Vec3<float>>& poly) const {
         assertx(ioc);
@@ -594,6 +706,15 @@ struct output_contour2D {
     }
 };
 
+template<typename Contour> void march_from_pcorg(Contour& contour) {
+    for_int(i, num) { contour.march_from(pcorg[i]); }
+}
+
+template<typename Eval> void march_from_pcorg(Contour3DMeshParallel<Eval>& contour) {
+    Array<Vec3<float>> startps(pcorg);
+    contour.march_from(startps);
+}
+
 template<typename Contour> void contour_3D(Contour& contour) { // with or without border
     contour.set_ostream(&std::cout);
     if (unsigneddis) {
@@ -604,7 +725,7 @@ template<typename Contour> void contour_3D(Contour& contour) { // with or withou
             if (contour.march_from(p)>1) break;
         }
     } else {
-        for_int(i, num) { contour.march_from(pcorg[i]); }
+        march_from_pcorg(contour);
     }
 }
 
@@ -623,16 +744,36 @@ template<typename Contour> void contour_2D(Contour& contour) { // with or withou
     }
 }
 
+// Contour an octree refined up to gridsize cells near the data points, but only to the resolution of samplingd
+//  where the signed distance is nearly linear.
+void contour_octree() {
+    assertx(is_3D && !ioc && !iol);
+    int max_level = 0; while ((1<<max_level)<gridsize) max_level++;
+    int min_level = 0; while (min_level<max_level && (1<<min_level)*samplingd<1.f) min_level++;
+    showdf("octree levels %d-%d\n", min_level, max_level);
+    Contour3DOctree<eval_batch3D> contour(max_level, &mesh);
+    contour.set_ostream(&std::cout);
+    contour.set_min_level(min_level);
+    contour.set_flatness_tolerance(octree_tol*samplingd);
+    Array<Vec3<float>> points(co);
+    contour.contour_near(points, samplingd);
+}
+
 void process_contour() {
     HH_TIMER(_contour);
     if (is_3D) {
         // Note: now mesh is always created even if !iom.
-        if (ioc) {
+        if (octree) {
+            contour_octree();
+        } else if (ioc) {
             Contour3DMesh<eval_point<3>, output_border3D> contour(gridsize, &mesh);
             contour_3D(contour);
-        } else {
+        } else if (iol) {
             Contour3DMesh<eval_point<3>> contour(gridsize, &mesh);
             contour_3D(contour);
+        } else {
+            Contour3DMeshParallel<eval_batch3D> contour(gridsize, &mesh);
+            contour_3D(contour);
         }
     } else {
         if (ioc) {
@@ -696,6 +837,8 @@ int main(int argc, const char** argv) {
     ARGSP(what,                 "string : output codes 'dbufgpohlcm' (default mesh 'm')");
     ARGSP(samplingd,            "f : sampling density + noise (delta+rho)");
     ARGSP(gridsize,             "n : contouring # grid cells (opt.)");
+    ARGSF(octree,               ": contour adaptive octree (finest level has >=gridsize cells)");
+    ARGSP(octree_tol,           "f : octree flatness tolerance (fraction of samplingd)");
     ARGSP(maxkintp,             "k : max # points in tp");
     ARGSP(minkintp,             "k : min # points in tp");
     ARGSP(unsigneddis,          "f : use unsigned distance, set value");
@@ -6,6 +6,7 @@
 #include "SubMesh.h"
 #include "Facedistance.h"
 #include "MeshOp.h"
+#include "MeshAttrib.h"
 #include "GeomOp.h"
 #include "Homogeneous.h"
 #include "LLS.h"
@@ -21,6 +22,7 @@
 #include "FrameIO.h"
 #include "RangeOp.h"
 #include "MathOp.h"
+#include "Parallel.h"
 using namespace hh;
 
 namespace {
@@ -267,15 +269,14 @@ void global_all_project(const SubMesh& smesh) {
     HH_STIMER(___gallproject);
     const GMesh& mesh = smesh.mesh();
     MeshSearch msearch(&mesh, false);
-    Face hintf = nullptr;
-    for_int(i, co.num()) {
+    // The points are projected concurrently; without local projection, the search ignores any hint face.
+    parallel_for_each(range(co.num()), [&](const int i) {
         Bary bary; Point clp; float d2;
-        gscmf[i] = msearch.search(co[i], hintf, bary, clp, d2);
-        hintf = gscmf[i];
+        gscmf[i] = msearch.search(co[i], nullptr, bary, clp, d2);
         gbary[i] = bary;
         gclp[i] = clp;
         gdis2[i] = d2;
-    }
+    }, 5000);
 }
 
 void global_neighb_project(const SubMesh& smesh) {
@@ -283,58 +284,92 @@ void global_neighb_project(const SubMesh& smesh) {
     if (g_force_global_project) {
         global_all_project(smesh);
     } else {
-        for_int(i, co.num()) {
+        parallel_for_each(range(co.num()), [&](const int i) {
             gdis2[i] = project_point_neighb(smesh.mesh(), co[i], gscmf[i], gbary[i], gclp[i], true);
-        }
+        }, 1000);
     }
 }
 
-void global_lls(SubMesh& smesh, double& rss0, double& rss1) {
-    HH_STIMER(___glls);
+// Least-squares system of the global fit, whose structure is kept across iterations while the topology of
+//  the subdivided mesh is unchanged: the indexing of the control vertices, the spring rows, and the solver.
+struct GlobalLLS {
+    explicit GlobalLLS(SubMesh& smesh);
+    SubMesh& _smesh;
+    Map<Vertex,int> _mvi;       // control vertex -> column index
+    Array<Vertex> _iv;          // column index -> control vertex
+    SparseLLS::Csr _springs;    // rows [co.num(), co.num()+_iv.num()) if spring
+    SparseLLS _lls;
+};
+
+GlobalLLS::GlobalLLS(SubMesh& smesh) : _smesh(smesh), _lls(co.num()+(spring ? smesh.orig_mesh().num_vertices() : 0),
+                                                          smesh.orig_mesh().num_vertices(), 3) {
     GMesh& omesh = smesh.orig_mesh();
-    GMesh& mesh = smesh.mesh();
-    Map<Vertex,int> mvi; Array<Vertex> iv;
     for (Vertex v : omesh.vertices()) {
-        mvi.enter(v, iv.num()); iv.push(v);
-    }
-    int m = co.num(), n = iv.num();
-    int mm = spring ? m+n : m;
-    SparseLLS lls(mm, n, 3);
-    lls.set_max_iter(10);
-    Array<Vertex> va;
-    for_int(i, m) {
-        mesh.get_vertices(gscmf[i], va); assertx(va.num()==3);
-        Combvh tricomb;
-        for_int(j, 3) { tricomb.c[va[j]] = gbary[i][j]; }
-        Combvh comb = smesh.compose_c_mvcvh(tricomb);
-        HH_SSTAT(Scombnum, comb.c.num());
-        Homogeneous h = Homogeneous(co[i])-comb.h;
-        lls.enter_b_r(i, h.head(3));
-        for_combination(comb.c, [&](Vertex v, float val) {
-            lls.enter_a_rc(i, mvi.get(v), val);
-        });
+        _mvi.enter(v, _iv.num()); _iv.push(v);
     }
+    _lls.set_max_iter(10);
     if (spring) {
         // These are vertex-based springs, unlike edge-based in Meshfit.
         float sqrt_spring = sqrt(spring);
-        for_int(i, n) {
-            lls.enter_a_rc(m+i, i, +sqrt_spring);
-            int deg = omesh.degree(iv[i]);
-            for (Vertex v : omesh.vertices(iv[i])) {
-                lls.enter_a_rc(m+i, mvi.get(v), -sqrt_spring/deg);
+        _springs._start.push(0);
+        for (Vertex vi : _iv) {
+            _springs._index.push(_mvi.get(vi)); _springs._value.push(+sqrt_spring);
+            int deg = omesh.degree(vi);
+            for (Vertex v : omesh.vertices(vi)) {
+                _springs._index.push(_mvi.get(v)); _springs._value.push(-sqrt_spring/deg);
             }
-            Vector zero(0.f, 0.f, 0.f);
-            lls.enter_b_r(m+i, zero);
+            _springs._start.push(_springs._index.num());
         }
     }
+}
+
+void global_lls(GlobalLLS& glls, double& rss0, double& rss1) {
+    HH_STIMER(___glls);
+    SubMesh& smesh = glls._smesh;
+    GMesh& omesh = smesh.orig_mesh();
+    GMesh& mesh = smesh.mesh();
+    SparseLLS& lls = glls._lls;
+    lls.clear();
+    int m = co.num(), n = glls._iv.num();
+    // The data rows are assembled concurrently in blocks of points and then entered in order.
+    const int block_size = 1024;
+    Array<SparseLLS::Csr> blocks((m+block_size-1)/block_size);
+    Array<Homogeneous> ar_h(m);
+    parallel_for_each(range(blocks.num()), [&](const int ib) {
+        SparseLLS::Csr& block = blocks[ib];
+        block._start.push(0);
+        Array<Vertex> va;
+        for_intL(i, ib*block_size, min((ib+1)*block_size, m)) {
+            mesh.get_vertices(gscmf[i], va); assertx(va.num()==3);
+            Combvh tricomb;
+            for_int(j, 3) { tricomb.c[va[j]] = gbary[i][j]; }
+            Combvh comb = smesh.compose_c_mvcvh(tricomb);
+            ar_h[i] = Homogeneous(co[i])-comb.h;
+            for_combination(comb.c, [&](Vertex v, float val) {
+                block._index.push(glls._mvi.get(v)); block._value.push(val);
+            });
+            block._start.push(block._index.num());
+        }
+    }, block_size*400);
+    for_int(ib, blocks.num()) {
+        const SparseLLS::Csr& block = blocks[ib];
+        for_int(k, block.nrows()) { HH_SSTAT(Scombnum, block._start[k+1]-block._start[k]); }
+        lls.enter_a_rows(ib*block_size, block);
+    }
+    for_int(i, m) { lls.enter_b_r(i, ar_h[i].head(3)); }
+    if (spring) {
+        lls.enter_a_rows(m, glls._springs);
+        Vector zero(0.f, 0.f, 0.f);
+        for_int(i, n) { lls.enter_b_r(m+i, zero); }
+    }
     for_int(i, n) {
-        lls.enter_xest_r(i, omesh.point(iv[i]));
+        lls.enter_xest_r(i, omesh.point(glls._iv[i]));
     }
     // Since specify max_iter, do not solve until convergence.
     { HH_STIMER(____gsolve); lls.solve(&rss0, &rss1); }
     for_int(i, n) {
         Point p; lls.get_x_r(i, p);
-        omesh.set_point(iv[i], p);
+        omesh.set_point(glls._iv[i], p);
     }
 }
 
@@ -362,12 +397,16 @@ void do_gfit(Args& args) {
     smesh.update_vertex_positions();
     global_all_project(smesh);
     if (verb>=2) analyze_mesh("gfit_before");
+    GlobalLLS glls(smesh);
     for_int(ni, niter) {
         HH_STIMER(__gfit_iter);
-        double rss0, rss1; global_lls(smesh, rss0, rss1);
+        Timer timer;
+        double rss0, rss1; global_lls(glls, rss0, rss1);
         if (verb>=3) showf(" gopt %d/%d lls rss0=%g rss1=%g\n", ni+1, niter, rss0, rss1);
         smesh.update_vertex_positions();
         global_neighb_project(smesh);
+        timer.stop();
+        if (verb>=2) showf(" gfit iter %d/%d: %.3fs (cpu %.3fs)\n", ni+1, niter, timer.real(), timer.cpu());
     }
     if (os) {
         gmesh.record_changes(os);
@@ -381,8 +420,6 @@ void do_gfit(Args& args) {
 
 // *** fgfit
 
-HH_SAC_ALLOCATE_FUNC(Mesh::MVertex, Vector, v_grad);
-
 // Test using:
 // Filtermesh ~/data/recon/new/cactus.crep1e-5.m -angle 55 -mark | Subdivfit -mf - -fi ~/data/recon/new/cactus.3337.pts -verb 3 -fgfit 60 >~/tmp/cactus.fgfit.m && G3dcmp ~/data/recon/new/cactus.nsub2.crep1e-5p.0.m ~/tmp/cactus.fgfit.m -key DmDe
 // verdict: not stable enough; often jumps out of initial minimum to worse state; use do_gfit instead.
@@ -410,6 +447,7 @@ void do_fgfit(Args& args) {
         int _niter;
         double _etot {0.};
         bool _desire_global_project {false};
+        VertexAttrib<Vector> _vgrad {gmesh}; // gradient at each vertex
         FG(SubMesh& smesh) : _smesh(smesh) {
             for (Vertex v : gmesh.vertices()) { _mvi.enter(v, _iv.num()); _iv.push(v); }
             _x.init(_iv.num()*3);
@@ -457,7 +495,7 @@ void do_fgfit(Args& args) {
                 }
             }
             // Computer gradient
-            for (Vertex v : gmesh.vertices()) { v_grad(v) = Vector(0.f, 0.f, 0.f); }
+            _vgrad.fill(Vector(0.f, 0.f, 0.f));
             Array<Vertex> va;
             for_int(i, co.num()) {
                 _smesh.mesh().get_vertices(gscmf[i], va); assertx(va.num()==3);
@@ -467,7 +505,7 @@ void do_fgfit(Args& args) {
                     float a = -2*gbary[i][j];
                     if (!a) continue;
                     const Combvh& comb = _smesh.combination(va[j]); assertx(is_zero(comb.h));
-                    for_combination(comb.c, [&](Vertex v, float val) { v_grad(v) += vtop*(a*val); });
+                    for_combination(comb.c, [&](Vertex v, float val) { _vgrad[v] += vtop*(a*val); });
                 }
             }
             if (spring) {
@@ -476,7 +514,7 @@ void do_fgfit(Args& args) {
                     Homogeneous h(gmesh.point(v));
                     float fac = 1.f/gmesh.degree(v);
                     for (Vertex vv : gmesh.vertices(v)) { h -= fac*Homogeneous(gmesh.point(vv)); }
-                    v_grad(v) += to_Vector(h)*sqrt_spring;
+                    _vgrad[v] += to_Vector(h)*sqrt_spring;
                 }
             }
             if (areafac) {
@@ -494,12 +532,12 @@ void do_fgfit(Args& args) {
                         float weight = farea/assertx(mag2(h));
                         h *= weight;
                         const Combvh& comb = _smesh.combination(v); assertx(is_zero(comb.h));
-                        for_combination(comb.c, [&](Vertex vv, float val) { v_grad(vv) += h*val; });
+                        for_combination(comb.c, [&](Vertex vv, float val) { _vgrad[vv] += h*val; });
                     }
                 }
             }
             for_int(j, gmesh.num_vertices()) {
-                const Vector& grad = v_grad(_iv[j]);
+                const Vector& grad = _vgrad[_iv[j]];
                 for_int(c, 3) { ret_grad[j*3+c] = grad[c]; }
             }
             _iter++;
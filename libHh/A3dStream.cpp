@@ -2,12 +2,14 @@
 #include "A3dStream.h"
 
 #include <cstdio>               // sscanf()
+#include <cstring>              // std::memcpy()
 
 #include "NetworkOrder.h"
 #include "BinaryIO.h"
 #include "StringOp.h"
 #include "Polygon.h"
 #include "RangeOp.h"
+#include "FileIO.h"             // mapped_stream_remainder(), LineTokenizer
 
 namespace hh {
 
@@ -155,6 +157,8 @@ void RA3dStream::set_current_color(char ctype, const Vec3<float>& f) {
 // *** RSA3dStream
 
 bool RSA3dStream::read_line(bool& binary, char& ctype, Vec3<float>& f, string& comment) {
+    ArrayView<char> mapped_buf = mapped_stream_remainder(_is);
+    if (mapped_buf.num()) return read_line_mapped(mapped_buf, binary, ctype, f, comment);
     // _is >> std::ws; // commented 20121211
     char ch;
     if (_is.peek()=='\n') _is.get(ch); // there may be a blank line between elements
@@ -189,6 +193,38 @@ bool RSA3dStream::read_line(bool& binary, char& ctype, Vec3<float>& f, string& c
     return true;
 }
 
+// Same as read_line() but parses in place the contents of a memory-mapped RFile stream.
+bool RSA3dStream::read_line_mapped(ArrayView<char> buf, bool& binary, char& ctype, Vec3<float>& f,
+                                   string& comment) {
+    LineTokenizer tokenizer(buf);
+    if (tokenizer.peek()=='\n') tokenizer.next(); // there may be a blank line between elements
+    int vpeek = tokenizer.peek();
+    if (vpeek<0) { mapped_stream_consume(_is, tokenizer.num_consumed()); return false; }
+    char ch = static_cast<char>(vpeek);
+    binary = ch==k_a3d_binary_code;
+    if (binary) {
+        a3d_binary_buf abuf;
+        const char* s = tokenizer.next_raw(sizeof(abuf)); assertx(s);
+        std::memcpy(&abuf, s, sizeof(abuf));
+        assertx(abuf.magic[1]==0);
+        from_std(&abuf.utype); ctype = narrow_cast<char>(abuf.utype);
+        for_int(i, 3) { from_std(&abuf.f[i]); f[i] = abuf.f[i]; }
+    } else {
+        const string possible_types = "PLp#ofqOvEndsg";
+        if (!contains(possible_types, ch)) assertnever(sform("read error on character '%c' (int %d)", ch, int(ch)));
+        ctype = ch;
+        const char* sline = tokenizer.next()+1;
+        if (A3dElem::EType(ctype)==A3dElem::EType::comment) {
+            comment = sline;
+        } else {
+            assertx(sline[0]==' ');
+            assertx(sscanf(sline, "%g %g %g", &f[0], &f[1], &f[2])==3);
+        }
+    }
+    mapped_stream_consume(_is, tokenizer.num_consumed());
+    return true;
+}
+
 // *** WA3dStream
 
 void WA3dStream::write(const A3dElem& el) {
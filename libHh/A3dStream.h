@@ -133,6 +133,7 @@ class RSA3dStream : public RA3dStream { // Read from stream
  private:
     std::istream& _is;
     bool read_line(bool& binary, char& type, Vec3<float>& f, string& comment) override;
+    bool read_line_mapped(ArrayView<char> buf, bool& binary, char& type, Vec3<float>& f, string& comment);
 };
 
 
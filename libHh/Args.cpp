@@ -328,6 +328,11 @@ auto ParseArgs::match(const string& s, bool skip_options) -> const option* {
     return omatch;
 }
 
+string ParseArgs::option_name(const string& s) {
+    const option* o = match(s, false);
+    return o ? o->str : "";
+}
+
 bool ParseArgs::parse_internal() {
     assertx(_icur!=-2);         // did not already parse
     bool skip = false;
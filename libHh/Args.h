@@ -104,6 +104,7 @@ class ParseArgs : public Args {
     void disallow_prefixes()    { _disallow_prefixes = true; } // options implicitly end with '[' if none is present
     // Note: usually, other_options_ok() implies that disallow_prefixes() should be set too.
     static bool special_arg(const string& s); // true if "-?" or "--help" or "--version"
+    string option_name(const string& s); // full name of the option recognized from argument s, or "" if none
     void print_help();
 // Perform argument parsing:
     bool parse();               // main function; returns success (false if "-?" is found)
@@ -0,0 +1,61 @@
+// -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
+#ifndef MESH_PROCESSING_LIBHH_BOUNDEDQUEUE_H_
+#define MESH_PROCESSING_LIBHH_BOUNDEDQUEUE_H_
+
+#include <condition_variable>
+#include <mutex>
+#include "Queue.h"
+
+#if 0
+{
+    BoundedQueue<Array<A3dElem>> queue(8);
+    std::thread producer([&] { for (;;) { Array<A3dElem> batch = read_batch(); if (!queue.push(batch)) break; } });
+    for (Array<A3dElem> batch; queue.pop(batch); ) { process(batch); }
+    queue.close(); producer.join();
+}
+#endif
+
+namespace hh {
+
+// Thread-safe FIFO queue with bounded capacity, for streaming elements from producer threads to consumer threads.
+// push() blocks while the queue is full, and pop() blocks while the queue is empty.
+// After close(), push() fails immediately (e.g. letting a producer stop early), and pop() fails once the queue is
+//  empty.
+template<typename T> class BoundedQueue : noncopyable {
+ public:
+    explicit BoundedQueue(int capacity)         : _capacity(capacity) { assertx(capacity>0); }
+    bool push(T e) {                            // ret: false if the queue was closed
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv_not_full.wait(lock, [this] { return _closed || _queue.length()<_capacity; });
+        if (_closed) return false;
+        _queue.enqueue(std::move(e));
+        _cv_not_empty.notify_one();
+        return true;
+    }
+    bool pop(T& e) {                            // ret: false if the queue is closed and empty
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv_not_empty.wait(lock, [this] { return _closed || !_queue.empty(); });
+        if (_queue.empty()) return false;
+        e = _queue.dequeue();
+        _cv_not_full.notify_one();
+        return true;
+    }
+    void close() {                              // elements already in the queue can still be popped
+        std::unique_lock<std::mutex> lock(_mutex);
+        _closed = true;
+        _cv_not_full.notify_all();
+        _cv_not_empty.notify_all();
+    }
+    int capacity() const                        { return _capacity; }
+ private:
+    const int _capacity;
+    std::mutex _mutex;
+    std::condition_variable _cv_not_full;
+    std::condition_variable _cv_not_empty;
+    Queue<T> _queue;
+    bool _closed {false};
+};
+
+} // namespace hh
+
+#endif // MESH_PROCESSING_LIBHH_BOUNDEDQUEUE_H_
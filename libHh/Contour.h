@@ -9,6 +9,8 @@
 #include "Stat.h"
 #include "PArray.h"
 #include "SGrid.h"
+#include "Parallel.h"           // parallel_for_each()
+#include "RangeOp.h"            // sort()
 
 #if 0
 {
@@ -37,9 +39,10 @@ namespace hh {
 //   - surface triangle mesh in the unit cube   (Contour3DMesh)
 //   - surface triangle stream in the unit cube (Contour3D)
 //   - curve polyline stream in the unit square (Contour2D)
+// Contour3DMeshParallel is a variant of Contour3DMesh that marches bricks of cubes concurrently.
+// Contour3DOctree is a variant of Contour3DMesh that contours an adaptive octree near given points.
 
 // TODO: improving efficiency/generality:
-// - use 64-bit encoding to allow larger grid sizes.
 // - perhaps distinguish  Set<unsigned> cubes_visited and  Map<unsigned,Node>  cube_vertices? and edge_vertices too?
 // - somehow remove _en from Node?
 // - somehow remove mapsucc
@@ -60,7 +63,9 @@ template<int D, typename VertexData = Vec0<int>> class ContourBase {
     using DPoint = Vec<float,D>; // domain point
     using IPoint = Vec<int,D>;   // grid point
     static_assert(D==2 || D==3, "");
-    static constexpr int k_max_gn = D==3 ? 1024 : 65536; // bits/coordinate==10 for 3D, 16 for 2D (max 32 bits total)
+    // Encoded vertex index: bits/coordinate==20 for 3D (64 bits total), 16 for 2D (32 bits total).
+    using Encoded = typename std::conditional<D==3, uint64_t, unsigned>::type;
+    static constexpr int k_max_gn = D==3 ? (1<<20) : 65536;
     explicit ContourBase(int gn) : _gn(gn), _gni(1.f/gn) {
         assertx(_gn>0);
         assertx(_gn<k_max_gn);  // must leave room for [0.._gn] inclusive
@@ -88,20 +93,20 @@ template<int D, typename VertexData = Vec0<int>> class ContourBase {
     // The cube vertices are indexed by nodes with indices [0, _gn].  See get_point().
     // So there are no "+.5f" roundings anywhere in the code.
     struct Node : VertexData {
-        explicit Node(unsigned pen) : _en(pen) { }
+        explicit Node(Encoded pen) : _en(pen) { }
         enum class ECubestate { nothing, queued, visited };
-        unsigned _en;                                // encoded vertex index
+        Encoded _en;                                 // encoded vertex index
         ECubestate _cubestate {ECubestate::nothing}; // cube info
         float _val {k_not_yet_evaled};               // vertex value
         DPoint _p;                                   // vertex point position in grid
         // Note that for 3D, base class contains Vec3<Vertex> _verts.
     };
-    struct hash_Node { size_t operator()(const Node& n) const { return n._en; } };
+    struct hash_Node { size_t operator()(const Node& n) const { return size_t(n._en); } };
     struct equal_Node { bool operator()(const Node& n1, const Node& n2) const { return n1._en==n2._en; } };
     Set<Node, hash_Node, equal_Node> _m;
     // (std::unordered_set<> : References and pointers to key stored in the container are only
     //   invalidated by erasing that element.  So it's OK to keep pointers to Node* even as more are added.)
-    Queue<unsigned> _queue;     // cubes queued to be visited
+    Queue<Encoded> _queue;      // cubes queued to be visited
     int _ncvisited {0};
     int _ncundef {0};
     int _ncnothing {0};
@@ -120,15 +125,51 @@ template<int D, typename VertexData = Vec0<int>> class ContourBase {
     }
     template<bool avoid_degen, typename Eval = float(const DPoint&)>
     DPoint compute_point(const DPoint& pp, const DPoint& pn, float vp, float vn, Eval& eval) {
-        DPoint pm; float fm;
-        if (!_vertex_tol) {
+        float fm; int neval;
+        DPoint pm = edge_point(pp, pn, vp, vn, eval, _vertex_tol, fm, neval);
+        if (_vertex_tol) { HH_SSTAT(SContneval, neval); }
+        if (avoid_degen) {
+            // const float fs = _gn>500 ? .05f : _gn >100 ? .01f : .001f;
+            const float fs = 2e-5f*_gn; // sufficient precision for HashFloat with default nignorebits==8
+            if (fm<fs) {
+                _nedegen++; pm = interp(pn, pp, fs);
+            } else if (fm>1.f-fs) {
+                _nedegen++; pm = interp(pp, pn, fs);
+            }
+        }
+        return pm;
+    }
+    // Evaluate all points, in a single call if Eval provides
+    //  "void operator()(CArrayView<DPoint> points, ArrayView<float> values) const".
+    template<typename E> static auto test_batch_eval(int) -> decltype(
+        std::declval<const E&>()(std::declval<CArrayView<DPoint>>(), std::declval<ArrayView<float>>()),
+        std::true_type());
+    template<typename E> static std::false_type test_batch_eval(...);
+    template<typename Eval> static void evaluate(Eval& eval, CArrayView<DPoint> points, ArrayView<float> values) {
+        evaluate(eval, points, values, decltype(test_batch_eval<Eval>(0))());
+    }
+    template<typename Eval> static void evaluate(Eval& eval, CArrayView<DPoint> points, ArrayView<float> values,
+                                                 std::true_type) {
+        eval(points, values);
+    }
+    template<typename Eval> static void evaluate(Eval& eval, CArrayView<DPoint> points, ArrayView<float> values,
+                                                 std::false_type) {
+        for_int(i, points.num()) { values[i] = eval(points[i]); }
+    }
+    // Point on the edge from pp (vp>=0) to pn (vn<0); fm is its fractional distance from pp.
+    // Uses no member state, so it may be called concurrently if eval is thread-safe.
+    template<typename Eval>
+    static DPoint edge_point(const DPoint& pp, const DPoint& pn, float vp, float vn, Eval& eval, float vertex_tol,
+                             float& fm, int& neval) {
+        DPoint pm;
+        neval = 0;
+        if (!vertex_tol) {
             fm = vp/(vp-vn);
             pm = interp(pn, pp, fm);
         } else {
             float v0 = vp, v1 = vn;
             DPoint p0 = pp, p1 = pn;
             float f0 = 0.f, f1 = 1.f;
-            int neval = 0;
             for (;;) {
                 ASSERTX(v0>=0.f && v1<0.f && f0<f1);
                 float b1 = v0/(v0-v1);
@@ -143,17 +184,7 @@ template<int D, typename VertexData = Vec0<int>> class ContourBase {
                 } else {
                     f0 = fm; p0 = pm; v0 = vm;
                 }
-                if (dist2(p0, p1)<=square(_vertex_tol)) break;
-            }
-            HH_SSTAT(SContneval, neval);
-        }
-        if (avoid_degen) {
-            // const float fs = _gn>500 ? .05f : _gn >100 ? .01f : .001f;
-            const float fs = 2e-5f*_gn; // sufficient precision for HashFloat with default nignorebits==8
-            if (fm<fs) {
-                _nedegen++; pm = interp(pn, pp, fs);
-            } else if (fm>1.f-fs) {
-                _nedegen++; pm = interp(pp, pn, fs);
+                if (dist2(p0, p1)<=square(vertex_tol)) break;
             }
         }
         return pm;
@@ -181,6 +212,7 @@ class Contour3DBase : public ContourBase<3, VertexData> {
     using typename base::DPoint;
     using typename base::IPoint;
     using typename base::Node;
+    using typename base::Encoded;
     using base::get_point; using base::cube_inbounds;
     using base::_gn; using base::k_max_gn;
     using base::_queue; using base::_m; using base::_tmp_poly;
@@ -202,15 +234,14 @@ class Contour3DBase : public ContourBase<3, VertexData> {
     using Node222 = SGrid<Node*, 2, 2, 2>;
     using base::k_not_yet_evaled;
     //
-    unsigned encode(const IPoint& ci) const {
-        static_assert(k_max_gn<=1024, "");
-        return (((unsigned(ci[0])<<10) | unsigned(ci[1]))<<10) | unsigned(ci[2]);
+    Encoded encode(const IPoint& ci) const {
+        static_assert(k_max_gn<=(1<<20), "");
+        return (((Encoded(ci[0])<<20) | Encoded(ci[1]))<<20) | Encoded(ci[2]);
     }
-    IPoint decode(unsigned en) const {
-        static_assert(k_max_gn<=1024, "");
-        return IPoint(narrow_cast<int>(en>>20),
-                      narrow_cast<int>((en>>10)&((1u<<10)-1)),
-                      narrow_cast<int>(en&((1u<<10)-1)));
+    IPoint decode(Encoded en) const {
+        static_assert(k_max_gn<=(1<<20), "");
+        const Encoded mask = (Encoded(1)<<20)-1;
+        return IPoint(narrow_cast<int>(en>>40), narrow_cast<int>((en>>20)&mask), narrow_cast<int>(en&mask));
     }
     void check_ok()                             { /* assertx(!(_pmesh && _contour)); */ }
     int march_from_i(const DPoint& startp) {
@@ -240,7 +271,7 @@ class Contour3DBase : public ContourBase<3, VertexData> {
     int march_from_aux(const IPoint& cc) {
         int oncvisited = _ncvisited;
         {
-            unsigned en = encode(cc);
+            Encoded en = encode(cc);
             bool is_new; Node* n = const_cast<Node*>(&_m.enter(Node(en), is_new)); // un-const OK if not modify n->_en
             // "base::" required when accessing ECubestate for mingw32 gcc 4.8.1
             if (n->_cubestate==base::Node::ECubestate::visited) return 0;
@@ -249,14 +280,14 @@ class Contour3DBase : public ContourBase<3, VertexData> {
             n->_cubestate = base::Node::ECubestate::queued;
         }
         while (!_queue.empty()) {
-            unsigned en = _queue.dequeue();
+            Encoded en = _queue.dequeue();
             consider_cube(en);
         }
         int cncvisited = _ncvisited-oncvisited;
         if (cncvisited==1) _ncnothing++;
         return cncvisited;
     }
-    void consider_cube(unsigned encube) {
+    void consider_cube(Encoded encube) {
         _ncvisited++;
         IPoint cc = decode(encube);
         Node222 na;
@@ -264,7 +295,7 @@ class Contour3DBase : public ContourBase<3, VertexData> {
         for_int(i, 2) for_int(j, 2) for_int(k, 2) {
             IPoint cd(i, j, k);
             IPoint ci = cc+cd;
-            unsigned en = encode(ci);
+            Encoded en = encode(ci);
             bool is_new; Node* n = const_cast<Node*>(&_m.enter(Node(en), is_new));
             na[i][j][k] = n;
             if (n->_val==k_not_yet_evaled) {
@@ -301,7 +332,7 @@ class Contour3DBase : public ContourBase<3, VertexData> {
             IPoint ci = cc+cd;  // indices of node for neighboring cube;
             // note: vmin<0 since 0 is arbitrarily taken to be positive
             if (vmax!=k_Contour_undefined && vmin<0 && vmax>=0 && cube_inbounds(ci)) {
-                unsigned en = encode(ci);
+                Encoded en = encode(ci);
                 bool is_new; Node* n2 = const_cast<Node*>(&_m.enter(Node(en), is_new));
                 if (n2->_cubestate==base::Node::ECubestate::nothing) {
                     n2->_cubestate = base::Node::ECubestate::queued;
@@ -492,6 +523,801 @@ class Contour3D : public Contour3DBase<Vec0<int>, Contour3D<Eval, Contour, Borde
     }
 };
 
+// Variant of Contour3DMesh that partitions the grid into bricks of k_brick^3 cubes and marches them concurrently.
+// The function eval must be thread-safe.  Each round marches all the bricks having pending seed cubes; the surface
+//  crossings into neighboring bricks become seeds for the next round.  The brick outputs are then welded into the
+//  mesh serially in brick order, so the resulting mesh is independent of the number of threads.
+// Within a brick, the cube vertices of each marching front are evaluated together; if Eval also provides
+//  "void operator()(CArrayView<Vec3<float>> points, ArrayView<float> values) const", they are passed to it in a
+//  single call (e.g. to exploit their spatial coherence).
+// Unlike Contour3DMesh, there is no Border output, and cube vertices on brick boundaries are evaluated once per
+//  adjacent brick.
+template<typename Eval = float(const Vec3<float>&)>
+class Contour3DMeshParallel : public ContourBase<3> {
+    static constexpr int D = 3;
+    using base = ContourBase<D>;
+ public:
+    explicit Contour3DMeshParallel(int gn, GMesh* pmesh, Eval eval = Eval())
+        : base(gn), _pmesh(pmesh), _eval(eval) {
+        assertx(_pmesh);
+    }
+    void big_mesh_faces()                       { _big_mesh_faces = true; }
+    // ret number of new cubes visited: 0=revisit_cube, 1=no_surf, >1=new
+    int march_from(const DPoint& startp)        { return march(V(cube_of(startp))); }
+    // march from all startps together; ret num new cubes visited
+    int march_from(CArrayView<DPoint> startps) {
+        Array<IPoint> cubes; cubes.reserve(startps.num());
+        for (const DPoint& p : startps) cubes.push(cube_of(p));
+        return march(cubes);
+    }
+    // call march_from() on all cells near startp; ret num new cubes visited
+    int march_near(const DPoint& startp) {
+        IPoint cc = cube_of(startp);
+        Array<IPoint> cubes;
+        for_intL(i, -1, 2) for_intL(j, -1, 2) for_intL(k, -1, 2) {
+            IPoint ci = cc+IPoint(i, j, k);
+            if (cube_inbounds(ci)) cubes.push(ci);
+        }
+        return march(cubes);
+    }
+ private:
+    static constexpr int k_brick = 16;          // number of cubes along each side of a brick
+    static constexpr int k_brickv = k_brick+1;  // number of cube vertices along each side of a brick
+    using Edgekey = uint64_t;   // ((x*(_gn+1)+y)*(_gn+1)+z)*3+d for the edge from vertex (x, y, z) along axis d
+    static constexpr float k_pending = -BIGFLOAT; // vertex value about to be evaluated
+    enum class ECubestate : uchar { nothing, queued, visited };
+    struct Brick {
+        IPoint origin;                  // index of first cube
+        Encoded key;                    // encoded brick index
+        Array<float> vals;              // values at the k_brickv^3 cube vertices
+        Array<ECubestate> cubestates;   // k_brick^3 cubes
+        Array<IPoint> seeds;            // cubes to visit in this round
+        Array<IPoint> exits;            // cubes in neighboring bricks reached in this round
+        Array<int> front;               // cubes queued to be visited
+        Array<int> next_front;          // cubes queued by the visits of front
+        Array<int> eval_indices;        // vertices of front to evaluate
+        Array<DPoint> eval_points;
+        Array<float> eval_values;
+        Array<int> face_nv;             // faces output in this round
+        Array<Edgekey> face_edges;      // their vertices
+        Map<Edgekey, DPoint> edge_points;
+        int ncvisited {0}, ncundef {0}, ncnothing {0}, nvevaled {0}, nvzero {0}, nvundef {0};
+    };
+    GMesh* _pmesh;
+    Eval _eval;
+    bool _big_mesh_faces {false};
+    Map<Encoded, unique_ptr<Brick>> _mbrick;
+    Map<Edgekey, Vertex> _medge_vertex;
+    //
+    static int mod4(int j)                      { ASSERTX(j>=0); return j&0x3; }
+    static int cube_index(const IPoint& lc)     { return (lc[0]*k_brick+lc[1])*k_brick+lc[2]; }
+    static int vertex_index(const IPoint& lc)   { return (lc[0]*k_brickv+lc[1])*k_brickv+lc[2]; }
+    IPoint cube_of(const DPoint& p) const {
+        for_int(d, D) ASSERTX(p[d]>=0.f && p[d]<=1.f);
+        IPoint cc; for_int(d, D) { cc[d] = min(static_cast<int>(p[d]*_gn), _gn-1); }
+        return cc;
+    }
+    Edgekey edge_key(const IPoint& ci, int d) const {
+        const Edgekey n = _gn+1;
+        return ((Edgekey(ci[0])*n+Edgekey(ci[1]))*n+Edgekey(ci[2]))*3+d;
+    }
+    void add_seed(const IPoint& ci, Array<Brick*>& active) {
+        IPoint bi = ci/k_brick;
+        Encoded key = (((Encoded(bi[0])<<20) | Encoded(bi[1]))<<20) | Encoded(bi[2]);
+        Brick* brick = _mbrick.retrieve(key).get();
+        if (!brick) {
+            auto up = make_unique<Brick>();
+            brick = up.get();
+            brick->origin = bi*k_brick;
+            brick->key = key;
+            _mbrick.enter(key, std::move(up));
+        }
+        if (!brick->seeds.num()) active.push(brick);
+        brick->seeds.push(ci);
+    }
+    int march(CArrayView<IPoint> cubes) {
+        int oncvisited = _ncvisited;
+        Array<Brick*> active;
+        for (const IPoint& ci : cubes) add_seed(ci, active);
+        for (bool user_seeds = true; active.num(); user_seeds = false) {
+            sort(active, [](const Brick* b1, const Brick* b2) { return b1->key<b2->key; });
+            parallel_for_each(range(active.num()), [&](const int i) { march_brick(*active[i], user_seeds); },
+                              k_brick*k_brick*500);
+            for (Brick* brick : active) output_brick(*brick);
+            Array<Brick*> new_active;
+            for (Brick* brick : active) {
+                for (const IPoint& ci : brick->exits) add_seed(ci, new_active);
+                brick->exits.init(0);
+            }
+            active = std::move(new_active);
+        }
+        return _ncvisited-oncvisited;
+    }
+    void march_brick(Brick& brick, bool user_seeds) {
+        if (!brick.vals.num()) {
+            brick.vals.init(k_brickv*k_brickv*k_brickv, k_not_yet_evaled);
+            brick.cubestates.init(k_brick*k_brick*k_brick, ECubestate::nothing);
+        }
+        for (const IPoint& ci : brick.seeds) {
+            int ic = cube_index(ci-brick.origin);
+            if (brick.cubestates[ic]!=ECubestate::nothing) continue;
+            brick.cubestates[ic] = ECubestate::queued;
+            brick.front.init(0); brick.front.push(ic);
+            bool is_seed = user_seeds;
+            while (brick.front.num()) {
+                evaluate_front(brick);
+                brick.next_front.init(0);
+                for (int ic2 : brick.front) {
+                    int npropagate = consider_cube(brick, ic2);
+                    if (is_seed && !npropagate) brick.ncnothing++;
+                    is_seed = false;
+                }
+                swap(brick.front, brick.next_front);
+            }
+        }
+        brick.seeds.init(0);
+    }
+    static IPoint cube_coords(int ic) { return IPoint(ic/(k_brick*k_brick), (ic/k_brick)%k_brick, ic%k_brick); }
+    void evaluate_front(Brick& brick) {
+        brick.eval_indices.init(0); brick.eval_points.init(0);
+        for (int ic : brick.front) {
+            IPoint lc = cube_coords(ic);
+            for_int(i, 2) for_int(j, 2) for_int(k, 2) {
+                IPoint cd(i, j, k);
+                int iv = vertex_index(lc+cd);
+                if (brick.vals[iv]!=k_not_yet_evaled) continue;
+                brick.vals[iv] = k_pending;
+                brick.eval_indices.push(iv);
+                brick.eval_points.push(get_point(brick.origin+lc+cd));
+            }
+        }
+        brick.eval_values.init(brick.eval_points.num());
+        evaluate(_eval, brick.eval_points, brick.eval_values);
+        for_int(i, brick.eval_indices.num()) {
+            float val = brick.eval_values[i];
+            brick.vals[brick.eval_indices[i]] = val;
+            brick.nvevaled++;
+            if (!val) brick.nvzero++;
+            if (val==k_Contour_undefined) brick.nvundef++;
+        }
+    }
+    int consider_cube(Brick& brick, int ic) { // ret: number of neighboring cubes reached
+        brick.ncvisited++;
+        IPoint lc = cube_coords(ic);
+        IPoint cc = brick.origin+lc;
+        SGrid<float, 2, 2, 2> va;
+        bool cundef = false;
+        for_int(i, 2) for_int(j, 2) for_int(k, 2) {
+            float val = brick.vals[vertex_index(lc+IPoint(i, j, k))];
+            ASSERTX(val!=k_not_yet_evaled && val!=k_pending);
+            va[i][j][k] = val;
+            if (val==k_Contour_undefined) cundef = true;
+        }
+        ASSERTX(brick.cubestates[ic]==ECubestate::queued);
+        brick.cubestates[ic] = ECubestate::visited;
+        if (cundef) {
+            brick.ncundef++;
+        } else {
+            contour_cube(brick, cc, va);
+        }
+        int npropagate = 0;
+        for_int(d, D) for_int(i, 2) { // push neighbors
+            int d1 = (d+1)%D, d2 = (d+2)%D;
+            IPoint cd; cd[d] = i;
+            float vmin = BIGFLOAT, vmax = -BIGFLOAT;
+            for (cd[d1] = 0; cd[d1]<2; cd[d1]++) {
+                for (cd[d2] = 0; cd[d2]<2; cd[d2]++) {
+                    float v = va[cd[0]][cd[1]][cd[2]];
+                    if (v<vmin) vmin = v;
+                    if (v>vmax) vmax = v;
+                }
+            }
+            cd[d] = i ? 1 : -1;
+            cd[d1] = cd[d2] = 0;
+            IPoint ci = cc+cd;  // indices of node for neighboring cube;
+            // note: vmin<0 since 0 is arbitrarily taken to be positive
+            if (!(vmax!=k_Contour_undefined && vmin<0 && vmax>=0 && cube_inbounds(ci))) continue;
+            npropagate++;
+            IPoint lc2 = lc+cd;
+            if (!lc2.in_range(ntimes<D>(k_brick))) {
+                brick.exits.push(ci);   // filtered by the neighboring brick in the next round
+                continue;
+            }
+            int ic2 = cube_index(lc2);
+            if (brick.cubestates[ic2]==ECubestate::nothing) {
+                brick.cubestates[ic2] = ECubestate::queued;
+                brick.next_front.push(ic2);
+            }
+        }
+        return npropagate;
+    }
+    void contour_cube(Brick& brick, const IPoint& cc, const SGrid<float, 2, 2, 2>& va) {
+        // Same as Contour3DMesh::contour_cube(), but with the face vertices identified by edge keys.
+        Vec<Edgekey,12> succ_from, succ_to; int nsucc = 0;
+        for_int(d, D) for_int(v, 2) { // examine each of 6 cube faces
+            Vec4<IPoint> cdf; {
+                int d1 = (d+1)%D, d2 = (d+2)%D;
+                IPoint cd; cd[d] = v;
+                int i = 0;
+                // Gather 4 cube vertices in a consistent order
+                for (cd[d1] = 0; cd[d1]<2; cd[d1]++) {
+                    int sw = cd[d]^cd[d1]; // 0 or 1
+                    for (cd[d2] = sw; cd[d2]==0||cd[d2]==1; cd[d2] += (sw ? -1 : 1)) cdf[i++] = cd;
+                }
+            }
+            Vec4<float> valf; for_int(i, 4) valf[i] = va[cdf[i][0]][cdf[i][1]][cdf[i][2]];
+            int nneg = 0;
+            double sumval = 0.;
+            for_int(i, 4) {
+                if (valf[i]<0) nneg++;
+                sumval += valf[i];
+            }
+            for_int(i, 4) {
+                int i1 = mod4(i+1), i2 = mod4(i+2), i3 = mod4(i+3);
+                if (!(valf[i]<0 && valf[i1]>=0)) continue;
+                // have start of edge
+                ASSERTX(nneg>=1 && nneg<=3);
+                int ie;                      // end of edge
+                if (nneg==1) {
+                    ie = i3;
+                } else if (nneg==3) {
+                    ie = i1;
+                } else if (valf[i2]>=0) {
+                    ie = i2;
+                } else if (sumval<0) {
+                    ie = i1;
+                } else {
+                    ie = i3;
+                }
+                int ie1 = mod4(ie+1);
+                succ_from[nsucc] = get_edge(brick, cc, cdf[ie], cdf[ie1], valf[ie], valf[ie1]);
+                succ_to[nsucc] = get_edge(brick, cc, cdf[i1], cdf[i], valf[i1], valf[i]);
+                nsucc++;
+            }
+        }
+        while (nsucc) {
+            int imin = 0; for_intL(i, 1, nsucc) { if (succ_from[i]<succ_from[imin]) imin = i; }
+            Edgekey kf = succ_from[imin];
+            int nv = 0;
+            for (Edgekey k = kf; ; ) {
+                brick.face_edges.push(k); nv++;
+                int i = 0;
+                for (; ; i++) { assertx(i<nsucc); if (succ_from[i]==k) break; }
+                k = succ_to[i];
+                nsucc--; succ_from[i] = succ_from[nsucc]; succ_to[i] = succ_to[nsucc];
+                if (k==kf) break;
+            }
+            brick.face_nv.push(nv);
+        }
+    }
+    // Edge from cube vertex cc+cdp (value vp>=0) to cube vertex cc+cdn (value vn<0).
+    Edgekey get_edge(Brick& brick, const IPoint& cc, const IPoint& cdp, const IPoint& cdn, float vp, float vn) {
+        int d = -1;
+        for_int(c, D) { if (cdp[c]!=cdn[c]) { ASSERTX(d<0); d = c; } }
+        ASSERTX(d>=0);
+        Edgekey key = edge_key(cc+(cdp[d]<cdn[d] ? cdp : cdn), d);
+        bool is_new; DPoint& p = brick.edge_points.enter(key, DPoint(), is_new);
+        if (is_new) {
+            float fm; int neval;
+            p = edge_point(get_point(cc+cdp), get_point(cc+cdn), vp, vn, _eval, _vertex_tol, fm, neval);
+        }
+        return key;
+    }
+    void output_brick(Brick& brick) {
+        _ncvisited += brick.ncvisited; _ncundef += brick.ncundef; _ncnothing += brick.ncnothing;
+        _nvevaled += brick.nvevaled; _nvzero += brick.nvzero; _nvundef += brick.nvundef;
+        brick.ncvisited = brick.ncundef = brick.ncnothing = brick.nvevaled = brick.nvzero = brick.nvundef = 0;
+        Array<Vertex> va;
+        int ie = 0;
+        for (int nv : brick.face_nv) {
+            va.init(nv);
+            for_int(j, nv) {
+                Edgekey key = brick.face_edges[ie++];
+                bool is_new; Vertex& v = _medge_vertex.enter(key, Vertex(nullptr), is_new);
+                if (is_new) {
+                    v = _pmesh->create_vertex();
+                    _pmesh->set_point(v, brick.edge_points.get(key));
+                }
+                va[j] = v;
+            }
+            Face f = _pmesh->create_face(va);
+            if (nv>3 && !_big_mesh_faces) {
+                // If 6 or more edges, may have 2 edges on same cube face, then must introduce new vertex to be safe.
+                if (nv>=6) _pmesh->center_split_face(f);
+                else assertx(triangulate_face(*_pmesh, f));
+            }
+        }
+        brick.face_nv.init(0);
+        brick.face_edges.init(0);
+        brick.edge_points.clear();
+    }
+};
+
+// Variant of Contour3DMesh that contours an adaptive octree using dual contouring, so that the grid resolution
+//  2^max_level is reached only where the function is not locally linear.
+// The octree is refined only within distance band of given points (e.g. the data points), and a cell is refined if
+//  level<min_level or if the function values at its 3^3 subcell vertices are undefined, introduce a sign change
+//  absent from the cell corners, or deviate from a linear fit by more than the flatness tolerance (unless they all
+//  have the same sign and are farther from zero than the half cell diagonal, which assumes that the function is
+//  approximately a distance).  Adjacent leaf cells with crossings then differ by at most one level.
+// Each surface patch within a leaf cell gets one mesh vertex (the average of the crossings on its minimal edges);
+//  each minimal edge with a crossing produces a quad (split into two triangles) joining the patches of the 4 leaf
+//  cells around it, so the mesh is crack-free across cells of different sizes.  A coarser leaf cell has a single
+//  patch, whereas a finest-level cell has the patches of Contour3DMesh::contour_cube(), so that surface sheets within
+//  a cell are not merged.  Any remaining non-manifold faces (possible if the function is discontinuous) are omitted.
+// The octree levels are refined successively; the new cell vertices of each level are evaluated concurrently in
+//  chunks (using the batch evaluation of Eval if present, see ContourBase::evaluate()), so eval must be thread-safe.
+template<typename Eval = float(const Vec3<float>&)>
+class Contour3DOctree : public ContourBase<3> {
+    static constexpr int D = 3;
+    using base = ContourBase<D>;
+ public:
+    explicit Contour3DOctree(int max_level, GMesh* pmesh, Eval eval = Eval())
+        : base(1<<max_level), _max_level(max_level), _pmesh(pmesh), _eval(eval) {
+        assertx(max_level>=0 && max_level<20 && _pmesh);
+    }
+    ~Contour3DOctree() {
+        if (_os) {
+            *_os << sform("%sOctree: %d cells (%d leaves, %d undefined), max level %d\n",
+                          g_comment_prefix_string, _cells.num(), _nleaves, _nlundef, _max_level);
+            *_os << sform("%soutput %d faces (%d non-manifold faces omitted)\n",
+                          g_comment_prefix_string, _nfaces, _nfomitted);
+        }
+    }
+    void set_min_level(int level)               { _min_level = level; }
+    void set_flatness_tolerance(float tol)      { _flatness_tol = tol; } // absolute deviation of function value
+    // Refine the octree near points and contour it; may be called only once.  Ret number of leaf cells.
+    int contour_near(CArrayView<DPoint> points, float band) {
+        assertx(!_cells.num());
+        refine(points, band);
+        balance();
+        extract();
+        return _nleaves;
+    }
+ private:
+    struct Cell {
+        Cell() = default;
+        explicit Cell(const IPoint& porigin, int plevel) : origin(porigin), level(plevel) { }
+        IPoint origin;                  // lattice coordinates of its first corner
+        int level {0};                  // its size is 1<<(_max_level-level) in lattice units
+        int child0 {-1};                // index of first of 8 children (bit d of child index is offset along d)
+        bool active {false};            // leaf within band whose corners are all defined
+        SGrid<float, 2, 2, 2> vals;     // values at its corners
+    };
+    struct Pending {
+        int icell;
+        Array<int> points;              // indices of points within band of the cell
+    };
+    using Samples = SGrid<float, 3, 3, 3>; // values at the corners of the 2^3 subcells of a cell
+    int _max_level;
+    GMesh* _pmesh;
+    Eval _eval;
+    int _min_level {0};
+    float _flatness_tol {0.f};
+    Array<Cell> _cells;
+    Array<Vec4<int>> _quads;            // patches about each minimal edge with a crossing, in face order
+    Array<DPoint> _vsum;                // for each patch (icell*4+ipatch), sum of the crossings on its minimal edges
+    Array<int> _vnum;                   // for each patch, number of these crossings
+    int _nleaves {0}, _nlundef {0}, _nfaces {0}, _nfomitted {0};
+    //
+    int cell_size(int level) const              { return 1<<(_max_level-level); }
+    static Encoded encode(const IPoint& ci) {
+        return (((Encoded(ci[0])<<20) | Encoded(ci[1]))<<20) | Encoded(ci[2]);
+    }
+    bool is_leaf(int ic) const                  { return _cells[ic].child0<0; }
+    int child(int ic, int c) const              { return is_leaf(ic) ? ic : _cells[ic].child0+c; }
+    void evaluate_points(CArrayView<DPoint> eval_points, ArrayView<float> eval_values) {
+        const int chunk = 1024;
+        parallel_for_each(range((eval_points.num()+chunk-1)/chunk), [&](const int ichunk) {
+            int ib = ichunk*chunk, ie = min(ib+chunk, eval_points.num());
+            evaluate(_eval, eval_points.slice(ib, ie), eval_values.slice(ib, ie));
+        }, chunk*1000);
+        for (float val : eval_values) {
+            _nvevaled++;
+            if (!val) _nvzero++;
+            if (val==k_Contour_undefined) _nvundef++;
+        }
+    }
+    void refine(CArrayView<DPoint> points, float band) {
+        _cells.push(Cell(IPoint(0, 0, 0), 0));
+        {
+            Array<DPoint> eval_points; for_int(i, 2) for_int(j, 2) for_int(k, 2) {
+                eval_points.push(get_point(IPoint(i, j, k)*_gn));
+            }
+            Array<float> eval_values(8); evaluate_points(eval_points, eval_values);
+            for_int(i, 2) for_int(j, 2) for_int(k, 2) { _cells[0].vals[i][j][k] = eval_values[(i*2+j)*2+k]; }
+        }
+        Array<Pending> cur(1);
+        cur[0].icell = 0;
+        for_int(i, points.num()) { cur[0].points.push(i); }
+        for (int level = 0; cur.num(); level++) {
+            // Cells that may contain the surface are sampled at their subcell corners.
+            Array<int> icells, isample(cur.num(), -1);
+            if (level<_max_level) {
+                for_int(icur, cur.num()) {
+                    if (is_empty(_cells[cur[icur].icell])) continue;
+                    isample[icur] = icells.num(); icells.push(cur[icur].icell);
+                }
+            }
+            Array<Samples> samples(icells.num());
+            evaluate_samples(icells, samples);
+            Array<bool> refines(icells.num());
+            parallel_for_each(range(icells.num()), [&](const int i) {
+                refines[i] = need_refine(_cells[icells[i]], samples[i]);
+            }, 100);
+            // Create the children and distribute the points among them.
+            Array<Pending> next;
+            for_int(icur, cur.num()) {
+                const int ic = cur[icur].icell;
+                _ncvisited++;
+                if (isample[icur]<0 || !refines[isample[icur]]) {
+                    _nleaves++;
+                    set_active_leaf(ic);
+                    continue;
+                }
+                const int csize = cell_size(level+1);
+                create_children(ic, samples[isample[icur]]);
+                for_int(c, 8) {
+                    const int icc = _cells[ic].child0+c;
+                    const IPoint& corigin = _cells[icc].origin;
+                    DPoint pmin = get_point(corigin), pmax = get_point(corigin+ntimes<D>(csize));
+                    Pending pending; pending.icell = icc;
+                    for (int pi : cur[icur].points) {
+                        const DPoint& p = points[pi];
+                        float d2 = 0.f;
+                        for_int(d, D) { d2 += square(max(pmin[d]-p[d], 0.f))+square(max(p[d]-pmax[d], 0.f)); }
+                        if (d2<=square(band)) pending.points.push(pi);
+                    }
+                    if (pending.points.num()) {
+                        next.push(std::move(pending));
+                    } else {
+                        _nleaves++; _ncnothing++;   // inactive leaf outside the band
+                    }
+                }
+            }
+            cur = std::move(next);
+        }
+    }
+    // A leaf cell is active if its corners are all defined.
+    bool set_active_leaf(int ic) {
+        Cell& cell = _cells[ic];
+        cell.active = true;
+        for_int(i, 2) for_int(j, 2) for_int(k, 2) {
+            if (cell.vals[i][j][k]==k_Contour_undefined) cell.active = false;
+        }
+        if (!cell.active) { _nlundef++; _ncundef++; }
+        return cell.active;
+    }
+    void create_children(int ic, const Samples& va) {
+        const int level = _cells[ic].level+1, csize = cell_size(level);
+        const IPoint origin = _cells[ic].origin;
+        _cells[ic].child0 = _cells.num();
+        _cells[ic].active = false;
+        for_int(c, 8) {
+            IPoint cd; for_int(d, D) { cd[d] = (c>>d)&1; }
+            Cell ccell(origin+cd*csize, level);
+            for_int(i, 2) for_int(j, 2) for_int(k, 2) { ccell.vals[i][j][k] = va[cd[0]+i][cd[1]+j][cd[2]+k]; }
+            _cells.push(ccell);
+        }
+    }
+    // Evaluate the subcell corners of the cells that are not cell corners; they are shared only by cells of the same
+    //  size.
+    void evaluate_samples(CArrayView<int> icells, ArrayView<Samples> samples) {
+        Map<Encoded, int> mindex;       // lattice point -> index in eval_points
+        Array<DPoint> eval_points; Array<Vec<int,27>> sindices(icells.num());
+        for_int(i, icells.num()) {
+            const Cell& cell = _cells[icells[i]];
+            const int hsize = cell_size(cell.level)/2;
+            for_int(j0, 3) for_int(j1, 3) for_int(j2, 3) {
+                if (j0!=1 && j1!=1 && j2!=1) continue;
+                IPoint ci = cell.origin+IPoint(j0, j1, j2)*hsize;
+                bool is_new; int& index = mindex.enter(encode(ci), eval_points.num(), is_new);
+                if (is_new) eval_points.push(get_point(ci));
+                sindices[i][(j0*3+j1)*3+j2] = index;
+            }
+        }
+        Array<float> eval_values(eval_points.num());
+        evaluate_points(eval_points, eval_values);
+        for_int(i, icells.num()) {
+            const Cell& cell = _cells[icells[i]];
+            Samples& va = samples[i];
+            for_int(j0, 3) for_int(j1, 3) for_int(j2, 3) {
+                va[j0][j1][j2] = (j0!=1 && j1!=1 && j2!=1 ? cell.vals[j0/2][j1/2][j2/2] :
+                                  eval_values[sindices[i][(j0*3+j1)*3+j2]]);
+            }
+        }
+    }
+    // Split the active leaf cells that are adjacent to active leaf cells more than one level finer, so that any
+    //  lattice point on the boundary of a leaf cell that is sampled by its finer neighbors was also examined by
+    //  need_refine() on that cell; otherwise the shared faces may have crossings unseen by the coarser cell.
+    // The new children are themselves refined according to need_refine().
+    void balance() {
+        // Only a leaf cell with a crossing on its edges can contribute a minimal edge to a coarser neighbor.
+        auto has_crossing = [&](int ic) {
+            const Cell& cell = _cells[ic];
+            bool neg = cell.vals[0][0][0]<0.f;
+            for_int(i, 2) for_int(j, 2) for_int(k, 2) { if ((cell.vals[i][j][k]<0.f)!=neg) return true; }
+            return false;
+        };
+        Array<int> stack, recheck;
+        for_int(ic, _cells.num()) { if (is_leaf(ic) && _cells[ic].active) stack.push(ic); }
+        while (stack.num()) {
+            Array<int> to_split; Set<int> set_split;
+            for (int ic : stack) {
+                if (!is_leaf(ic) || !has_crossing(ic)) continue;
+                const int level = _cells[ic].level, size = cell_size(level);
+                bool unbalanced = false;
+                for_int(i, 3) for_int(j, 3) for_int(k, 3) {
+                    // Lattice cell just outside the cell in the direction (i-1, j-1, k-1).
+                    IPoint off(i, j, k), p; bool outside = false;
+                    for_int(d, D) {
+                        p[d] = _cells[ic].origin[d]+(off[d]==0 ? -1 : off[d]==2 ? size : 0);
+                        if (p[d]<0 || p[d]>=_gn) outside = true;
+                    }
+                    if (outside || off==IPoint(1, 1, 1)) continue;
+                    int jc = 0;
+                    while (!is_leaf(jc) && _cells[jc].level<level-1) {
+                        const int hsize = cell_size(_cells[jc].level)/2;
+                        int c = 0; for_int(d, D) { if (p[d]-_cells[jc].origin[d]>=hsize) c |= 1<<d; }
+                        jc = _cells[jc].child0+c;
+                    }
+                    if (!_cells[jc].active || _cells[jc].level>=level-1) continue;
+                    unbalanced = true;
+                    if (set_split.add(jc)) to_split.push(jc);
+                }
+                if (unbalanced) recheck.push(ic); // the children of its neighbors may still be too coarse
+            }
+            stack.init(0);
+            Array<Samples> samples(to_split.num());
+            evaluate_samples(to_split, samples);
+            while (to_split.num()) {
+                Array<int> to_test;
+                for_int(i, to_split.num()) {
+                    const int ic = to_split[i];
+                    create_children(ic, samples[i]);
+                    _nleaves += 7;
+                    for_int(c, 8) {
+                        const int icc = _cells[ic].child0+c;
+                        _ncvisited++;
+                        if (!set_active_leaf(icc)) continue;
+                        if (_cells[icc].level<_max_level && !is_empty(_cells[icc])) {
+                            to_test.push(icc);
+                        } else {
+                            stack.push(icc);
+                        }
+                    }
+                }
+                samples.init(to_test.num());
+                evaluate_samples(to_test, samples);
+                Array<bool> refines(to_test.num());
+                parallel_for_each(range(to_test.num()), [&](const int i) {
+                    refines[i] = need_refine(_cells[to_test[i]], samples[i]);
+                }, 100);
+                to_split.init(0);
+                Array<Samples> nsamples;
+                for_int(i, to_test.num()) {
+                    if (refines[i]) {
+                        to_split.push(to_test[i]); nsamples.push(samples[i]);
+                    } else {
+                        stack.push(to_test[i]);
+                    }
+                }
+                samples = std::move(nsamples);
+            }
+            stack.push_array(recheck); recheck.init(0);
+        }
+    }
+    // The corner values show that the cell cannot contain the surface (assuming that the function is approximately a
+    //  distance).
+    bool is_empty(const Cell& cell) const {
+        const float h = cell_size(cell.level)*_gni;
+        float vmin = BIGFLOAT, vmax = -BIGFLOAT, vabsmin = BIGFLOAT;
+        for_int(i, 2) for_int(j, 2) for_int(k, 2) {
+            float val = cell.vals[i][j][k];
+            if (val==k_Contour_undefined) return false;
+            vmin = min(vmin, val); vmax = max(vmax, val); vabsmin = min(vabsmin, abs(val));
+        }
+        return (vmin>=0.f || vmax<0.f) && vabsmin>h*.8661f;
+    }
+    bool need_refine(const Cell& cell, const Samples& va) const {
+        float vmin = BIGFLOAT, vmax = -BIGFLOAT, vabsmin = BIGFLOAT;
+        for_int(i, 3) for_int(j, 3) for_int(k, 3) {
+            float val = va[i][j][k];
+            if (val==k_Contour_undefined) return true;
+            vmin = min(vmin, val); vmax = max(vmax, val); vabsmin = min(vabsmin, abs(val));
+        }
+        const float h = cell_size(cell.level)*_gni;
+        if ((vmin>=0.f || vmax<0.f) && vabsmin>h*.4331f) return false; // no surface within the cell
+        if (cell.level<_min_level) return true;
+        Vec<int,12> edge_patch;
+        if (cube_patches(cell.vals, edge_patch)>1) return true;
+        // The sign at each edge midpoint, face center, and cell center must agree with some corner of that element,
+        //  so that the subcells introduce no surface topology absent from the cell [Ju et al. 2002].
+        for_int(i, 3) for_int(j, 3) for_int(k, 3) {
+            if (i!=1 && j!=1 && k!=1) continue;
+            bool neg = va[i][j][k]<0.f, agree = false;
+            for (int i2 : {i/2*2, (i+1)/2*2}) for (int j2 : {j/2*2, (j+1)/2*2}) for (int k2 : {k/2*2, (k+1)/2*2}) {
+                if ((va[i2][j2][k2]<0.f)==neg) agree = true;
+            }
+            if (!agree) return true;
+        }
+        // Least-squares linear fit to the 3^3 values, at local coordinates {-1, 0, 1}^3.
+        float mean = 0.f; Vec3<float> grad(0.f, 0.f, 0.f);
+        for_int(i, 3) for_int(j, 3) for_int(k, 3) {
+            float val = va[i][j][k];
+            mean += val; grad += V(float(i-1), float(j-1), float(k-1))*val;
+        }
+        mean /= 27.f; grad /= 18.f;
+        for_int(i, 3) for_int(j, 3) for_int(k, 3) {
+            float lin = mean+grad[0]*float(i-1)+grad[1]*float(j-1)+grad[2]*float(k-1);
+            if (abs(va[i][j][k]-lin)>_flatness_tol) return true;
+        }
+        return false;
+    }
+    // Dual contouring traversal of the minimal edges [Ju et al. 2002].
+    void extract() {
+        _vsum.init(_cells.num()*4, DPoint(0.f, 0.f, 0.f));
+        _vnum.init(_cells.num()*4, 0);
+        cell_proc(0);
+        Array<Vertex> patch_vertex(_vnum.num(), Vertex(nullptr));
+        for_int(ip, _vnum.num()) {
+            if (!_vnum[ip]) continue;
+            Vertex v = _pmesh->create_vertex();
+            _pmesh->set_point(v, _vsum[ip]/float(_vnum[ip]));
+            patch_vertex[ip] = v;
+        }
+        auto create_face = [&](const Vec3<Vertex>& va) {
+            if (_pmesh->legal_create_face(va)) {
+                _pmesh->create_face(va); _nfaces++;
+            } else {
+                _nfomitted++;
+            }
+        };
+        for (const Vec4<int>& quad : _quads) {
+            Vec4<Vertex> va = map(quad, [&](int ip) { return patch_vertex[ip]; });
+            int idup = -1; for_int(i, 4) { if (va[i]==va[(i+1)%4]) idup = i; }
+            if (idup>=0) {
+                // A larger leaf cell occupies two of the quadrants about an edge interior to one of its faces.
+                create_face(V(va[(idup+1)%4], va[(idup+2)%4], va[(idup+3)%4]));
+                continue;
+            }
+            // Split the quad along its shorter diagonal.
+            bool diag02 = (dist2(_pmesh->point(va[0]), _pmesh->point(va[2]))<=
+                           dist2(_pmesh->point(va[1]), _pmesh->point(va[3])));
+            const int i0 = diag02 ? 0 : 1;
+            for (int j : {1, 2}) create_face(V(va[i0], va[(i0+j)%4], va[(i0+j+1)%4]));
+        }
+        _quads = {}; _vsum = {}; _vnum = {};
+    }
+    void cell_proc(int ic) {
+        if (is_leaf(ic)) return;
+        const int c0 = _cells[ic].child0;
+        for_int(c, 8) cell_proc(c0+c);
+        for_int(d, D) for_int(c, 8) {
+            if (!(c&(1<<d))) face_proc(c0+c, c0+(c|(1<<d)), d);
+        }
+        for_int(e, D) for_int(t, 2) {
+            const int e1 = (e+1)%D, e2 = (e+2)%D;
+            Vec4<int> n;
+            for_int(q, 4) { n[q] = c0+((t<<e) | ((q&1)<<e1) | ((q>>1)<<e2)); }
+            edge_proc(n, e);
+        }
+    }
+    // Cells i0 and i1 are adjacent along axis d, with i0 on the lower side.
+    void face_proc(int i0, int i1, int d) {
+        if (is_leaf(i0) && is_leaf(i1)) return;
+        const int d1 = (d+1)%D, d2 = (d+2)%D;
+        for_int(c, 4) {
+            int cc = ((c&1)<<d1) | ((c>>1)<<d2);
+            face_proc(child(i0, cc|(1<<d)), child(i1, cc), d);
+        }
+        for (int e : {d1, d2}) {
+            const int f = D-d-e, e1 = (e+1)%D;
+            for_int(t, 2) {
+                Vec4<int> n;
+                for_int(q, 4) {
+                    int b1 = q&1, b2 = q>>1;
+                    int sd = e1==d ? b1 : b2, sf = e1==d ? b2 : b1;
+                    n[q] = child(sd ? i1 : i0, ((1-sd)<<d) | (sf<<f) | (t<<e));
+                }
+                edge_proc(n, e);
+            }
+        }
+    }
+    // Cells n[q] surround an edge along axis e; bit 0 of q is the side along e1=(e+1)%3 and bit 1 along e2.
+    void edge_proc(const Vec4<int>& n, int e) {
+        if (is_leaf(n[0]) && is_leaf(n[1]) && is_leaf(n[2]) && is_leaf(n[3])) {
+            process_edge(n, e);
+            return;
+        }
+        const int e1 = (e+1)%D, e2 = (e+2)%D;
+        for_int(t, 2) {
+            Vec4<int> m;
+            for_int(q, 4) { m[q] = child(n[q], (t<<e) | ((1-(q&1))<<e1) | ((1-(q>>1))<<e2)); }
+            edge_proc(m, e);
+        }
+    }
+    void process_edge(const Vec4<int>& n, int e) {
+        int qmin = 0;
+        for_int(q, 4) {
+            if (!_cells[n[q]].active) return;
+            if (_cells[n[q]].level>_cells[n[qmin]].level) qmin = q;
+        }
+        // The minimal edge is the edge of the smallest cell.
+        const Cell& cell = _cells[n[qmin]];
+        const int e1 = (e+1)%D, e2 = (e+2)%D, size = cell_size(cell.level);
+        IPoint cd0; cd0[e] = 0; cd0[e1] = 1-(qmin&1); cd0[e2] = 1-(qmin>>1);
+        IPoint cd1 = cd0; cd1[e] = 1;
+        float v0 = cell.vals[cd0[0]][cd0[1]][cd0[2]], v1 = cell.vals[cd1[0]][cd1[1]][cd1[2]];
+        if ((v0<0.f)==(v1<0.f)) return;
+        DPoint p0 = get_point(cell.origin+cd0*size), p1 = get_point(cell.origin+cd1*size);
+        float fm; int neval;
+        DPoint p = v0>=0.f ? edge_point(p0, p1, v0, v1, _eval, _vertex_tol, fm, neval) :
+            edge_point(p1, p0, v1, v0, _eval, _vertex_tol, fm, neval);
+        Vec4<int> patches;
+        for_int(q, 4) {
+            int ip = n[q]*4;
+            const Cell& cellq = _cells[n[q]];
+            if (cellq.level==_max_level) {
+                Vec<int,12> edge_patch; cube_patches(cellq.vals, edge_patch);
+                ip += edge_patch[e*4+(1-(q&1))+2*(1-(q>>1))];
+            }
+            patches[q] = ip;
+            _vsum[ip] += p; _vnum[ip]++;
+        }
+        _quads.push(v0<0.f ? V(patches[0], patches[1], patches[3], patches[2]) :
+                    V(patches[2], patches[3], patches[1], patches[0]));
+    }
+    // Group the cube edges having a crossing into surface patches, consistently with Contour3DMesh::contour_cube().
+    // Cube edge d*4+b1+2*b2 is along axis d at offsets b1 and b2 along axes (d+1)%3 and (d+2)%3.  Ret num patches.
+    static int cube_patches(const SGrid<float, 2, 2, 2>& va, Vec<int,12>& edge_patch) {
+        auto edge_index = [](const IPoint& c0, const IPoint& c1) {
+            int d = c0[0]!=c1[0] ? 0 : c0[1]!=c1[1] ? 1 : 2;
+            return d*4+min(c0[(d+1)%D], c1[(d+1)%D])+2*min(c0[(d+2)%D], c1[(d+2)%D]);
+        };
+        Vec<int,12> parent; for_int(i, 12) { parent[i] = i; }
+        auto find = [&](int i) { while (parent[i]!=i) i = parent[i]; return i; };
+        for_int(d, D) for_int(v, 2) { // examine each of 6 cube faces
+            Vec4<IPoint> cdf; {
+                int d1 = (d+1)%D, d2 = (d+2)%D;
+                IPoint cd; cd[d] = v;
+                int i = 0;
+                for (cd[d1] = 0; cd[d1]<2; cd[d1]++) {
+                    int sw = cd[d]^cd[d1]; // 0 or 1
+                    for (cd[d2] = sw; cd[d2]==0||cd[d2]==1; cd[d2] += (sw ? -1 : 1)) cdf[i++] = cd;
+                }
+            }
+            Vec4<float> valf; for_int(i, 4) valf[i] = va[cdf[i][0]][cdf[i][1]][cdf[i][2]];
+            int nneg = 0;
+            double sumval = 0.;
+            for_int(i, 4) {
+                if (valf[i]<0) nneg++;
+                sumval += valf[i];
+            }
+            for_int(i, 4) {
+                int i1 = (i+1)&3, i2 = (i+2)&3, i3 = (i+3)&3;
+                if (!(valf[i]<0 && valf[i1]>=0)) continue;
+                int ie = nneg==1 ? i3 : nneg==3 ? i1 : valf[i2]>=0 ? i2 : sumval<0 ? i1 : i3;
+                int ie1 = (ie+1)&3;
+                parent[find(edge_index(cdf[ie], cdf[ie1]))] = find(edge_index(cdf[i1], cdf[i]));
+            }
+        }
+        int npatches = 0;
+        Vec<int,12> root_patch; fill(root_patch, -1);
+        for_int(ei, 12) {
+            const int d = ei/4;
+            IPoint c0; c0[d] = 0; c0[(d+1)%D] = ei&1; c0[(d+2)%D] = (ei>>1)&1;
+            IPoint c1 = c0; c1[d] = 1;
+            edge_patch[ei] = -1;
+            if ((va[c0[0]][c0[1]][c0[2]]<0.f)==(va[c1[0]][c1[1]][c1[2]]<0.f)) continue;
+            int r = find(ei);
+            if (root_patch[r]<0) root_patch[r] = npatches++;
+            edge_patch[ei] = root_patch[r];
+        }
+        return npatches;
+    }
+};
+
 
 
 // *** Contour2D
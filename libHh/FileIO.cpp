@@ -22,6 +22,7 @@
 #include <utime.h>              // struct utimbuf, struct _utimbuf, utime()
 #include <sys/wait.h>           // wait(), waidpid()
 #include <dirent.h>             // struct dirent, opendir(), readdir(), closedir()
+#include <sys/mman.h>           // mmap(), munmap()
 
 #endif  // defined(_WIN32)
 
@@ -46,7 +47,8 @@
 #include "Locks.h"
 #include "RangeOp.h"            // contains()
 
-// Note that RFile/WFile first construct a FILE* (which is accessible via cfile()), then a std::stream on top.
+// Note that RFile/WFile first construct a FILE* (which is accessible via cfile()), then a std::stream on top
+//  (for RFile, only upon first use of the stream, and preferably as a memory mapping of the file).
 // This is quite flexible.  I use this in:
 // - Image_IO.cpp so that libpng and libjpeg can work directly on FILE*; this could easily be worked around
 //    because these libraries support user-defined reader/writer functions, which could access std::stream.
@@ -212,6 +214,29 @@ class ocfstream : public std::ostream {
 #endif  // defined(IO_USE_CFSTREAM)
 
 
+// An implementation of streambuf that reads directly from a memory-mapped file, without any buffer copies.
+class mapped_streambuf : public std::streambuf {
+ public:
+    mapped_streambuf(char* data, size_t size) { setg(data, data, data+size); }
+    ArrayView<char> remainder()                 { return ArrayView<char>(gptr(), narrow_cast<int>(egptr()-gptr())); }
+    void consume(int n)                         { assertx(n>=0 && n<=egptr()-gptr()); gbump(n); }
+ private:
+    // base underflow() returns EOF, which is correct because the whole file is in the get area
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (which&std::ios_base::out) return pos_type(off_type(-1));
+        char* p = dir==std::ios_base::beg ? eback() : dir==std::ios_base::end ? egptr() : gptr();
+        if (off<eback()-p || off>egptr()-p) return pos_type(off_type(-1));
+        setg(eback(), p+off, egptr());
+        return pos_type(gptr()-eback());
+    }
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+// Index of the std::ios_base::pword() slot which points to the mapped_streambuf of an RFile stream.
+const int k_pword_mapped_streambuf = std::ios_base::xalloc();
+
 } // namespace
 
 
@@ -278,6 +303,67 @@ class WFile::Implementation {
 
 // *** RFile
 
+// Memory mapping of a regular file, accessed through a std::istream.
+class RFile::Mapping {
+ public:
+    static unique_ptr<Mapping> create(FILE* file) { // ret: nullptr if file cannot be mapped
+        static const bool no_mmap = getenv_bool("RFILE_NO_MMAP");
+        if (no_mmap) return nullptr;
+        unique_ptr<Mapping> mapping = make_unique<Mapping>();
+        if (!mapping->map(file)) return nullptr;
+        mapping->_streambuf = make_unique<mapped_streambuf>(mapping->_data, mapping->_size);
+        mapping->_istream = make_unique<std::istream>(mapping->_streambuf.get());
+        mapping->_istream->pword(k_pword_mapped_streambuf) = mapping->_streambuf.get();
+        return mapping;
+    }
+    ~Mapping() {
+        _istream = nullptr;
+        _streambuf = nullptr;
+        if (!_data) return;
+#if defined(_WIN32)
+        assertw(UnmapViewOfFile(_data));
+        assertw(CloseHandle(_hmapping));
+#else
+        assertw(!munmap(_data, _size));
+#endif
+    }
+    operator std::istream*()                    { return _istream.get(); }
+ private:
+    char* _data {nullptr};
+    size_t _size {0};
+#if defined(_WIN32)
+    HANDLE _hmapping {nullptr};
+#endif
+    unique_ptr<mapped_streambuf> _streambuf;
+    unique_ptr<std::istream> _istream;
+    bool map(FILE* file) {
+        // The mapping is private (copy-on-write) so that parsers may modify it in place.
+        // Empty files cannot be mapped, and mapped_stream_remainder() must fit within an ArrayView<char>.
+        const int fd = HH_POSIX(fileno)(file);
+#if defined(_WIN32)
+        HANDLE hfile = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+        if (hfile==INVALID_HANDLE_VALUE || GetFileType(hfile)!=FILE_TYPE_DISK) return false;
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(hfile, &file_size)) return false;
+        if (file_size.QuadPart<=0 || file_size.QuadPart>std::numeric_limits<int>::max()) return false;
+        _hmapping = CreateFileMappingW(hfile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (!_hmapping) return false;
+        _data = static_cast<char*>(MapViewOfFile(_hmapping, FILE_MAP_COPY, 0, 0, 0));
+        if (!_data) { assertw(CloseHandle(_hmapping)); return false; }
+        _size = static_cast<size_t>(file_size.QuadPart);
+#else
+        struct stat st;
+        if (fstat(fd, &st) || !S_ISREG(st.st_mode)) return false;
+        if (st.st_size<=0 || st.st_size>std::numeric_limits<int>::max()) return false;
+        _size = static_cast<size_t>(st.st_size);
+        void* data = mmap(nullptr, _size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data==MAP_FAILED) return false;
+        _data = static_cast<char*>(data);
+#endif
+        return true;
+    }
+};
+
 RFile::RFile(const string& filename) {
     string sfor = get_canonical_path(filename);
     const string mode = "r";
@@ -306,11 +392,26 @@ RFile::RFile(const string& filename) {
         _file_ispipe = true;
         _file = my_popen(V<string>("gzip", "-d", "-c", sfor + ".Z"), mode);
     }
-    if (_file && !_is) {
+    if (!_file) throw std::runtime_error("Could not open file '" + filename + "' for reading");
+}
+
+std::istream& RFile::create_stream() {
+    // Readers that only use cfile() (e.g. libpng, libjpeg, RBuffer) do not need a mapping.
+    if (!_file_ispipe && !_cfile_used) {
+        _mapping = Mapping::create(_file);
+        if (_mapping) _is = *_mapping;
+    }
+    if (!_is) {
         _impl = make_unique<Implementation>(_file);
         _is = *_impl;
     }
-    if (!_is) throw std::runtime_error("Could not open file '" + filename + "' for reading");
+    return *_is;
+}
+
+FILE* RFile::cfile() {
+    assertx(!_mapping);         // the mapped stream does not share the read position of the FILE
+    _cfile_used = true;
+    return _file;
 }
 
 RFile::~RFile() {
@@ -321,6 +422,7 @@ RFile::~RFile() {
 #endif
     }
     _impl = nullptr;
+    _mapping = nullptr;
     if (_file) {
         if (_file_ispipe) {
             int ret = my_pclose(_file);
@@ -334,6 +436,47 @@ RFile::~RFile() {
 }
 
 
+ArrayView<char> mapped_stream_remainder(std::istream& is) {
+    void* p = is.pword(k_pword_mapped_streambuf);
+    return p ? static_cast<mapped_streambuf*>(p)->remainder() : ArrayView<char>(nullptr, 0);
+}
+
+void mapped_stream_consume(std::istream& is, int n) {
+    void* p = is.pword(k_pword_mapped_streambuf); assertx(p);
+    static_cast<mapped_streambuf*>(p)->consume(n);
+}
+
+
+// *** LineTokenizer
+
+char* LineTokenizer::next() {
+    if (_p==_end) return nullptr;
+    char* sline = _p;
+    char* s = static_cast<char*>(std::memchr(_p, '\n', _end-_p));
+    if (!s) {                   // final line without terminator
+        _last.assign(sline, _end);
+        _p = _end;
+        sline = const_cast<char*>(_last.c_str());
+        s = sline+_last.size();
+    } else {
+        _p = s+1;
+        *s = '\0';
+    }
+    if (s>sline && s[-1]=='\r') {
+        s[-1] = '\0';
+        Warning("LineTokenizer: stripping out control-M from DOS file");
+    }
+    return sline;
+}
+
+const char* LineTokenizer::next_raw(int nbytes) {
+    if (_end-_p<nbytes) return nullptr;
+    const char* s = _p;
+    _p += nbytes;
+    return s;
+}
+
+
 // *** WFile
 
 WFile::WFile(const string& filename) {
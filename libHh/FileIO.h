@@ -7,19 +7,50 @@
 namespace hh {
 
 // Create a read stream from a file (FILE and/or istream); supports file decompression and input pipe commands.
+// A regular file is memory-mapped (unless getenv_bool("RFILE_NO_MMAP")), and its istream then reads directly
+//  from the mapping; see mapped_stream_remainder().
 class RFile : noncopyable {
  public:
     // supports "-", ".Z", ".gz", "command args... |"  (in most cases, try to close stdin within "command |")
     explicit RFile(const string& filename);
     ~RFile();
-    std::istream& operator()() const            { return *_is; }
-    FILE* cfile()                               { return _file; }
+    std::istream& operator()()                  { return _is ? *_is : create_stream(); }
+    FILE* cfile();               // if called first, the stream is not memory-mapped, so both share the read position
+    bool is_mapped() const                      { return !!_mapping; }
  private:
     bool _file_ispipe {false};
+    bool _cfile_used {false};
     FILE* _file {nullptr};
     class Implementation;
     unique_ptr<Implementation> _impl;
+    class Mapping;
+    unique_ptr<Mapping> _mapping;
     std::istream* _is {nullptr};
+    std::istream& create_stream(); // a regular file is memory-mapped upon the first access to its stream
+};
+
+// If is is the stream of an RFile on a memory-mapped file, return its unread contents, else an empty view.
+// The mapping is private (copy-on-write), so a parser may modify these contents in place; it should report the
+//  number of characters it has parsed using mapped_stream_consume(), so that the stream remains consistent.
+ArrayView<char> mapped_stream_remainder(std::istream& is);
+
+// Advance the read position of the memory-mapped stream is by n characters.
+void mapped_stream_consume(std::istream& is, int n);
+
+// Tokenize a character buffer (e.g. from mapped_stream_remainder()) into lines, in place and without copies:
+//  each line terminator ("\n" or "\r\n") is overwritten by '\0'.  It can also extract raw binary records.
+class LineTokenizer : noncopyable {
+ public:
+    explicit LineTokenizer(ArrayView<char> buf) : _beg(buf.data()), _p(_beg), _end(_beg+buf.num()) { }
+    int peek() const                            { return _p<_end ? static_cast<unsigned char>(*_p) : -1; }
+    char* next();                     // next line, or nullptr at end of buffer
+    const char* next_raw(int nbytes); // next nbytes of binary data, or nullptr if the buffer is too short
+    int num_consumed() const                    { return narrow_cast<int>(_p-_beg); }
+ private:
+    char* _beg;
+    char* _p;
+    char* _end;
+    string _last;               // copy of a final line without terminator (there is no room for its '\0')
 };
 
 // Create a write stream to a file (FILE and/or ostream); supports file compression and output pipe commands.
@@ -10,6 +10,7 @@
 #include "A3dStream.h"
 #include "Array.h"
 #include "Set.h"
+#include "FileIO.h"             // mapped_stream_remainder(), LineTokenizer
 
 namespace hh {
 
@@ -20,6 +21,14 @@ void swap(GMesh& l, GMesh& r) noexcept {
     using std::swap; swap(static_cast<Mesh&>(l), static_cast<Mesh&>(r)); swap(l._os, r._os);
 }
 
+void GMesh::clear() {
+    if (_os) {
+        for (Face f : ordered_faces()) { *_os << "DFace " << face_id(f) << '\n'; }
+        for (Vertex v : ordered_vertices()) { *_os << "DVertex " << vertex_id(v) << '\n'; }
+    }
+    Mesh::clear();
+}
+
 void GMesh::copy(const GMesh& m) {
     Mesh::copy(m);
     for (Vertex v : m.vertices()) {
@@ -344,6 +353,14 @@ void GMesh::update_string(Corner c, const char* key, const char* val) {
 // I/O
 
 void GMesh::read(std::istream& is) {
+    ArrayView<char> buf = mapped_stream_remainder(is);
+    if (buf.num()) {            // parse the lines in place within the memory-mapped file
+        LineTokenizer tokenizer(buf);
+        while (char* sline = tokenizer.next()) {
+            read_line(sline);
+        }
+        mapped_stream_consume(is, tokenizer.num_consumed());
+    }
     for (string sline; my_getline(is, sline); ) {
         read_line(const_cast<char*>(sline.c_str()));
     }
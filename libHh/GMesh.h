@@ -33,6 +33,7 @@ class GMesh : public Mesh {
     ~GMesh()                                    = default;
     GMesh& operator=(GMesh&& m) noexcept        { clear(); swap(*this, m); return *this; } // =default?
 // Extend functionality
+    void clear() override;      // also records the element destructions
     void copy(const GMesh& m);  // carries flags (but not sac fields), hence not named operator=().
     void merge(const GMesh& mo, Map<Vertex,Vertex>* mvvn = nullptr);
     void destroy_vertex(Vertex v) override;
@@ -12,6 +12,7 @@
 #include "Stat.h"
 #include "Array.h"
 #include "RangeOp.h"            // fill()
+#include "Parallel.h"           // parallel_for_each()
 
 namespace hh {
 
@@ -24,8 +25,15 @@ template<typename T> void graph_symmetric_closure(Graph<T>& g) {
     }
 }
 
+namespace details {
+// Priority queue for Dijkstra: nonnegative integer vertices index dense slots rather than being hashed.
+template<typename T, bool = std::is_integral<T>::value> struct dijkstra_pqueue { using type = HPqueue<T>; };
+template<typename T> struct dijkstra_pqueue<T, true> { using type = IPqueue<T, IPqueueIntSlots>; };
+} // namespace details
+
 // Given a graph (possibly directed), return vertices in order of increasing graph distance from vs.
 // (Vertex vs itself is returned on first invocation of next().)
+// If T is an integer type, vertices must be nonnegative.
 template<typename T, typename Func_dist = float (&)(const T& v1, const T& v2)> class Dijkstra : noncopyable {
  public:
     explicit Dijkstra(const Graph<T>* g, T vs, Func_dist fdist = Func_dist{}) : _g(*assertx(g)), _fdist(fdist) {
@@ -48,7 +56,7 @@ template<typename T, typename Func_dist = float (&)(const T& v1, const T& v2)> c
  private:
     const Graph<T>& _g;
     Func_dist _fdist;
-    HPqueue<T> _pq;
+    typename details::dijkstra_pqueue<T>::type _pq;
     Set<T> _set;
 };
 
@@ -99,6 +107,74 @@ Graph<T> graph_mst(const Graph<T>& undirectedg, Func fdist) {
     return gnew;
 }
 
+// Same as graph_mst() but the edge costs fdist() are evaluated concurrently (so fdist must be thread-safe), and
+//  the edges are processed using filter-Kruskal: the edges are recursively partitioned about a median cost, and the
+//  edges of each higher partition that already join connected vertices are discarded before it is sorted.
+// Internally, the vertices are indexed densely so that the union-find structure is a simple array.
+template<typename T, typename Func = float(const T&, const T&)>
+bool graph_mst_parallel(const Graph<T>& undirectedg, Func fdist, Graph<T>& gnew) {
+    Array<T> vertices;
+    Map<T,int> mvi;
+    for (const T& v : gnew.vertices()) {
+        ASSERTX(!gnew.out_degree(v));
+        mvi.enter(v, vertices.num()); vertices.push(v);
+    }
+    const int nv = vertices.num();
+    struct tedge { int i1, i2; float w; };
+    Array<tedge> tedges;
+    for_int(i1, nv) {
+        const T& v1 = vertices[i1];
+        for (const T& v2 : undirectedg.edges(v1)) {
+            if (v1<v2) continue;
+            tedges.push(tedge{i1, mvi.get(v2), 0.f});
+        }
+    }
+    const int nebefore = tedges.num();
+    parallel_for_each(range(nebefore), [&](const int i) {
+        tedges[i].w = fdist(vertices[tedges[i].i1], vertices[tedges[i].i2]);
+    });
+    auto by_cost = [](const tedge& a, const tedge& b) { return a.w < b.w; };
+    Array<int> uf_parent(nv); for_int(i, nv) { uf_parent[i] = i; }
+    auto uf_root = [&](int i) {
+        while (uf_parent[i]!=i) { uf_parent[i] = uf_parent[uf_parent[i]]; i = uf_parent[i]; } // path halving
+        return i;
+    };
+    int neconsidered = 0, neadded = 0;
+    const int k_small = 1000;   // below this number of edges, simply sort them
+    // Stack of pending partitions [ib, ie), in order of decreasing cost.
+    Array<Vec2<int>> stack; stack.push(V(0, nebefore));
+    while (stack.num() && neadded<nv-1) {
+        Vec2<int> be = stack.pop();
+        int ib = be[0], ie = be[1];
+        if (ib>0) {             // lower partitions are done; filter this one
+            ie = int(std::partition(&tedges[ib], tedges.data()+ie, [&](const tedge& t) {
+                return uf_root(t.i1)!=uf_root(t.i2);
+            })-tedges.data());
+        }
+        if (ie-ib>k_small) {
+            int im = (ib+ie)/2;
+            std::nth_element(&tedges[ib], &tedges[im], tedges.data()+ie, by_cost);
+            stack.push(V(im, ie));
+            stack.push(V(ib, im));
+            continue;
+        }
+        std::sort(tedges.data()+ib, tedges.data()+ie, by_cost);
+        for_intL(i, ib, ie) {
+            neconsidered++;
+            const tedge& t = tedges[i];
+            int r1 = uf_root(t.i1), r2 = uf_root(t.i2);
+            if (r1==r2) continue;
+            uf_parent[r1] = r2;
+            gnew.enter_undirected(vertices[t.i1], vertices[t.i2]);
+            neadded++;
+            if (neadded==nv-1) break;
+        }
+    }
+    showf("graph_mst_parallel: %d vertices, %d/%d edges considered, %d output\n",
+          nv, neconsidered, nebefore, neadded);
+    return neadded==nv-1;
+}
+
 // *** Prim MST
 
 // Returns a undirected graph that is the minimum spanning tree of the full graph
@@ -134,14 +210,14 @@ template<typename Func = float(int, int)> Graph<int> graph_mst(int num, Func fdi
 
 // Try to build the EMST of the num points pa using all edges with length less than thresh.
 // Uses modified Prim's, where only edges of length<thresh are considered.
-// Uses a HPqueue because it can no longer afford to find min in O(n) time.
+// Uses an IPqueue because it can no longer afford to find min in O(n) time.
 // Returns an empty graph if not connected.
 inline Graph<int> try_emst(float thresh, CArrayView<Point> pa, const PointSpatial<int>& sp) {
     Graph<int> gnew;
     Array<bool> inset(pa.num(), false); // vertices already added to mst
     Array<int> closest(pa.num());       // for !inset[i], closest inset[] so far
     for_int(i, pa.num()) { gnew.enter(i); }
-    HPqueue<int> pq;
+    IPqueue<int, IPqueueIntSlots> pq;
     pq.enter(0, 0.f);
     while (!pq.empty()) {
         int i = pq.remove_min();
@@ -180,6 +256,33 @@ inline Graph<int> graph_quick_emst(CArrayView<Point> pa, const PointSpatial<int>
     return gnew;
 }
 
+// *** Orientation propagation
+
+// Propagate a binary orientation from root along the undirected tree:
+//  a vertex is flipped relative to its parent p if fdot(p, v)<0, where fdot() reflects the unflipped state.
+// fdot() is evaluated concurrently on all tree edges, so it must be thread-safe.
+// Returns the vertices reached from root in breadth-first order; for each of these (indexed by its position i in this
+//  order), sets parent[i] (position of its parent, or -1 for root), dots[i]==fdot(parent, vertex), and flip[i]
+//  (orientation relative to root).
+template<typename T, typename Func = float(const T&, const T&)>
+Array<T> graph_propagate_orientation(const Graph<T>& tree, const T& root, Func fdot, Array<int>& parent,
+                                     Array<float>& dots, Array<bool>& flip) {
+    Array<T> order;
+    Set<T> visited;
+    order.push(root); visited.enter(root); parent.init(0); parent.push(-1);
+    for (int i = 0; i<order.num(); i++) {
+        for (const T& v : tree.edges(order[i])) {
+            if (!visited.add(v)) continue;
+            order.push(v); parent.push(i);
+        }
+    }
+    dots.init(order.num()); flip.init(order.num());
+    dots[0] = 1.f; flip[0] = false;
+    parallel_for_each(range(1, order.num()), [&](const int i) { dots[i] = fdot(order[parent[i]], order[i]); });
+    for_intL(i, 1, order.num()) { flip[i] = flip[parent[i]] != (dots[i]<0.f); }
+    return order;
+}
+
 // Return statistics about graph edge lengths.  If undirected, edges stats are duplicated.
 template<typename T, typename Func = float(const T&, const T&)> Stat graph_edge_stats(const Graph<T>& g, Func fdist) {
     Stat stat;
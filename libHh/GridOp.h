@@ -100,6 +100,22 @@ template<int D, bool parallel = true> Grid<D,Pixel> convolve_d(CGridView<D,Pixel
                                                                CArrayView<float> kernel, Bndrule bndrule,
                                                                const Pixel* bordervalue = nullptr);
 
+// Radii of num_boxes successive box filters whose combined variance best approximates square(sdv).
+Array<int> gaussian_box_radii(float sdv, int num_boxes = 3);
+
+// Approximate a Gaussian blur with standard deviation sdv (in samples) along the d'th dimension of a Pixel grid
+//  by num_boxes successive box filters using running sums, so the cost is independent of sdv.
+template<int D, bool parallel = true> Grid<D,Pixel> box_blur_d(CGridView<D,Pixel> grid, int d, float sdv,
+                                                               Bndrule bndrule, const Pixel* bordervalue = nullptr,
+                                                               int num_boxes = 3);
+
+// Exact Euclidean distance transform, computed in linear time as a lower envelope of parabolas along each
+//  dimension in turn (Felzenszwalb and Huttenlocher 2012).  For each grid point u, the returned offset points to
+//  a closest feature point (u+offset, where grid_feature is true); it is grid_feature.dims() if there is none.
+// If pgrid_dist is non-null, it is set to the Euclidean distances (BIGFLOAT if there is no feature point).
+template<int D> Grid<D,Vec<int,D>> euclidean_distance_transform(CGridView<D,bool> grid_feature,
+                                                                Grid<D,float>* pgrid_dist = nullptr);
+
 
 //----------------------------------------------------------------------------
 
@@ -659,6 +675,169 @@ template<int D, bool parallel> Grid<D,Pixel> convolve_d(CGridView<D,Pixel> grid,
     return ngrid;
 }
 
+inline Array<int> gaussian_box_radii(float sdv, int num_boxes) {
+    // Odd box widths w (with variance (w*w-1)/12 each): the first m boxes have width wl and the others wl+2.
+    assertx(sdv>=0.f && num_boxes>0);
+    const int n = num_boxes;
+    const float variance = 12.f*square(sdv);
+    int wl = static_cast<int>(std::sqrt(variance/n+1.f)); if (wl%2==0) wl--;
+    const int m = clamp(static_cast<int>(floor((variance-n*wl*wl-4*n*wl-3*n)/(-4.f*wl-4.f)+.5f)), 0, n);
+    Array<int> radii(n);
+    for_int(i, n) { radii[i] = (i<m ? wl-1 : wl+1)/2; }
+    return radii;
+}
+
+template<int D, bool parallel> Grid<D,Pixel> box_blur_d(CGridView<D,Pixel> grid, int d, float sdv,
+                                                        Bndrule bndrule, const Pixel* bordervalue, int num_boxes) {
+    if (bndrule==Bndrule::border) assertx(bordervalue);
+    const Vec<int,D>& dims = grid.dims();
+    const int nx = dims[d];
+    const Array<int> radii = gaussian_box_radii(sdv, num_boxes);
+    int rsum = 0; for (int r : radii) rsum += r;
+    const size_t stride = grid_stride(dims, d);
+    const Vector4i vborder = bordervalue ? Vector4i(*bordervalue) : Vector4i(0);
+    Grid<D,Pixel> ngrid(dims);
+    // Each line is extended by rsum samples on both sides; each box pass then shrinks its valid extent by its radius.
+    // The passes accumulate unnormalized integer sums, so each result is exact and independent of the position
+    //  at which the running sum started (e.g. the result is identical when blurring only a strip of rows).
+    auto func_line = [&](const Vec<int,D>& u) {
+        const size_t i0 = grid_index(dims, u);
+        Array<Vector4i> buf0(nx+2*rsum), buf1(nx+2*rsum);
+        for_int(j, nx+2*rsum) {
+            int i = j-rsum;
+            buf0[j] = map_boundaryrule_1D(i, nx, bndrule) ? Vector4i(grid.raster(i0+i*stride)) : vborder;
+        }
+        int jL = 0, jU = nx+2*rsum;
+        int64_t scale = 1;      // current sums are scale times the pixel values
+        auto func_normalize = [&]() {
+            for_intL(j, jL, jU) for_int(c, 4) { buf0[j][c] = int((buf0[j][c]+scale/2)/scale); }
+            scale = 1;
+        };
+        for (int r : radii) {
+            if (255*scale*(2*r+1)>std::numeric_limits<int>::max()) func_normalize(); // rare: very large sdv
+            Vector4i vsum(0); for_intL(j, jL, jL+2*r) { vsum = vsum+buf0[j]; }
+            for_intL(j, jL+r, jU-r) {
+                vsum = vsum+buf0[j+r];
+                buf1[j] = vsum;
+                vsum = vsum-buf0[j-r];
+            }
+            jL += r; jU -= r; scale *= 2*r+1;
+            std::swap(buf0, buf1);
+        }
+        const double rscale = 1./scale;
+        for_int(i, nx) {
+            const Vector4i& v = buf0[rsum+i];
+            Pixel& pix = ngrid.raster(i0+i*stride);
+            for_int(c, 4) { pix[c] = static_cast<uchar>(static_cast<int>(v[c]*rscale+.5)); } // OPT:box_blur
+        }
+    };
+    const Vec<int,D> line_dims = dims.with(d, 1);
+    const uint64_t cycles_per_line = uint64_t(nx+2*rsum)*(num_boxes+4)*4;
+    if (!parallel || product(line_dims)*cycles_per_line<k_omp_thresh)
+        for_coords(line_dims, func_line);
+    else
+        parallel_for_coords(line_dims, func_line, cycles_per_line);
+    return ngrid;
+}
+
+template<int D> Grid<D,Vec<int,D>> euclidean_distance_transform(CGridView<D,bool> grid_feature,
+                                                                Grid<D,float>* pgrid_dist) {
+    const Vec<int,D>& dims = grid_feature.dims();
+    const int k_undef = -1;     // first coordinate of the closest feature point if it is not yet known
+    // Closest feature point, considering only the dimensions processed so far; the last pass replaces it in place by
+    //  the offset to the closest feature point.
+    Grid<D,Vec<int,D>> grid_closest(dims);
+    if (pgrid_dist) pgrid_dist->init(dims);
+    for_int(d, D) {
+        const int n = dims[d];
+        const size_t stride = grid_stride(dims, d);
+        // Unless d is the last dimension, process nb adjacent lines together so that memory is accessed in rows.
+        const int nb = d<D-1 ? 16 : 1;
+        auto func_lines = [&](const Vec<int,D>& ub) {
+            const Vec<int,D> u0 = ub.with(D-1, ub[D-1]*nb);
+            const int nlines = min(nb, dims[D-1]-u0[D-1]);
+            const size_t i0 = grid_index(dims, u0);
+            Array<Vec<int,D>> ar_closest(d>0 ? n*nlines : 0); // indexed by [q*nlines+j]
+            Array<int> ar_best(n*nlines);   // [q*nlines+j] is the location along line j of the closest point
+            if (d==0) {
+                // All feature points have f==0, so the closest one along each line is found in two sweeps.
+                Vec<int,16> qprev; fill(qprev, -1);
+                for_int(q, n) for_int(j, nlines) {
+                    if (grid_feature.raster(i0+q*stride+j)) qprev[j] = q;
+                    ar_best[q*nlines+j] = qprev[j];
+                }
+                Vec<int,16> qnext; fill(qnext, -1);
+                for (int q = n-1; q>=0; --q) for_int(j, nlines) {
+                    int& qbest = ar_best[q*nlines+j];
+                    if (qbest==q) qnext[j] = q;
+                    if (qnext[j]>=0 && (qbest<0 || qnext[j]-q<q-qbest)) qbest = qnext[j];
+                }
+            } else {
+                for_int(q, n) for_int(j, nlines) { ar_closest[q*nlines+j] = grid_closest.raster(i0+q*stride+j); }
+                // The lower envelope of the parabolas square(x-q)+f[q] has boundaries z[k]=zn[k]/zd[k] (zd[k]>0);
+                //  these are compared exactly using integer arithmetic.
+                Array<int64_t> f(n);        // squared distance to closest feature point over dimensions [0, d)
+                Array<int> v(n);            // locations of the parabolas in the lower envelope
+                Array<int64_t> zn(n), zd(n);
+                for_int(j, nlines) {
+                    int k = -1;
+                    for_int(q, n) {
+                        const Vec<int,D>& closest = ar_closest[q*nlines+j];
+                        if (closest[0]==k_undef) continue;
+                        int64_t d2 = 0; for_int(c, d) { d2 += square(int64_t(closest[c]-u0[c]-(c==D-1 ? j : 0))); }
+                        f[q] = d2;
+                        int64_t num = 0, den = 1;
+                        while (k>=0) {
+                            const int p = v[k];
+                            num = (f[q]+square(int64_t(q)))-(f[p]+square(int64_t(p))); den = 2*(q-p);
+                            if (k>0 && num*zd[k]<=zn[k]*den) { k--; continue; } // intersection precedes z[k]
+                            break;
+                        }
+                        k++; v[k] = q; zn[k] = num; zd[k] = den;
+                    }
+                    if (k<0) {      // no feature point along this line
+                        for_int(q, n) { ar_best[q*nlines+j] = -1; }
+                        continue;
+                    }
+                    const int kmax = k;
+                    k = 0;
+                    for_int(q, n) {
+                        while (k<kmax && zn[k+1]<q*zd[k+1]) k++;
+                        ar_best[q*nlines+j] = v[k];
+                    }
+                }
+            }
+            for_int(q, n) for_int(j, nlines) {
+                const int qbest = ar_best[q*nlines+j];
+                Vec<int,D> closest = ntimes<D>(k_undef);
+                if (qbest>=0) {
+                    if (d>0) {
+                        closest = ar_closest[qbest*nlines+j];
+                    } else {
+                        closest = u0.with(0, qbest); closest[D-1] += j;
+                    }
+                }
+                const size_t i = i0+q*stride+j;
+                if (d<D-1) {
+                    grid_closest.raster(i) = closest;
+                } else {            // final dimension
+                    const bool found = closest[0]!=k_undef;
+                    const Vec<int,D> u = u0.with(d, q);
+                    grid_closest.raster(i) = found ? closest-u : dims;
+                    if (pgrid_dist) pgrid_dist->raster(i) = found ? float(mag(convert<double>(closest-u))) : BIGFLOAT;
+                }
+            }
+        };
+        Vec<int,D> block_dims = dims.with(d, 1); block_dims[D-1] = (block_dims[D-1]+nb-1)/nb;
+        const uint64_t cycles_per_block = uint64_t(n)*nb*30;
+        if (product(block_dims)*cycles_per_block<k_omp_thresh)
+            for_coords(block_dims, func_lines);
+        else
+            parallel_for_coords(block_dims, func_lines, cycles_per_block);
+    }
+    return grid_closest;
+}
+
 } // namespace hh
 
 #endif // MESH_PROCESSING_LIBHH_GRIDOP_H_
@@ -12,6 +12,171 @@ namespace hh {
 // echo $n; Filterimage -create $n $n -bound c -scaleu 1 -noo
 // end
 
+namespace details {
+
+// Resampling weights along one dimension (from FilterBnd::setup_kernel_weights()), in which the boundary rule is
+//  already applied to the input indices so that the inner loops need no boundary tests.
+// For Bndrule::border, the taps lying outside the input domain (index -1) take the border value; the few outputs
+//  with such taps are evaluated separately, accumulating the taps in the same order as evaluate_kernel_d().
+struct ResampleWeights {
+    ResampleWeights(int cx, int nx, const FilterBnd& filterb) {
+        Array<int> ar_pixelindex0; Matrix<float> mat_weights;
+        filterb.setup_kernel_weights(cx, nx, false, ar_pixelindex0, mat_weights);
+        nk = mat_weights.xsize();
+        index.init(V(nx, nk)); weight.init(V(nx, nk)); has_border.init(nx, false);
+        for_int(x, nx) for_int(k, nk) {
+            int i = ar_pixelindex0[x]+k;
+            weight[x][k] = mat_weights[x][k];
+            if (map_boundaryrule_1D(i, cx, filterb.bndrule())) {
+                index[x][k] = i;
+            } else {            // Bndrule::border
+                index[x][k] = -1; has_border[x] = true;
+            }
+        }
+    }
+    int nk;                     // number of kernel taps
+    Matrix<int> index;          // [nx][nk] input index of each tap, or -1 for the border value
+    Matrix<float> weight;       // [nx][nk] weight of each tap
+    Array<bool> has_border;     // [nx] some tap lies outside the input domain
+};
+
+inline Vector4 to_Vector4(const Pixel& pix)     { return Vector4(pix); }
+inline const Vector4& to_Vector4(const Vector4& v) { return v; }
+
+// Resample a row: out[x] = sum_k weight[x][k]*in[index[x][k]] (with vborder for index -1).
+template<typename T> void resample_row(const ResampleWeights& rw, const T* __restrict in,
+                                       ArrayView<Vector4> out, const Vector4& vborder) {
+    const int nk = rw.nk;
+    for_int(x, out.num()) {
+        const int* __restrict ai = rw.index[x].data();
+        const float* __restrict aw = rw.weight[x].data();
+        Vector4 v(0.f);
+        if (!rw.has_border[x]) {
+            for_int(k, nk) { v += aw[k]*to_Vector4(in[ai[k]]); } // OPT:resample_row
+        } else {
+            for_int(k, nk) { v += aw[k]*(ai[k]>=0 ? to_Vector4(in[ai[k]]) : vborder); }
+        }
+        out[x] = v;
+    }
+}
+
+// Resample output row y of a column resampling: out[x] = sum_k weight[y][k]*in[index[y][k]][x] (with vborder for
+//  index -1).
+template<typename T> void resample_column_row(const ResampleWeights& rw, int y, CMatrixView<T> in,
+                                              ArrayView<Vector4> out, const Vector4& vborder) {
+    const int nx = out.num();
+    Vector4* __restrict ao = out.data();
+    for_int(x, nx) { ao[x] = Vector4(0.f); }
+    for_int(k, rw.nk) {
+        const float w = rw.weight[y][k];
+        if (!w) continue;
+        const int i = rw.index[y][k];
+        if (i<0) {
+            const Vector4 vb = w*vborder;
+            for_int(x, nx) { ao[x] += vb; }
+            continue;
+        }
+        const T* __restrict ai = in[i].data();
+        for_int(x, nx) { ao[x] += w*to_Vector4(ai[x]); } // OPT:resample_column
+    }
+}
+
+// Inverse convolution of a single row (see inverse_convolution_d()).
+inline void inverse_convolution_row(ArrayView<Vector4> row, const FilterBnd& filterb) {
+    inverse_convolution_d(GridView<1,Vector4>(row.data(), V(row.num())), filterb, 0);
+}
+
+inline bool can_scale_Matrix_Pixel_separable(const Vec2<FilterBnd>& filterbs) {
+    if (b_image_linear_filter) return false;
+    for (const FilterBnd& filterb : filterbs) {
+        if (filterb.filter().is_preprocess() || filterb.filter().name()=="justspline") return false;
+    }
+    return true;
+}
+
+// Same result as converting to Matrix<Vector4> and calling scale() (exactly), but without full-size float copies
+//  of the input and output:
+//  the pixels are converted within the first and last passes, using precomputed weights without boundary tests.
+inline void scale_Matrix_Pixel_separable(CMatrixView<Pixel> matrixp, const Vec2<FilterBnd>& filterbs,
+                                         const Pixel* bordervalue, MatrixView<Pixel> nmatrixp) {
+    HH_GRIDOP_TIMER(__scale_separable);
+    const Vec2<int> dims = matrixp.dims(), ndims = nmatrixp.dims();
+    assertx(min(dims)>0 && min(ndims)>0);
+    Vector4 vborder(0.f);
+    if (any_of(filterbs, [](const FilterBnd& fb) { return fb.bndrule()==Bndrule::border; }))
+        vborder = Vector4(*assertx(bordervalue));
+    // Same order of dimensions as in scale_i().
+    const Vec2<float> syx = convert<float>(ndims)/convert<float>(dims);
+    const float sx_adjusted = syx[1]<1.f ? syx[1]/2.f : syx[1]>1.f ? syx[1]*2.f : syx[1];
+    const bool hfirst = sx_adjusted<syx[0];
+    Vec2<bool> identity, pre_invconv, post_invconv;
+    for_int(d, 2) {
+        const Filter& filter = filterbs[d].filter();
+        identity[d] = ndims[d]==dims[d] && filter.is_interpolating();
+        pre_invconv[d] = !identity[d] && filter.has_inv_convolution() && ndims[d]>=dims[d];
+        post_invconv[d] = !identity[d] && filter.has_inv_convolution() && ndims[d]<dims[d];
+    }
+    const ResampleWeights rwy(dims[0], ndims[0], filterbs[0]), rwx(dims[1], ndims[1], filterbs[1]);
+    // Resample the (Vector4 or Pixel) row in horizontally into out (of size ndims[1]).
+    auto hpass_row = [&](ArrayView<Vector4> in, ArrayView<Vector4> out) {
+        if (identity[1]) { out.assign(in); return; }
+        if (pre_invconv[1]) inverse_convolution_row(in, filterbs[1]);
+        resample_row(rwx, in.data(), out, vborder);
+        if (post_invconv[1]) inverse_convolution_row(out, filterbs[1]);
+    };
+    const int cycles_per_row = 8*(rwx.nk+rwy.nk)*max(dims[1], ndims[1]);
+    if (hfirst) {
+        Matrix<Vector4> matrix(V(dims[0], ndims[1]));
+        parallel_for_each(range(dims[0]), [&](const int y) {
+            Array<Vector4> row(dims[1]);
+            for_int(x, dims[1]) { row[x] = Vector4(matrixp[y][x]); }
+            hpass_row(row, matrix[y]);
+        }, cycles_per_row);
+        if (identity[0]) {
+            convert(matrix, nmatrixp);
+            return;
+        }
+        if (pre_invconv[0]) inverse_convolution_d(matrix, filterbs[0], 0);
+        if (post_invconv[0]) {
+            Matrix<Vector4> nmatrix(ndims);
+            parallel_for_each(range(ndims[0]), [&](const int y) {
+                resample_column_row(rwy, y, CMatrixView<Vector4>(matrix), nmatrix[y], vborder);
+            }, cycles_per_row);
+            inverse_convolution_d(nmatrix, filterbs[0], 0);
+            convert(nmatrix, nmatrixp);
+        } else {
+            parallel_for_each(range(ndims[0]), [&](const int y) {
+                Array<Vector4> row(ndims[1]);
+                resample_column_row(rwy, y, CMatrixView<Vector4>(matrix), row, vborder);
+                for_int(x, ndims[1]) { nmatrixp[y][x] = row[x].pixel(); }
+            }, cycles_per_row);
+        }
+    } else {
+        Matrix<Vector4> matrix(V(ndims[0], dims[1]));
+        if (identity[0]) {
+            convert(matrixp, matrix);
+        } else if (pre_invconv[0]) {
+            Matrix<Vector4> omatrix(dims); convert(matrixp, omatrix);
+            inverse_convolution_d(omatrix, filterbs[0], 0);
+            parallel_for_each(range(ndims[0]), [&](const int y) {
+                resample_column_row(rwy, y, CMatrixView<Vector4>(omatrix), matrix[y], vborder);
+            }, cycles_per_row);
+        } else {
+            parallel_for_each(range(ndims[0]), [&](const int y) {
+                resample_column_row(rwy, y, matrixp, matrix[y], vborder);
+            }, cycles_per_row);
+            if (post_invconv[0]) inverse_convolution_d(matrix, filterbs[0], 0);
+        }
+        parallel_for_each(range(ndims[0]), [&](const int y) {
+            Array<Vector4> row(ndims[1]);
+            hpass_row(matrix[y], row);
+            for_int(x, ndims[1]) { nmatrixp[y][x] = row[x].pixel(); }
+        }, cycles_per_row);
+    }
+}
+
+} // namespace details
+
 // Rescale matrix of pixels to the sizes given by destination nmatrixp; views matrixp and nmatrixp must be distinct.
 inline void scale_Matrix_Pixel(CMatrixView<Pixel> matrixp, const Vec2<FilterBnd>& filterbs,
                                const Pixel* bordervalue, MatrixView<Pixel> nmatrixp) {
@@ -94,6 +259,10 @@ inline void scale_Matrix_Pixel(CMatrixView<Pixel> matrixp, const Vec2<FilterBnd>
             return;
         }
     }
+    if (details::can_scale_Matrix_Pixel_separable(filterbs)) {
+        details::scale_Matrix_Pixel_separable(matrixp, filterbs, bordervalue, nmatrixp);
+        return;
+    }
     Matrix<Vector4> matrix(matrixp.dims()); convert(matrixp, matrix);
     Vector4 vborder;
     if (bordervalue) convert(CGrid1View(*bordervalue), Grid1View(vborder));
@@ -820,7 +820,10 @@ class Warnings {
  public:
     Warnings()                                  { }
     ~Warnings()                                 { flush(); }
-    int increment_count(const char* s)          { return ++_m[s]; }
+    int increment_count(const char* s) {        // (warnings may be issued concurrently)
+        std::lock_guard<std::mutex> lock(_mutex);
+        return ++_m[s];
+    }
     void flush() {
         if (_m.empty()) return;
         struct ltstr {              // lexicographic comparison; deterministic, unlike pointer comparison
@@ -838,6 +841,7 @@ class Warnings {
     }
  private:
     std::unordered_map<const void*, int> _m; // warning char* -> number of times printed
+    std::mutex _mutex;
 };
 
 class Warnings_init {
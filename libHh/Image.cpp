@@ -235,6 +235,7 @@ string image_suffix_for_magic_byte(uchar c) {
     // *.png: "\211PNG\r\n"
     // *.arw: "II*\000" (Sony alpha raw)
     // *.exr: "v/1\001\002\0\0\0channels"
+    // *.rawimage: "RawImage " (see ImageRows.h)
     switch (c) {
      case 1:   return "rgb";    // u'\x01'
      case 255: return "jpg";    // u'\xFF'
@@ -243,6 +244,7 @@ string image_suffix_for_magic_byte(uchar c) {
      case 137: return "png";    // u'\x89'
      case 'I': return "arw";
      case 'v': return "exr";    // 118
+     case 'R': return "rawimage";
      default:  return "";
     }
 }
@@ -366,6 +368,161 @@ void Image::write_file_i(const string& filename, bool bgra) const {
 
 // *** Conversions between YUV and RGB
 
+namespace {
+
+// The SSE kernels below process 8 pixels (4 chroma samples) per iteration and produce results bit-identical to
+//  the scalar Vector4i code (which handles the remaining columns and is the reference on other platforms):
+//  all intermediate values are exact in 32-bit lanes, and the saturating packs match Vector4i::pixel().
+#if defined(HH_VECTOR4_SSE) && !defined(HH_NO_SSE41)
+#define HH_NV12_SSE
+#endif
+
+// Convert the two luminance rows bufY0/bufY1 sharing the chroma row bufUV into the Pixel rows bufP0/bufP1.
+template<bool bgra> void convert_Nv12_row_pair(const uchar* bufY0, const uchar* bufY1, const uchar* bufUV,
+                                               Pixel* bufP0, Pixel* bufP1, int nx) {
+    // Chroma coefficients (u, v) and constant offsets of the first and third output channels.
+    const int cu0 = bgra ? 516 : 0, cv0 = bgra ? 0 : 409, cu2 = bgra ? 0 : 516, cv2 = bgra ? 409 : 0;
+    const int k0 = -16*298 + 128 - cu0*128 - cv0*128, k2 = -16*298 + 128 - cu2*128 - cv2*128;
+    const int k1 = -16*298 + 128 + 100*128 + 208*128;
+    int x = 0;
+#if defined(HH_NV12_SSE)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i m298 = _mm_set1_epi16(298);
+        // _mm_madd_epi16() combines each 16-bit (u, v) pair with the channel coefficients (cu, cv).
+        const __m128i muv0 = _mm_setr_epi16(short(cu0), short(cv0), short(cu0), short(cv0),
+                                            short(cu0), short(cv0), short(cu0), short(cv0));
+        const __m128i muv1 = _mm_setr_epi16(-100, -208, -100, -208, -100, -208, -100, -208);
+        const __m128i muv2 = _mm_setr_epi16(short(cu2), short(cv2), short(cu2), short(cv2),
+                                            short(cu2), short(cv2), short(cu2), short(cv2));
+        const __m128i vk0 = _mm_set1_epi32(k0), vk1 = _mm_set1_epi32(k1), vk2 = _mm_set1_epi32(k2);
+        const __m128i alpha = _mm_set1_epi8(char(255));
+        for (; x+8<=nx; x += 8) {
+            __m128i uv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bufUV+x)), zero);
+            __m128i c0 = _mm_add_epi32(_mm_madd_epi16(uv, muv0), vk0); // 4 chroma samples, 32-bit
+            __m128i c1 = _mm_add_epi32(_mm_madd_epi16(uv, muv1), vk1);
+            __m128i c2 = _mm_add_epi32(_mm_madd_epi16(uv, muv2), vk2);
+            // Each chroma sample applies to two adjacent pixels.
+            __m128i c0l = _mm_unpacklo_epi32(c0, c0), c0h = _mm_unpackhi_epi32(c0, c0);
+            __m128i c1l = _mm_unpacklo_epi32(c1, c1), c1h = _mm_unpackhi_epi32(c1, c1);
+            __m128i c2l = _mm_unpacklo_epi32(c2, c2), c2h = _mm_unpackhi_epi32(c2, c2);
+            for_int(i, 2) {
+                const uchar* bufY = i ? bufY1 : bufY0;
+                Pixel* bufP = i ? bufP1 : bufP0;
+                __m128i y16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bufY+x)), zero);
+                __m128i ylo = _mm_mullo_epi16(y16, m298), yhi = _mm_mulhi_epu16(y16, m298);
+                __m128i yy0 = _mm_unpacklo_epi16(ylo, yhi), yy1 = _mm_unpackhi_epi16(ylo, yhi); // 298*Y, 32-bit
+                __m128i v0 = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(yy0, c0l), 8),
+                                             _mm_srai_epi32(_mm_add_epi32(yy1, c0h), 8));
+                __m128i v1 = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(yy0, c1l), 8),
+                                             _mm_srai_epi32(_mm_add_epi32(yy1, c1h), 8));
+                __m128i v2 = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(yy0, c2l), 8),
+                                             _mm_srai_epi32(_mm_add_epi32(yy1, c2h), 8));
+                __m128i v01 = _mm_packus_epi16(v0, v1);                  // 8 bytes channel0, 8 bytes channel1
+                __m128i v23 = _mm_packus_epi16(v2, v2);
+                __m128i p01 = _mm_unpacklo_epi8(v01, _mm_srli_si128(v01, 8)); // interleaved channels 0 and 1
+                __m128i p23 = _mm_unpacklo_epi8(v23, alpha);                  // interleaved channels 2 and 3
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(bufP+x+0), _mm_unpacklo_epi16(p01, p23));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(bufP+x+4), _mm_unpackhi_epi16(p01, p23));
+            }
+        }
+    }
+#endif
+    const Vector4i yscale(298, 298, 298, 0);
+    for (; x<nx; x += 2) {
+        int u = bufUV[x+0], v = bufUV[x+1];
+        Vector4i vi0 = (Vector4i(k0, k1, k2, 255*256) +
+                        Vector4i(cu0, -100, cu2, 0)*u +
+                        Vector4i(cv0, -208, cv2, 0)*v);
+        bufP0[x+0] = ((vi0 + yscale*bufY0[x+0]) >> 8).pixel(); // OPT:YUV4
+        bufP0[x+1] = ((vi0 + yscale*bufY0[x+1]) >> 8).pixel();
+        bufP1[x+0] = ((vi0 + yscale*bufY1[x+0]) >> 8).pixel();
+        bufP1[x+1] = ((vi0 + yscale*bufY1[x+1]) >> 8).pixel();
+    }
+}
+
+template<bool bgra> void convert_Nv12_to_Pixels(CNv12View nv12v, MatrixView<Pixel> frame) {
+    assertx(same_size(nv12v.get_Y(), frame));
+    const int nx = frame.xsize();
+    parallel_for_each(range(frame.ysize()/2), [&](const int y) {
+        convert_Nv12_row_pair<bgra>(nv12v.get_Y()[y*2+0].data(), nv12v.get_Y()[y*2+1].data(),
+                                    nv12v.get_UV()[y].data()->data(),
+                                    frame[y*2+0].data(), frame[y*2+1].data(), nx);
+    }, nx*12);
+}
+
+// Convert the two Pixel rows bufP0/bufP1 into the luminance rows bufY0/bufY1 and the shared chroma row bufUV.
+void convert_row_pair_to_Nv12(const uchar* __restrict bufP0, const uchar* __restrict bufP1,
+                              uchar* __restrict bufY0, uchar* __restrict bufY1, uchar* __restrict bufUV, int nx) {
+    int x = 0;
+#if defined(HH_NV12_SSE)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mY = _mm_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0);
+        const __m128i mU = _mm_setr_epi16(-38, -74, 112, 0, -38, -74, 112, 0);
+        const __m128i mV = _mm_setr_epi16(112, -94, -18, 0, 112, -94, -18, 0);
+        const __m128i kY = _mm_set1_epi32(128+16*256);
+        const __m128i kUV = _mm_set1_epi32(128*4 + 128*1024); // (2*(-38-74+112) and 2*(112-94-18) are zero)
+        // Luminance of 8 pixels given as 4 registers of 2 pixels with 16-bit channels.
+        auto func_Y = [&](__m128i a, __m128i b, __m128i c, __m128i d) {
+            __m128i y0 = _mm_hadd_epi32(_mm_madd_epi16(a, mY), _mm_madd_epi16(b, mY));
+            __m128i y1 = _mm_hadd_epi32(_mm_madd_epi16(c, mY), _mm_madd_epi16(d, mY));
+            y0 = _mm_srli_epi32(_mm_add_epi32(y0, kY), 8);
+            y1 = _mm_srli_epi32(_mm_add_epi32(y1, kY), 8);
+            __m128i y16 = _mm_packs_epi32(y0, y1);
+            return _mm_packus_epi16(y16, y16);
+        };
+        for (; x+8<=nx; x += 8) {
+            __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bufP0+x*4+0));
+            __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bufP0+x*4+16));
+            __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bufP1+x*4+0));
+            __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bufP1+x*4+16));
+            __m128i a01 = _mm_unpacklo_epi8(a0, zero), a23 = _mm_unpackhi_epi8(a0, zero);
+            __m128i a45 = _mm_unpacklo_epi8(a1, zero), a67 = _mm_unpackhi_epi8(a1, zero);
+            __m128i b01 = _mm_unpacklo_epi8(b0, zero), b23 = _mm_unpackhi_epi8(b0, zero);
+            __m128i b45 = _mm_unpacklo_epi8(b1, zero), b67 = _mm_unpackhi_epi8(b1, zero);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(bufY0+x), func_Y(a01, a23, a45, a67));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(bufY1+x), func_Y(b01, b23, b45, b67));
+            // Sums over the 2x2 blocks of 16-bit channels (at most 4*255).
+            __m128i s01 = _mm_add_epi16(a01, b01), s23 = _mm_add_epi16(a23, b23);
+            __m128i s45 = _mm_add_epi16(a45, b45), s67 = _mm_add_epi16(a67, b67);
+            __m128i blk01 = _mm_add_epi16(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+            __m128i blk23 = _mm_add_epi16(_mm_unpacklo_epi64(s45, s67), _mm_unpackhi_epi64(s45, s67));
+            __m128i u = _mm_hadd_epi32(_mm_madd_epi16(blk01, mU), _mm_madd_epi16(blk23, mU));
+            __m128i v = _mm_hadd_epi32(_mm_madd_epi16(blk01, mV), _mm_madd_epi16(blk23, mV));
+            u = _mm_srai_epi32(_mm_add_epi32(u, kUV), 10);
+            v = _mm_srai_epi32(_mm_add_epi32(v, kUV), 10);
+            __m128i uv16 = _mm_unpacklo_epi16(_mm_packs_epi32(u, u), _mm_packs_epi32(v, v));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(bufUV+x), _mm_packus_epi16(uv16, uv16));
+        }
+    }
+#endif
+    for (; x<nx; x += 2) {
+        const uchar* __restrict p0 = bufP0+x*4;
+        const uchar* __restrict p1 = bufP1+x*4;
+        int r00 = p0[0], g00 = p0[1], b00 = p0[2];
+        uchar y00 = uchar((66*r00 + 129*g00 + 25*b00 + 128+16*256) >> 8);
+        int r01 = p0[4], g01 = p0[5], b01 = p0[6];
+        r00 += r01; g00 += g01; b00 += b01;
+        uchar y01 = uchar((66*r01 + 129*g01 + 25*b01 + 128+16*256) >> 8);
+        int r10 = p1[0], g10 = p1[1], b10 = p1[2];
+        r00 += r10; g00 += g10; b00 += b10;
+        uchar y10 = uchar((66*r10 + 129*g10 + 25*b10 + 128+16*256) >> 8);
+        int r11 = p1[4], g11 = p1[5], b11 = p1[6];
+        r00 += r11; g00 += g11; b00 += b11;
+        uchar y11 = uchar((66*r11 + 129*g11 + 25*b11 + 128+16*256) >> 8); // OPT:to_YUV
+        bufY0[x+0] = y00;
+        bufY0[x+1] = y01;
+        bufY1[x+0] = y10;
+        bufY1[x+1] = y11;
+        // (more accurate than other implementations in convert_Image_to_Nv12())
+        bufUV[x+0] = uchar((-38*r00 - 74*g00 + 112*b00 + 128*4 + 2*(-38-74+112) + 128*1024) >> 10); // U
+        bufUV[x+1] = uchar((112*r00 - 94*g00 -  18*b00 + 128*4 + 2*(112-94-18)  + 128*1024) >> 10); // V
+    }
+}
+
+} // namespace
+
 void convert_Nv12_to_Image(CNv12View nv12v, MatrixView<Pixel> frame) {
     assertx(same_size(nv12v.get_Y(), frame));
     const uchar* bufY = nv12v.get_Y().data();
@@ -429,7 +586,7 @@ void convert_Nv12_to_Image(CNv12View nv12v, MatrixView<Pixel> frame) {
             }
             bufY += rowlen; pP += rowlen;
         }
-    } else if (1) {
+    } else if (0) {
         const int rowlen = frame.xsize();
         for_int(y, frame.ysize()/2) {
             for_int(x, frame.xsize()/2) {
@@ -449,34 +606,14 @@ void convert_Nv12_to_Image(CNv12View nv12v, MatrixView<Pixel> frame) {
             }
             bufY += rowlen; bufP += rowlen;
         }
+    } else if (1) {
+        // Same as OPT:YUV4, with SSE kernels and parallelism over pairs of rows.
+        convert_Nv12_to_Pixels<false>(nv12v, frame);
     }
 }
 
 void convert_Nv12_to_Image_BGRA(CNv12View nv12v, MatrixView<Pixel> frame) {
-    assertx(same_size(nv12v.get_Y(), frame));
-    const uchar* bufY = nv12v.get_Y().data();
-    const uchar* bufUV = nv12v.get_UV().data()->data();
-    Pixel* bufP = frame.data();
-    assertx(reinterpret_cast<uintptr_t>(bufP)%4==0);
-    const int rowlen = frame.xsize();
-    for_int(y, frame.ysize()/2) {
-        for_int(x, frame.xsize()/2) {
-            int u = bufUV[0], v = bufUV[1];
-            Vector4i vi0 = (Vector4i(-16*298 + 128 - 516*128,
-                                     -16*298 + 128 + 100*128 + 208*128,
-                                     -16*298 + 128           - 409*128,
-                                     255*256) +
-                            Vector4i(516, -100,   0, 0)*u +
-                            Vector4i(0,   -208, 409, 0)*v);
-            const Vector4i yscale(298, 298, 298, 0);
-            bufP[0*rowlen+0] = ((vi0 + yscale*bufY[0*rowlen+0]) >> 8).pixel(); // OPT:YUV4
-            bufP[0*rowlen+1] = ((vi0 + yscale*bufY[0*rowlen+1]) >> 8).pixel();
-            bufP[1*rowlen+0] = ((vi0 + yscale*bufY[1*rowlen+0]) >> 8).pixel();
-            bufP[1*rowlen+1] = ((vi0 + yscale*bufY[1*rowlen+1]) >> 8).pixel();
-            bufY += 2; bufUV += 2; bufP += 2;
-        }
-        bufY += rowlen; bufP += rowlen;
-    }
+    convert_Nv12_to_Pixels<true>(nv12v, frame);
 }
 
 void convert_Image_to_Nv12(CMatrixView<Pixel> frame, Nv12View nv12v) {
@@ -530,34 +667,13 @@ void convert_Image_to_Nv12(CMatrixView<Pixel> frame, Nv12View nv12v) {
             }
         }
     } else if (1) {
-        for_int(y, frame.ysize()/2) {
-            const uchar* __restrict bufP0 = frame[y*2+0].data()->data();
-            uchar* __restrict bufY0 = nv12v.get_Y()[y*2+0].data();
-            const int hnx = frame.xsize()/2;
-            for_int(x, hnx) {
-                int r00 = bufP0[0], g00 = bufP0[1], b00 = bufP0[2];
-                uchar y00 = uchar((66*r00 + 129*g00 + 25*b00 + 128+16*256) >> 8);
-                int r01 = bufP0[4], g01 = bufP0[5], b01 = bufP0[6];
-                r00 += r01; g00 += g01; b00 += b01;
-                uchar y01 = uchar((66*r01 + 129*g01 + 25*b01 + 128+16*256) >> 8);
-                const uchar* __restrict bufP1 = bufP0+hnx*8;
-                int r10 = bufP1[0], g10 = bufP1[1], b10 = bufP1[2];
-                r00 += r10; g00 += g10; b00 += b10;
-                uchar y10 = uchar((66*r10 + 129*g10 + 25*b10 + 128+16*256) >> 8);
-                int r11 = bufP1[4], g11 = bufP1[5], b11 = bufP1[6];
-                r00 += r11; g00 += g11; b00 += b11;
-                uchar y11 = uchar((66*r11 + 129*g11 + 25*b11 + 128+16*256) >> 8); // OPT:to_YUV
-                bufY0[0] = y00;
-                bufY0[1] = y01;
-                bufY0[2*hnx+0] = y10;
-                bufY0[2*hnx+1] = y11;
-                // (more accurate than other implementations in this function)
-                *bufUV++ = uchar((-38*r00 - 74*g00 + 112*b00 + 128*4 + 2*(-38-74+112) + 128*1024) >> 10); // U
-                *bufUV++ = uchar((112*r00 - 94*g00 -  18*b00 + 128*4 + 2*(112-94-18)  + 128*1024) >> 10); // V
-                bufP0 += 8;
-                bufY0 += 2;
-            }
-        }
+        // OPT:to_YUV with SSE kernels and parallelism over pairs of rows.
+        const int nx = frame.xsize();
+        parallel_for_each(range(frame.ysize()/2), [&](const int y) {
+            convert_row_pair_to_Nv12(frame[y*2+0].data()->data(), frame[y*2+1].data()->data(),
+                                     nv12v.get_Y()[y*2+0].data(), nv12v.get_Y()[y*2+1].data(),
+                                     nv12v.get_UV()[y].data()->data(), nx);
+        }, nx*12);
     } else if (0) {
         auto func_enc_Y = [](int r, int g, int b) { return uchar(((66*r + 129*g + 25*b + 128) >> 8) + 16); };
         for_int(y, frame.ysize()/2) {
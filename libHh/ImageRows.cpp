@@ -0,0 +1,400 @@
+// -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
+#include "ImageRows.h"
+
+#include "Image_IO.h"           // jpeglib.h, png.h
+#include "FileIO.h"
+#include "BinaryIO.h"           // read_raw(), write_raw()
+#include "StringOp.h"           // to_lower(), ends_with()
+
+namespace hh {
+
+namespace details {
+
+void write_rawimage_header(FILE* file, const Vec2<int>& dims, int zsize) {
+    string s = sform("RawImage %d %d %d", dims[1], dims[0], zsize);
+    assertx(narrow_cast<int>(s.size())<k_rawimage_header_size);
+    s += string(k_rawimage_header_size-1-s.size(), ' ') + "\n";
+    assertt(write_raw(file, CArrayView<char>(s.data(), k_rawimage_header_size)));
+}
+
+void read_rawimage_header(FILE* file, Vec2<int>& dims, int& zsize) {
+    Vec<char, k_rawimage_header_size+1> buf;
+    if (!read_raw(file, ArrayView<char>(buf.data(), k_rawimage_header_size)))
+        throw std::runtime_error("Error reading rawimage header");
+    buf.last() = '\0';
+    int xsize, ysize;
+    if (sscanf(buf.data(), "RawImage %d %d %d", &xsize, &ysize, &zsize)!=3)
+        throw std::runtime_error("Error parsing rawimage header");
+    assertt(xsize>=0 && ysize>=0 && zsize>=1 && zsize<=4);
+    dims = V(ysize, xsize);
+}
+
+} // namespace details
+
+using namespace details;
+
+namespace {
+
+inline void finish_pixel(Pixel& pix, int zsize) {
+    if (zsize==1) pix[2] = pix[1] = pix[0];
+    if (zsize<4) pix[3] = 255;
+}
+
+string lower_suffix(const string& filename) {
+    string s = to_lower(filename);
+    if (ends_with(s, ".gz")) s.erase(s.size()-3);
+    auto i = s.rfind('.');
+    return i==string::npos ? "" : s.substr(i+1);
+}
+
+} // namespace
+
+// *** RImageRows
+
+class RImageRows::Implementation {
+ public:
+    virtual ~Implementation()                   { }
+    virtual void read_row(ArrayView<Pixel> row) = 0;
+};
+
+namespace {
+
+class WholeImageReader : public RImageRows::Implementation {
+ public:
+    explicit WholeImageReader(const string& filename) { _image.read_file(filename); }
+    const Image& image() const                  { return _image; }
+    void read_row(ArrayView<Pixel> row) override { row.assign(_image[_y++]); }
+ private:
+    Image _image;
+    int _y {0};
+};
+
+class FileReader : public RImageRows::Implementation {
+ public:
+    explicit FileReader(unique_ptr<RFile> rfile) : _rfile(std::move(rfile)), _file(_rfile->cfile()) { }
+ protected:
+    unique_ptr<RFile> _rfile;
+    FILE* _file;
+};
+
+class RawImageReader : public FileReader {
+ public:
+    RawImageReader(unique_ptr<RFile> rfile, Vec2<int>& dims, int& zsize) : FileReader(std::move(rfile)) {
+        read_rawimage_header(_file, dims, zsize);
+    }
+    void read_row(ArrayView<Pixel> row) override {
+        if (!read_raw(_file, row)) throw std::runtime_error("Error reading rawimage row");
+    }
+};
+
+class PpmReader : public FileReader {
+ public:
+    PpmReader(unique_ptr<RFile> rfile, Vec2<int>& dims, int& zsize) : FileReader(std::move(rfile)) {
+        Vec<char,200> buf;
+        if (!fgets(buf.data(), buf.num()-1, _file)) throw std::runtime_error("Error reading ppm image header");
+        assertt(buf[0]=='P');
+        assertt(buf[1]=='6' || buf[1]=='5');
+        zsize = buf[1]=='5' ? 1 : 3;
+        for (;;) {
+            assertt(fgets(buf.data(), buf.num()-1, _file));
+            if (buf[0]!='#') break;
+        }
+        int width, height, mask;
+        int numfields = sscanf(buf.data(), "%d %d %d", &width, &height, &mask);
+        if (numfields==2) {
+            assertt(fgets(buf.data(), buf.num()-1, _file));
+            numfields += sscanf(buf.data(), "%d", &mask);
+        }
+        assertt(numfields==3);
+        assertt(width>=0 && height>=0);
+        assertw(mask==255);
+        dims = V(height, width);
+        _zsize = zsize;
+        _buf.init(width*zsize);
+    }
+    void read_row(ArrayView<Pixel> row) override {
+        assertt(read_raw(_file, _buf));
+        const uchar* p = _buf.data();
+        for (Pixel& pix : row) {
+            for_int(z, _zsize) { pix[z] = *p++; }
+            finish_pixel(pix, _zsize);
+        }
+    }
+ private:
+    int _zsize;
+    Array<uchar> _buf;
+};
+
+#if defined(HH_IMAGE_HAVE_IO)
+
+class PngReader : public FileReader {
+ public:
+    explicit PngReader(unique_ptr<RFile> rfile) : FileReader(std::move(rfile)) {
+        _png_ptr = assertt(png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr));
+        png_set_throwing_error_fn(_png_ptr);
+        _info_ptr = assertt(png_create_info_struct(_png_ptr));
+        png_init_io(_png_ptr, _file);
+        png_read_info(_png_ptr, _info_ptr);
+    }
+    ~PngReader() { png_destroy_read_struct(&_png_ptr, &_info_ptr, nullptr); }
+    // ret: false if the image must instead be read as a whole (interlaced, or bit_depth 1 with its special case)
+    bool setup(Vec2<int>& dims, int& zsize) {
+        int width = png_get_image_width(_png_ptr, _info_ptr);
+        int height = png_get_image_height(_png_ptr, _info_ptr);
+        int ncomp = png_get_channels(_png_ptr, _info_ptr);
+        int bit_depth = png_get_bit_depth(_png_ptr, _info_ptr);
+        int color_type = png_get_color_type(_png_ptr, _info_ptr);
+        if (png_get_interlace_type(_png_ptr, _info_ptr)!=PNG_INTERLACE_NONE || bit_depth==1) return false;
+        assertt(width>0 && height>0);
+        assertt(ncomp>=1 && ncomp<=4);
+        if (color_type==PNG_COLOR_TYPE_PALETTE) {
+            png_set_palette_to_rgb(_png_ptr);
+            ncomp = 3;
+        }
+        if (bit_depth==16) png_set_strip_16(_png_ptr);
+        if (bit_depth<8) png_set_packing(_png_ptr);
+        if (color_type==PNG_COLOR_TYPE_GRAY || color_type==PNG_COLOR_TYPE_GRAY_ALPHA)
+            png_set_gray_to_rgb(_png_ptr);                 // always RGB
+        png_set_filler(_png_ptr, 255, PNG_FILLER_AFTER); // always RGBA since Pixel expects it
+        dims = V(height, width);
+        zsize = ncomp;
+        _zsize = ncomp;
+        return true;
+    }
+    void read_row(ArrayView<Pixel> row) override {
+        png_read_row(_png_ptr, row.data()->data(), nullptr);
+        if (_zsize<4) { for (Pixel& pix : row) pix[3] = 255; }
+    }
+ private:
+    png_structp _png_ptr;
+    png_infop _info_ptr;
+    int _zsize;
+};
+
+class JpgReader : public FileReader {
+ public:
+    JpgReader(unique_ptr<RFile> rfile, Vec2<int>& dims, int& zsize) : FileReader(std::move(rfile)) {
+        _cinfo.err = jpeg_throwing_error_mgr(_jerr);
+        jpeg_create_decompress(&_cinfo);
+        jpeg_stdio_src(&_cinfo, _file);
+        jpeg_read_header(&_cinfo, TRUE);
+        if (_cinfo.output_components==3) _cinfo.out_color_space = JCS_RGB;
+        jpeg_start_decompress(&_cinfo);
+        dims = V(int(_cinfo.output_height), int(_cinfo.output_width));
+        zsize = _zsize = _cinfo.output_components;
+        _buf.init(dims[1]*_zsize);
+    }
+    ~JpgReader() { jpeg_destroy_decompress(&_cinfo); } // (jpeg_finish_decompress() is unnecessary)
+    void read_row(ArrayView<Pixel> row) override {
+        JSAMPROW row_pointer[1] = {_buf.data()};
+        assertt(jpeg_read_scanlines(&_cinfo, row_pointer, 1)==1);
+        const uchar* p = _buf.data();
+        for (Pixel& pix : row) {
+            for_int(z, _zsize) { pix[z] = *p++; }
+            finish_pixel(pix, _zsize);
+        }
+    }
+ private:
+    jpeg_decompress_struct _cinfo;
+    jpeg_error_mgr _jerr;
+    int _zsize;
+    Array<uchar> _buf;
+};
+
+#endif  // defined(HH_IMAGE_HAVE_IO)
+
+} // namespace
+
+RImageRows::RImageRows(const string& filename) {
+    if (filename!="-") {
+        auto rfile = make_unique<RFile>(filename);
+        FILE* file = rfile->cfile();
+        int c = getc(file);
+        if (c<0) throw std::runtime_error("empty image file '" + filename + "'");
+        ungetc(c, file);
+        if (c=='R') {
+            _impl = make_unique<RawImageReader>(std::move(rfile), _dims, _zsize); _suffix = "rawimage";
+        } else if (c=='P') {
+            _impl = make_unique<PpmReader>(std::move(rfile), _dims, _zsize); _suffix = "ppm";
+#if defined(HH_IMAGE_HAVE_IO)
+        } else if (c==0xFF) {
+            _impl = make_unique<JpgReader>(std::move(rfile), _dims, _zsize); _suffix = "jpg";
+        } else if (c==0x89) {
+            auto up = make_unique<PngReader>(std::move(rfile));
+            if (up->setup(_dims, _zsize)) { _impl = std::move(up); _suffix = "png"; }
+#endif
+        }
+    }
+    if (!_impl) {
+        auto up = make_unique<WholeImageReader>(filename);
+        _dims = up->image().dims(); _zsize = up->image().zsize(); _suffix = up->image().suffix();
+        _impl = std::move(up);
+    }
+}
+
+RImageRows::~RImageRows() { }
+
+void RImageRows::read_rows(MatrixView<Pixel> rows) {
+    assertx(rows.xsize()==xsize() && _cur_row+rows.ysize()<=ysize());
+    for_int(y, rows.ysize()) { _impl->read_row(rows[y]); }
+    _cur_row += rows.ysize();
+}
+
+void RImageRows::skip_rows(int nrows) {
+    assertx(nrows>=0 && _cur_row+nrows<=ysize());
+    Array<Pixel> row(xsize());
+    for_int(y, nrows) { _impl->read_row(row); }
+    _cur_row += nrows;
+}
+
+// *** WImageRows
+
+class WImageRows::Implementation {
+ public:
+    virtual ~Implementation()                   { } // must not throw; it may be invoked during stack unwinding
+    virtual void write_row(CArrayView<Pixel> row) = 0;
+    virtual void finish()                       { } // complete the file after all rows are written
+};
+
+namespace {
+
+class WholeImageWriter : public WImageRows::Implementation {
+ public:
+    WholeImageWriter(string filename, const Vec2<int>& dims, int zsize, const string& suffix)
+        : _filename(std::move(filename)), _image(dims) {
+        _image.set_zsize(zsize);
+        if (suffix!="") _image.set_suffix(suffix);
+    }
+    void write_row(CArrayView<Pixel> row) override { _image[_y++].assign(row); }
+    void finish() override                      { _image.write_file(_filename); }
+ private:
+    string _filename;
+    Image _image;
+    int _y {0};
+};
+
+class FileWriter : public WImageRows::Implementation {
+ public:
+    explicit FileWriter(const string& filename) : _wfile(filename), _file(_wfile.cfile()) { }
+ protected:
+    WFile _wfile;
+    FILE* _file;
+};
+
+class RawImageWriter : public FileWriter {
+ public:
+    RawImageWriter(const string& filename, const Vec2<int>& dims, int zsize) : FileWriter(filename) {
+        write_rawimage_header(_file, dims, zsize);
+    }
+    void write_row(CArrayView<Pixel> row) override { assertt(write_raw(_file, row)); }
+};
+
+class PpmWriter : public FileWriter {
+ public:
+    PpmWriter(const string& filename, const Vec2<int>& dims, int zsize) : FileWriter(filename), _buf(dims[1]*3) {
+        fprintf(_file, "P6\n%d %d\n255\n", dims[1], dims[0]);
+        if (zsize==1) Warning("Writing to ppm loses grayscale format");
+        if (zsize==4) Warning("Writing to ppm loses alpha channel");
+    }
+    void write_row(CArrayView<Pixel> row) override {
+        uchar* p = _buf.data();
+        for (const Pixel& pix : row) { for_int(z, 3) { *p++ = pix[z]; } }
+        assertt(write_raw(_file, _buf));
+    }
+ private:
+    Array<uchar> _buf;
+};
+
+#if defined(HH_IMAGE_HAVE_IO)
+
+class PngWriter : public FileWriter {
+ public:
+    PngWriter(const string& filename, const Vec2<int>& dims, int zsize)
+        : FileWriter(filename), _zsize(zsize), _buf(dims[1]*zsize) {
+        _png_ptr = assertt(png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr));
+        png_set_throwing_error_fn(_png_ptr);
+        _info_ptr = assertt(png_create_info_struct(_png_ptr));
+        png_init_io(_png_ptr, _file);
+        png_set_write_header(_png_ptr, _info_ptr, dims, zsize);
+        png_write_info(_png_ptr, _info_ptr);
+    }
+    ~PngWriter()                                { png_destroy_write_struct(&_png_ptr, &_info_ptr); }
+    void write_row(CArrayView<Pixel> row) override {
+        uchar* p = _buf.data();
+        for (const Pixel& pix : row) { for_int(z, _zsize) { *p++ = pix[z]; } }
+        png_write_row(_png_ptr, _buf.data());
+    }
+    void finish() override                      { png_write_end(_png_ptr, nullptr); }
+ private:
+    png_structp _png_ptr;
+    png_infop _info_ptr;
+    int _zsize;
+    Array<uchar> _buf;
+};
+
+class JpgWriter : public FileWriter {
+ public:
+    JpgWriter(const string& filename, const Vec2<int>& dims, int zsize)
+        : FileWriter(filename), _zsize(zsize), _buf(dims[1]*zsize) {
+        _cinfo.err = jpeg_throwing_error_mgr(_jerr);
+        jpeg_create_compress(&_cinfo);
+        jpeg_stdio_dest(&_cinfo, _file);
+        jpeg_set_write_params(_cinfo, dims, zsize);
+        jpeg_start_compress(&_cinfo, TRUE);
+    }
+    ~JpgWriter()                                { jpeg_destroy_compress(&_cinfo); }
+    void write_row(CArrayView<Pixel> row) override {
+        uchar* p = _buf.data();
+        for (const Pixel& pix : row) { for_int(z, _zsize) { *p++ = pix[z]; } }
+        JSAMPROW row_pointer[1] = {_buf.data()};
+        assertt(jpeg_write_scanlines(&_cinfo, row_pointer, 1)==1);
+    }
+    void finish() override                      { jpeg_finish_compress(&_cinfo); }
+ private:
+    jpeg_compress_struct _cinfo;
+    jpeg_error_mgr _jerr;
+    int _zsize;
+    Array<uchar> _buf;
+};
+
+#endif  // defined(HH_IMAGE_HAVE_IO)
+
+} // namespace
+
+WImageRows::WImageRows(const string& filename, const Vec2<int>& dims, int zsize, const string& suffix)
+    : _dims(dims), _zsize(zsize) {
+    assertx(min(dims)>=0 && zsize>=1 && zsize<=4);
+    if (filename!="-") {
+        string fsuffix = lower_suffix(filename);
+        if (fsuffix=="rawimage") {
+            _impl = make_unique<RawImageWriter>(filename, dims, zsize);
+        } else if (fsuffix=="ppm") {
+            _impl = make_unique<PpmWriter>(filename, dims, zsize);
+#if defined(HH_IMAGE_HAVE_IO)
+        } else if (fsuffix=="png") {
+            _impl = make_unique<PngWriter>(filename, dims, zsize);
+        } else if (fsuffix=="jpg" || fsuffix=="jpeg") {
+            _impl = make_unique<JpgWriter>(filename, dims, zsize);
+#endif
+        }
+    }
+    if (!_impl) _impl = make_unique<WholeImageWriter>(filename, dims, zsize, suffix);
+}
+
+WImageRows::~WImageRows() {
+    if (!_finished) Warning("WImageRows: image file left incomplete");
+}
+
+void WImageRows::write_rows(CMatrixView<Pixel> rows) {
+    assertx(rows.xsize()==_dims[1] && _cur_row+rows.ysize()<=_dims[0]);
+    for_int(y, rows.ysize()) { _impl->write_row(rows[y]); }
+    _cur_row += rows.ysize();
+}
+
+void WImageRows::finish() {
+    assertx(_cur_row==_dims[0] && !_finished);
+    _impl->finish();
+    _finished = true;
+}
+
+} // namespace hh
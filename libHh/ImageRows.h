@@ -0,0 +1,83 @@
+// -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
+#ifndef MESH_PROCESSING_LIBHH_IMAGEROWS_H_
+#define MESH_PROCESSING_LIBHH_IMAGEROWS_H_
+
+#include "Image.h"
+
+#if 0
+{
+    RImageRows rimage("huge.png");
+    WImageRows wimage("huge.rawimage", rimage.dims(), rimage.zsize());
+    Matrix<Pixel> strip(64, rimage.xsize());
+    for (int y = 0; y<rimage.ysize(); y += strip.ysize()) {
+        MatrixView<Pixel> rows(strip.data(), V(min(strip.ysize(), rimage.ysize()-y), rimage.xsize()));
+        rimage.read_rows(rows);
+        process(rows);
+        wimage.write_rows(rows);
+    }
+    wimage.finish();
+}
+#endif
+
+namespace hh {
+
+// Sequential access to the rows of image files, for images too large to be held in memory.
+// Rows are streamed for the "rawimage" container (below) and for ppm, png (non-interlaced), and jpg files;
+//  any other image (including "-" for std::cin/std::cout) is buffered entirely in memory.
+// The "rawimage" container is an uncompressed format for intermediate results: a 64-byte text header
+//  "RawImage xsize ysize zsize" followed by the rows of Pixel values (4 bytes each, regardless of zsize).
+// Within a row, pixels use the Image conventions: for zsize==1, pix[1]==pix[2]==pix[0]; for zsize<4, pix[3]==255.
+
+// Read an image file sequentially in strips of rows.
+class RImageRows : noncopyable {
+ public:
+    explicit RImageRows(const string& filename); // may throw std::runtime_error
+    ~RImageRows();
+    const Vec2<int>& dims() const               { return _dims; }
+    int ysize() const                           { return _dims[0]; }
+    int xsize() const                           { return _dims[1]; }
+    int zsize() const                           { return _zsize; }
+    const string& suffix() const                { return _suffix; } // e.g. "png"
+    int cur_row() const                         { return _cur_row; } // index of next row to be read
+    void read_rows(MatrixView<Pixel> rows);     // next rows.ysize() rows; rows.xsize()==xsize()
+    void skip_rows(int nrows);
+    class Implementation;
+ private:
+    unique_ptr<Implementation> _impl;
+    Vec2<int> _dims;
+    int _zsize;
+    string _suffix;
+    int _cur_row {0};
+};
+
+// Write an image file sequentially in strips of rows; the file is complete once all rows are written and finish()
+//  is called.  (Destroying the object without calling finish(), e.g. when an exception is thrown, leaves the file
+//  incomplete.)
+class WImageRows : noncopyable {
+ public:
+    // The suffix of filename determines the format; for "-", the format is given by suffix (e.g. "png").
+    explicit WImageRows(const string& filename, const Vec2<int>& dims, int zsize, const string& suffix = "");
+    ~WImageRows();
+    const Vec2<int>& dims() const               { return _dims; }
+    int zsize() const                           { return _zsize; }
+    int cur_row() const                         { return _cur_row; } // index of next row to be written
+    void write_rows(CMatrixView<Pixel> rows);   // next rows.ysize() rows; rows.xsize()==dims()[1]
+    void finish();                              // may throw std::runtime_error
+    class Implementation;
+ private:
+    unique_ptr<Implementation> _impl;
+    Vec2<int> _dims;
+    int _zsize;
+    int _cur_row {0};
+    bool _finished {false};
+};
+
+namespace details {
+constexpr int k_rawimage_header_size = 64;
+void write_rawimage_header(FILE* file, const Vec2<int>& dims, int zsize);
+void read_rawimage_header(FILE* file, Vec2<int>& dims, int& zsize);
+} // namespace details
+
+} // namespace hh
+
+#endif // MESH_PROCESSING_LIBHH_IMAGEROWS_H_
@@ -11,26 +11,16 @@ void Image_IO_dummy_function_to_avoid_linkage_warnings() { }
 
 #else
 
-extern "C" {
-#if defined(__GNUC__) && __GNUC__*100+__GNUC_MINOR__>=408 && !defined(__clang__)
-#pragma GCC diagnostic ignored "-Wuseless-cast" // for (size_t) cast in two macros in jpeglib.h
-#endif
-#include "jpeglib.h"
-#include "png.h"
-}
-
+#include "Image_IO.h"           // jpeglib.h, png.h
 #include "FileIO.h"
 #include "NetworkOrder.h"
 #include "Array.h"
 #include "ConsoleProgress.h"
 #include "Parallel.h"
 #include "BinaryIO.h"           // read_raw(), write_raw()
+#include "ImageRows.h"          // read_rawimage_header(), write_rawimage_header()
 using namespace hh;
 
-#if defined(__GNUC__)
-#pragma GCC diagnostic ignored "-Wold-style-cast" // for (size_t) cast in two macros in jpeglib.h
-#endif
-
 HH_REFERENCE_LIB("libjpeg.lib");
 HH_REFERENCE_LIB("libpng.lib");
 HH_REFERENCE_LIB("libz.lib");
@@ -50,6 +40,8 @@ struct ImageIO {                 // friend of Image
     static void write_ppm(const Image& image, FILE* file);
     static void  read_png(Image& image, FILE* file);
     static void write_png(const Image& image, FILE* file);
+    static void  read_rawimage(Image& image, FILE* file);
+    static void write_rawimage(const Image& image, FILE* file);
 };
 
 struct ImageFiletype {
@@ -68,6 +60,7 @@ const Array<ImageFiletype> k_image_filetypes = {
     { "bmp", 'B' ,    ImageIO::read_bmp, ImageIO::write_bmp },
     { "ppm", 'P' ,    ImageIO::read_ppm, ImageIO::write_ppm },
     { "png", u'\x89', ImageIO::read_png, ImageIO::write_png },
+    { "rawimage", 'R', ImageIO::read_rawimage, ImageIO::write_rawimage }, // see ImageRows.h
 };
 
 static const ImageFiletype* recognize_filetype(const string& pfilename) {
@@ -314,6 +307,52 @@ void ImageIO::write_rgb(const Image& image, FILE* file) {
 
 static const bool g_jpg_debug = getenv_bool("JPG_DEBUG");
 
+jpeg_error_mgr* jpeg_throwing_error_mgr(jpeg_error_mgr& jerr) {
+    jpeg_std_error(&jerr);
+    // Intercepting warning messages ("Premature end of JPEG file") would require modifying jerr.output_message .
+    jerr.error_exit = [](j_common_ptr cinfo) {
+        char jpegLastErrorMsg[JMSG_LENGTH_MAX];
+        cinfo->err->format_message(cinfo, jpegLastErrorMsg);
+        throw std::runtime_error(string(cinfo->is_decompressor ? "libjpeg read error: " : "libjpeg write error: ") +
+                                 jpegLastErrorMsg);
+    };
+    return &jerr;
+}
+
+void jpeg_set_write_params(jpeg_compress_struct& cinfo, const Vec2<int>& dims, int zsize) {
+    // First we supply a description of the input image.
+    // Four fields of the cinfo struct must be filled in:
+    cinfo.image_width = dims[1];
+    cinfo.image_height = dims[0];
+    cinfo.input_components = zsize;
+    cinfo.in_color_space = (zsize==3 ? JCS_RGB :
+                            zsize==1 ? JCS_GRAYSCALE :
+                            zsize==4 ? JCS_UNKNOWN :
+                            (assertt(false), JCS_UNKNOWN));
+    // Now use the library routine to set default compression parameters.
+    // (You must set at least cinfo.in_color_space before calling this,
+    // since the defaults depend on the source color space.)
+    jpeg_set_defaults(&cinfo);  // quality defaults to 75
+    // JFIF only supports JCS_YCbCr and JCS_GRAYSCALE, so
+    //  for RGB do automatic conversion to YCbCr (this should be the default)
+    if (zsize==3) {
+        assertw(cinfo.jpeg_color_space==JCS_YCbCr);
+        jpeg_set_colorspace(&cinfo, JCS_YCbCr); // this should automatically set write_JFIF_header
+        assertw(cinfo.jpeg_color_space==JCS_YCbCr);
+        assertw(int(cinfo.write_JFIF_header));
+    }
+    if (zsize==4) {
+        Warning("JPEG with alpha is non-standard; color space will likely look wrong");
+    }
+    // Now you can set any non-default parameters you wish to.
+    // Here we just illustrate the use of quality (quantization table) scaling:
+    if (1) {
+        int quality = getenv_int("JPG_QUALITY", 95);  // 0--100 (default 75)
+        assertt(quality>0 && quality<=100);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+    }
+}
+
 // From jpeg-8d/install.txt:
 //  You might want to tweak the RGB_xxx macros in jmorecfg.h so that the library
 //  will accept or deliver color pixels in BGR sample order, not RGB; BGR order
@@ -330,13 +369,7 @@ void ImageIO::read_jpg(Image& image, FILE* file) {
     jpeg_decompress_struct cinfo;
     jpeg_error_mgr jerr;
 // Step 1: allocate and initialize JPEG decompression object
-    cinfo.err = jpeg_std_error(&jerr);
-    // Intercepting warning messages ("Premature end of JPEG file") would require modifying jerr.output_message .
-    jerr.error_exit = [](j_common_ptr cinfo) {
-        char jpegLastErrorMsg[JMSG_LENGTH_MAX];
-        cinfo->err->format_message(cinfo, jpegLastErrorMsg);
-        throw std::runtime_error(string("libjpeg read error: ") + jpegLastErrorMsg);
-    };
+    cinfo.err = jpeg_throwing_error_mgr(jerr);
     jpeg_create_decompress(&cinfo);
 // Step 2: specify data source (eg, a file)
     jpeg_stdio_src(&cinfo, file);
@@ -484,48 +517,13 @@ void ImageIO::write_jpg(const Image& image, FILE* file) {
     jpeg_compress_struct cinfo;
     jpeg_error_mgr jerr;
 // Step 1: allocate and initialize JPEG compression object
-    cinfo.err = jpeg_std_error(&jerr);
-    jerr.error_exit = [](j_common_ptr cinfo) {
-        char jpegLastErrorMsg[JMSG_LENGTH_MAX];
-        cinfo->err->format_message(cinfo, jpegLastErrorMsg);
-        throw std::runtime_error(string("libjpeg write error: ") + jpegLastErrorMsg);
-    };
+    cinfo.err = jpeg_throwing_error_mgr(jerr);
     jpeg_create_compress(&cinfo);
 // Step 2: specify data destination (eg, a file)
     // Note: steps 2 and 3 can be done in either order.
     jpeg_stdio_dest(&cinfo, file);
 // Step 3: set parameters for compression
-    // First we supply a description of the input image.
-    // Four fields of the cinfo struct must be filled in:
-    cinfo.image_width = image.xsize();
-    cinfo.image_height = image.ysize();
-    cinfo.input_components = image.zsize();
-    cinfo.in_color_space = (image.zsize()==3 ? JCS_RGB :
-                            image.zsize()==1 ? JCS_GRAYSCALE :
-                            image.zsize()==4 ? JCS_UNKNOWN :
-                            (assertt(false), JCS_UNKNOWN));
-    // Now use the library routine to set default compression parameters.
-    // (You must set at least cinfo.in_color_space before calling this,
-    // since the defaults depend on the source color space.)
-    jpeg_set_defaults(&cinfo);  // quality defaults to 75
-    // JFIF only supports JCS_YCbCr and JCS_GRAYSCALE, so
-    //  for RGB do automatic conversion to YCbCr (this should be the default)
-    if (image.zsize()==3) {
-        assertw(cinfo.jpeg_color_space==JCS_YCbCr);
-        jpeg_set_colorspace(&cinfo, JCS_YCbCr); // this should automatically set write_JFIF_header
-        assertw(cinfo.jpeg_color_space==JCS_YCbCr);
-        assertw(int(cinfo.write_JFIF_header));
-    }
-    if (image.zsize()==4) {
-        Warning("JPEG with alpha is non-standard; color space will likely look wrong");
-    }
-    // Now you can set any non-default parameters you wish to.
-    // Here we just illustrate the use of quality (quantization table) scaling:
-    if (1) {
-        int quality = getenv_int("JPG_QUALITY", 95);  // 0--100 (default 75)
-        assertt(quality>0 && quality<=100);
-        jpeg_set_quality(&cinfo, quality, TRUE);
-    }
+    jpeg_set_write_params(cinfo, image.dims(), image.zsize());
 // Step 4: Start compressor
     // TRUE ensures that we will write a complete interchange-JPEG file.
     // Pass TRUE unless you are very sure of what you are doing.
@@ -941,12 +939,51 @@ static void my_png_user_warning_fn(png_structp png_ptr, png_const_charp warning_
     showf("PNG lib warning : %s", warning_msg);
 }
 
+void png_set_throwing_error_fn(png_structp png_ptr) {
+    png_set_error_fn(png_ptr, png_get_error_ptr(png_ptr), my_png_user_error_fn, my_png_user_warning_fn);
+}
+
+void png_set_write_header(png_structp png_ptr, png_infop info_ptr, const Vec2<int>& dims, int zsize) {
+    // turn off compression or set another filter
+    // png_set_filter(png_ptr, 0, PNG_FILTER_NONE);
+    png_set_IHDR(png_ptr, info_ptr, dims[1], dims[0],
+                 8,
+                 (zsize==1 ? PNG_COLOR_TYPE_GRAY :
+                  zsize==3 ? PNG_COLOR_TYPE_RGB :
+                  zsize==4 ? PNG_COLOR_TYPE_RGB_ALPHA :
+                  (assertt(false), 0)),
+                 PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT,
+                 PNG_FILTER_TYPE_DEFAULT);
+    if (getenv_bool("PNG_SRGB")) { // 20080507
+        // It looks unchanged both on the screen and on the printer --> I give up on this.
+        // (The intent was to make the images look less dark on the printer.)
+        int srgb_intent = PNG_sRGB_INTENT_PERCEPTUAL;
+        png_set_sRGB_gAMA_and_cHRM(png_ptr, info_ptr, srgb_intent);
+    }
+    if (1) {
+        int level = getenv_int("PNG_COMPRESSION_LEVEL", 6);  //  0-9; 0=none
+        assertt(level>=0 && level<=9);
+        png_set_compression_level(png_ptr, level);
+    }
+    if (1) {                    // 20100103 to get consistent import size into Word
+        // png_set_pHYs(png_ptr, info_ptr, res_x, res_y, unit_type);
+        // res_x       - pixels/unit physical resolution in x direction
+        // res_y       - pixels/unit physical resolution in y direction
+        // unit_type   - PNG_RESOLUTION_UNKNOWN, PNG_RESOLUTION_METER
+        // 2834 pixels/meter == 71.9836 pixels/inch (dpi)
+        // 2835 pixels/meter == 72.0090 pixels/inch (dpi)
+        // 3779 pixels/meter == 95.9866 pixels/inch (dpi)
+        png_set_pHYs(png_ptr, info_ptr, 3779, 3779, PNG_RESOLUTION_METER);
+    }
+}
+
 void ImageIO::read_png(Image& image, FILE* file) {
     // Note that it would be possible to read from an istream instead of a FILE* using png_set_read_fn() as
     //   described in http://www.piko3d.net/tutorials/libpng-tutorial-loading-png-files-from-streams/
     // (PNG_LIBPNG_VER_STRING, png_voidp(user_error_ptr), user_error_fn, user_warning_fn)
     png_structp png_ptr = assertt(png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr));
-    png_set_error_fn(png_ptr, png_get_error_ptr(png_ptr), my_png_user_error_fn, my_png_user_warning_fn);
+    png_set_throwing_error_fn(png_ptr);
     png_infop info_ptr = assertt(png_create_info_struct(png_ptr));
     png_infop end_info = assertt(png_create_info_struct(png_ptr));
     png_init_io(png_ptr, file);
@@ -1055,41 +1092,10 @@ void ImageIO::read_png(Image& image, FILE* file) {
 void ImageIO::write_png(const Image& image, FILE* file) {
     // Note that it would be possible to write to an ostream instead of a FILE* using png_set_write_fn().
     png_structp png_ptr = assertt(png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr));
-    png_set_error_fn(png_ptr, png_get_error_ptr(png_ptr), my_png_user_error_fn, my_png_user_warning_fn);
+    png_set_throwing_error_fn(png_ptr);
     png_infop info_ptr = assertt(png_create_info_struct(png_ptr));
     png_init_io(png_ptr, file);
-    // turn off compression or set another filter
-    // png_set_filter(png_ptr, 0, PNG_FILTER_NONE);
-    png_set_IHDR(png_ptr, info_ptr, image.xsize(), image.ysize(),
-                 8,
-                 (image.zsize()==1 ? PNG_COLOR_TYPE_GRAY :
-                  image.zsize()==3 ? PNG_COLOR_TYPE_RGB :
-                  image.zsize()==4 ? PNG_COLOR_TYPE_RGB_ALPHA :
-                  (assertt(false), 0)),
-                 PNG_INTERLACE_NONE,
-                 PNG_COMPRESSION_TYPE_DEFAULT,
-                 PNG_FILTER_TYPE_DEFAULT);
-    if (getenv_bool("PNG_SRGB")) { // 20080507
-        // It looks unchanged both on the screen and on the printer --> I give up on this.
-        // (The intent was to make the images look less dark on the printer.)
-        int srgb_intent = PNG_sRGB_INTENT_PERCEPTUAL;
-        png_set_sRGB_gAMA_and_cHRM(png_ptr, info_ptr, srgb_intent);
-    }
-    if (1) {
-        int level = getenv_int("PNG_COMPRESSION_LEVEL", 6);  //  0-9; 0=none
-        assertt(level>=0 && level<=9);
-        png_set_compression_level(png_ptr, level);
-    }
-    if (1) {                    // 20100103 to get consistent import size into Word
-        // png_set_pHYs(png_ptr, info_ptr, res_x, res_y, unit_type);
-        // res_x       - pixels/unit physical resolution in x direction
-        // res_y       - pixels/unit physical resolution in y direction
-        // unit_type   - PNG_RESOLUTION_UNKNOWN, PNG_RESOLUTION_METER
-        // 2834 pixels/meter == 71.9836 pixels/inch (dpi)
-        // 2835 pixels/meter == 72.0090 pixels/inch (dpi)
-        // 3779 pixels/meter == 95.9866 pixels/inch (dpi)
-        png_set_pHYs(png_ptr, info_ptr, 3779, 3779, PNG_RESOLUTION_METER);
-    }
+    png_set_write_header(png_ptr, info_ptr, image.dims(), image.zsize());
     if (0) png_set_bgr(png_ptr); // provide data as BGR or BGRA
     if (0) {                     // high-level write
         Matrix<uchar> matrix(V(image.ysize(), image.xsize()*image.zsize()));
@@ -1128,6 +1134,21 @@ void ImageIO::write_png(const Image& image, FILE* file) {
     png_destroy_write_struct(&png_ptr, &info_ptr);
 }
 
+
+// *** rawimage (uncompressed container for streamed intermediate results; see ImageRows.h)
+
+void ImageIO::read_rawimage(Image& image, FILE* file) {
+    Vec2<int> dims; int zsize;
+    read_rawimage_header(file, dims, zsize);
+    image.init(dims); image.set_zsize(zsize);
+    for_int(y, image.ysize()) { assertt(read_raw(file, image[y])); }
+}
+
+void ImageIO::write_rawimage(const Image& image, FILE* file) {
+    write_rawimage_header(file, image.dims(), image.zsize());
+    for_int(y, image.ysize()) { assertt(write_raw(file, image[y])); }
+}
+
 } // namespace details
 
 using namespace details;
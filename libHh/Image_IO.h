@@ -0,0 +1,46 @@
+// -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
+#ifndef MESH_PROCESSING_LIBHH_IMAGE_IO_H_
+#define MESH_PROCESSING_LIBHH_IMAGE_IO_H_
+
+#include "Image.h"
+
+// Internal header: setup of the libjpeg and libpng codecs shared by Image_IO.cpp (whole images) and
+//  ImageRows.cpp (streamed rows).
+
+#if defined(HH_IMAGE_HAVE_IO)
+
+extern "C" {
+#if defined(__GNUC__) && __GNUC__*100+__GNUC_MINOR__>=408 && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wuseless-cast" // for (size_t) cast in two macros in jpeglib.h
+#endif
+#include "jpeglib.h"
+#include "png.h"
+}
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wold-style-cast" // for (size_t) cast in two macros in jpeglib.h
+#endif
+
+namespace hh {
+
+namespace details {
+
+// Initialize jerr so that libjpeg errors throw std::runtime_error; ret: &jerr, to be assigned to cinfo.err .
+jpeg_error_mgr* jpeg_throwing_error_mgr(jpeg_error_mgr& jerr);
+
+// Describe the image to be written and set its compression parameters (color space and quality).
+void jpeg_set_write_params(jpeg_compress_struct& cinfo, const Vec2<int>& dims, int zsize);
+
+// Make libpng errors throw std::runtime_error and report libpng warnings.
+void png_set_throwing_error_fn(png_structp png_ptr);
+
+// Set the header information (size, color type, compression level, resolution) for writing an image.
+void png_set_write_header(png_structp png_ptr, png_infop info_ptr, const Vec2<int>& dims, int zsize);
+
+} // namespace details
+
+} // namespace hh
+
+#endif  // defined(HH_IMAGE_HAVE_IO)
+
+#endif // MESH_PROCESSING_LIBHH_IMAGE_IO_H_
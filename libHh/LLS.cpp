@@ -6,6 +6,7 @@
 #include "Stat.h"
 #include "SingularValueDecomposition.h"
 #include "MatrixOp.h"           // mat_mul()
+#include "Parallel.h"
 
 #if !defined(HH_NO_LAPACK)
 #include "my_lapack.h"
@@ -84,16 +85,113 @@ void LLS::get_x(MatrixView<float> mat) {
 
 // *** SparseLLS
 
+namespace {
+
+// Compute vo = a*vi, where the vectors vi and vo each interleave nd columns (element (i, d) is at index i*nd+d).
+// For ND>0 (nd==ND), the per-row sums are held in registers.
+template<int ND> void csr_mult(const SparseLLS::Csr& a, CArrayView<double> vi, ArrayView<double> vo, int nd) {
+    const int nd2 = ND ? ND : nd;
+    const int* const start = a._start.data();
+    const int* const index = a._index.data();
+    const float* const value = a._value.data();
+    const double* const pvi = vi.data();
+    cond_parallel_for_int(uint64_t(a._index.num())*nd2*2, i, a.nrows()) {
+        double* const pvo = vo.data()+int64_t{i}*nd2;
+        if (ND) {
+            double sum[ND ? ND : 1] = {};
+            for_intL(k, start[i], start[i+1]) {
+                const double v = value[k];
+                const double* const pv = pvi+int64_t{index[k]}*ND;
+                for_int(d, ND) { sum[d] += v*pv[d]; }
+            }
+            for_int(d, ND) { pvo[d] = sum[d]; }
+        } else {
+            for_int(d, nd2) { pvo[d] = 0.; }
+            for_intL(k, start[i], start[i+1]) {
+                const double v = value[k];
+                const double* const pv = pvi+int64_t{index[k]}*nd2;
+                for_int(d, nd2) { pvo[d] += v*pv[d]; }
+            }
+        }
+    }
+}
+
+void csr_mult(const SparseLLS::Csr& a, CArrayView<double> vi, ArrayView<double> vo, int nd) {
+    ASSERTX(vo.num()==a.nrows()*nd);
+    switch (nd) {
+     case 1: csr_mult<1>(a, vi, vo, nd); break;
+     case 2: csr_mult<2>(a, vi, vo, nd); break;
+     case 3: csr_mult<3>(a, vi, vo, nd); break;
+     case 4: csr_mult<4>(a, vi, vo, nd); break;
+     default: csr_mult<0>(a, vi, vo, nd);
+    }
+}
+
+// Per-column sums of squares of interleaved vector v.
+void column_mag2(CArrayView<double> v, int nd, ArrayView<double> ar) {
+    const int n = v.num()/nd;
+    const double* const pv = v.data();
+    for_int(d, nd) {
+        double sum = 0.; for_int(i, n) { sum += square(pv[i*nd+d]); }
+        ar[d] = sum;
+    }
+}
+
+// Reverse Cuthill-McKee ordering of the symmetric graph with adjacency (adj_start, adj); ret: perm[old]=new.
+Array<int> rcm_ordering(CArrayView<int> adj_start, CArrayView<int> adj) {
+    const int n = adj_start.num()-1;
+    auto degree = [&](int i) { return adj_start[i+1]-adj_start[i]; };
+    Array<int> order; order.reserve(n);
+    Array<int> level(n, -1);
+    Array<int> nbrs;
+    // Breadth-first traversal from vroot; appends visited vertices to order; ret: last vertex in traversal.
+    auto bfs = [&](int vroot) -> int {
+        int i0 = order.num();
+        level[vroot] = 0; order.push(vroot);
+        for (int qi = i0; qi<order.num(); qi++) {
+            int v = order[qi];
+            nbrs.init(0);
+            for_intL(k, adj_start[v], adj_start[v+1]) {
+                int w = adj[k];
+                if (level[w]<0) { level[w] = level[v]+1; nbrs.push(w); }
+            }
+            sort(nbrs, [&](int w1, int w2) { return degree(w1)<degree(w2) || (degree(w1)==degree(w2) && w1<w2); });
+            order.push_array(nbrs);
+        }
+        return order.last();
+    };
+    for_int(i, n) {
+        if (level[i]>=0) continue;
+        // Find a pseudo-peripheral vertex in the component of i, starting from a vertex of small degree.
+        int i0 = order.num();
+        int vroot = i;
+        for_int(iter, 2) {
+            int vlast = bfs(vroot);
+            for_intL(qi, i0, order.num()) { level[order[qi]] = -1; }
+            order.resize(i0);
+            if (vlast==vroot) break;
+            vroot = vlast;
+        }
+        bfs(vroot);
+    }
+    assertx(order.num()==n);
+    Array<int> perm(n);
+    for_int(i, n) { perm[order[i]] = n-1-i; }
+    return perm;
+}
+
+} // namespace
+
 void SparseLLS::clear() {
-    _rows.clear();
-    _cols.clear();
+    _entries.clear();
+    _a = Csr(); _at = Csr();
     LLS::clear();
 }
 
 void SparseLLS::enter_a_rc(int r, int c, float val) {
-    _rows[r].push(Ival(c, val));
-    _cols[c].push(Ival(r, val));
-    _nentries++;
+    ASSERTX(r>=0 && r<_m && c>=0 && c<_n);
+    Entry entry; entry._r = r; entry._c = c; entry._v = val;
+    _entries.push(entry);
 }
 
 void SparseLLS::enter_a_r(int r, CArrayView<float> ar) {
@@ -106,99 +204,241 @@ void SparseLLS::enter_a_c(int c, CArrayView<float> ar) {
     for_int(r, _m) { if (ar[r]) enter_a_rc(r, c, ar[r]); }
 }
 
-Array<float> SparseLLS::mult_m_v(CArrayView<float> vi) const {
-    Array<float> vo(_m);
-    // vo[m] = _a[m][n]*vi[n];
-    for_int(i, _m) {
-        double sum = 0.;
-        for (const Ival& ival : _rows[i]) { sum += double(ival._v)*vi[ival._i]; }
-        vo[i] = float(sum);
+void SparseLLS::enter_a_rows(int r0, const Csr& rows) {
+    assertx(r0>=0 && r0+rows.nrows()<=_m && rows._index.num()==rows._value.num());
+    for_int(i, rows.nrows()) {
+        for_intL(k, rows._start[i], rows._start[i+1]) { enter_a_rc(r0+i, rows._index[k], rows._value[k]); }
     }
-    return vo;
 }
 
-Array<float> SparseLLS::mult_mt_v(CArrayView<float> vi) const {
-    Array<float> vo(_n);
-    // vo[n] = uT[n][m]*vi[m];
-    for_int(j, _n) {
-        double sum = 0.;
-        for (const Ival& ival : _cols[j]) { sum += double(ival._v)*vi[ival._i]; }
-        vo[j] = float(sum);
-    }
-    return vo;
+void SparseLLS::set_tolerance(float tolerance) {
+    _tolerance = tolerance;
 }
 
-bool SparseLLS::do_cg(Array<float>& x, CArrayView<float> h, double* prssb, double* prssa) const {
-    // x(_n), h(_m)
-    Array<float> rc, gc, gp, dc, tc;
-    rc = mult_m_v(x);
-    for_int(i, _m) rc[i] -= h[i];
-    double rssb = mag2(rc);
-    gc = mult_mt_v(rc);
-    for_int(i, _n) gc[i] = -gc[i];
-    const int fudge_for_small_systems = 20;
-    const int kmax = _n+fudge_for_small_systems;
-    float gm2;
-    int k;
-    for (k = 0; ; k++) {
-        gm2 = float(mag2(gc));
-        if (sdebug>=2) showf("k=%-4d gm2=%g\n", k, gm2);
-        if (gm2<_tolerance) break;
-        if (k==_max_iter) break;
-        if (k==kmax) break;
-        if (k>0) {
-            float bi = gm2/float(mag2(gp));
-            for_int(i, _n) dc[i] = gc[i]+bi*dc[i];
-        } else {
-            dc = gc;
+void SparseLLS::set_max_iter(int max_iter) {
+    _max_iter = max_iter;
+}
+
+void SparseLLS::set_verbose(int verb) {
+    _verb = verb;
+}
+
+void SparseLLS::set_direct(bool direct) {
+    _direct = direct;
+}
+
+void SparseLLS::build_csr() {
+    // Counting sort on rows (resp. columns); being stable, entries within a row retain their order of entry.
+    auto build = [&](Csr& csr, int nrows, bool transposed) {
+        csr._start.init(nrows+1, 0);
+        for (const Entry& e : _entries) { csr._start[(transposed ? e._c : e._r)+1]++; }
+        for_int(i, nrows) { csr._start[i+1] += csr._start[i]; }
+        csr._index.init(_entries.num()); csr._value.init(_entries.num());
+        Array<int> pos(csr._start.slice(0, nrows));
+        for (const Entry& e : _entries) {
+            int k = pos[transposed ? e._c : e._r]++;
+            csr._index[k] = transposed ? e._r : e._c;
+            csr._value[k] = e._v;
         }
-        tc = mult_m_v(dc);
-        float ai = gm2/float(mag2(tc));
-        for_int(i, _n) x[i] += ai*dc[i];
-        for_int(i, _m) rc[i] += ai*tc[i];
-        gp = gc;
-        gc = mult_mt_v(rc);
-        for_int(i, _n) gc[i] = -gc[i];
-    }
-    double rssa = mag2(rc);
-    // Print final gradient norm squared and final residual norm squared.
-    if (sdebug || _verb)
-        showf("CG: %d iter (gm2=%.10g, rssb=%.10g, rssa=%.10g)\n", k, gm2, rssb, rssa);
-    if (prssb) *prssb += rssb;
-    if (prssa) *prssa += rssa;
-    return gm2<_tolerance;
+    };
+    build(_a, _m, false);
+    build(_at, _n, true);
+    Array<Entry> tmp; swap(_entries, tmp); // free memory
 }
 
 bool SparseLLS::solve(double* prssb, double* prssa) {
     auto up_timer = _verb ? make_unique<Timer>("_____SparseLLS", Timer::EMode::abbrev) : nullptr;
     assertx(!_solved); _solved = true;
-    if (sdebug) showf("SparseLLS: solving %dx%d system, nonzerofrac=%f\n", _m, _n, float(_nentries)/_m/_n);
+    if (sdebug) showf("SparseLLS: solving %dx%d system, nonzerofrac=%f\n", _m, _n, float(_entries.num())/_m/_n);
+    build_csr();
     if (prssb) *prssb = 0.;
     if (prssa) *prssa = 0.;
-    Array<float> x(_n), rhv(_m);
-    bool success = true;
-    for_int(di, _nd) {
-        for_int(i, _m) { rhv[i] = _b[di][i]; }
-        for_int(j, _n) { x[j] = _x[di][j]; }
-        if (!do_cg(x, rhv, prssb, prssa)) {
-            success = false;
-            if (0 && _max_iter==INT_MAX) continue;
-        }
-        for_int(j, _n) { _x[di][j] = x[j]; }
+    _num_iter = 0;
+    if (_direct) {
+        bool too_large = false;
+        if (solve_direct(prssb, prssa, too_large)) return true;
+        Warning(too_large ? "SparseLLS: system too large for direct solver; using CG" :
+                "SparseLLS: direct solver failed (singular system); using CG");
     }
-    return success;
-}
-
-void SparseLLS::set_tolerance(float tolerance) {
-    _tolerance = tolerance;
+    return solve_cg(prssb, prssa);
 }
 
-void SparseLLS::set_max_iter(int max_iter) {
-    _max_iter = max_iter;
+// Conjugate gradient on the normal equations A^T*A*x=A^T*b (CGLS), preconditioned by the inverse of the diagonal
+//  of A^T*A.  All _nd columns advance together, sharing the sparse matrix-vector products; each column stops
+//  when its gradient norm squared |A^T*(b-A*x)|^2 falls below _tolerance (as in the unpreconditioned version).
+bool SparseLLS::solve_cg(double* prssb, double* prssa) {
+    const int nd = _nd;
+    Array<double> x(_n*nd), r(_m*nd), s(_n*nd), p(_n*nd), q(_m*nd);
+    for_int(j, _n) { for_int(d, nd) { x[j*nd+d] = _x[d][j]; } }
+    Array<double> dinv(_n);     // Jacobi preconditioner
+    for_int(j, _n) {
+        double sum = 0.; for_intL(k, _at._start[j], _at._start[j+1]) { sum += square(double(_at._value[k])); }
+        dinv[j] = sum ? 1./sum : 0.;
+    }
+    csr_mult(_a, x, r, nd);
+    for_int(i, _m) { for_int(d, nd) { r[i*nd+d] = _b[d][i]-r[i*nd+d]; } }
+    Array<double> rssb(nd); column_mag2(r, nd, rssb);
+    csr_mult(_at, r, s, nd);    // s = A^T*r is the negated gradient
+    Array<double> gamma(nd, 0.), tmp(nd);
+    for_int(j, _n) { for_int(d, nd) { p[j*nd+d] = dinv[j]*s[j*nd+d]; gamma[d] += s[j*nd+d]*p[j*nd+d]; } }
+    Array<bool> active(nd, true);
+    Array<float> gm2(nd);
+    Array<int> niter(nd, 0);
+    Array<double> alpha(nd);
+    column_mag2(s, nd, tmp);
+    const int fudge_for_small_systems = 20;
+    const int kmax = _n+fudge_for_small_systems;
+    for (int k = 0; ; k++) {
+        // Here tmp[d] == |s_d|^2.
+        int nactive = 0;
+        for_int(d, nd) {
+            if (!active[d]) continue;
+            gm2[d] = float(tmp[d]);
+            if (sdebug>=2) showf("k=%-4d d=%d gm2=%g\n", k, d, gm2[d]);
+            if (gm2[d]<_tolerance || k==_max_iter || k==kmax) { active[d] = false; niter[d] = k; continue; }
+            nactive++;
+        }
+        if (!nactive) break;
+        csr_mult(_a, p, q, nd);
+        column_mag2(q, nd, tmp);
+        for_int(d, nd) {
+            alpha[d] = 0.;      // converged columns are left unchanged
+            if (!active[d]) continue;
+            if (!tmp[d]) { active[d] = false; niter[d] = k; continue; } // breakdown
+            alpha[d] = gamma[d]/tmp[d];
+        }
+        // (The loops over d are outermost so that the per-column scalars and sums stay in registers.)
+        for_int(d, nd) {
+            if (!active[d]) continue;
+            const double a = alpha[d];
+            cond_parallel_for_int(uint64_t(_n)*4, j, _n) { x[j*nd+d] += a*p[j*nd+d]; }
+            cond_parallel_for_int(uint64_t(_m)*4, i, _m) { r[i*nd+d] -= a*q[i*nd+d]; }
+        }
+        csr_mult(_at, r, s, nd);
+        for_int(d, nd) {
+            double sum = 0., sumw = 0.;
+            for_int(j, _n) { double v2 = square(s[j*nd+d]); sum += v2; sumw += dinv[j]*v2; }
+            tmp[d] = sum;
+            if (!active[d]) continue;
+            const double b = sumw/gamma[d];
+            gamma[d] = sumw;
+            cond_parallel_for_int(uint64_t(_n)*4, j, _n) { p[j*nd+d] = dinv[j]*s[j*nd+d]+b*p[j*nd+d]; }
+        }
+    }
+    Array<double> rssa(nd); column_mag2(r, nd, rssa);
+    bool success = true;
+    for_int(d, nd) {
+        // Print final gradient norm squared and final residual norm squared.
+        if (sdebug || _verb)
+            showf("CG: %d iter (gm2=%.10g, rssb=%.10g, rssa=%.10g)\n", niter[d], gm2[d], rssb[d], rssa[d]);
+        if (prssb) *prssb += rssb[d];
+        if (prssa) *prssa += rssa[d];
+        if (!(gm2[d]<_tolerance)) success = false;
+        _num_iter = max(_num_iter, niter[d]);
+    }
+    for_int(j, _n) { for_int(d, nd) { _x[d][j] = float(x[j*nd+d]); } }
+    return success;
 }
 
-void SparseLLS::set_verbose(int verb) {
-    _verb = verb;
+// Envelope (skyline) Cholesky factorization L*L^T of A^T*A, after a reverse Cuthill-McKee reordering that reduces
+//  the envelope.  Row i of L is stored densely over columns [first[i], i].
+bool SparseLLS::solve_direct(double* prssb, double* prssa, bool& too_large) {
+    const int64_t k_max_envelope = int64_t{1}<<26; // maximum number of stored entries in the factorization
+    const int nd = _nd;
+    // Adjacency graph of A^T*A: columns c1 and c2 are adjacent if some row of A references both.
+    Array<int> adj_start(_n+1), adj;
+    {
+        Array<int> mark(_n, -1);
+        adj_start[0] = 0;
+        for_int(j, _n) {
+            for_intL(k, _at._start[j], _at._start[j+1]) {
+                int i = _at._index[k];
+                for_intL(k2, _a._start[i], _a._start[i+1]) {
+                    int j2 = _a._index[k2];
+                    if (j2!=j && mark[j2]!=j) { mark[j2] = j; adj.push(j2); }
+                }
+            }
+            adj_start[j+1] = adj.num();
+        }
+    }
+    Array<int> perm = rcm_ordering(adj_start, adj); // perm[j] is the new index of column j
+    Array<int> first(_n);
+    Array<int64_t> env_start(_n+1);
+    env_start[0] = 0;
+    {
+        Array<int> iperm(_n); for_int(j, _n) { iperm[perm[j]] = j; }
+        for_int(pi, _n) {
+            int j = iperm[pi], f = pi;
+            for_intL(k, adj_start[j], adj_start[j+1]) { f = min(f, perm[adj[k]]); }
+            first[pi] = f;
+            env_start[pi+1] = env_start[pi]+(pi-f+1);
+        }
+    }
+    if (sdebug) showf("SparseLLS: direct solver envelope size %lld\n", static_cast<long long>(env_start[_n]));
+    if (env_start[_n]>k_max_envelope) { too_large = true; return false; }
+    Array<double> env(narrow_cast<int>(env_start[_n]), 0.);
+    auto el = [&](int pi, int pj) -> double& { return env[narrow_cast<int>(env_start[pi]+(pj-first[pi]))]; };
+    // Accumulate the lower triangle of A^T*A.
+    for_int(i, _m) {
+        for_intL(k1, _a._start[i], _a._start[i+1]) {
+            int p1 = perm[_a._index[k1]]; double v1 = _a._value[k1];
+            for_intL(k2, _a._start[i], _a._start[i+1]) {
+                int p2 = perm[_a._index[k2]];
+                if (p2<=p1) el(p1, p2) += v1*_a._value[k2];
+            }
+        }
+    }
+    // Row-oriented Cholesky factorization within the envelope.
+    for_int(pi, _n) {
+        double* li = &el(pi, first[pi]);
+        for_intL(pj, first[pi], pi) {
+            const double* lj = &el(pj, first[pj]);
+            int k0 = max(first[pi], first[pj]);
+            double sum = li[pj-first[pi]];
+            for_intL(k, k0, pj) { sum -= li[k-first[pi]]*lj[k-first[pj]]; }
+            li[pj-first[pi]] = sum/lj[pj-first[pj]];
+        }
+        const double diag = li[pi-first[pi]];
+        double sum = diag;
+        for_intL(k, first[pi], pi) { sum -= square(li[k-first[pi]]); }
+        if (!(sum>diag*1e-12)) return false;
+        li[pi-first[pi]] = sqrt(sum);
+    }
+    // Solve L*L^T*x = A^T*b for each column.
+    Array<double> bcol(_m), y(_n), rssb(nd, 0.), rssa(nd, 0.);
+    for_int(d, nd) {
+        for_int(i, _m) {
+            double sum = 0.;
+            for_intL(k, _a._start[i], _a._start[i+1]) { sum += double(_a._value[k])*_x[d][_a._index[k]]; }
+            rssb[d] += square(sum-_b[d][i]);
+            bcol[i] = _b[d][i];
+        }
+        fill(y, 0.);
+        for_int(i, _m) {
+            for_intL(k, _a._start[i], _a._start[i+1]) { y[perm[_a._index[k]]] += double(_a._value[k])*bcol[i]; }
+        }
+        for_int(pi, _n) {       // forward substitution
+            const double* li = &el(pi, first[pi]);
+            double sum = y[pi];
+            for_intL(k, first[pi], pi) { sum -= li[k-first[pi]]*y[k]; }
+            y[pi] = sum/li[pi-first[pi]];
+        }
+        for (int pi = _n-1; pi>=0; --pi) { // backward substitution
+            const double* li = &el(pi, first[pi]);
+            y[pi] /= li[pi-first[pi]];
+            for_intL(k, first[pi], pi) { y[k] -= li[k-first[pi]]*y[pi]; }
+        }
+        for_int(j, _n) { _x[d][j] = float(y[perm[j]]); }
+        for_int(i, _m) {
+            double sum = 0.;
+            for_intL(k, _a._start[i], _a._start[i+1]) { sum += double(_a._value[k])*_x[d][_a._index[k]]; }
+            rssa[d] += square(sum-_b[d][i]);
+        }
+        if (sdebug || _verb) showf("Cholesky: (rssb=%.10g, rssa=%.10g)\n", rssb[d], rssa[d]);
+        if (prssb) *prssb += rssb[d];
+        if (prssa) *prssa += rssa[d];
+    }
+    return true;
 }
 
 // *** FullLLS
@@ -41,10 +41,15 @@ class LLS : noncopyable {
     LLS(int m, int n, int nd);
 };
 
-// Sparse conjugate-gradient approach.
+// Sparse approach: the matrix is stored in compressed-sparse-row (CSR) form, both as A and as A^T, and the normal
+//  equations are solved using Jacobi-preconditioned conjugate gradient, simultaneously for all _nd columns.
+// Optionally (set_direct() or env SPARSE_LLS_DIRECT), a direct envelope Cholesky factorization of A^T*A (after
+//  reverse Cuthill-McKee reordering) is used instead; it reverts to conjugate gradient if the factorization is
+//  too large or numerically fails.
 class SparseLLS : public LLS {
  public:
-    explicit SparseLLS(int m, int n, int nd) : LLS(m, n, nd), _rows(m), _cols(n), _tolerance(square(8e-7f)*m) { }
+    explicit SparseLLS(int m, int n, int nd)
+        : LLS(m, n, nd), _tolerance(square(8e-7f)*m), _direct(getenv_bool("SPARSE_LLS_DIRECT")) { }
     void clear() override;
     void enter_a_rc(int r, int c, float val) override;
     void enter_a_r(int r, CArrayView<float> ar) override;
@@ -53,22 +58,31 @@ class SparseLLS : public LLS {
     void set_tolerance(float tolerance); // default square(8e-7)*m  (because x is float) (was 1e-10f)
     void set_max_iter(int max_iter);     // default INT_MAX
     void set_verbose(int verb);          // default 0
+    void set_direct(bool direct);        // default getenv_bool("SPARSE_LLS_DIRECT")
+    int num_iter() const                 { return _num_iter; } // max CG iterations over columns in last solve()
+    struct Csr {                         // compressed sparse row matrix
+        Array<int> _start;               // [nrows+1]; entries of row i are in [_start[i], _start[i+1])
+        Array<int> _index;               // [nnz] column index of each entry
+        Array<float> _value;             // [nnz]
+        int nrows() const                { return _start.num()-1; }
+    };
+    void enter_a_rows(int r0, const Csr& rows); // rows [r0, r0+rows.nrows()), e.g. assembled in concurrent blocks
  private:
-    struct Ival {
-        Ival()                                  = default;
-        Ival(int i, float v)                    : _i(i), _v(v) { }
-        int _i;
+    struct Entry {
+        int _r, _c;
         float _v;
     };
-    Array<Array<Ival>> _rows;
-    Array<Array<Ival>> _cols;
+    Array<Entry> _entries;      // entered in arbitrary order; converted to CSR in solve()
+    Csr _a;                     // [_m][_n]
+    Csr _at;                    // [_n][_m]
     float _tolerance;
     int _max_iter {INT_MAX};
     int _verb {0};
-    int _nentries {0};
-    Array<float> mult_m_v(CArrayView<float> vi) const;
-    Array<float> mult_mt_v(CArrayView<float> vi) const;
-    bool do_cg(Array<float>& x, CArrayView<float> h, double* prssb, double* prssa) const;
+    bool _direct;
+    int _num_iter {0};
+    void build_csr();
+    bool solve_cg(double* prssb, double* prssa);
+    bool solve_direct(double* prssb, double* prssa, bool& too_large);
 };
 
 // Base class for full (non-sparse) approaches.
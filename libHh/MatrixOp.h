@@ -318,6 +318,7 @@ template<typename T> void transform(CMatrixView<T> m, const Frame& frame, const
 
 // Input: mvec[y][x].mag() is large except near seedpoints where it should indicate relative location of seedpoints.
 // Output: vectors indicating relative location of nearest seedpoint.  e.g. T = int or float
+// (For integer seedpoints, euclidean_distance_transform() in GridOp.h is exact, parallel, and supports 3D grids.)
 template<typename T> void euclidean_distance_map(MatrixView<Vec2<T>> mvec);
 
 // Compute the matrix which is the outer product of two vectors (ar1 is column vector, ar2 is row vector).
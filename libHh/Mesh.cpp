@@ -48,6 +48,21 @@ HH_ALLOCATE_POOL(Mesh::MHEdge);
 
 // *** Mesh
 
+namespace {
+
+// Allocate a mesh element, either from its shared pool or from the arena of the mesh.
+template<typename T, typename... Args> T* new_element(PoolArena* arena, Args&&... args) {
+    return arena ? new(*arena) T(std::forward<Args>(args)...) : new T(std::forward<Args>(args)...);
+}
+
+template<typename T> void delete_element(T* p, PoolArena* arena) {
+    if (!arena) { delete p; return; }
+    p->~T();
+    T::arena_free(p, *arena);
+}
+
+} // namespace
+
 const int Mesh::sdebug = getenv_int("MESH_DEBUG"); // 0, 1, or 3
 
 Mesh::Mesh() {
@@ -56,17 +71,41 @@ Mesh::Mesh() {
 
 void Mesh::clear() {
     if (sdebug>=1) ok();
-    while (num_faces()) {
-        destroy_face(_id2face.get_one_value());
+    // Destroy all elements directly, without maintaining the adjacency structure as destroy_face() does.
+    // With an arena, the element memory is not freed individually but released all at once.
+    PoolArena* arena = _arena.get();
+    for (Face f : _id2face.values()) {
+        HEdge he = herep(f), hef = he;
+        for (;;) {
+            HEdge hen = he->_next;
+            // Each edge is destroyed by exactly one of its (one or two) hedges.
+            Edge e = he->_edge;
+            if (!he->_sym || std::less<HEdge>()(he, he->_sym)) {
+                if (arena) e->~MEdge(); else delete e;
+            }
+            if (arena) he->~MHEdge(); else delete he;
+            he = hen;
+            if (he==hef) break;
+        }
+        if (arena) f->~MFace(); else delete f;
     }
-    while (num_vertices()) {
-        destroy_vertex(_id2vertex.get_one_value());
+    for (Vertex v : _id2vertex.values()) {
+        if (arena) v->~MVertex(); else delete v;
     }
+    _id2face.clear();
+    _id2vertex.clear();
+    if (arena) arena->release();
     _vertexnum = 1;
     _facenum = 1;
     _nedges = 0;
 }
 
+void Mesh::set_arena_allocation(bool b) {
+    assertx(!num_vertices() && !num_faces());
+    if (b && !_arena) _arena = make_unique<PoolArena>();
+    if (!b) _arena = nullptr;
+}
+
 void Mesh::copy(const Mesh& m) {
     clear();
     _flags = m._flags;
@@ -92,7 +131,7 @@ void Mesh::copy(const Mesh& m) {
 
 Vertex Mesh::create_vertex_private(int id) {
     assertx(id>=1);
-    Vertex v = new MVertex(id);
+    Vertex v = new_element<MVertex>(_arena.get(), id);
     // v->point undefined
     _id2vertex.enter(id, v);
     _vertexnum = max(_vertexnum, id+1);
@@ -103,7 +142,7 @@ void Mesh::destroy_vertex(Vertex v) {
     assertx(!herep(v));
     assertx(_id2vertex.remove(v->_id));
     if (0 && _vertexnum-1==v->_id) --_vertexnum;  // intermittent reuse of vertex id might be unsafe
-    delete v;
+    delete_element(v, _arena.get());
 }
 
 bool Mesh::legal_create_face(CArrayView<Vertex> va) const {
@@ -127,14 +166,14 @@ Face Mesh::create_face_private(int id, CArrayView<Vertex> va) {
     assertx(id>=1);
     assertx(va.num()>=3);
     if (sdebug>=1) assertx(legal_create_face(va));
-    Face f = new MFace(id);
+    Face f = new_element<MFace>(_arena.get(), id);
     // f->herep defined below
     _id2face.enter(id, f);
     HEdge hep = nullptr;
     int nv = va.num();
     for_int(i, nv) {
         Vertex v2 = va[i+1==nv ? 0 : i+1];
-        HEdge he = new MHEdge;
+        HEdge he = new_element<MHEdge>(_arena.get());
         he->_prev = hep;
         // he->_next is set below
         he->_vert = v2;
@@ -167,14 +206,14 @@ void Mesh::destroy_face(Face f) {
             HEdge hen = he->_next;
             Vertex v1n = he->_vert;
             remove_hedge(he, v1);
-            delete he; he = hen;
+            delete_element(he, _arena.get()); he = hen;
             v1 = v1n;
             if (he==hef) break;
         }
     }
     assertx(_id2face.remove(f->_id));
     if (0 && _facenum-1==f->_id) --_facenum;  // intermittent reuse of face id might be unsafe
-    delete f;
+    delete_element(f, _arena.get());
     if (sdebug>=3) ok();
 }
 
@@ -1029,7 +1068,7 @@ void Mesh::enter_hedge(HEdge he, Vertex v1) {
         if (he->_vert->_id>hes->_vert->_id) e->_herep = he;
     } else {
         _nedges++;
-        Edge e = new MEdge(he);
+        Edge e = new_element<MEdge>(_arena.get(), he);
         he->_edge = e;
     }
 }
@@ -1054,7 +1093,7 @@ void Mesh::remove_hedge(HEdge he, Vertex v1) {
     } else {
         --_nedges;
         // e->herep = nullptr;     // optional
-        delete e;
+        delete_element(e, _arena.get());
     }
     // he->_edge = nullptr;         // optional
     assertx(v1->_arhe.remove_unordered(he)); // slow, shucks
@@ -1066,7 +1105,7 @@ void Mesh::create_bogus_hedges(ArrayView<HEdge> ar_he) {
         if (is_boundary(he)) {
             HEdge heo = he;
             Vertex v1 = heo->_vert;
-            he = new MHEdge;
+            he = new_element<MHEdge>(_arena.get());
             HH_ASSUME(heo->_prev);
             he->_vert = heo->_prev->_vert;
             he->_prev = nullptr; // note: temporarily causes mesh.ok() to fail
@@ -1084,7 +1123,7 @@ void Mesh::remove_bogus_hedges(CArrayView<HEdge> ar_he) {
         if (!he) continue;
         Vertex v1 = reinterpret_cast<Vertex>(he->_face); // temporary overload
         remove_hedge(he, v1);
-        delete he;
+        delete_element(he, _arena.get());
     }
 }
 
@@ -55,10 +55,14 @@ class Mesh : noncopyable {
  public:
     Mesh();
     Mesh(Mesh&& m) noexcept                     { swap(*this, m); } // =default?
-    virtual ~Mesh()                             { clear(); }
+    virtual ~Mesh()                             { Mesh::clear(); }
     Mesh& operator=(Mesh&& m) noexcept          { clear(); swap(*this, m); return *this; } // =default?
-    void clear();
+    virtual void clear();
     void copy(const Mesh& m); // not a GMesh!  carries flags (but not sac fields), hence not named operator=().
+    // Allocate the mesh elements from a private PoolArena rather than the shared pools, so that clear() and the
+    //  destructor release all element memory in one shot.  The mesh must be empty.
+    void set_arena_allocation(bool b);
+    bool arena_allocation() const               { return !!_arena; }
 // Raw manipulation functions, may lead to non-nice Meshes.
     // always legal
     Vertex create_vertex()                      { return create_vertex_private(_vertexnum); }
@@ -219,6 +223,8 @@ class Mesh : noncopyable {
     int face_id(Face f) const                   { return f->_id; }
     Vertex id_retrieve_vertex(int i) const      { return _id2vertex.retrieve(i); }
     Face id_retrieve_face(int i) const          { return _id2face.retrieve(i); }
+    int vertex_id_bound() const                 { return _vertexnum; } // all vertex ids are less than this
+    int face_id_bound() const                   { return _facenum; }   // all face ids are less than this
     bool is_nice() const;
     void renumber();            // renumber vertices and faces
 // Misc
@@ -566,6 +572,7 @@ class Mesh : noncopyable {
     int _vertexnum {1};         // id to assign to next new vertex
     int _facenum {1};           // id to assign to next new face
     int _nedges {0};
+    unique_ptr<PoolArena> _arena; // if non-null, all elements are allocated from it
     //
     HEdge most_clw_hedge(Vertex v) const; // is_nice(v), may return nullptr
     HEdge most_ccw_hedge(Vertex v) const; // is_nice(v), may return nullptr
@@ -639,6 +646,7 @@ HH_INITIALIZE_POOL_NESTED(Mesh::MHEdge, MeshMHEdge);
 inline void swap(Mesh& l, Mesh& r) noexcept {
     using std::swap; swap(l._flags, r._flags); swap(l._id2vertex, r._id2vertex); swap(l._id2face, r._id2face);
     swap(l._vertexnum, r._vertexnum); swap(l._facenum, r._facenum); swap(l._nedges, r._nedges);
+    swap(l._arena, r._arena);
 }
 
 inline void Mesh::triangle_vertices(Face f, Vec3<Vertex>& va) const {
@@ -0,0 +1,57 @@
+// -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
+#ifndef MESH_PROCESSING_LIBHH_MESHATTRIB_H_
+#define MESH_PROCESSING_LIBHH_MESHATTRIB_H_
+
+#include "Mesh.h"
+#include "Array.h"
+
+#if 0
+{
+    VertexAttrib<Vector> vgrad(mesh, Vector(0.f, 0.f, 0.f));
+    for (Vertex v : mesh.vertices()) { vgrad[v] += compute_gradient(v); }
+    vgrad.fill(Vector(0.f, 0.f, 0.f));  // contiguous storage, indexed by vertex id
+}
+#endif
+
+namespace hh {
+
+namespace details {
+inline int mesh_attrib_id(const Mesh& mesh, Vertex v)   { return mesh.vertex_id(v); }
+inline int mesh_attrib_id(const Mesh& mesh, Face f)     { return mesh.face_id(f); }
+inline int mesh_attrib_id_bound(const Mesh& mesh, Vertex) { return mesh.vertex_id_bound(); }
+inline int mesh_attrib_id_bound(const Mesh& mesh, Face)   { return mesh.face_id_bound(); }
+} // namespace details
+
+// Attribute of type T for each vertex (E=Vertex) or face (E=Face) of one Mesh.
+// Unlike HH_SAC_ALLOCATE_FUNC(), which enlarges the elements of all meshes in the program, the values are stored in
+//  a side table allocated for just this mesh: a contiguous array indexed by element id.
+// Elements created after construction are accommodated by growing the array upon access.
+// The array size is the largest element id plus one, so ids should be compact (e.g. see Mesh::renumber()).
+template<typename E, typename T> class MeshAttrib : noncopyable {
+ public:
+    explicit MeshAttrib(const Mesh& mesh, const T& vinit = T{}) : _mesh(mesh), _vinit(vinit) { resize(); }
+    T& operator[](E e)                          { int i = id(e); if (i>=_ar.num()) grow(i); return _ar[i]; }
+    const T& operator[](E e) const              { int i = id(e); return i<_ar.num() ? _ar[i] : _vinit; }
+    void resize()                               { grow(details::mesh_attrib_id_bound(_mesh, E{})-1); }
+    void fill(const T& v)                       { for (T& e : _ar) { e = v; } }
+    ArrayView<T> array()                        { return _ar; } // indexed by element id; entry 0 is unused
+    CArrayView<T> array() const                 { return _ar; }
+ private:
+    const Mesh& _mesh;
+    T _vinit;
+    Array<T> _ar;
+    int id(E e) const                           { return details::mesh_attrib_id(_mesh, e); }
+    void grow(int i) {
+        int n = _ar.num();
+        if (i<n) return;
+        _ar.resize(max(i+1, details::mesh_attrib_id_bound(_mesh, E{})));
+        for_intL(j, n, _ar.num()) { _ar[j] = _vinit; }
+    }
+};
+
+template<typename T> using VertexAttrib = MeshAttrib<Vertex, T>;
+template<typename T> using FaceAttrib = MeshAttrib<Face, T>;
+
+} // namespace hh
+
+#endif // MESH_PROCESSING_LIBHH_MESHATTRIB_H_
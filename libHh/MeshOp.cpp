@@ -705,7 +705,7 @@ float project_point_neighb(const GMesh& mesh, const Point& p, Face& pf, Bary& re
     float nearestedge = min(min(minbary[0], minbary[1]), minbary[2]);
     ASSERTX(nearestedge>=0 && nearestedge<.34f); // optional
     bool nearedge = nearestedge<bnearedge;
-    bool projquick = pfsmooth && !nearedge; HH_SSTAT(Sprojquick, projquick);
+    bool projquick = pfsmooth && !nearedge; HH_SSTAT_CONCURRENT(Sprojquick, projquick); // may be called concurrently
     if (projquick) {
         ret_bary = minbary;
         return mind2;
@@ -748,8 +748,8 @@ float project_point_neighb(const GMesh& mesh, const Point& p, Face& pf, Bary& re
         if (setfvis.contains(pf)) break;
         for (Face f : setf) { setfvis.enter(f); }
     }
-    HH_SSTAT(Sprojnei, ni); HH_SSTAT(Sprojf, nvis);
-    if (ni>0) { HH_SSTAT(Sprojunexp, !nearedge); }
+    HH_SSTAT_CONCURRENT(Sprojnei, ni); HH_SSTAT_CONCURRENT(Sprojf, nvis);
+    if (ni>0) { HH_SSTAT_CONCURRENT(Sprojunexp, !nearedge); }
     ret_bary = minbary;
     return mind2;
 }
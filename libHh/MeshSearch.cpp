@@ -118,7 +118,7 @@ Face MeshSearch::search(const Point& p, Face hintf, Bary& bary, Point& clp, floa
         }
         // HH_SSTAT(Sms_locn, count);
     }
-    HH_SSTAT(Sms_loc, !!f);
+    HH_SSTAT_CONCURRENT(Sms_loc, !!f); // searches may proceed concurrently
     if (!f) {
         Point pbb = p*_ftospatial;
         SpatialSearch<PolygonFace*> ss(_ppsp.get(), pbb);
@@ -22,6 +22,8 @@
     setup_rhs(grid_orig, multigrid.rhs());
     if (optional) for (const auto& u : range(dims)) multigrid.initial_estimate()[u] = some_value;
     // Grid<2,float> grid_orig(dims); if (optional) multigrid.set_original(grid_orig); // for convergence analysis
+    if (optional) multigrid.set_relaxation(MultigridRelaxation::red_black);
+    if (optional) { multigrid.set_num_vcycles(20); multigrid.set_residual_tolerance(1e-5); } // at most 20 cycles
     multigrid.solve();
     CGridView<2,float> grid_result = multigrid.result();
     if (1) HH_RSTAT(Sresult, grid_result);
@@ -113,6 +115,15 @@ template<int D> struct MultigridMetricIsotropic { // would modify metric value v
     float operator()(float v, int d) const { ASSERTX(d>=0 && d<D); return v; }
 };
 
+// Recursion pattern of each multigrid cycle: a V-cycle visits the coarser level once, a W-cycle twice, and an
+//  F-cycle performs an F-cycle followed by a V-cycle on the coarser level (between V and W in cost).
+enum class MultigridCycle { V, W, F };
+
+// Smoother used within the cycles.  Lexicographic Gauss-Seidel is parallelized over blocks of dim0; red-black
+//  Gauss-Seidel updates each color in parallel over all rows of the grid (all dimensions but the last), and its
+//  result is independent of the number of threads.
+enum class MultigridRelaxation { gauss_seidel, red_black };
+
 // Solve a Poisson problem over D-dimensional domain with elements of type T using a multigrid solver,
 //  optionally with Periodic boundary conditions and with an anisotropic Metric on the Laplacian.
 template<int D, typename T,
@@ -134,7 +145,16 @@ class Multigrid : noncopyable {
     GridView<D,T>& initial_estimate()           { return _grid_result; } // should be set!
     void set_verbose(bool v)                    { _verbose = v; }
     void set_screening_weight(float v)          { _screening_weight = v; }
+    void set_cycle(MultigridCycle v)            { _cycle = v; }
+    void set_relaxation(MultigridRelaxation v)  { _relaxation = v; }
+    // Stop early once rms(residual)<=v*rms(rhs); the number of cycles (set_num_vcycles()) is then a maximum.
+    void set_residual_tolerance(double v)       { _residual_tolerance = v; }
+    // With T==double, perform the cycles in float precision on the residual equation and accumulate the
+    //  corrections in double precision (iterative refinement); faster relaxation, same final accuracy.
+    void set_mixed_precision(bool v) { _mixed_precision = v; assertx(!v || std::is_same<T,double>::value); }
     void solve()                                { run_multigrid(_grid_rhs, _grid_result); }
+    int num_cycles() const                      { return _num_cycles; } // cycles performed in last solve()
+    double rms_residual()                       { return mag_e(rms(compute_residual(_grid_rhs, _grid_result))); }
     void just_relax(int niter)                  { relax(_grid_rhs, _grid_result, niter, false); }
     CGridView<D,T> result()                     { return _grid_result; } // retrieve result
  private:
@@ -147,6 +167,11 @@ class Multigrid : noncopyable {
     int _num_vcycles {0};
     bool _verbose {false};      // include analysis of residual and error
     float _screening_weight {0.f};
+    MultigridCycle _cycle {MultigridCycle::V};
+    MultigridRelaxation _relaxation {MultigridRelaxation::gauss_seidel};
+    double _residual_tolerance {0.};
+    bool _mixed_precision {false};
+    int _num_cycles {0};
     Periodic _periodic;
     Metric _metric;
     //
@@ -302,7 +327,86 @@ class Multigrid : noncopyable {
     // Perform niter iterations of Gauss-Seidel relaxation, possibly with extra iterations near
     //   the ends of the grid for odd grid dimensions.
     void relax(CGridView<D,T> grid_rhs, GridView<D,T> grid_result, int niter, bool extra) {
-        relax_aux(Specialize<Z>{}, grid_rhs, grid_result, niter, extra);
+        if (_relaxation==MultigridRelaxation::red_black && red_black_applies(grid_rhs.dims())) {
+            relax_red_black(grid_rhs, grid_result, niter, extra);
+        } else {
+            relax_aux(Specialize<Z>{}, grid_rhs, grid_result, niter, extra);
+        }
+    }
+    // The two colors are independent unless a periodic dimension (other than the last, which is traversed
+    //  sequentially within each row) has odd size.
+    bool red_black_applies(const Vec<int,D>& dims) const {
+        for_int(c, D-1) { if (_periodic(c) && dims[c]%2==1) return false; }
+        return true;
+    }
+    // Perform niter iterations of red-black Gauss-Seidel relaxation, possibly with extra iterations near
+    //   the ends of the grid for odd grid dimensions.
+    void relax_red_black(CGridView<D,T> grid_rhs, GridView<D,T> grid_result, int niter, bool extra) {
+        HH_MULTIGRID_TIMER(_relax_rb);
+        assertx(same_size(grid_rhs, grid_result));
+        const Vec<int,D> dims = grid_rhs.dims();
+        if (product(dims)==1) { Warning("relax of singleteon"); return; }
+        const float wL = get_wL(dims), rwLnum = 1.f/((2.f*D*wL)+_screening_weight);
+        auto func_update = [&](const Vec<int,D>& u) { // Gauss-Seidel update of value at u
+            T vnei; my_zero(vnei);
+            float vnum = _screening_weight; // or 0.f
+            for_int(c, D) {
+                float w = _metric(wL, c);
+                bool b = _periodic(c);
+                if (u[c]>0)         { vnei += w*grid_result[u.with(c, u[c]-1)];    vnum += w; }
+                else if (b)         { vnei += w*grid_result[u.with(c, dims[c]-1)]; vnum += w; }
+                if (u[c]<dims[c]-1) { vnei += w*grid_result[u.with(c, u[c]+1)];    vnum += w; }
+                else if (b)         { vnei += w*grid_result[u.with(c, 0)];         vnum += w; }
+            }
+            grid_result[u] = (vnei-grid_rhs[u])/vnum;
+        };
+        const Vec<int,D> ar_interior_offsets = generate_interior_offsets(dims);
+        auto func_update_interior = [&](size_t i) {
+            T vnei; my_zero(vnei);
+            for_int(c, D) {
+                int o = ar_interior_offsets[c]; vnei += grid_result.raster(i+o)+grid_result.raster(i-o);
+            }
+            grid_result.raster(i) = (vnei*wL-grid_rhs.raster(i))*rwLnum;
+        };
+        const int nx = dims[D-1];
+        const size_t nrows = grid_rhs.size()/nx;
+        // Update the elements of the given color (parity of the sum of coordinates) within a row.
+        auto func_relax_row = [&](size_t row, int color) {
+            Vec<int,D> u; u[D-1] = 0;
+            int usum = 0; {
+                size_t r = row;
+                for (int c = D-2; c>=0; --c) { u[c] = int(r%dims[c]); r /= dims[c]; usum += u[c]; }
+            }
+            bool interior = b_default_metric && nx>2;
+            for_int(c, D-1) { if (u[c]==0 || u[c]==dims[c]-1) interior = false; }
+            int x = (usum+color)%2;
+            if (!interior) {
+                for (; x<nx; x += 2) func_update(u.with(D-1, x));
+                return;
+            }
+            if (x==0) { func_update(u); x += 2; }
+            for (; x<nx-1; x += 2) func_update_interior(row*nx+x);
+            if (x==nx-1) func_update(u.with(D-1, x));
+        };
+        for_int(iter, niter) {
+            for_int(color, 2) {
+                if (grid_rhs.size()*10<k_omp_thresh) { // avoid the overhead of parallel_for_each() on coarse grids
+                    for_size_t(row, nrows) { func_relax_row(row, color); }
+                } else {
+                    parallel_for_each(range(nrows), [&](const size_t row) { func_relax_row(row, color); }, nx*D*2);
+                }
+            }
+        }
+        if (extra) {            // perform additional relaxations near ends of dimensions with odd sizes
+            const int extra_niter = D==3 ? 5 : 30, extra_size = D==3 ? 3 : 6;
+            for_int(c, D) {
+                if (!(dims[c]>1 && dims[c]%2==1)) continue;
+                for_int(extra_iter, extra_niter) {
+                    const Vec<int,D> uL = ntimes<D>(0).with(c, max(dims[c]-extra_size, 0));
+                    for (const auto& u : range(uL, dims)) func_update(u);
+                }
+            }
+        }
     }
     template<int DD> void relax_aux(Specialize<DD>, CGridView<D,T> grid_rhs, GridView<D,T> grid_result,
                                     int niter, bool extra) {
@@ -610,11 +714,11 @@ class Multigrid : noncopyable {
     bool coarse_enough(CGridView<D,T> grid_rhs) {
         return max(grid_rhs.dims())<=k_direct_solver_resolution;
     }
-    // Recursively perform a multigrid V-cyce.
-    void rec_vcycle(CGridView<D,T> grid_rhs, GridView<D,T> grid_result) {
+    // Recursively perform a multigrid cycle.
+    void rec_cycle(CGridView<D,T> grid_rhs, GridView<D,T> grid_result, MultigridCycle cycle) {
         assertx(same_size(grid_rhs, grid_result));
         static Set<size_t> set;
-        if (0 && set.add(grid_rhs.size())) showf("rec_vcycle dims=%s\n", make_string(grid_rhs.dims()).c_str());
+        if (0 && set.add(grid_rhs.size())) showf("rec_cycle dims=%s\n", make_string(grid_rhs.dims()).c_str());
         const bool vverbose = 0;
         if (coarse_enough(grid_rhs)) {
             run_direct_solver(grid_rhs, grid_result);
@@ -629,8 +733,20 @@ class Multigrid : noncopyable {
             if (0) SHOW(rms(grid_newrhs)/rms(grid_residual));
         }
         Grid<D,T> grid_newresult(grid_newrhs.dims(), T{0});
-        const int num_recursions = 1; // 1==V-cycle, 2==W-cycle
-        for_int(k, num_recursions) { rec_vcycle(grid_newrhs, grid_newresult); }
+        switch (cycle) {
+         case MultigridCycle::V:
+            rec_cycle(grid_newrhs, grid_newresult, MultigridCycle::V);
+            break;
+         case MultigridCycle::W:
+            rec_cycle(grid_newrhs, grid_newresult, MultigridCycle::W);
+            rec_cycle(grid_newrhs, grid_newresult, MultigridCycle::W);
+            break;
+         case MultigridCycle::F:
+            rec_cycle(grid_newrhs, grid_newresult, MultigridCycle::F);
+            rec_cycle(grid_newrhs, grid_newresult, MultigridCycle::V);
+            break;
+         default: assertnever("");
+        }
         Grid<D,T> grid_correction = dual_upsample(grid_newresult, &grid_result.dims());
         { HH_MULTIGRID_TIMER(_add_correction); grid_result += grid_correction; }
         double rms2 = vverbose ? mag_e(rms(compute_residual(grid_rhs, grid_result))) : 0.;
@@ -639,7 +755,26 @@ class Multigrid : noncopyable {
         if (vverbose) showf(" resy=%-7d  rms0=%-12.7e rms1=%-12.7e   rms2=%-12.7e rms3=%-12.7e\n",
                             grid_rhs.dim(0), rms0, rms1, rms2, rms3);
     }
-    // Perform a sequence of multigrid V-cycles.
+    // Perform one cycle on the residual equation in float precision and add the correction to grid_result.
+    void refine_cycle(CGridView<D,T> grid_rhs, GridView<D,T> grid_result) {
+        using Lower = std::conditional_t<std::is_same<T,double>::value, float, T>;
+        Grid<D,T> grid_residual = compute_residual(grid_rhs, grid_result);
+        const Vec<int,D> dims = grid_rhs.dims();
+        Multigrid<D, Lower, Periodic, Metric> multigrid(dims);
+        GridView<D,Lower> grid_lower_rhs = multigrid.rhs();
+        parallel_for_coords(dims, [&](const Vec<int,D>& u) {
+            grid_lower_rhs[u] = static_cast<Lower>(grid_residual[u]);
+        });
+        fill(multigrid.initial_estimate(), Lower{0});
+        multigrid.set_screening_weight(_screening_weight);
+        multigrid.set_cycle(_cycle);
+        multigrid.set_relaxation(_relaxation);
+        multigrid.set_num_vcycles(1);
+        multigrid.solve();
+        CGridView<D,Lower> grid_correction = multigrid.result();
+        parallel_for_coords(dims, [&](const Vec<int,D>& u) { grid_result[u] += static_cast<T>(grid_correction[u]); });
+    }
+    // Perform a sequence of multigrid cycles.
     void run_multigrid(CGridView<D,T> grid_rhs, GridView<D,T> grid_result) {
         HH_MULTIGRID_TIMER(multigrid);
         assertx(same_size(grid_rhs, grid_result));
@@ -648,8 +783,15 @@ class Multigrid : noncopyable {
         bool is_power_of_2 = true; for_int(c, D) { if (!is_pow2(_grid_rhs.dim(c))) is_power_of_2 = false; }
         if (0) ASSERTX(mag_e(rms(grid_result))==0.); // good starting state for numerical accuracy?
         if (!_num_vcycles) _num_vcycles = k_default_num_vcycles;
+        const double rms_rhs = _residual_tolerance ? mag_e(rms(grid_rhs)) : 0.;
+        _num_cycles = 0;
         for_int(vcycle, _num_vcycles) {
-            { HH_MULTIGRID_TIMER(vcycle); rec_vcycle(grid_rhs, grid_result); }
+            {
+                HH_MULTIGRID_TIMER(vcycle);
+                if (_mixed_precision) refine_cycle(grid_rhs, grid_result);
+                else rec_cycle(grid_rhs, grid_result, _cycle);
+            }
+            _num_cycles++;
             if (0) grid_result -= static_cast<T>(mean(grid_result)); // does not help reducing rms(err)
             if (!b_fastest && (1 || !is_power_of_2) && _have_mean_desired) {
                 // for odd grid sizes, mean value may drift significantly due to inaccurate Galerkin condition
@@ -658,6 +800,8 @@ class Multigrid : noncopyable {
                 // staying near the original mean value of zero is generally OK
             }
             if (_verbose) analyze_error(sform("vcycle%-2d", vcycle+1)); // relatively slow
+            if (_residual_tolerance &&
+                mag_e(rms(compute_residual(grid_rhs, grid_result)))<=_residual_tolerance*rms_rhs) break;
         }
         if (_have_mean_desired) grid_result += static_cast<T>(_mean_desired-mean(grid_result));
         if (_verbose) analyze_error("Finalerr");
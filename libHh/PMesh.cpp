@@ -1,7 +1,7 @@
 // -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
 #include "PMesh.h"
 
-#include <cstring>              // strncmp() etc.
+#include <cstring>              // strncmp(), std::memcpy(), etc.
 
 #include "PArray.h"             // ar_pwedge
 #include "GMesh.h"              // in extract_gmesh()
@@ -9,6 +9,7 @@
 #include "HashTuple.h"          // std::hash<std::pair<...>>
 #include "BinaryIO.h"           // read_binary_std() and write_binary_std()
 #include "RangeOp.h"            // fill()
+#include "FileIO.h"             // mapped_stream_remainder(), LineTokenizer
 
 namespace hh {
 
@@ -339,13 +340,49 @@ void WMesh::ok() const {
 
 // *** Vsplit
 
+namespace {
+
+// Reads binary records (in network order) from a std::istream.
+struct StreamRecordReader {
+    explicit StreamRecordReader(std::istream& is) : _is(is) { }
+    template<typename T> bool read_std(ArrayView<T> ar) { return !!read_binary_std(_is, ar); }
+    std::istream& _is;
+};
+
+// Reads binary records (in network order) directly from the contents of a memory-mapped RFile stream.
+struct MappedRecordReader {
+    explicit MappedRecordReader(ArrayView<char> buf) : _tokenizer(buf) { }
+    template<typename T> bool read_std(ArrayView<T> ar) {
+        const char* s = _tokenizer.next_raw(ar.num()*int(sizeof(T)));
+        if (!s) return false;
+        std::memcpy(ar.data(), s, ar.num()*sizeof(T));
+        for_int(i, ar.num()) { from_std(&ar[i]); }
+        return true;
+    }
+    LineTokenizer _tokenizer;
+};
+
+} // namespace
+
 void Vsplit::read(std::istream& is, const PMeshInfo& pminfo) {
-    assertx(read_binary_std(is, ArView(flclw)));
-    assertx(read_binary_std(is, ArView(vlr_offset1)));
-    assertx(read_binary_std(is, ArView(code)));
+    ArrayView<char> buf = mapped_stream_remainder(is);
+    if (buf.num()) {            // decode in place within the memory-mapped file
+        MappedRecordReader reader(buf);
+        read_aux(reader, pminfo);
+        mapped_stream_consume(is, reader._tokenizer.num_consumed());
+    } else {
+        StreamRecordReader reader(is);
+        read_aux(reader, pminfo);
+    }
+}
+
+template<typename Reader> void Vsplit::read_aux(Reader& reader, const PMeshInfo& pminfo) {
+    assertx(reader.read_std(ArView(flclw)));
+    assertx(reader.read_std(ArView(vlr_offset1)));
+    assertx(reader.read_std(ArView(code)));
     if (code & (FLN_MASK | FRN_MASK)) {
-        assertx(read_binary_std(is, ArView(fl_matid)));
-        assertx(read_binary_std(is, ArView(fr_matid)));
+        assertx(reader.read_std(ArView(fl_matid)));
+        assertx(reader.read_std(ArView(fr_matid)));
     } else {
         fl_matid = 0; fr_matid = 0;
     }
@@ -356,7 +393,7 @@ void Vsplit::read(std::istream& is, const PMeshInfo& pminfo) {
     Vec<float, 6+max_nwa*(3+3+2)+2> buf;
     const int bufn = 6+nwa*wadlength+2*pminfo._has_resid;
     assertx(bufn<=buf.num());
-    assertx(read_binary_std(is, buf.head(bufn)));
+    assertx(reader.read_std(buf.head(bufn)));
     Vector& vlarge = vad_large.dpoint; for_int(c, 3) { vlarge[c] = buf[0+c]; }
     Vector& vsmall = vad_small.dpoint; for_int(c, 3) { vsmall[c] = buf[3+c]; }
     ar_wad.init(nwa);
@@ -92,7 +92,7 @@ struct WMesh {
 // Vertex split record.
 // Records the information necessary to split a vertex of the mesh, to add to the mesh 1 new vertex and 1/2 new faces.
 struct Vsplit {
-    void read(std::istream& is, const PMeshInfo& pminfo);
+    void read(std::istream& is, const PMeshInfo& pminfo); // decodes in place if is is memory-mapped
     void write(std::ostream& os, const PMeshInfo& pminfo) const;
     void ok() const;
     bool adds_two_faces() const;
@@ -210,6 +210,8 @@ struct Vsplit {
     float resid_uni;
     float resid_dir;
     int expected_wad_num(const PMeshInfo& pminfo) const;
+ private:
+    template<typename Reader> void read_aux(Reader& reader, const PMeshInfo& pminfo);
 };
 
 // For each face, what are its 3 neighbors?
@@ -0,0 +1,75 @@
+// -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
+#include "Pool.h"
+
+#include <algorithm>            // std::find()
+#include <vector>
+
+namespace hh {
+
+namespace details {
+
+thread_local PoolCache t_pool_caches[k_max_pools];
+thread_local int t_pool_caches_state;
+
+namespace {
+
+// The registry is allocated on first use and never destroyed, because pools are constructed and destroyed
+//  during static initialization and termination of arbitrary translation units.
+struct Registry {
+    std::mutex mutex;
+    Pool* pools[k_max_pools] {};        // nullptr once destroyed
+    int npools {0};
+    std::vector<PoolCache*> caches;     // t_pool_caches of each registered thread
+};
+
+Registry& registry() {
+    static Registry* const p = new Registry;
+    return *p;
+}
+
+// On thread exit, return the thread's cached elements to their pools.
+struct ThreadCachesOwner {
+    ThreadCachesOwner() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.caches.push_back(t_pool_caches);
+    }
+    ~ThreadCachesOwner() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for_int(id, r.npools) {
+            if (r.pools[id] && t_pool_caches[id].h) r.pools[id]->return_cache(t_pool_caches[id]);
+        }
+        r.caches.erase(std::find(r.caches.begin(), r.caches.end(), t_pool_caches));
+        t_pool_caches_state = 2;
+    }
+};
+
+} // namespace
+
+void register_pool_caches() {
+    static thread_local ThreadCachesOwner owner;
+    dummy_use(owner);
+    t_pool_caches_state = 1;
+}
+
+} // namespace details
+
+int Pool::register_pool(Pool* pool) {
+    details::Registry& r = details::registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    assertx(r.npools<details::k_max_pools);
+    r.pools[r.npools] = pool;
+    return r.npools++;
+}
+
+int Pool::unregister_pool(int id) {
+    details::Registry& r = details::registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.pools[id] = nullptr;
+    int ncached = 0;
+    for (details::PoolCache* caches : r.caches) ncached += caches[id].n;
+    return ncached;
+}
+
+} // namespace hh
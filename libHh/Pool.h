@@ -4,6 +4,9 @@
 
 #include "Hh.h"
 
+#include <atomic>
+#include <mutex>
+
 #if 0
 // *.h
 class Polygon {
@@ -59,7 +62,19 @@ namespace hh {
 
 //----------------------------------------------------------------------------
 
+namespace details {
+struct PoolCache { void* h; int n; }; // free elements of one Pool cached by one thread
+constexpr int k_max_pools = 64;
+extern thread_local PoolCache t_pool_caches[k_max_pools];
+// 0=unregistered, 1=registered (caches returned to the pools on thread exit), 2=exited (no longer cache elements)
+extern thread_local int t_pool_caches_state;
+void register_pool_caches();
+} // namespace details
+
 // Custom memory allocation pool for a class of objects.
+// It is thread-safe: each thread allocates from and frees into its own cache of free elements, and the caches
+//  exchange batches of elements with the shared free list (protected by a mutex) when they run empty or grow large.
+//  An element may be freed by a thread other than the one that allocated it.
 class Pool : noncopyable {
  public:
     Pool() {
@@ -79,6 +94,8 @@ class Pool : noncopyable {
         _h = nullptr;
         _nalloc = 0;
         _chunkh = nullptr;
+        _mutex = new std::mutex;  // (not a member since the constructor may be called after construct())
+        _id = register_pool(this);
         // static variable sdebug may not yet be initialized.
         if (getenv_int("POOL_DEBUG")>=2)
             showf("Pool %-20s: construct (size=%2d, align=%2d)\n", _name, _esize, _ealign);
@@ -86,55 +103,81 @@ class Pool : noncopyable {
     }
     void destroy() {
         assertx(_name);
-        int n = 0;
+        // Any caches of the main thread have already been returned, but other threads may still hold caches.
+        int n = 0, ncached = unregister_pool(_id);
         for (Link* p = _h; p; p = p->next) n++;
-        if (sdebug>=2 || (sdebug && _nalloc) || n!=_nalloc)
+        const int nfree = n+ncached;
+        if (sdebug>=2 || (sdebug && _nalloc) || nfree!=_nalloc)
             showf("Pool %-20s: (size %2d) %6d/%-6d elements outstanding%s\n",
-                  _name, _esize, _nalloc-n, _nalloc, (n!=_nalloc ? " **" : ""));
+                  _name, _esize, _nalloc-nfree, _nalloc, (nfree!=_nalloc ? " **" : ""));
         if (n!=_nalloc) return;
         for (Chunk* chunk = _chunkh; chunk; ) {
             char* p = reinterpret_cast<char*>(chunk);
             chunk = chunk->next;
             aligned_free(p-_offset);
         }
-        _name = nullptr; _esize = 0; _h = nullptr; _nalloc = 0; _chunkh = nullptr;
+        delete _mutex;
+        _name = nullptr; _esize = 0; _h = nullptr; _nalloc = 0; _chunkh = nullptr; _mutex = nullptr;
+        _inited.store(false, std::memory_order_relaxed);
     }
     // allocate based on static size of class
     void* alloc() {
-        if (!_h) grow();
-        Link* p = _h; _h = p->next; return p;
+        details::PoolCache& c = details::t_pool_caches[_id];
+        if (!c.h) refill(c);
+        Link* p = static_cast<Link*>(c.h); c.h = p->next; c.n--; return p;
     }
     void free(void* pp) {
         if (!pp) return;
-        Link* p = static_cast<Link*>(pp); p->next = _h; _h = p;
+        details::PoolCache& c = details::t_pool_caches[_id];
+        Link* p = static_cast<Link*>(pp); p->next = static_cast<Link*>(c.h); c.h = p;
+        if (++c.n>=2*k_batch || details::t_pool_caches_state!=1) return_batch(c);
     }
     // allocate based on size of first alloc_size() call
     void* alloc_size(size_t s64, int align) {
-        int s = narrow_cast<int>(s64);
-        if (!_h) grow_size(s, align);
-        Link* p = _h; _h = p->next; return p;
+        details::PoolCache& c = details::t_pool_caches[_id];
+        if (!c.h) {
+            if (!_inited.load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> lock(*_mutex);
+                if (!_esize) { _ealign = align; init_size(narrow_cast<int>(s64)); }
+            }
+            refill(c);
+        }
+        Link* p = static_cast<Link*>(c.h); c.h = p->next; c.n--; return p;
     }
     void free_size(void* pp, size_t s) {
         dummy_use(s);
-        // Pool::free(pp);
-        if (!pp) return;
-        Link* p = static_cast<Link*>(pp); p->next = _h; _h = p;
+        Pool::free(pp);
+    }
+    // Return the elements in the cache c (belonging to an exiting thread) to the shared free list.
+    void return_cache(details::PoolCache& c) {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        while (c.h) {
+            Link* p = static_cast<Link*>(c.h); c.h = p->next;
+            p->next = _h; _h = p;
+        }
+        c.n = 0;
     }
  private:
     static constexpr int k_pagesize = 16*1024;   // could refer to getpagesize();
     static constexpr int k_malloc_overhead = 64; // high just to be safe, multiple of 16; was 32
     static constexpr int k_chunksize = k_pagesize-k_malloc_overhead;
+    static constexpr int k_batch = 64;           // number of elements moved between a thread cache and _h
     const int sdebug = getenv_int("POOL_DEBUG"); // 0, 1, 2, or 3; may be uninitialized in constructor() and init()
     struct Link { Link* next; };
     struct Chunk { Chunk* next; };
     unsigned _esize;
     int _ealign;
     const char* _name;          // not "string" because construct() may be called before constructor!
-    Link* _h;
+    Link* _h;                   // shared free list
     Chunk* _chunkh;
     int _nalloc;
     int _offset;
+    int _id;                    // index into details::t_pool_caches
+    std::mutex* _mutex;         // protects _h, _chunkh, _nalloc, and the initialization of _esize
+    std::atomic<bool> _inited;  // _esize is final; set last in init() so that alloc_size() may test it unlocked
     //
+    static int register_pool(Pool* pool);
+    static int unregister_pool(int id); // ret: number of elements in caches of other threads
     void init() {
         // make allocated size a multiple of sizeof(Link)!
         _esize = ((_esize+sizeof(Link)-1)/sizeof(Link))*sizeof(Link);
@@ -146,6 +189,32 @@ class Pool : noncopyable {
         // static variable sdebug may not yet be initialized.
         if (getenv_int("POOL_DEBUG")>=2)
             showf("Pool %-20s: _esize=%d _ealign=%d _offset=%d\n", _name, _esize, _ealign, _offset);
+        _inited.store(true, std::memory_order_release);
+    }
+    void init_size(int size)                    { _esize = unsigned(size); init(); }
+    // Move a batch of elements from the shared free list into the (empty) cache c of the current thread.
+    void refill(details::PoolCache& c) {
+        if (!details::t_pool_caches_state) details::register_pool_caches();
+        const int nbatch = details::t_pool_caches_state==1 ? k_batch : 1;
+        std::lock_guard<std::mutex> lock(*_mutex);
+        for_int(i, nbatch) {
+            if (!_h) grow();
+            Link* p = _h; _h = p->next;
+            p->next = static_cast<Link*>(c.h); c.h = p;
+        }
+        c.n += nbatch;
+    }
+    // Move a batch of elements from the (large) cache c of the current thread back to the shared free list.
+    void return_batch(details::PoolCache& c) {
+        if (!details::t_pool_caches_state) details::register_pool_caches();
+        if (details::t_pool_caches_state==2) { return_cache(c); return; } // e.g. objects destroyed at program exit
+        if (c.n<2*k_batch) return;
+        std::lock_guard<std::mutex> lock(*_mutex);
+        for_int(i, k_batch) {
+            Link* p = static_cast<Link*>(c.h); c.h = p->next;
+            p->next = _h; _h = p;
+        }
+        c.n -= k_batch;
     }
     void grow() {
         assertx(!_h);
@@ -166,10 +235,68 @@ class Pool : noncopyable {
         reinterpret_cast<Link*>(p)->next = nullptr;
         _nalloc += nelem;
     }
-    void grow_size(int size, int align) {
-        assertx(!_h);
-        if (!_esize) { _esize = unsigned(size); _ealign = align; init(); }
-        grow();
+};
+
+// Memory arena for pooled objects owned by a single container (e.g. the elements of a Mesh with arena
+//  allocation): freed elements are recycled within the arena, and release() frees all its memory in one shot.
+// Unlike Pool, an arena is not thread-safe; it is meant to be used by one container at a time.
+class PoolArena : noncopyable {
+ public:
+    PoolArena()                                 = default;
+    ~PoolArena()                                { release(); }
+    void* alloc(size_t s64, int align) {
+        int s = round_size(s64);
+        for (SizeClass& sc : _sizes) {
+            if (sc.size==s && sc.align==align && sc.h) { Link* p = sc.h; sc.h = p->next; return p; }
+        }
+        uintptr_t a = (reinterpret_cast<uintptr_t>(_cur)+align-1)/align*align;
+        if (!_cur || a+s>reinterpret_cast<uintptr_t>(_end)) {
+            grow(s+align);
+            a = (reinterpret_cast<uintptr_t>(_cur)+align-1)/align*align;
+        }
+        _cur = reinterpret_cast<char*>(a+s);
+        return reinterpret_cast<void*>(a);
+    }
+    void free(void* pp, size_t s64, int align) {
+        if (!pp) return;
+        int s = round_size(s64);
+        for (SizeClass& sc : _sizes) {
+            if ((sc.size==s && sc.align==align) || !sc.size) {
+                sc.size = s; sc.align = align;
+                Link* p = static_cast<Link*>(pp); p->next = sc.h; sc.h = p;
+                return;
+            }
+        }
+        assertnever("PoolArena: too many distinct element sizes");
+    }
+    void release() {            // all objects must have been destroyed already
+        for (Chunk* chunk = _chunkh; chunk; ) {
+            Chunk* next = chunk->next;
+            aligned_free(chunk);
+            chunk = next;
+        }
+        _chunkh = nullptr; _cur = nullptr; _end = nullptr;
+        for (SizeClass& sc : _sizes) { sc = SizeClass{}; }
+    }
+ private:
+    static constexpr int k_chunksize = 256*1024-64;
+    struct Link { Link* next; };
+    struct Chunk { Chunk* next; };
+    struct SizeClass { int size; int align; Link* h; };
+    Chunk* _chunkh {nullptr};
+    char* _cur {nullptr};       // next free byte in the current chunk
+    char* _end {nullptr};
+    SizeClass _sizes[8] {};     // free lists for each element size and alignment
+    static int round_size(size_t s64) {
+        int s = narrow_cast<int>(s64);
+        return (s+int(sizeof(Link))-1)/int(sizeof(Link))*int(sizeof(Link));
+    }
+    void grow(int minsize) {
+        int size = max(k_chunksize, int(sizeof(Chunk))+minsize);
+        char* p = static_cast<char*>(assertx(aligned_malloc(size, 64)));
+        Chunk* chunk = reinterpret_cast<Chunk*>(p);
+        chunk->next = _chunkh; _chunkh = chunk;
+        _cur = p+sizeof(Chunk); _end = p+size;
     }
 };
 
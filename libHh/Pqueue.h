@@ -285,6 +285,170 @@ template<typename T, typename Hash = std::hash<T>, typename Equal = std::equal_t
     }
 };
 
+// Heap index of an element within an IPqueue, suitable as a per-element field (e.g. HH_SAC_ALLOCATE_CD_FUNC);
+//  it is default-constructed as "not in queue".
+struct IPqueueSlot {
+    int index {-1};
+};
+
+// Self-resizing array of IPqueue slots for nonnegative integer elements (e.g. dense vertex ids).
+class IPqueueIntSlots {
+ public:
+    int& operator()(int e) {
+        ASSERTXX(e>=0);
+        if (e>=_ar.num()) { int n = _ar.num(); _ar.resize(std::max(e+1, n*2)); for_intL(i, n, _ar.num()) { _ar[i] = -1; } }
+        return _ar[e];
+    }
+ private:
+    Array<int> _ar;
+};
+
+// Indexed priority queue allowing insertion/deletion/update, like HPqueue but without hashing.
+// The heap index of each element is stored in a dense per-element slot returned by fslot(e) (an int&), which must
+//  be -1 for any element not in the queue (see IPqueueSlot and IPqueueIntSlots); the queue maintains the slots
+//  of its elements and resets them to -1 upon removal.
+// The 4-ary heap has shallower sift-up paths (cheap decrease-key) and more cache-friendly sift-down than a binary heap.
+template<typename T, typename Func_slot> class IPqueue : noncopyable {
+    static constexpr int D = 4; // heap arity
+ public:
+    explicit IPqueue(Func_slot fslot = Func_slot{}) : _fslot(fslot) { }
+    void clear()                                { for (Node& n : _ar) { slot(n._e) = -1; } _ar.clear(); }
+    void enter(const T& e, float pri)           { ASSERTX(pri>=0); ASSERTX(!contains(e)); enter_i(e, pri); }
+    void reserve(int size)                      { _ar.reserve(size); }
+    int num() const                             { return _ar.num(); }
+    size_t size() const                         { return _ar.size(); }
+    bool empty() const                          { return !num(); }
+    const T& min() const                        { ASSERTXX(!empty()); return _ar[0]._e; }
+    float min_priority() const                  { ASSERTXX(!empty()); return _ar[0]._pri; }
+    T remove_min()                              { ASSERTXX(!empty()); return remove_min_i(); }
+    void enter_unsorted(const T& e, float pri) {
+        ASSERTX(pri>=0); ASSERTX(!contains(e)); slot(e) = num(); _ar.push(Node(e, pri));
+    }
+    void sort()                                 { sort_i(); }
+    bool contains(const T& e) const             { return find(e)>=0; }
+    float retrieve(const T& e) const            { int i = find(e); return i>=0 ? _ar[i]._pri : -1.f; }
+    float remove(const T& e)                    { return remove_i(e); }                       // ret pri or <0
+    float update(const T& e, float pri)         { ASSERTX(pri>=0); return update_i(e, pri); } // ret prevpri or <0
+    float enter_update(const T& e, float pri) { // ret prevpri or <0
+        ASSERTX(pri>=0);
+        int i = find(e);
+        if (i<0) { enter_i(e, pri); return -1.f; }
+        float oldpri = _ar[i]._pri; place(i, e, pri, true, true); return oldpri;
+    }
+    bool enter_update_if_smaller(const T& e, float pri) {
+        ASSERTX(pri>=0);
+        int i = find(e);
+        if (i<0) { enter_i(e, pri); return true; }
+        if (!(pri<_ar[i]._pri)) return false;
+        place(i, e, pri, true, false); return true;
+    }
+    bool enter_update_if_greater(const T& e, float pri) {
+        ASSERTX(pri>=0);
+        int i = find(e);
+        if (i<0) { enter_i(e, pri); return true; }
+        if (!(pri>_ar[i]._pri)) return false;
+        place(i, e, pri, false, true); return true;
+    }
+    // Update the priorities of a batch of elements already in the queue (e.g. a set of decrease_key operations).
+    // If the batch is large relative to the queue, it is cheaper to assign all priorities and rebuild the heap.
+    void update_batch(CArrayView<std::pair<T, float>> updates) {
+        if (updates.num()*8>num()) {
+            for (const auto& pair : updates) { int i = find(pair.first); assertx(i>=0); _ar[i]._pri = pair.second; }
+            sort_i();
+        } else {
+            for (const auto& pair : updates) { assertx(update(pair.first, pair.second)>=0.f); }
+        }
+    }
+ private:
+    using Node = details::PQ::Node<T>;
+    Array<Node> _ar;
+    mutable Func_slot _fslot;
+    int& slot(const T& e) const                 { return _fslot(e); }
+    int find(const T& e) const {
+        int i = slot(e);
+        ASSERTXX(i<0 || (i<num() && _ar[i]._e==e));
+        return i;
+    }
+    void nmove(int n1, int n2)                  { _ar[n1] = std::move(_ar[n2]); slot(_ar[n1]._e) = n1; }
+    // (cp is the priority of the element destined for node n, whose entry in _ar[n] is a hole)
+    // Returns the final index j where that element should be placed.
+    int adjust(int n, const float cp, bool up, bool down) {
+        int orig_n = n;
+        if (up) {
+            while (n) {
+                int pn = (n-1)/D;
+                if (!(cp<_ar[pn]._pri)) break;
+                nmove(n, pn); n = pn;
+            }
+            if (n!=orig_n) return n;
+        }
+        if (down) {
+            for (;;) {
+                int fc = n*D+1;   // first child
+                if (fc>=num()) break;
+                int lc = std::min(fc+D, num());
+                int mc = fc; float mp = _ar[fc]._pri;
+                for_intL(c, fc+1, lc) { if (_ar[c]._pri<mp) { mc = c; mp = _ar[c]._pri; } }
+                if (!(cp>mp)) break;
+                nmove(n, mc); n = mc;
+            }
+        }
+        return n;
+    }
+    void place(int i, const T& e, float pri, bool up, bool down) {
+        int j = adjust(i, pri, up, down);
+        _ar[j]._pri = pri;
+        if (j!=i) { _ar[j]._e = e; slot(e) = j; }
+    }
+    void enter_i(const T& e, float pri) {
+        _ar.add(1);             // leave this new node uninitialized
+        int j = adjust(num()-1, pri, true, false);
+        _ar[j]._e = e; _ar[j]._pri = pri;
+        slot(e) = j;
+    }
+    void sort_i() {
+        if (num()<2) return;    // (num()-2)/D is 0 rather than -1 for an empty queue
+        for (int i = (num()-2)/D; i>=0; --i) { // parent of the last node
+            T e = _ar[i]._e; float pri = _ar[i]._pri;
+            place(i, e, pri, false, true);
+        }
+    }
+    // Fill the hole at index i using the last node.
+    void fill_hole(int i) {
+        int ilast = num()-1;
+        if (i<ilast) {
+            T e0 = _ar[ilast]._e; float pri = _ar[ilast]._pri;
+            _ar.sub(1);
+            int j = adjust(i, pri, true, true);
+            _ar[j]._e = e0; _ar[j]._pri = pri;
+            slot(e0) = j;
+        } else {
+            _ar.sub(1);
+        }
+    }
+    T remove_min_i() {
+        T e = _ar[0]._e;
+        slot(e) = -1;
+        fill_hole(0);
+        return e;
+    }
+    float remove_i(const T& e) {
+        int i = find(e);
+        if (i<0) return -1.f;
+        float ppri = _ar[i]._pri;
+        slot(e) = -1;
+        fill_hole(i);
+        return ppri;
+    }
+    float update_i(const T& e, float pri) {
+        int i = find(e);
+        if (i<0) return -1.f;
+        float oldpri = _ar[i]._pri;
+        place(i, e, pri, true, true);
+        return oldpri;
+    }
+};
+
 } // namespace hh
 
 #endif // MESH_PROCESSING_LIBHH_PQUEUE_H_
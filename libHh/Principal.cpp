@@ -5,6 +5,9 @@
 #include "Timer.h"
 #include "Stat.h"
 #include "SGrid.h"
+#include "Spatial.h"
+#include "PArray.h"
+#include "Parallel.h"
 
 namespace hh {
 
@@ -100,6 +103,25 @@ void principal_components(CArrayView<Vector>va, Frame& f, Vec3<float>& eimag) {
 }
 
 
+void local_principal_components(CArrayView<Point> pa, const PointSpatial<int>& sp, int mink, int maxk, float maxdis,
+                                ArrayView<Frame> frames, Array<Array<int>>* pneighbors) {
+    assertx(frames.num()==pa.num() && mink>0 && maxk>=mink);
+    if (pneighbors) pneighbors->init(pa.num());
+    parallel_for_each(range(pa.num()), [&](const int i) {
+        PArray<Point,40> pts;
+        SpatialSearch<int> ss(&sp, pa[i]);
+        for (;;) {
+            assertx(!ss.done());
+            float dis2; int pi = ss.next(&dis2);
+            if ((pts.num()>=mink && dis2>square(maxdis)) || pts.num()>=maxk) break;
+            pts.push(pa[pi]);
+            if (pneighbors) (*pneighbors)[i].push(pi);
+        }
+        Vec3<float> eimag;
+        principal_components(pts, frames[i], eimag);
+    }, maxk*1000);
+}
+
 void subtract_mean(MatrixView<float> mi) {
     const int m = mi.ysize(), n = mi.xsize(); assertx(m>=2 && n>0);
     for_int(j, n) {
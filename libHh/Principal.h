@@ -7,6 +7,8 @@
 
 namespace hh {
 
+template<typename T> class PointSpatial;
+
 // Given points pa[], compute the principal component frame f and the (redundant) eigenvalues eimag.
 // The frame f is guaranteed to be invertible and orthogonal, as the axis
 //   will always have non-zero (albeit very small) lengths.
@@ -17,6 +19,12 @@ void principal_components(CArrayView<Point> pa, Frame& f, Vec3<float>& eimag);
 // Same but for vectors va[].  Note that the origin f.p() of frame f will therefore be thrice(0.f).
 void principal_components(CArrayView<Vector> va, Frame& f, Vec3<float>& eimag);
 
+// For each point pa[i], compute the principal component frame frames[i] of its nearest points in sp (which contains
+//  the points pa, including pa[i] itself): the closest mink points, and more (up to maxk) if within distance maxdis.
+// If pneighbors, also returns these nearest points for each point.  The points are processed in parallel.
+void local_principal_components(CArrayView<Point> pa, const PointSpatial<int>& sp, int mink, int maxk, float maxdis,
+                                ArrayView<Frame> frames, Array<Array<int>>* pneighbors = nullptr);
+
 // Given mi[m][n] (m data points of dimension n),
 //   compute mo[n][n] (n orthonormal eigenvectors rows, by decreasing eigenv.) and eigenvalues eimag[n].
 // Note that the mean must be subtracted out of mi[][] if desired.
@@ -108,18 +108,25 @@ template<typename T> BSac::Func Sac<T>::dfuncs[k_max] = {};
     static void operator delete(void* p, size_t) { hh::aligned_free(p); }                       \
     hh::Sac<T> sac
 
-#define HH_MAKE_POOLED_SAC(T)                                                       \
-    hh::Sac<T> sac;                                                                 \
-    static void* operator new(size_t s) {                                           \
-        ASSERTX(s==sizeof(T));                                                      \
-        return pool.alloc_size(sizeof(T)-hh::BSac::k_dummy+hh::Sac<T>::get_size(),  \
-                               hh::Sac<T>::get_max_align());                        \
-    }                                                                               \
-    static void operator delete(void* p, size_t) {                                  \
-        pool.free_size(p, sizeof(T)-hh::BSac::k_dummy+hh::Sac<T>::get_size());      \
-    }                                                                               \
-    static void* operator new[](size_t) = delete;                                   \
-    static void operator delete[](void*, size_t) = delete;                          \
+#define HH_MAKE_POOLED_SAC(T)                                                                 \
+    hh::Sac<T> sac;                                                                           \
+    static size_t pool_size() { return sizeof(T)-hh::BSac::k_dummy+hh::Sac<T>::get_size(); }  \
+    static void* operator new(size_t s) {                                                     \
+        ASSERTX(s==sizeof(T));                                                                \
+        return pool.alloc_size(pool_size(), hh::Sac<T>::get_max_align());                     \
+    }                                                                                         \
+    static void operator delete(void* p, size_t) { pool.free_size(p, pool_size()); }          \
+    /* Allocation in an arena; to free, call the destructor and then arena_free(). */         \
+    static void* operator new(size_t s, hh::PoolArena& arena) {                               \
+        ASSERTX(s==sizeof(T));                                                                \
+        return arena.alloc(pool_size(), hh::Sac<T>::get_max_align());                         \
+    }                                                                                         \
+    static void operator delete(void* p, hh::PoolArena& arena) { arena_free(p, arena); }      \
+    static void arena_free(void* p, hh::PoolArena& arena) {                                   \
+        arena.free(p, pool_size(), hh::Sac<T>::get_max_align());                              \
+    }                                                                                         \
+    static void* operator new[](size_t) = delete;                                             \
+    static void operator delete[](void*, size_t) = delete;                                    \
     HH_POOL_ALLOCATION_3(T)
 
 #define HH_SACABLE(T)                                                                       \
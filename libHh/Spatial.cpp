@@ -111,8 +111,8 @@ BSpatialSearch::BSpatialSearch(const Spatial* sp, const Point& p, float maxdis)
 }
 
 BSpatialSearch::~BSpatialSearch() {
-    HH_SSTAT(Sssncellsv, _ncellsv);
-    HH_SSTAT(Sssnelemsv, _nelemsv);
+    HH_SSTAT_CONCURRENT(Sssncellsv, _ncellsv); // searches may proceed concurrently
+    HH_SSTAT_CONCURRENT(Sssnelemsv, _nelemsv);
 }
 
 bool BSpatialSearch::done() {
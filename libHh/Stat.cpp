@@ -1,6 +1,7 @@
 // -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
 #include "Stat.h"
 
+#include <mutex>                // std::mutex, std::lock_guard
 #include <vector>
 
 namespace hh {
@@ -9,6 +10,8 @@ class Stats {                   // friend of Stat
  public:
     ~Stats()                                    { if (0) flush(); } // unlikely to come before all static ~Stat()
     void flush() {
+        for (ConcurrentStat* cstat : _vecconcurrent) { cstat->merge(); }
+        _vecconcurrent.clear();
         if (_vecstat.empty()) return;
         int ntoprint = 0;
         for (Stat* stat : _vecstat) {
@@ -19,6 +22,7 @@ class Stats {                   // friend of Stat
         _vecstat.clear();
     }
     std::vector<Stat*> _vecstat; // do not take dependency on Array.h
+    std::vector<ConcurrentStat*> _vecconcurrent;
 };
 
 namespace {
@@ -92,6 +96,28 @@ void Stat::add(const Stat& st) {
     if (st._max>_max) _max = st._max;
 }
 
+struct ConcurrentStat::Implementation {
+    std::mutex _mutex;
+    std::vector<unique_ptr<Stat>> _locals;
+};
+
+ConcurrentStat::ConcurrentStat(const char* pname) : _stat(pname, true, true), _impl(make_unique<Implementation>()) {
+    if (Stats* pstats = g_pstats.get()) pstats->_vecconcurrent.push_back(this);
+}
+
+ConcurrentStat::~ConcurrentStat() { merge(); }
+
+Stat& ConcurrentStat::new_local() {
+    std::lock_guard<std::mutex> lock(_impl->_mutex); // only once per thread
+    _impl->_locals.push_back(make_unique<Stat>());
+    return *_impl->_locals.back();
+}
+
+void ConcurrentStat::merge() {
+    std::lock_guard<std::mutex> lock(_impl->_mutex);
+    for (auto& pstat : _impl->_locals) { _stat.add(*pstat); pstat->zero(); }
+}
+
 string Stat::short_string() const {
     float tavg = _n>0 ? avg() : 0.f, tsdv = _n>1 ? sdv() : 0.f, trms = _n>0 ? rms() : 0.f;
     // (on _WIN32, could also use "(%-7I64d)")
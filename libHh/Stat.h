@@ -9,6 +9,7 @@
 {
     { HH_STAT(Svdeg); for_int(i, 10) Svdeg.enter(vdeg[i]); }
     HH_SSTAT(Svanum, va.num());
+    parallel_for_each(range(n), [&](const int i) { HH_SSTAT_CONCURRENT(Sdist, dist[i]); });
     SHOW(Stat(V(1., 4., 5., 6.)).sdv());
     // getenv_bool("STAT_FILES") -> store all data values in files.
 }
@@ -70,6 +71,20 @@ class Stat {
 
 template<> HH_DECLARE_OSTREAM_EOL(Stat);
 
+// Static Stat into which values may be entered concurrently by several threads.
+// Each thread accumulates into its own Stat, and these are combined when the statistics are printed.
+class ConcurrentStat {
+ public:
+    explicit ConcurrentStat(const char* pname);
+    ~ConcurrentStat();
+    Stat& new_local();          // create the Stat of the calling thread; it lives as long as *this
+    void merge();               // add the per-thread Stats into the printed one; no thread may be entering values
+ private:
+    Stat _stat;
+    struct Implementation;
+    unique_ptr<Implementation> _impl;
+};
+
 // Like Stat(range), but later specialized to operate on magnitude of Vector4 elements.
 template<typename R, typename = enable_if_range_t<R> > Stat range_stat(const R& range);
 
@@ -85,6 +100,9 @@ template<typename R, typename = enable_if_range_t<R> > R standardize_rms(R&& ran
 #define HH_STAT(S) hh::Stat S{#S, true}
 #define HH_STATNP(S) hh::Stat S{#S, false} // no print
 #define HH_SSTAT(S, v) do { static hh::Stat S(#S, true, true); S.enter(v); } while (false) // static Stat
+#define HH_SSTAT_CONCURRENT(S, v) do { \
+    static hh::ConcurrentStat S(#S); thread_local hh::Stat& S##_local = S.new_local(); S##_local.enter(v); \
+} while (false)                 // static Stat safe for concurrent threads
 #define HH_SSTAT_RMS(S, v) do { static hh::Stat S(#S, true, true); S.set_rms(); S.enter(v); } while (false)
 #define HH_RSTAT(S, range) do { HH_STAT(S); for (auto e : range) { S.enter(e); } } while (false) // range Stat
 #define HH_RSTAT_RMS(S, range) do { HH_STAT(S); S.set_rms(); for (auto e : range) { S.enter(e); } } while (false)
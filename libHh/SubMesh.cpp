@@ -6,6 +6,7 @@
 #include "Set.h"
 #include "Queue.h"
 #include "RangeOp.h"            // is_zero()
+#include "Parallel.h"
 
 namespace hh {
 
@@ -173,6 +174,7 @@ SubMesh::SubMesh(GMesh& pmesh) : _omesh(pmesh) {
 }
 
 void SubMesh::clear() {
+    _stencils = nullptr;
     _m.clear();
     _cmvcvh.clear();
     _mforigf.clear();
@@ -248,6 +250,7 @@ void SubMesh::subdivide_aux(float cosang, Mvcvh* pmconv) {
 // *** compute convolutions
 
 void SubMesh::refine(Mvcvh& mconv) {
+    _stencils = nullptr;
     // Save current mesh objects for later iteration
     // Array<Vertex> arv; for (Vertex v : _m.vertices()) { arv += v; }
     Array<Face> arf; for (Face f : _m.ordered_faces()) { arf.push(f); }
@@ -391,6 +394,7 @@ void SubMesh::selectively_refine(Mvcvh& mconv, float cosang) {
     //       Subdivfit -mf ~/data/mesh/cat.m -selective 40 -nsub 2 -outn >v
     // See also Filtermesh.cpp:do_silsubdiv()
     assertx(!_isquad);
+    _stencils = nullptr;
     // _mforigf, _mfindex, and _mofif are not supported with this scheme!
     Array<Face> arf; for (Face f : _m.faces()) { arf.push(f); }
     // Determine which edges will be subdivided
@@ -663,6 +667,7 @@ void SubMesh::limit_mask(Vertex v, Combvh& comb) const {
 
 void SubMesh::triangulate_quads(Mvcvh& mconv) {
     assertx(_isquad);
+    _stencils = nullptr;
     Array<Face> arf; for (Face f : _m.ordered_faces()) { arf.push(f); }
     for (Edge e : _m.edges()) { assertx(!_m.flags(e)); }
     if (0) {
@@ -695,6 +700,7 @@ void SubMesh::triangulate_quads(Mvcvh& mconv) {
 // *** misc
 
 void SubMesh::convolve_self(const Mvcvh& mconv) {
+    _stencils = nullptr;
     _cmvcvh.compose(mconv);
 }
 
@@ -711,8 +717,39 @@ void SubMesh::update_vertex_position(Vertex v) {
     _m.set_point(v, comb.evaluate(_omesh));
 }
 
+void SubMesh::build_stencils() {
+    _stencils = make_unique<StencilTable>();
+    StencilTable& st = *_stencils;
+    Map<Vertex,int> moindex;    // vertex of _omesh -> index in st._overtices
+    st._start.push(0);
+    for (Vertex v : _m.vertices()) {
+        const Combvh& comb = _cmvcvh.get(v);
+        st._vertices.push(v);
+        st._h.push(comb.h);
+        // Entries are kept in the order of for_combination(), so the evaluation matches Combvh::evaluate().
+        for_combination(comb.c, [&](Vertex vo, float val) {
+            bool is_new; int& i = moindex.enter(vo, st._overtices.num(), is_new);
+            if (is_new) st._overtices.push(vo);
+            st._index.push(i);
+            st._weight.push(val);
+        });
+        st._start.push(st._index.num());
+    }
+}
+
 void SubMesh::update_vertex_positions() {
-    for (Vertex v : _m.vertices()) { update_vertex_position(v); }
+    if (!_stencils) build_stencils();
+    const StencilTable& st = *_stencils;
+    assertx(st._vertices.num()==_m.num_vertices());
+    Array<Homogeneous> opoints(st._overtices.num());
+    for_int(i, opoints.num()) { opoints[i] = Homogeneous(_omesh.point(st._overtices[i])); }
+    Array<Point> points(st._vertices.num());
+    parallel_for_each(range(points.num()), [&](const int i) {
+        Homogeneous th(st._h[i]);
+        for_intL(k, st._start[i], st._start[i+1]) { th += st._weight[k]*opoints[st._index[k]]; }
+        points[i] = to_Point(th);
+    }, 100);
+    for_int(i, points.num()) { _m.set_point(st._vertices[i], points[i]); }
 }
 
 Face SubMesh::orig_face(Face f) const {
@@ -52,7 +52,7 @@ class SubMesh {
     Combvh compose_c_mvcvh(const Combvh& ci) const;
 // update vertex positions on mesh() according to its mask
     void update_vertex_position(Vertex v);
-    void update_vertex_positions();
+    void update_vertex_positions(); // evaluates a cached stencil table, so repeated calls are fast
 // misc
     void mask_parameters(bool ps222, float pweighta) { _s222 = ps222; _weighta = pweighta; }
 // omesh to and from mesh
@@ -90,6 +90,18 @@ class SubMesh {
     float _weighta {0.f};
     bool _selrefine {false};    // no longer used
     //
+    // Flat (CSR) form of _cmvcvh, so that when only the positions of _omesh change, all vertex positions are
+    //  re-evaluated as one sparse matrix-vector product; built on demand and discarded whenever _m or _cmvcvh change.
+    struct StencilTable {
+        Array<Vertex> _vertices;    // vertex of _m for each stencil
+        Array<Homogeneous> _h;      // constant term of each stencil
+        Array<int> _start;          // [_vertices.num()+1]; entries of stencil i are in [_start[i], _start[i+1])
+        Array<int> _index;          // index in _overtices of each entry
+        Array<float> _weight;       // weight of each entry
+        Array<Vertex> _overtices;   // vertices of _omesh referenced by the stencils
+    };
+    unique_ptr<StencilTable> _stencils;
+    void build_stencils();
     bool sharp(Edge e) const;
     int nume(Vertex v) const;
     int num_sharp_edges(Vertex v) const;
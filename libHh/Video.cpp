@@ -57,7 +57,10 @@ HH_REFERENCE_LIB("mfuuid.lib");      // MF_MT_DEFAULT_STRIDE
 #include "Timer.h"
 #include "ConsoleProgress.h"
 #include "StringOp.h"           // get_path_extension()
+#include "BoundedQueue.h"
 #include <cstring>              // std::memcpy()
+#include <thread>
+#include <exception>            // std::exception_ptr
 
 
 //----------------------------------------------------------------------------
@@ -358,6 +361,165 @@ class Unsupported_WVideo_Implementation : public WVideo::Implementation {
 };
 
 
+//----------------------------------------------------------------------------
+// **** asynchronous decode-ahead and encode-behind
+
+namespace {
+
+// Number of frames buffered ahead of RVideo::read() or behind WVideo::write(); 0 disables the asynchronous mode.
+int video_async_frames() {
+    static const int k_frames = getenv_int("VIDEO_ASYNC_FRAMES", 2, true);
+    return k_frames;
+}
+
+// A frame buffer in the native format of the video stream.
+struct AsyncFrame {
+    Matrix<Pixel> rgb;
+    Nv12 nv12;
+};
+
+} // namespace
+
+// Decode frames in a background thread into a bounded ring of buffers, so that the reading and pixel conversion
+//  of the next frames overlap the processing of the current frame by the caller.
+class Async_RVideo_Implementation : public RVideo::Implementation {
+ public:
+    Async_RVideo_Implementation(RVideo& rvideo, unique_ptr<RVideo::Implementation> impl, int nframes)
+        : RVideo::Implementation(rvideo), _impl(std::move(impl)), _free(nframes+1), _filled(nframes) {
+        for_int(i, nframes+1) {
+            auto frame = make_unique<AsyncFrame>();
+            if (use_nv12()) frame->nv12.init(_rvideo.spatial_dims()); else frame->rgb.init(_rvideo.spatial_dims());
+            assertx(_free.push(std::move(frame)));
+        }
+        _thread = std::thread([this] { decode_frames(); });
+    }
+    ~Async_RVideo_Implementation() {
+        _free.close(); _filled.close();   // stop the decoder thread if it is blocked
+        _thread.join();
+    }
+    virtual string name() const override { return "async_" + _impl->name(); }
+    bool read(MatrixView<Pixel> frame) override {
+        unique_ptr<AsyncFrame> aframe; if (!pop_frame(aframe)) return false;
+        assertx(frame.dims()==_rvideo.spatial_dims());
+        if (use_nv12()) convert_Nv12_to_Image(aframe->nv12, frame); else frame.assign(aframe->rgb);
+        _free.push(std::move(aframe));
+        return true;
+    }
+    bool read_nv12(Nv12View frame) override {
+        unique_ptr<AsyncFrame> aframe; if (!pop_frame(aframe)) return false;
+        assertx(frame.get_Y().dims()==_rvideo.spatial_dims());
+        if (use_nv12()) {
+            frame.get_Y().assign(aframe->nv12.get_Y()); frame.get_UV().assign(aframe->nv12.get_UV());
+        } else {
+            convert_Image_to_Nv12(aframe->rgb, frame);
+        }
+        _free.push(std::move(aframe));
+        return true;
+    }
+    bool discard_frame() override {
+        unique_ptr<AsyncFrame> aframe; if (!pop_frame(aframe)) return false;
+        _free.push(std::move(aframe));
+        return true;
+    }
+ private:
+    unique_ptr<RVideo::Implementation> _impl;
+    BoundedQueue<unique_ptr<AsyncFrame>> _free;   // buffers available to the decoder thread
+    BoundedQueue<unique_ptr<AsyncFrame>> _filled; // decoded frames in order; closed at end of stream
+    std::exception_ptr _exception;               // set by the decoder thread before closing _filled
+    std::thread _thread;
+    bool use_nv12() const { return _rvideo._use_nv12; }
+    void decode_frames() {
+        try {
+            for (unique_ptr<AsyncFrame> aframe; _free.pop(aframe); ) {
+                if (!(use_nv12() ? _impl->read_nv12(aframe->nv12) : _impl->read(aframe->rgb))) break;
+                if (!_filled.push(std::move(aframe))) break;
+            }
+        }
+        catch (...) {
+            _exception = std::current_exception();
+        }
+        _filled.close();
+    }
+    bool pop_frame(unique_ptr<AsyncFrame>& aframe) {
+        if (_filled.pop(aframe)) return true;
+        if (_exception) std::rethrow_exception(_exception);
+        return false;
+    }
+};
+
+// Encode frames in a background thread from a bounded ring of buffers, so that the pixel conversion and writing
+//  of previous frames overlap the production of the next frame by the caller.
+class Async_WVideo_Implementation : public WVideo::Implementation {
+ public:
+    Async_WVideo_Implementation(WVideo& wvideo, unique_ptr<WVideo::Implementation> impl, int nframes)
+        : WVideo::Implementation(wvideo), _impl(std::move(impl)), _free(nframes+1), _filled(nframes) {
+        for_int(i, nframes+1) {
+            auto frame = make_unique<AsyncFrame>();
+            if (use_nv12()) frame->nv12.init(_wvideo.spatial_dims()); else frame->rgb.init(_wvideo.spatial_dims());
+            assertx(_free.push(std::move(frame)));
+        }
+        _thread = std::thread([this] { encode_frames(); });
+    }
+    ~Async_WVideo_Implementation() {
+        _filled.close();        // the encoder thread finishes writing the queued frames
+        _thread.join();
+        if (_exception) {
+            try {
+                std::rethrow_exception(_exception);
+            }
+            catch (std::exception& ex) {
+                assertnever("Failed to write video: " + string(ex.what()));
+            }
+        }
+    }
+    virtual string name() const override { return "async_" + _impl->name(); }
+    void write(CMatrixView<Pixel> frame) override {
+        assertx(frame.dims()==_wvideo.spatial_dims());
+        unique_ptr<AsyncFrame> aframe = pop_free();
+        if (use_nv12()) convert_Image_to_Nv12(frame, aframe->nv12); else aframe->rgb.assign(frame);
+        if (!_filled.push(std::move(aframe))) rethrow_failure();
+    }
+    void write_nv12(CNv12View frame) override {
+        assertx(frame.get_Y().dims()==_wvideo.spatial_dims());
+        unique_ptr<AsyncFrame> aframe = pop_free();
+        if (use_nv12()) {
+            aframe->nv12.get_Y().assign(frame.get_Y()); aframe->nv12.get_UV().assign(frame.get_UV());
+        } else {
+            convert_Nv12_to_Image(frame, aframe->rgb);
+        }
+        if (!_filled.push(std::move(aframe))) rethrow_failure();
+    }
+ private:
+    unique_ptr<WVideo::Implementation> _impl;
+    BoundedQueue<unique_ptr<AsyncFrame>> _free;   // buffers available to the caller
+    BoundedQueue<unique_ptr<AsyncFrame>> _filled; // frames to encode in order
+    std::exception_ptr _exception;               // set by the encoder thread before closing both queues
+    std::thread _thread;
+    bool use_nv12() const { return _wvideo._use_nv12; }
+    void encode_frames() {
+        try {
+            for (unique_ptr<AsyncFrame> aframe; _filled.pop(aframe); ) {
+                if (use_nv12()) _impl->write_nv12(aframe->nv12); else _impl->write(aframe->rgb);
+                _free.push(std::move(aframe));
+            }
+        }
+        catch (...) {
+            _exception = std::current_exception();
+            _free.close(); _filled.close();
+        }
+    }
+    unique_ptr<AsyncFrame> pop_free() {
+        unique_ptr<AsyncFrame> aframe;
+        if (!_free.pop(aframe)) rethrow_failure();
+        return aframe;
+    }
+    [[noreturn]] void rethrow_failure() { // report the encoder failure once to the caller
+        std::exception_ptr exception = _exception; assertx(exception); _exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+};
+
+
 //----------------------------------------------------------------------------
 
 RVideo::RVideo(const string& filename, bool use_nv12) : _filename(filename), _use_nv12(use_nv12) {
@@ -1172,6 +1334,22 @@ class FF_WVideo_Implementation : public WVideo::Implementation {
 
 //----------------------------------------------------------------------------
 
+namespace {
+
+// The ffmpeg implementations run the codec in a separate process, so the pipe reads/writes and pixel conversions
+//  can move to a background thread.  (The Media Foundation objects are left on the calling thread.)
+unique_ptr<RVideo::Implementation> make_async(RVideo& rvideo, unique_ptr<RVideo::Implementation> impl) {
+    if (!video_async_frames()) return impl;
+    return make_unique<Async_RVideo_Implementation>(rvideo, std::move(impl), video_async_frames());
+}
+
+unique_ptr<WVideo::Implementation> make_async(WVideo& wvideo, unique_ptr<WVideo::Implementation> impl) {
+    if (!video_async_frames()) return impl;
+    return make_unique<Async_WVideo_Implementation>(wvideo, std::move(impl), video_async_frames());
+}
+
+} // namespace
+
 unique_ptr<RVideo::Implementation> RVideo::Implementation::make(RVideo& rvideo) {
     // Notes:
     // - Win7 Media Foundation: For some mp4 files, e.g. ~/data/video/fewpalms.mp4, bitrate is read as 0.
@@ -1179,9 +1357,10 @@ unique_ptr<RVideo::Implementation> RVideo::Implementation::make(RVideo& rvideo)
     string implementation = getenv_string("RVIDEO_IMPLEMENTATION");
     if (implementation=="") implementation = getenv_string("VIDEO_IMPLEMENTATION");
     if (implementation=="MF") return make_unique<MF_RVideo_Implementation>(rvideo);
-    if (implementation=="FF") return make_unique<FF_RVideo_Implementation>(rvideo);
+    if (implementation=="FF") return make_async(rvideo, make_unique<FF_RVideo_Implementation>(rvideo));
     if (implementation!="") throw std::runtime_error("RVideo implementation '" + implementation + "' not recognized");
-    if (FF_RVideo_Implementation::supported()) return make_unique<FF_RVideo_Implementation>(rvideo);
+    if (FF_RVideo_Implementation::supported())
+        return make_async(rvideo, make_unique<FF_RVideo_Implementation>(rvideo));
     if (MF_RVideo_Implementation::supported()) return make_unique<MF_RVideo_Implementation>(rvideo);
     throw std::runtime_error("Video I/O not implemented");
 }
@@ -1194,12 +1373,13 @@ unique_ptr<WVideo::Implementation> WVideo::Implementation::make(WVideo& wvideo)
     string implementation = getenv_string("WVIDEO_IMPLEMENTATION");
     if (implementation=="") implementation = getenv_string("VIDEO_IMPLEMENTATION");
     if (implementation=="MF") return make_unique<MF_WVideo_Implementation>(wvideo);
-    if (implementation=="FF") return make_unique<FF_WVideo_Implementation>(wvideo);
+    if (implementation=="FF") return make_async(wvideo, make_unique<FF_WVideo_Implementation>(wvideo));
     if (implementation!="") throw std::runtime_error("WVideo implementation '" + implementation + "' not recognized");
     // Prefer ffmpeg, but revert to Windows Media Foundation (if available) for *.wmv output (using VC1 encoder).
     if (wvideo._attrib.suffix=="wmv" && MF_WVideo_Implementation::supported())
         return make_unique<MF_WVideo_Implementation>(wvideo);
-    if (FF_WVideo_Implementation::supported()) return make_unique<FF_WVideo_Implementation>(wvideo);
+    if (FF_WVideo_Implementation::supported())
+        return make_async(wvideo, make_unique<FF_WVideo_Implementation>(wvideo));
     if (MF_WVideo_Implementation::supported()) return make_unique<MF_WVideo_Implementation>(wvideo);
     throw std::runtime_error("Video I/O not implemented");
 }
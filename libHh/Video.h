@@ -141,6 +141,7 @@ VideoNv12 scale(const VideoNv12& video_nv12, const Vec2<float>& syx, const Vec2<
                 const Pixel* bordervalue = nullptr, VideoNv12&& pnewvideo_nv12 = VideoNv12());
 
 // Read a video stream one image frame at a time.  getenv_string("VIDEO_IMPLEMENTATION") may set FF or MF.
+// With FF, a background thread decodes up to getenv_int("VIDEO_ASYNC_FRAMES") (default 2, 0 disables) frames ahead.
 class RVideo {
  public:
     explicit RVideo(const string& filename, bool use_nv12 = false); // may throw std::runtime_error
@@ -164,9 +165,12 @@ class RVideo {
     unique_ptr<Implementation> _impl;
     friend class MF_RVideo_Implementation;
     friend class FF_RVideo_Implementation;
+    friend class Async_RVideo_Implementation;
 };
 
 // Write a video stream one image frame at a time.  getenv_string("VIDEO_IMPLEMENTATION") may set FF or MF.
+// With FF, write() copies the frame and a background thread encodes up to getenv_int("VIDEO_ASYNC_FRAMES") frames
+//  behind; the stream is complete once the object is destroyed.
 class WVideo {
  public:
     explicit WVideo(const string& filename, const Vec2<int>& spatial_dims, const Video::Attrib& attrib,
@@ -188,6 +192,7 @@ class WVideo {
     unique_ptr<Implementation> _impl;
     friend class MF_WVideo_Implementation;
     friend class FF_WVideo_Implementation;
+    friend class Async_WVideo_Implementation;
 };
 
 
@@ -0,0 +1,51 @@
+// -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
+#include "BoundedQueue.h"
+#include "Array.h"
+
+#include <thread>
+
+using namespace hh;
+
+int main() {
+    {
+        BoundedQueue<int> q(3);
+        assertx(q.push(1) && q.push(2));
+        int i; assertx(q.pop(i) && i==1);
+        q.close();
+        assertx(!q.push(3));
+        assertx(q.pop(i) && i==2);  // remaining elements are still delivered after close()
+        assertx(!q.pop(i));
+    }
+    {
+        // The producer is throttled by the small capacity; the consumer receives all elements in order.
+        const int n = 10000;
+        BoundedQueue<Array<int>> q(2);
+        std::thread producer([&] {
+            for_int(i, n) { assertx(q.push(Array<int>(1, i))); }
+            q.close();
+        });
+        int sum = 0, expected = 0;
+        for (Array<int> ar; q.pop(ar); ) {
+            assertx(ar.num()==1 && ar[0]==expected++);
+            sum += ar[0];
+        }
+        producer.join();
+        SHOW(expected, sum);
+    }
+    {
+        // A consumer that stops early closes the queue to release a blocked producer.
+        BoundedQueue<unique_ptr<int>> q(1);
+        int num_pushed = 0;
+        std::thread producer([&] {
+            for (;;) {
+                if (!q.push(make_unique<int>(num_pushed))) break;
+                num_pushed++;
+            }
+        });
+        unique_ptr<int> up;
+        for_int(i, 5) { assertx(q.pop(up) && *up==i); }
+        q.close();
+        producer.join();
+        assertx(num_pushed>=5 && num_pushed<=6);
+    }
+}
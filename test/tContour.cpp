@@ -96,6 +96,100 @@ void testmesh() {
     mesh.write(fmesh());
 }
 
+// Same surface as the serial Contour3DMesh, although vertices and faces are created in a different order.
+template<typename Eval> void compare_parallel(int gn, const Point& startp, Eval eval) {
+    auto sorted_points = [](const GMesh& mesh) {
+        Array<Point> ar; for (Vertex v : mesh.vertices()) ar.push(mesh.point(v));
+        sort(ar, [](const Point& p1, const Point& p2) {
+            return p1[0]<p2[0] || (p1[0]==p2[0] && (p1[1]<p2[1] || (p1[1]==p2[1] && p1[2]<p2[2])));
+        });
+        return ar;
+    };
+    for (bool big_faces : {false, true}) {
+        GMesh mesh1; {
+            Contour3DMesh<Eval> contour(gn, &mesh1, eval);
+            contour.set_ostream(nullptr);
+            if (big_faces) contour.big_mesh_faces();
+            contour.set_vertex_tolerance(1e-4f);
+            contour.march_near(startp);
+        }
+        GMesh mesh2; {
+            Contour3DMeshParallel<Eval> contour(gn, &mesh2, eval);
+            if (!big_faces) contour.set_ostream(nullptr);
+            if (big_faces) contour.big_mesh_faces();
+            contour.set_vertex_tolerance(1e-4f);
+            contour.march_near(startp);
+            assertx(contour.march_from(startp)==0);
+        }
+        assertx(mesh2.num_vertices()==mesh1.num_vertices() && mesh2.num_faces()==mesh1.num_faces());
+        // (With triangulated faces, the centers introduced by center_split_face() may differ in rounding.)
+        if (big_faces) assertx(sorted_points(mesh2)==sorted_points(mesh1));
+        SHOW(gn, big_faces, mesh2.num_vertices(), mesh2.num_faces());
+    }
+}
+
+// Same function, with batch evaluation of points.
+struct feval3D_batch : feval3D {
+    using feval3D::operator();
+    void operator()(CArrayView<Vec3<float>> points, ArrayView<float> values) const {
+        assertx(points.num()==values.num());
+        for_int(i, points.num()) { values[i] = feval3D::operator()(points[i]); }
+    }
+};
+
+void testparallel() {
+    compare_parallel(10, Point(.35f, .3f, .3f), feval3D());
+    compare_parallel(10, Point(.35f, .3f, .3f), feval3D_batch());
+    auto func_sphere = [](const Vec3<float>& p) { return dist(p, V(.5f, .5f, .5f))-.4f; };
+    compare_parallel(100, Point(.9f, .5f, .5f), func_sphere);
+    // A small sphere in a grid exceeding 1024^3 cubes.
+    auto func_small_sphere = [](const Vec3<float>& p) { return dist(p, V(.7f, .3f, .55f))-.003f; };
+    compare_parallel(2000, Point(.703f, .3f, .55f), func_small_sphere);
+}
+
+// Signed volume enclosed by a closed triangle mesh.
+float mesh_volume(const GMesh& mesh) {
+    double vol = 0.;
+    for (Face f : mesh.faces()) {
+        Vec3<Vertex> va; mesh.triangle_vertices(f, va);
+        Vec3<Vector> vv = map(va, [&](Vertex v) { return to_Vector(mesh.point(v)); });
+        vol += dot(cross(vv[0], vv[1]), vv[2])/6.;
+    }
+    return float(vol);
+}
+
+void testoctree() {
+    // A torus about a small sphere: two closed components, with total genus 1.
+    auto func_torus_sphere = [](const Vec3<float>& p) {
+        Vector v = p-Point(.5f, .5f, .5f);
+        float dt = sqrt(square(sqrt(square(v[0])+square(v[1]))-.25f)+square(v[2]))-.08f;
+        float ds = mag(v)-.1f;
+        return min(dt, ds);
+    };
+    Array<Vec3<float>> points;          // samples near the surface
+    for_int(i, 100) for_int(j, 100) for_int(k, 30) {
+        Vec3<float> p((i+.5f)/100.f, (j+.5f)/100.f, .35f+k/100.f);
+        if (abs(func_torus_sphere(p))<.006f) points.push(p);
+    }
+    GMesh mesh1; {
+        Contour3DMesh<decltype(func_torus_sphere)> contour(128, &mesh1, func_torus_sphere);
+        contour.set_ostream(nullptr);
+        for (const Point& p : points) contour.march_from(p);
+    }
+    SHOW(mesh1.num_faces(), mesh_genus_string(mesh1));
+    for (float tol : {0.f, .0005f, .005f}) {
+        GMesh mesh; {
+            Contour3DOctree<decltype(func_torus_sphere)> contour(7, &mesh, func_torus_sphere);
+            contour.set_ostream(nullptr);
+            contour.set_min_level(3);
+            contour.set_flatness_tolerance(tol);
+            contour.contour_near(points, .02f);
+        }
+        SHOW(tol, mesh.num_faces(), mesh_genus_string(mesh));
+        assertx(mesh.is_nice());
+        assertx(abs(mesh_volume(mesh)/mesh_volume(mesh1)-1.f)<.1f); // also verifies the orientation
+    }
+}
 
 struct fmonkey {
     float operator()(const Point& p) const {
@@ -168,6 +262,8 @@ int main() {
         do_densemonkey();
     } else {
         testmesh();
+        testparallel();
+        testoctree();
         test2D();
         test3D();
     }
@@ -1,5 +1,6 @@
 // -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
 #include "GMesh.h"
+#include "FileIO.h"
 using namespace hh;
 
 namespace {
@@ -89,4 +90,26 @@ int main() {
         // The mesh faces are destroyed in a non-sorted order.
         SHOW(sum_destruct);
     }
+    {
+        // A memory-mapped file is parsed in place; compare with reading the same file through a pipe.
+        GMesh mesh1; { RFile fi("tGMesh.inp"); mesh1.read(fi()); assertx(fi.is_mapped()); }
+        GMesh mesh2; { RFile fi("cat tGMesh.inp |"); mesh2.read(fi()); assertx(!fi.is_mapped()); }
+        std::ostringstream oss1; mesh1.write(oss1);
+        std::ostringstream oss2; mesh2.write(oss2);
+        assertx(oss1.str()==oss2.str());
+        // If the FILE is accessed first, the file is not mapped and the stream continues from the FILE position.
+        GMesh mesh4; {
+            RFile fi("tGMesh.inp");
+            int ch = getc(fi.cfile()); assertx(ch!=EOF); assertx(ungetc(ch, fi.cfile())==ch);
+            mesh4.read(fi()); assertx(!fi.is_mapped());
+        }
+        std::ostringstream oss4; mesh4.write(oss4);
+        assertx(oss4.str()==oss1.str());
+        SHOW(mesh1.num_vertices(), mesh1.num_faces());
+        // The last line of a mapped file need not be terminated.
+        TmpFile tmpfile(".m");
+        { WFile fo(tmpfile.filename()); fo() << "Vertex 1  1 2 3\nVertex 2  4 5 6 {tag}"; }
+        GMesh mesh3; { RFile fi(tmpfile.filename()); mesh3.read(fi()); assertx(fi.is_mapped()); }
+        SHOW(mesh3.point(mesh3.id_vertex(2)), mesh3.get_string(mesh3.id_vertex(2)));
+    }
 }
@@ -92,11 +92,45 @@ void do_points() {
     show_graph(gkcl, true);
 }
 
+void do_parallel() {
+    SHOW("do_parallel");
+    // Grid graph with pseudo-random edge costs, large enough that the edges get partitioned.
+    const int n = 60;
+    Graph<int> g;
+    for_int(i, n*n) { g.enter(i); }
+    for_int(y, n) for_int(x, n) {
+        int i = y*n+x;
+        if (x+1<n) g.enter_undirected(i, i+1);
+        if (y+1<n) g.enter_undirected(i, i+n);
+    }
+    auto fcost = [](int v1, int v2) { return float((min(v1, v2)*7919+max(v1, v2)*104729)%10007); };
+    auto tree_cost = [&](const Graph<int>& gt) {
+        double cost = 0.; for (int i : gt.vertices()) for (int j : gt.edges(i)) { if (i<j) cost += fcost(i, j); }
+        return cost;
+    };
+    Graph<int> gmst = graph_mst(g, fcost);
+    Graph<int> gpmst; for_int(i, n*n) { gpmst.enter(i); }
+    assertx(graph_mst_parallel(g, fcost, gpmst));
+    SHOW(tree_cost(gmst), tree_cost(gpmst));
+    assertx(tree_cost(gpmst)==tree_cost(gmst));
+    // Orientations s[v]; the dot product between adjacent vertices has sign s[v1]*s[v2].
+    auto fsign = [](int v) { return v%3==0 ? -1.f : 1.f; };
+    auto fdot = [&](int v1, int v2) { return fsign(v1)*fsign(v2)*(1.f+float((v1+v2)%5)); };
+    Array<int> parent; Array<float> dots; Array<bool> flip;
+    Array<int> order = graph_propagate_orientation(gpmst, 5, fdot, parent, dots, flip);
+    SHOW(order.num(), order[0], parent[0]);
+    for_int(i, order.num()) {
+        assertx(flip[i]==(fsign(order[i])!=fsign(order[0])));
+        if (i) assertx(parent[i]<i && gpmst.contains(order[parent[i]], order[i]));
+    }
+}
+
 } // namespace
 
 int main() {
     do_ints();
     do_points();
+    do_parallel();
 }
 
 template class hh::Dijkstra<int,fdist>;
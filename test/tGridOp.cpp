@@ -1,5 +1,6 @@
 // -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
 #include "GridOp.h"
+#include "GridPixelOp.h"         // scale_Matrix_Pixel()
 #include "MatrixOp.h"
 #include "Filter.h"
 #include "RangeOp.h"
@@ -118,6 +119,155 @@ int main() {
         test(V(2, 1, 5, 3), V(1, 2, 1, 4));
         SHOW("end test");
     }
+    {                           // scale_Matrix_Pixel() matches scaling of Matrix<Vector4>
+        Matrix<Pixel> matrixp(V(23, 37));
+        for (Pixel& pix : matrixp) for_int(z, 4) { pix[z] = uchar(Random::G.get_unsigned(256)); }
+        const Pixel bordervalue(10, 200, 30, 255);
+        Vector4 vborder(bordervalue);
+        for (string sfilter : {"impulse", "box", "triangle", "quadratic", "mitchell", "keys", "lanczos6", "spline",
+                               "omoms"}) {
+            int max_diff = 0, max_diff_border = 0;
+            for (Bndrule bndrule : {Bndrule::reflected, Bndrule::periodic, Bndrule::clamped, Bndrule::border}) {
+                // Inverse convolution does not support the clamped and border boundary rules.
+                if (Filter::get(sfilter).has_inv_convolution() &&
+                    (bndrule==Bndrule::clamped || bndrule==Bndrule::border)) continue;
+                Vec2<FilterBnd> filterbs = twice(FilterBnd(Filter::get(sfilter), bndrule));
+                for (auto ndims : {V(23, 29), V(41, 37), V(9, 80), V(50, 11), V(7, 5), V(23, 37), V(1, 1)}) {
+                    Matrix<Pixel> nmatrixp(ndims);
+                    scale_Matrix_Pixel(matrixp, filterbs, &bordervalue, nmatrixp);
+                    Matrix<Vector4> matrix(matrixp.dims()); convert(matrixp, matrix);
+                    matrix = scale(matrix, ndims, filterbs, &vborder, std::move(matrix));
+                    Matrix<Pixel> nmatrixp2(ndims); convert(matrix, nmatrixp2);
+                    int& mdiff = bndrule==Bndrule::border ? max_diff_border : max_diff;
+                    for_int(i, nmatrixp.size()) for_int(z, 4) {
+                        mdiff = max(mdiff, abs(nmatrixp.raster(i)[z]-nmatrixp2.raster(i)[z]));
+                    }
+                }
+            }
+            SHOW(sfilter, max_diff, max_diff_border);
+            assertx(max_diff==0 && max_diff_border==0);
+        }
+        if (getenv_bool("SHOW_TIMES")) { // throughput benchmark
+            Matrix<Pixel> matrixp2(V(1000, 1500));
+            for (Pixel& pix : matrixp2) for_int(z, 4) { pix[z] = uchar(Random::G.get_unsigned(256)); }
+            for (string sfilter : {"triangle", "keys", "lanczos6", "spline"}) {
+                Vec2<FilterBnd> filterbs = twice(FilterBnd(Filter::get(sfilter), Bndrule::reflected));
+                for (float s : {.37f, 1.7f}) {
+                    Matrix<Pixel> nmatrixp(convert<int>(convert<float>(matrixp2.dims())*s));
+                    const double mpixels = max(matrixp2.size(), nmatrixp.size())*1e-6;
+                    Timer timer;
+                    scale_Matrix_Pixel(matrixp2, filterbs, nullptr, nmatrixp);
+                    timer.stop();
+                    Timer timer2;
+                    Matrix<Vector4> matrix(matrixp2.dims()); convert(matrixp2, matrix);
+                    matrix = scale(matrix, nmatrixp.dims(), filterbs, implicit_cast<Vector4*>(nullptr), std::move(matrix));
+                    convert(matrix, nmatrixp);
+                    timer2.stop();
+                    showf("scale %-8s %4.2f: %6.1f MP/s (Matrix<Vector4>: %6.1f MP/s)\n", sfilter.c_str(), s,
+                          mpixels/max(timer.real(), 1e-6), mpixels/max(timer2.real(), 1e-6));
+                }
+            }
+        }
+    }
+    {                           // box_blur_d() approximates convolution with a Gaussian kernel
+        auto gaussian_kernel = [](float sdv) {
+            const int r = int(3.f*sdv+.5f);
+            Array<float> kernel(2*r+1); for_int(i, 2*r+1) { kernel[i] = gaussian(float(i-r), sdv); }
+            kernel /= float(sum(kernel));
+            return kernel;
+        };
+        for (float sdv : {1.f, 2.5f, 8.f, 30.f}) {
+            Array<int> radii = gaussian_box_radii(sdv);
+            float variance = 0.f; for (int r : radii) variance += (square(2.f*r+1.f)-1.f)/12.f;
+            SHOW(sdv, radii);
+            assertx(abs(std::sqrt(variance)-sdv)<.3f);
+        }
+        Matrix<Pixel> matrixp(V(61, 47));
+        for_coords(matrixp.dims(), [&](const Vec2<int>& yx) {
+            for_int(z, 3) matrixp[yx][z] = uchar(128.f+100.f*std::sin(yx[0]*.1f*(z+1))*std::cos(yx[1]*.13f));
+            matrixp[yx][3] = 255;
+        });
+        for (float sdv : {1.f, 3.f, 6.f}) {
+            Grid<2,Pixel> grid1(matrixp), grid2(matrixp);
+            for_int(d, 2) {
+                grid1 = box_blur_d(grid1, d, sdv, Bndrule::reflected);
+                grid2 = convolve_d(grid2, d, gaussian_kernel(sdv), Bndrule::reflected);
+            }
+            int max_diff = 0; for_int(i, grid1.size()) for_int(z, 4) {
+                max_diff = max(max_diff, abs(grid1.raster(i)[z]-grid2.raster(i)[z]));
+            }
+            assertx(max_diff<=3);
+        }
+        {
+            const Pixel pix(10, 120, 250, 255);
+            Grid<3,Pixel> grid(V(4, 9, 7), pix);
+            for_int(d, 3) {   // a constant grid is preserved
+                Grid<3,Pixel> grid2 = box_blur_d(grid, d, 20.f, Bndrule::reflected);
+                assertx(grid2.array_view()==grid.array_view());
+            }
+            const Pixel bordervalue(0, 0, 0, 255);
+            Grid<3,Pixel> grid3 = box_blur_d(grid, 1, 2.f, Bndrule::border, &bordervalue);
+            assertx(grid3[1][4][3]==pix && grid3[1][0][3][2]<pix[2]);
+        }
+        if (getenv_bool("SHOW_TIMES")) { // throughput benchmark: cost of box_blur_d() is independent of sdv
+            Matrix<Pixel> matrixp2(V(2000, 2000));
+            for (Pixel& pix : matrixp2) for_int(z, 4) { pix[z] = uchar(Random::G.get_unsigned(256)); }
+            for (float sdv : {1.f, 4.f, 16.f, 64.f}) {
+                Grid<2,Pixel> grid1(matrixp2), grid2(matrixp2);
+                Timer timer1; for_int(d, 2) grid1 = box_blur_d(grid1, d, sdv, Bndrule::reflected); timer1.stop();
+                Timer timer2;
+                for_int(d, 2) grid2 = convolve_d(grid2, d, gaussian_kernel(sdv), Bndrule::reflected);
+                timer2.stop();
+                showf("blur sdv=%-4g: box_blur_d %6.1f MP/s (convolve_d: %6.1f MP/s)\n", sdv,
+                      matrixp2.size()*1e-6/max(timer1.real(), 1e-6), matrixp2.size()*1e-6/max(timer2.real(), 1e-6));
+            }
+        }
+    }
+    {                           // euclidean_distance_transform() is exact and improves on euclidean_distance_map()
+        Random::G.seed(5);
+        Grid<2,bool> grid_feature(V(53, 71), false);
+        for_int(i, 30) { grid_feature[Random::G.get_unsigned(53)][Random::G.get_unsigned(71)] = true; }
+        Grid<2,float> grid_dist;
+        Grid<2,Vec2<int>> grid_offset = euclidean_distance_transform<2>(grid_feature, &grid_dist);
+        Matrix<Vec2<int>> mvec(grid_feature.dims(), grid_feature.dims());
+        for (const auto& yx : range(grid_feature.dims())) { if (grid_feature[yx]) mvec[yx] = V(0, 0); }
+        euclidean_distance_map(mvec);
+        int num_improved = 0;
+        for (const auto& yx : range(grid_feature.dims())) {
+            int64_t dist2 = std::numeric_limits<int64_t>::max();
+            for (const auto& yx2 : range(grid_feature.dims())) {
+                if (grid_feature[yx2]) dist2 = min(dist2, mag2(yx2-yx));
+            }
+            assertx(grid_feature[yx+grid_offset[yx]] && mag2(grid_offset[yx])==dist2);
+            assertx(abs(grid_dist[yx]-std::sqrt(float(dist2)))<1e-5f);
+            assertx(mag2(mvec[yx])>=dist2);
+            num_improved += mag2(mvec[yx])>dist2;
+        }
+        SHOW(num_improved);
+        Grid<3,bool> grid3(V(9, 12, 10), false);
+        grid3[2][3][4] = grid3[8][0][9] = grid3[5][11][1] = true;
+        Grid<3,Vec3<int>> grid3_offset = euclidean_distance_transform<3>(grid3);
+        for (const auto& u : range(grid3.dims())) {
+            int64_t dist2 = std::numeric_limits<int64_t>::max();
+            for (const auto& u2 : range(grid3.dims())) { if (grid3[u2]) dist2 = min(dist2, mag2(u2-u)); }
+            assertx(grid3[u+grid3_offset[u]] && mag2(grid3_offset[u])==dist2);
+        }
+        Grid<2,bool> grid_empty(V(3, 4), false);
+        assertx(euclidean_distance_transform<2>(grid_empty)[2][1]==grid_empty.dims());
+        if (getenv_bool("SHOW_TIMES")) {
+            const int n = 4000;
+            Grid<2,bool> grid_big(V(n, n), false);
+            for_int(i, 1000) { grid_big[Random::G.get_unsigned(n)][Random::G.get_unsigned(n)] = true; }
+            Timer timer1; Grid<2,Vec2<int>> grid_big_offset = euclidean_distance_transform<2>(grid_big);
+            timer1.stop();
+            Timer timer2;
+            Matrix<Vec2<int>> mvec_big(grid_big.dims(), grid_big.dims());
+            for (const auto& yx : range(grid_big.dims())) { if (grid_big[yx]) mvec_big[yx] = V(0, 0); }
+            euclidean_distance_map(mvec_big); timer2.stop();
+            showf("edt %dx%d: euclidean_distance_transform %.3fs (euclidean_distance_map: %.3fs)\n", n, n,
+                  timer1.real(), timer2.real());
+        }
+    }
     {                           // scaling of Grid<2,T> matches scaling of Matrix<2,T>; no longer applicable
         int cy = 13, cx = 17;
         int ny = 16, nx = 11;
@@ -1,6 +1,8 @@
 // -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
 #include "Image.h"
 #include "Stat.h"
+#include "Random.h"
+#include "Timer.h"
 using namespace hh;
 
 
@@ -25,4 +27,42 @@ int main() {
             SHOW(newgrid.dims());
         }
     }
+    {
+        // The vectorized conversions between NV12 and RGBA are bit-identical to the scalar formulas.
+        for (const Vec2<int>& dims : {V(2, 2), V(4, 14), V(10, 16), V(34, 46), V(64, 62)}) {
+            Nv12 nv12(dims);
+            for (uchar& e : nv12.get_Y()) e = uchar(Random::G.get_unsigned(256));
+            for (Vec2<uchar>& e : nv12.get_UV()) for_int(c, 2) e[c] = uchar(Random::G.get_unsigned(256));
+            Matrix<Pixel> frame(dims), frame_bgra(dims);
+            convert_Nv12_to_Image(nv12, frame);
+            convert_Nv12_to_Image_BGRA(nv12, frame_bgra);
+            for_coords(dims, [&](const Vec2<int>& yx) {
+                const Vec2<uchar>& uv = nv12.get_UV()[yx/2];
+                const Pixel pix = YUV_to_RGB_Pixel(nv12.get_Y()[yx], uv[0], uv[1]);
+                assertx(frame[yx]==pix);
+                assertx(frame_bgra[yx]==Pixel(pix[2], pix[1], pix[0], pix[3]));
+            });
+            for (Pixel& pix : frame) for_int(z, 4) pix[z] = uchar(Random::G.get_unsigned(256));
+            convert_Image_to_Nv12(frame, nv12);
+            for_coords(dims, [&](const Vec2<int>& yx) { assertx(nv12.get_Y()[yx]==RGB_to_Y(frame[yx])); });
+            for_coords(nv12.get_UV().dims(), [&](const Vec2<int>& yx) {
+                Vec3<int> sum(0, 0, 0);
+                for_int(dy, 2) for_int(dx, 2) for_int(z, 3) sum[z] += frame[yx*2+V(dy, dx)][z];
+                assertx(nv12.get_UV()[yx][0]==((-38*sum[0] - 74*sum[1] + 112*sum[2] + 128*4 + 128*1024) >> 10));
+                assertx(nv12.get_UV()[yx][1]==((112*sum[0] - 94*sum[1] -  18*sum[2] + 128*4 + 128*1024) >> 10));
+            });
+        }
+        if (getenv_bool("SHOW_TIMES")) {
+            for (const Vec2<int>& dims : {V(1080, 1920), V(2160, 3840)}) {
+                Matrix<Pixel> frame(dims);
+                for (Pixel& pix : frame) for_int(z, 4) pix[z] = uchar(Random::G.get_unsigned(256));
+                Nv12 nv12(dims);
+                const int nframes = 20;
+                Timer timer1; for_int(i, nframes) { convert_Image_to_Nv12(frame, nv12); } timer1.stop();
+                Timer timer2; for_int(i, nframes) { convert_Nv12_to_Image(nv12, frame); } timer2.stop();
+                showf("%dx%d: to_Nv12 %.2f ms/frame, to_Image %.2f ms/frame\n", dims[1], dims[0],
+                      timer1.real()/nframes*1e3, timer2.real()/nframes*1e3);
+            }
+        }
+    }
 }
@@ -0,0 +1,76 @@
+// -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
+#include "ImageRows.h"
+#include "ConsoleProgress.h"
+using namespace hh;
+
+namespace {
+
+// Write image in strips of nrows rows.
+void write_in_strips(const Image& image, const string& filename, int nrows) {
+    WImageRows wimage(filename, image.dims(), image.zsize());
+    for (int y = 0; y<image.ysize(); y += nrows) {
+        wimage.write_rows(image.slice(y, min(y+nrows, image.ysize())));
+    }
+    wimage.finish();
+}
+
+// Read image in strips of nrows rows.
+Image read_in_strips(const string& filename, int nrows) {
+    RImageRows rimage(filename);
+    Image image(rimage.dims()); image.set_zsize(rimage.zsize()); image.set_suffix(rimage.suffix());
+    for (int y = 0; y<image.ysize(); y += nrows) {
+        rimage.read_rows(image.slice(y, min(y+nrows, image.ysize())));
+    }
+    return image;
+}
+
+bool same_pixels(CMatrixView<Pixel> m1, CMatrixView<Pixel> m2) {
+    return same_size(m1, m2) && m1.array_view()==m2.array_view();
+}
+
+} // namespace
+
+int main() {
+    ConsoleProgress::set_all_silent(true);
+    Image image(V(37, 53));
+    for_int(y, image.ysize()) for_int(x, image.xsize()) {
+        image[y][x] = Pixel(narrow_cast<uchar>(y*6), narrow_cast<uchar>(x*4), narrow_cast<uchar>((x*y)%256), 255);
+    }
+    for (string suffix : {"rawimage", "ppm", "png", "jpg"}) {
+        string filename = "tImageRows." + suffix;
+        write_in_strips(image, filename, 5);
+        Image image1; image1.read_file(filename);          // whole image
+        Image image2 = read_in_strips(filename, 7);
+        bool lossless = suffix!="jpg";
+        SHOW(suffix, image1.dims(), image1.zsize(), image2.suffix());
+        if (lossless) assertx(same_pixels(image1, image));
+        assertx(image2.zsize()==image1.zsize());
+        assertx(same_pixels(image2, image1));
+        HH_POSIX(unlink)(filename.c_str());
+    }
+    {
+        // The row interface also applies to the image formats that are not streamed.
+        Image image1(image); image1.set_zsize(1);
+        for_int(y, image1.ysize()) for_int(x, image1.xsize()) {
+            uchar v = image[y][x][0]; image1[y][x] = Pixel(v, v, v, 255);
+        }
+        image1.write_file("tImageRows.bmp");
+        Image image2 = read_in_strips("tImageRows.bmp", 10);
+        SHOW(image2.dims(), image2.zsize(), image2.suffix());
+        assertx(same_pixels(image2, image1));
+        HH_POSIX(unlink)("tImageRows.bmp");
+    }
+    for (string suffix : {"png", "jpg"}) {
+        // An exception thrown while writing must not terminate the program; the file is left incomplete.
+        string filename = "tImageRows." + suffix;
+        try {
+            WImageRows wimage(filename, image.dims(), image.zsize());
+            wimage.write_rows(image.slice(0, 10));
+            throw std::runtime_error("abort writing " + suffix);
+        }
+        catch (const std::runtime_error& ex) {
+            SHOW(ex.what());
+        }
+        HH_POSIX(unlink)(filename.c_str());
+    }
+}
@@ -4,6 +4,7 @@
 #include "Random.h"
 #include "MatrixOp.h"           // identity_mat()
 #include "Stat.h"
+#include "Timer.h"
 using namespace hh;
 
 static unique_ptr<LLS> make_lls(int c, int m, int n, int nd) {
@@ -13,9 +14,34 @@ static unique_ptr<LLS> make_lls(int c, int m, int n, int nd) {
     if (c==3) return make_unique<SvdLLS>(m, n, nd);
     if (c==4) return make_unique<SvdDoubleLLS>(m, n, nd);
     if (c==5) return make_unique<QrdLLS>(m, n, nd);
+    if (c==6) { auto up_lls = make_unique<SparseLLS>(m, n, nd); up_lls->set_direct(true); return std::move(up_lls); }
     assertnever("");
 }
 
+// Screened Poisson system on a gn*gn grid: finite-difference gradient constraints plus weak value constraints.
+static void enter_poisson(SparseLLS& lls, int gn, int nd) {
+    int r = 0;
+    auto f = [&](int y, int x, int d) { return float(std::sin(.05*(x+d*7))+std::cos(.03*y*(d+1))); };
+    for_int(y, gn) for_int(x, gn) {
+        int i = y*gn+x;
+        if (x+1<gn) {
+            lls.enter_a_rc(r, i, -1.f); lls.enter_a_rc(r, i+1, 1.f);
+            for_int(d, nd) { lls.enter_b_rc(r, d, f(y, x+1, d)-f(y, x, d)); }
+            r++;
+        }
+        if (y+1<gn) {
+            lls.enter_a_rc(r, i, -1.f); lls.enter_a_rc(r, i+gn, 1.f);
+            for_int(d, nd) { lls.enter_b_rc(r, d, f(y+1, x, d)-f(y, x, d)); }
+            r++;
+        }
+        const float wvalue = (x+y)%5==0 ? 1.f : .01f;
+        lls.enter_a_rc(r, i, wvalue);
+        for_int(d, nd) { lls.enter_b_rc(r, d, wvalue*f(y, x, d)); }
+        r++;
+    }
+    assertx(r==lls.num_rows());
+}
+
 int main() {
     {
         SvdLLS lls(1, 1, 1);
@@ -87,7 +113,7 @@ int main() {
             b[i] = float(abs(i-4));
             // SHOW(b[i]);
         }
-        for_int(c, 6) {
+        for_int(c, 7) {
             SHOW(c);
             const int nd = 2;
             auto up_lls = make_lls(c, n, n, nd); LLS& lls = *up_lls;
@@ -104,7 +130,7 @@ int main() {
         }
     }
     {
-        for_int(c, 6) {
+        for_int(c, 7) {
             SHOW(c);
             auto up_lls = make_lls(c, 2, 1, 1); LLS& lls = *up_lls;
             lls.enter_a_rc(0, 0, 1.f);
@@ -117,7 +143,7 @@ int main() {
         }
     }
     {
-        for_int(c, 6) {
+        for_int(c, 7) {
             SHOW(c);
             auto up_lls = make_lls(c, 3, 2, 1); LLS& lls = *up_lls;
             lls.enter_a_rc(0, 0, 1.f);
@@ -136,6 +162,49 @@ int main() {
             SHOW(round_fraction_digits(lls.get_x_rc(1, 0)));
         }
     }
+    {
+        // Compare the iterative and direct sparse solvers.
+        const int gn = 128, n = gn*gn, m = 2*gn*(gn-1)+n, nd = 3;
+        Matrix<float> x_cg(n, nd), x_direct(n, nd);
+        int num_iter;
+        {
+            HH_PTIMER(_sparse_cg);
+            SparseLLS lls(m, n, nd);
+            enter_poisson(lls, gn, nd);
+            lls.set_tolerance(1e-8f);
+            assertx(lls.solve());
+            lls.get_x(x_cg);
+            num_iter = lls.num_iter();
+        }
+        {
+            HH_PTIMER(_sparse_direct);
+            SparseLLS lls(m, n, nd);
+            enter_poisson(lls, gn, nd);
+            lls.set_direct(true);
+            assertx(lls.solve());
+            lls.get_x(x_direct);
+        }
+        float maxerr = Stat(x_cg-x_direct).max_abs();
+        if (getenv_bool("SHOW_TIMES")) SHOW(num_iter, maxerr);
+        assertx(maxerr<1e-3f);
+    }
+    {
+        // Rows entered as CSR blocks (same system as above), in a solver reused after clear().
+        SparseLLS::Csr block0, block1;
+        block0._start = {0, 2, 3}; block0._index = {0, 1, 0}; block0._value = {1.f, 1.f, 1.f};
+        block1._start = {0, 1}; block1._index = {1}; block1._value = {1.f};
+        SparseLLS lls(3, 2, 1);
+        for_int(iter, 2) {
+            lls.clear();
+            lls.enter_a_rows(0, block0);
+            lls.enter_a_rows(2, block1);
+            lls.enter_b_rc(0, 0, 10.f);
+            lls.enter_b_rc(1, 0, 2.f);
+            lls.enter_b_rc(2, 0, 12.f);
+            assertx(lls.solve());
+            SHOW(round_fraction_digits(lls.get_x_rc(0, 0)), round_fraction_digits(lls.get_x_rc(1, 0)));
+        }
+    }
     {
         using Real = float;
         for_int(imode, 2) {
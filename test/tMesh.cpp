@@ -1,6 +1,9 @@
 // -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
 #include "Mesh.h"
 #include "Array.h"
+
+#include <thread>
+
 using namespace hh;
 
 namespace {
@@ -21,6 +24,24 @@ void show_mesh(const Mesh& mesh) {
     SHOW("  } EndFaces\n} EndMesh");
 }
 
+// Create a triangulated grid of n*n vertices, collapse some of its edges, and return a summary of the result.
+Vec3<int> build_and_simplify(Mesh& mesh, int n) {
+    Array<Vertex> va; for_int(i, n*n) { va.push(mesh.create_vertex()); }
+    for_int(y, n-1) for_int(x, n-1) {
+        Vertex v00 = va[y*n+x], v01 = va[y*n+x+1], v10 = va[(y+1)*n+x], v11 = va[(y+1)*n+x+1];
+        mesh.create_face(v00, v01, v11);
+        mesh.create_face(v00, v11, v10);
+    }
+    for_int(i, n*n/4) {
+        Vertex v = mesh.id_retrieve_vertex(4*i+1);
+        if (!v) continue;
+        for (Edge e : mesh.edges(v)) {
+            if (mesh.nice_edge_collapse(e)) { mesh.collapse_edge(e); break; }
+        }
+    }
+    return V(mesh.num_vertices(), mesh.num_faces(), mesh.num_edges());
+}
+
 } // namespace
 
 int main() {
@@ -183,5 +204,24 @@ int main() {
         Face f = mesh.create_face(va);
         for (Face ff : mesh.faces(f)) { dummy_use(ff); if (1) assertnever(""); }
     }
+    {
+        // Meshes (some using arena allocation) are built and modified concurrently on separate threads.
+        const int nthreads = 8, n = 60;
+        Array<Vec3<int>> results(nthreads);
+        Array<std::thread> threads;
+        for_int(i, nthreads) {
+            threads.push(std::thread([&results, i] {
+                for_int(iter, 3) {
+                    Mesh mesh2;
+                    mesh2.set_arena_allocation(i%2==1);
+                    results[i] = build_and_simplify(mesh2, n);
+                    if (iter==1) mesh2.clear();
+                }
+            }));
+        }
+        for (std::thread& thread : threads) thread.join();
+        for_int(i, nthreads) { assertx(results[i]==results[0]); }
+        SHOW(results[0]);
+    }
     SHOW("all ok");
 }
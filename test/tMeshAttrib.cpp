@@ -0,0 +1,33 @@
+// -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
+#include "MeshAttrib.h"
+#include "Geometry.h"
+using namespace hh;
+
+int main() {
+    Mesh mesh;
+    Array<Vertex> va; for_int(i, 4) { va.push(mesh.create_vertex()); }
+    Face f1 = mesh.create_face(va[0], va[1], va[2]);
+    Face f2 = mesh.create_face(va[0], va[2], va[3]);
+    {
+        VertexAttrib<Vector> vnor(mesh, Vector(0.f, 0.f, 0.f));
+        SHOW(vnor.array().num());
+        vnor[va[1]] = Vector(1.f, 2.f, 3.f);
+        vnor[va[3]] += Vector(0.f, 0.f, 1.f);
+        for (Vertex v : mesh.ordered_vertices()) { SHOW(mesh.vertex_id(v), vnor[v]); }
+        Vertex v5 = mesh.create_vertex(); // created after the attribute; the array grows upon access
+        const VertexAttrib<Vector>& cvnor = vnor;
+        SHOW(cvnor[v5]);
+        vnor[v5] = Vector(5.f, 5.f, 5.f);
+        SHOW(vnor.array().num(), vnor[v5]);
+        vnor.fill(Vector(0.f, 0.f, 0.f));
+        SHOW(vnor[va[1]]);
+    }
+    {
+        FaceAttrib<int> fmat(mesh, -1);
+        fmat[f2] = 7;
+        SHOW(fmat[f1], fmat[f2]);
+        mesh.destroy_face(f1);
+        Face f3 = mesh.create_face(va[0], va[1], va[2]);
+        SHOW(mesh.face_id(f3), fmat[f3]);
+    }
+}
@@ -8,6 +8,7 @@
 #include "Vector4.h"
 #include "Args.h"
 #include "Random.h"
+#include "Timer.h"
 using namespace hh;
 
 namespace {
@@ -124,6 +125,53 @@ void test(GridView<D,T> grid_orig, Periodic = Periodic{}) {
     if (result_rms_err>=expected_rms_err) { SHOW(expected_rms_err, result_rms_err); if (0) assertnever(""); }
 }
 
+// Verify that a cycle type, smoother, and precision reach the residual tolerance; optionally report timings.
+template<int D, typename T> void test_options(const Vec<int,D>& dims, MultigridCycle cycle,
+                                              MultigridRelaxation relaxation, bool mixed_precision, double tolerance) {
+    Grid<D,T> grid_orig(dims);
+    for (auto& e : grid_orig) { e = T{Random::G.unif()}; }
+    Multigrid<D,T> multigrid(dims);
+    fill(multigrid.initial_estimate(), T{0});
+    multigrid.set_desired_mean(mean(grid_orig));
+    setup_rhs(grid_orig, multigrid);
+    const double rms_rhs = mag_e(rms(Grid<D,T>(multigrid.rhs())));
+    const int max_cycles = 40;
+    multigrid.set_cycle(cycle);
+    multigrid.set_relaxation(relaxation);
+    multigrid.set_mixed_precision(mixed_precision);
+    multigrid.set_num_vcycles(max_cycles);
+    multigrid.set_residual_tolerance(tolerance);
+    Timer timer;
+    multigrid.solve();
+    timer.stop();
+    const double rms_resid = multigrid.rms_residual();
+    const char* scycle = cycle==MultigridCycle::V ? "V" : cycle==MultigridCycle::W ? "W" : "F";
+    const char* srelax = relaxation==MultigridRelaxation::red_black ? "red_black" : "gauss_seidel";
+    const string sprecision = mixed_precision ? "mixed" : std::is_same<T,double>::value ? "double" : "float";
+    if (getenv_bool("SHOW_TIMES")) {
+        // Convergence rate: decimal digits of residual reduction per second.
+        showf("%-16s %-6s %s-cycle %-12s: %2d cycles %7.3f sec  %6.2f digits/sec\n", make_string(dims).c_str(),
+              sprecision.c_str(), scycle, srelax, multigrid.num_cycles(), timer.real(),
+              std::log10(rms_rhs/rms_resid)/max(timer.real(), 1e-6));
+    } else {
+        showf("%-16s %-6s %s-cycle %-12s: converged=%d\n", make_string(dims).c_str(), sprecision.c_str(), scycle,
+              srelax, rms_resid<=tolerance*rms_rhs && multigrid.num_cycles()<max_cycles);
+    }
+}
+
+template<int D, typename T> void test_all_options(const Vec<int,D>& dims, double tolerance,
+                                                  double mixed_tolerance = 1e-10) {
+    for (MultigridCycle cycle : {MultigridCycle::V, MultigridCycle::W, MultigridCycle::F}) {
+        for (MultigridRelaxation relaxation : {MultigridRelaxation::gauss_seidel, MultigridRelaxation::red_black}) {
+            test_options<D,T>(dims, cycle, relaxation, false, tolerance);
+        }
+    }
+    if (std::is_same<T,double>::value) {
+        // (The float relaxation coefficients limit the accuracy of the pure double solver in 3D.)
+        test_options<D,T>(dims, MultigridCycle::V, MultigridRelaxation::red_black, true, mixed_tolerance);
+    }
+}
+
 struct MultigridPeriodicDim0 {
     bool operator()(int d) const { return d==0; } // only dimension-0 is periodic
 };
@@ -142,6 +190,16 @@ int main(int argc, const char** argv) {
             test(Grid<2,double>(129, 3));
             test(Grid<3,Vector4>(8, 16, 8));
             test(Grid<3,float>(32, 8, 4), MultigridPeriodicDim0());
+            test_all_options<2,double>(V(65, 65), 1e-10);
+            test_all_options<2,float>(V(64, 48), 1e-5);
+            test_all_options<3,double>(V(16, 17, 16), 1e-7);
+            test_all_options<3,float>(V(16, 16, 16), 1e-5);
+            if (getenv_bool("SHOW_TIMES")) { // benchmark convergence per second on larger problems
+                test_all_options<2,double>(V(1024, 1024), 1e-10);
+                test_all_options<2,float>(V(1024, 1024), 1e-5);
+                test_all_options<3,double>(V(32, 128, 128), 1e-7);
+                test_all_options<3,float>(V(32, 128, 128), 1e-5);
+            }
         } else {
             test(Grid<1,float>(2049));
             test(Grid<1,float>(511));
@@ -1,8 +1,33 @@
 // -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
 #include "Pqueue.h"
+#include "Timer.h"
 #include <random>               // std::default_random_engine
 using namespace hh;
 
+namespace {
+
+// Dijkstra traversal of a gn*gn grid graph with vertex weights wts; returns the sum of vertex distances.
+template<typename PQ> double grid_dijkstra(PQ& pq, int gn, CArrayView<float> wts) {
+    const int n = gn*gn;
+    Array<float> dist(n, BIGFLOAT); Array<bool> done(n, false);
+    dist[0] = 0.f; pq.enter(0, 0.f);
+    double sum = 0.;
+    while (!pq.empty()) {
+        float d = pq.min_priority(); int i = pq.remove_min();
+        done[i] = true; sum += d;
+        int y = i/gn, x = i%gn;
+        const int nei[4] = {x>0 ? i-1 : -1, x<gn-1 ? i+1 : -1, y>0 ? i-gn : -1, y<gn-1 ? i+gn : -1};
+        for (int j : nei) {
+            if (j<0 || done[j]) continue;
+            float dj = d+wts[j];
+            if (dj<dist[j]) { dist[j] = dj; pq.enter_update_if_smaller(j, dj); }
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
 int main() {
 #if 0                           // test noncopyable
     {
@@ -215,6 +240,59 @@ int main() {
             }
         }
     }
+    {
+        IPqueue<int, IPqueueIntSlots> pq;
+        pq.sort();              // empty queue
+        assertx(pq.empty());
+        pq.enter_unsorted(3, 1.f);
+        pq.sort();
+        assertx(pq.min()==3);
+    }
+    {
+        // IPqueue behaves identically to HPqueue under random insertions, updates, and removals.
+        std::default_random_engine dre;
+        for_int(itest, 50) {
+            const int n = 1+dre()%300;
+            HPqueue<int> hpq;
+            IPqueue<int, IPqueueIntSlots> ipq;
+            for_int(i, n) { float pri = float(dre()%1000); hpq.enter_unsorted(i, pri); ipq.enter_unsorted(i, pri); }
+            hpq.sort(); ipq.sort();
+            for_int(iop, n*4) {
+                int i = int(dre()%(n+5)); float pri = float(dre()%1000);
+                switch (dre()%5) {
+                 case 0: assertx(hpq.update(i, pri)==ipq.update(i, pri)); break;
+                 case 1: assertx(hpq.remove(i)==ipq.remove(i)); break;
+                 case 2: assertx(hpq.enter_update(i, pri)==ipq.enter_update(i, pri)); break;
+                 case 3: assertx(hpq.enter_update_if_smaller(i, pri)==ipq.enter_update_if_smaller(i, pri)); break;
+                 case 4: assertx(hpq.enter_update_if_greater(i, pri)==ipq.enter_update_if_greater(i, pri)); break;
+                 default: assertnever("");
+                }
+                assertx(hpq.num()==ipq.num() && hpq.retrieve(i)==ipq.retrieve(i));
+            }
+            if (!ipq.empty() && itest%2) {
+                Array<std::pair<int, float>> updates;
+                for_int(i, n+5) { if (ipq.contains(i) && dre()%2) updates.push(std::make_pair(i, float(dre()%1000))); }
+                for (const auto& pair : updates) { hpq.update(pair.first, pair.second); }
+                ipq.update_batch(updates);
+            }
+            while (!hpq.empty()) {
+                assertx(ipq.min_priority()==hpq.min_priority());
+                float pri = hpq.min_priority(); int i = ipq.remove_min();
+                assertx(hpq.remove(i)==pri);
+            }
+            assertx(ipq.empty());
+            for_int(i, n) { assertx(!ipq.contains(i)); }
+        }
+    }
+    {
+        // Benchmark (timings shown if SHOW_TIMES=1): Dijkstra traversal of a grid graph with many decrease-keys.
+        const int gn = 300;
+        Array<float> wts(gn*gn); { std::default_random_engine dre; for (float& w : wts) { w = 1.f+float(dre()%100); } }
+        double sum1, sum2;
+        { HH_PTIMER(_hpqueue); HPqueue<int> pq; sum1 = grid_dijkstra(pq, gn, wts); }
+        { HH_PTIMER(_ipqueue); IPqueue<int, IPqueueIntSlots> pq; sum2 = grid_dijkstra(pq, gn, wts); }
+        assertx(sum1==sum2);
+    }
 }
 
 template class hh::Pqueue<unsigned>;
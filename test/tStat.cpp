@@ -1,6 +1,7 @@
 // -*- C++ -*-  Copyright (c) Microsoft Corporation; see license.txt
 #include "Stat.h"
 #include "Array.h"
+#include "Parallel.h"
 #include "Vec.h"
 using namespace hh;
 
@@ -48,5 +49,8 @@ int main() {
         SHOW(Stat(V(1., 4., 5., 6.)).short_string());
         SHOW(Stat(V(1., 4., 5., 6.)).sdv());
     }
+    {
+        parallel_for_each(range(1000), [&](const int i) { HH_SSTAT_CONCURRENT(Sconcurrent, i); });
+    }
     hh_clean_up();
 }